@@ -0,0 +1,272 @@
+#include "benchmark.hpp"
+#include <edyn/edyn.hpp>
+#include <edyn/config/profiling_config.hpp>
+#include <edyn/context/step_stats.hpp>
+#include <edyn/time/time.hpp>
+#include <entt/entity/registry.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+// Count heap allocations in all threads by replacing the global allocation
+// functions.
+static std::atomic<uint64_t> g_allocation_count {0};
+static std::atomic<uint64_t> g_allocation_bytes {0};
+
+static void * counted_alloc(std::size_t size) {
+    g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    g_allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+    return std::malloc(size > 0 ? size : 1);
+}
+
+static void * counted_aligned_alloc(std::size_t size, std::align_val_t align) {
+    g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    g_allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+    auto alignment = static_cast<std::size_t>(align);
+    // Size must be a multiple of the alignment.
+    size = (std::max(size, std::size_t{1}) + alignment - 1) / alignment * alignment;
+#ifdef _MSC_VER
+    return _aligned_malloc(size, alignment);
+#else
+    return std::aligned_alloc(alignment, size);
+#endif
+}
+
+static void aligned_free(void *ptr) noexcept {
+#ifdef _MSC_VER
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+void * operator new(std::size_t size) {
+    if (auto *ptr = counted_alloc(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void * operator new(std::size_t size, std::align_val_t align) {
+    if (auto *ptr = counted_aligned_alloc(size, align)) {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept {
+    aligned_free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept {
+    aligned_free(ptr);
+}
+
+namespace edyn::bench {
+
+uint64_t allocation_count() {
+    return g_allocation_count.load(std::memory_order_relaxed);
+}
+
+uint64_t allocation_bytes() {
+    return g_allocation_bytes.load(std::memory_order_relaxed);
+}
+
+static const char * mode_name(execution_mode mode) {
+    switch (mode) {
+    case execution_mode::sequential: return "sequential";
+    case execution_mode::sequential_multithreaded: return "sequential_mt";
+    case execution_mode::asynchronous: return "asynchronous";
+    }
+    return "";
+}
+
+// Performs one step using the stepper of the simulation, timing the
+// scene's `post_step` separately.
+static void step_sequential(entt::registry &registry, const scene &scn, double time, result *res) {
+    edyn::step_simulation(registry, time);
+
+    if (scn.post_step) {
+        auto start_time = performance_time();
+        (*scn.post_step)(registry);
+
+        if (res) {
+            res->post_step_time += performance_time() - start_time;
+        }
+    }
+}
+
+static std::atomic<unsigned> g_async_step_count {0};
+
+static void count_async_step(entt::registry &) {
+    g_async_step_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Steps the simulation worker `num_steps` times and waits until done.
+static void step_async(entt::registry &registry, const scene &scn, unsigned num_steps, result *res) {
+    auto target = g_async_step_count.load(std::memory_order_relaxed) + num_steps;
+
+    for (unsigned i = 0; i < num_steps; ++i) {
+        edyn::step_simulation(registry);
+    }
+
+    while (g_async_step_count.load(std::memory_order_relaxed) < target) {
+        edyn::update(registry);
+
+        if (scn.post_step) {
+            auto start_time = performance_time();
+            (*scn.post_step)(registry);
+
+            if (res) {
+                res->post_step_time += performance_time() - start_time;
+            }
+        }
+    }
+
+    // Merge results of the last steps into the main registry.
+    edyn::update(registry);
+}
+
+result run(const scene &scn, execution_mode mode, const options &opts) {
+    entt::registry registry;
+
+    auto config = edyn::init_config{};
+    config.execution_mode = mode;
+    config.num_worker_threads = opts.num_worker_threads;
+    // Use a fixed timestamp to make runs reproducible.
+    config.timestamp = 0;
+    edyn::attach(registry, config);
+    edyn::set_paused(registry, true);
+
+    if (mode == execution_mode::asynchronous) {
+        edyn::set_post_step_callback(registry, &count_async_step);
+    }
+
+    (*scn.setup)(registry);
+
+    auto res = result{};
+    res.scene_name = scn.name;
+    res.mode = mode;
+    res.steps = opts.steps > 0 ? opts.steps : scn.steps;
+
+    // Keep the stats of all measured steps, which are summed at the end.
+    edyn::set_profiling_enabled(registry, true, res.steps);
+    auto &stats_history = registry.ctx().at<step_stats_history>();
+
+    auto dt = static_cast<double>(edyn::get_fixed_dt(registry));
+    double time = 0;
+
+    if (mode == execution_mode::asynchronous) {
+        // Send new entities to the simulation worker.
+        edyn::update(registry, time);
+        step_async(registry, scn, scn.warmup_steps, nullptr);
+        stats_history.clear();
+
+        auto allocation_count_start = allocation_count();
+        auto allocation_bytes_start = allocation_bytes();
+        auto start_time = performance_time();
+
+        step_async(registry, scn, res.steps, &res);
+
+        res.total_time = performance_time() - start_time;
+        res.num_allocations = allocation_count() - allocation_count_start;
+        res.allocated_bytes = allocation_bytes() - allocation_bytes_start;
+    } else {
+        // Run a regular step first to initialize shapes and AABBs.
+        edyn::step_simulation(registry, time);
+
+        for (unsigned i = 0; i < scn.warmup_steps; ++i) {
+            time += dt;
+            step_sequential(registry, scn, time, nullptr);
+        }
+
+        stats_history.clear();
+
+        auto allocation_count_start = allocation_count();
+        auto allocation_bytes_start = allocation_bytes();
+        auto start_time = performance_time();
+
+        for (unsigned i = 0; i < res.steps; ++i) {
+            time += dt;
+            step_sequential(registry, scn, time, &res);
+        }
+
+        res.total_time = performance_time() - start_time;
+        res.num_allocations = allocation_count() - allocation_count_start;
+        res.allocated_bytes = allocation_bytes() - allocation_bytes_start;
+    }
+
+    // Stats are only recorded if Edyn is built with `EDYN_ENABLE_PROFILING`.
+    stats_history.each([&](const step_stats &stats) {
+        for (size_t i = 0; i < size_t(profile_stage::count); ++i) {
+            res.stage_time[i] += stats.stage_time[i];
+        }
+        ++res.num_profiled_steps;
+    });
+
+    if (scn.teardown) {
+        (*scn.teardown)(registry);
+    }
+
+    if (scn.summary) {
+        res.summary = (*scn.summary)();
+    }
+
+    edyn::detach(registry);
+
+    return res;
+}
+
+// Width of the column of a stage, which fits its name.
+static int stage_column_width(profile_stage stage) {
+    return std::max(10, static_cast<int>(std::strlen(profile_stage_name(stage))));
+}
+
+void print_header() {
+    std::printf("%-18s %-14s %7s %10s", "scene", "mode", "steps", "steps/s");
+
+    for (size_t i = 0; i < size_t(profile_stage::count); ++i) {
+        auto stage = profile_stage(i);
+        std::printf(" %*s", stage_column_width(stage), profile_stage_name(stage));
+    }
+
+    std::printf(" %10s %12s %12s\n", "post_step", "allocs/step", "KiB/step");
+}
+
+void print_result(const result &res) {
+    std::printf("%-18s %-14s %7u %10.1f", res.scene_name.c_str(), mode_name(res.mode),
+                res.steps, res.steps_per_second());
+
+    // Average time per step in milliseconds.
+    for (size_t i = 0; i < size_t(profile_stage::count); ++i) {
+        auto width = stage_column_width(profile_stage(i));
+
+        if (res.num_profiled_steps == 0) {
+            std::printf(" %*s", width, "-");
+        } else {
+            std::printf(" %*.3fms", width - 2, res.stage_time[i] / res.num_profiled_steps * 1000);
+        }
+    }
+
+    std::printf(" %8.3fms %12.1f %12.2f\n",
+                res.post_step_time / res.steps * 1000,
+                double(res.num_allocations) / res.steps,
+                double(res.allocated_bytes) / res.steps / 1024);
+
+    if (!res.summary.empty()) {
+        std::printf("    %s\n", res.summary.c_str());
+    }
+}
+
+}
@@ -0,0 +1,95 @@
+#ifndef BENCHMARK_EDYN_COMMON_BENCHMARK_HPP
+#define BENCHMARK_EDYN_COMMON_BENCHMARK_HPP
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <edyn/config/execution_mode.hpp>
+#include <edyn/context/step_stats.hpp>
+#include <entt/entity/fwd.hpp>
+
+namespace edyn::bench {
+
+/**
+ * @brief A reproducible benchmark scene.
+ */
+struct scene {
+    const char *name;
+
+    // Creates the entities. Called right after `edyn::attach`.
+    void (*setup)(entt::registry &);
+
+    // Optional function called after each step, whose duration is recorded
+    // separately from the step.
+    void (*post_step)(entt::registry &) {nullptr};
+
+    // Optional function called before `edyn::detach`.
+    void (*teardown)(entt::registry &) {nullptr};
+
+    // Optional function called after the teardown which returns scene
+    // specific results to be printed along the timings.
+    std::string (*summary)() {nullptr};
+
+    // Number of steps to run before measuring, to let bodies settle or fall
+    // asleep, for example.
+    unsigned warmup_steps {0};
+
+    // Number of measured steps.
+    unsigned steps {300};
+};
+
+/**
+ * @brief Results of running a scene in one execution mode.
+ */
+struct result {
+    std::string scene_name;
+    execution_mode mode;
+    unsigned steps {0};
+    double total_time {0};
+    // Accumulated time per stage, as recorded by the step profiler. Only
+    // available if Edyn is built with `EDYN_ENABLE_PROFILING`.
+    std::array<double, size_t(profile_stage::count)> stage_time {};
+    // Number of steps whose stats were recorded by the profiler.
+    unsigned num_profiled_steps {0};
+    // Accumulated time spent in the scene's `post_step`.
+    double post_step_time {0};
+    uint64_t num_allocations {0};
+    uint64_t allocated_bytes {0};
+    std::string summary;
+
+    double steps_per_second() const {
+        return total_time > 0 ? steps / total_time : 0;
+    }
+};
+
+struct options {
+    // Override for the number of measured steps. Zero uses the scene default.
+    unsigned steps {0};
+    // Number of worker threads. Zero lets Edyn decide.
+    size_t num_worker_threads {0};
+};
+
+/**
+ * @brief Runs a scene in the given execution mode.
+ */
+result run(const scene &, execution_mode, const options &);
+
+void print_header();
+void print_result(const result &);
+
+/**
+ * @brief All registered scenes.
+ */
+const std::vector<scene> & get_scenes();
+
+/**
+ * @brief Total number of heap allocations and bytes allocated since the
+ * program started, in all threads.
+ */
+uint64_t allocation_count();
+uint64_t allocation_bytes();
+
+}
+
+#endif // BENCHMARK_EDYN_COMMON_BENCHMARK_HPP
@@ -0,0 +1,91 @@
+#include "common/benchmark.hpp"
+#include <edyn/config/execution_mode.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+static void print_usage(const char *program) {
+    std::printf("Usage: %s [options]\n"
+                "  --scene <name>     Run only the given scene. Can be repeated.\n"
+                "  --mode <mode>      sequential, sequential_multithreaded, asynchronous or all.\n"
+                "                     Defaults to all.\n"
+                "  --steps <count>    Number of measured steps, overriding scene defaults.\n"
+                "  --workers <count>  Number of worker threads.\n"
+                "  --list             List available scenes.\n", program);
+}
+
+int main(int argc, char **argv) {
+    auto scene_names = std::vector<std::string>{};
+    auto modes = std::vector<edyn::execution_mode>{};
+    auto opts = edyn::bench::options{};
+
+    for (int i = 1; i < argc; ++i) {
+        auto arg = std::string(argv[i]);
+        auto has_value = i + 1 < argc;
+
+        if (arg == "--scene" && has_value) {
+            scene_names.emplace_back(argv[++i]);
+        } else if (arg == "--mode" && has_value) {
+            auto mode = std::string(argv[++i]);
+
+            if (mode == "sequential") {
+                modes.push_back(edyn::execution_mode::sequential);
+            } else if (mode == "sequential_multithreaded") {
+                modes.push_back(edyn::execution_mode::sequential_multithreaded);
+            } else if (mode == "asynchronous") {
+                modes.push_back(edyn::execution_mode::asynchronous);
+            } else if (mode != "all") {
+                std::printf("Unknown mode: %s\n", mode.c_str());
+                return EXIT_FAILURE;
+            }
+        } else if (arg == "--steps" && has_value) {
+            opts.steps = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--workers" && has_value) {
+            opts.num_worker_threads = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--list") {
+            for (auto &scn : edyn::bench::get_scenes()) {
+                std::printf("%s\n", scn.name);
+            }
+            return EXIT_SUCCESS;
+        } else {
+            print_usage(argv[0]);
+            return arg == "--help" ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    if (modes.empty()) {
+        modes = {
+            edyn::execution_mode::sequential,
+            edyn::execution_mode::sequential_multithreaded,
+            edyn::execution_mode::asynchronous
+        };
+    }
+
+    auto selected = std::vector<const edyn::bench::scene *>{};
+
+    for (auto &scn : edyn::bench::get_scenes()) {
+        if (scene_names.empty() ||
+            std::find(scene_names.begin(), scene_names.end(), scn.name) != scene_names.end()) {
+            selected.push_back(&scn);
+        }
+    }
+
+    if (selected.empty()) {
+        std::printf("No matching scenes. Use --list to see available scenes.\n");
+        return EXIT_FAILURE;
+    }
+
+    edyn::bench::print_header();
+
+    for (auto *scn : selected) {
+        for (auto mode : modes) {
+            auto res = edyn::bench::run(*scn, mode, opts);
+            edyn::bench::print_result(res);
+            std::fflush(stdout);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
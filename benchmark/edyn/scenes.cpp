@@ -0,0 +1,523 @@
+#include "common/benchmark.hpp"
+#include <edyn/edyn.hpp>
+#include <edyn/util/ragdoll.hpp>
+#include <edyn/util/shape_util.hpp>
+#include <edyn/shapes/create_paged_triangle_mesh.hpp>
+#include <edyn/shapes/triangle_mesh_page_loader.hpp>
+#include <edyn/networking/networking.hpp>
+#include <edyn/networking/sys/server_side.hpp>
+#include <edyn/networking/util/snapshot_compression.hpp>
+#include <edyn/serialization/memory_archive.hpp>
+#include <edyn/serialization/math_s11n.hpp>
+#include <edyn/serialization/triangle_mesh_s11n.hpp>
+#include <edyn/serialization/triangle_mesh_compression.hpp>
+#include <edyn/time/time.hpp>
+#include <entt/entity/registry.hpp>
+#include <entt/signal/sigh.hpp>
+#include <atomic>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace edyn::bench {
+
+static void make_ground(entt::registry &registry) {
+    auto def = edyn::rigidbody_def{};
+    def.kind = edyn::rigidbody_kind::rb_static;
+    def.material->restitution = 0;
+    def.material->friction = 0.5;
+    def.shape = edyn::plane_shape{{0, 1, 0}, 0};
+    edyn::make_rigidbody(registry, def);
+}
+
+// A large stack of boxes in a single island. Stresses the constraint solver.
+static void setup_box_pyramid(entt::registry &registry) {
+    make_ground(registry);
+
+    auto def = edyn::rigidbody_def{};
+    def.mass = 10;
+    def.material->restitution = 0;
+    def.material->friction = 0.8;
+    def.shape = edyn::box_shape{0.2, 0.2, 0.2};
+
+    constexpr int base = 24;
+
+    for (int i = 0; i < base; ++i) {
+        for (int j = 0; j < base - i; ++j) {
+            def.position = {
+                (scalar(i) * scalar(0.5) + scalar(j) - scalar(base) * scalar(0.5)) * scalar(0.4),
+                scalar(0.2) + scalar(i) * scalar(0.4),
+                0
+            };
+            edyn::make_rigidbody(registry, def);
+        }
+    }
+}
+
+// Many rag dolls falling on top of each other, which creates many constraints
+// of different types and many contacts between capsules.
+static void setup_ragdoll_pile(entt::registry &registry) {
+    make_ground(registry);
+
+    auto def = edyn::ragdoll_simple_def{};
+
+    for (int i = 0; i < 6; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            for (int k = 0; k < 4; ++k) {
+                def.position = {scalar(j - 2) * scalar(0.6), scalar(1 + i * 2), scalar(k - 2) * scalar(0.4)};
+                edyn::make_ragdoll(registry, def);
+            }
+        }
+    }
+}
+
+// How submeshes are stored by the `memory_page_loader`.
+enum class page_encoding {
+    // Submeshes are kept as objects and loading is free.
+    none,
+    // Submeshes are serialized in the default format.
+    raw,
+    // Submeshes are encoded with `compress_triangle_mesh`.
+    compressed
+};
+
+static std::atomic<uint64_t> g_num_page_loads;
+static std::atomic<uint64_t> g_page_load_bytes;
+static std::atomic<uint64_t> g_page_load_counter;
+static uint64_t g_page_stored_bytes;
+
+// Serves submeshes from memory. Loading happens immediately in the same
+// thread so the cost of paging in and out is part of the narrowphase. If
+// submeshes are encoded, they're decoded on every load, which measures load
+// throughput without disk access.
+class memory_page_loader : public edyn::triangle_mesh_page_loader_base {
+public:
+    memory_page_loader(page_encoding encoding)
+        : m_encoding(encoding)
+    {}
+
+    void load(size_t index) override {
+        if (m_encoding == page_encoding::none) {
+            m_loaded_signal.publish(index, m_submeshes[index]);
+            return;
+        }
+
+        auto &buffer = m_buffers[index];
+        auto mesh = std::make_shared<edyn::triangle_mesh>();
+        auto start = edyn::performance_counter();
+
+        if (m_encoding == page_encoding::raw) {
+            auto archive = edyn::memory_input_archive(buffer.data(), buffer.size());
+            edyn::serialize(archive, *mesh);
+        } else {
+            edyn::decompress_triangle_mesh(buffer.data(), buffer.size(), *mesh);
+        }
+
+        g_page_load_counter += edyn::performance_counter() - start;
+        g_page_load_bytes += buffer.size();
+        ++g_num_page_loads;
+
+        m_loaded_signal.publish(index, mesh);
+    }
+
+    entt::sink<entt::sigh<loaded_mesh_func_t>> on_load_sink() override {
+        return {m_loaded_signal};
+    }
+
+    void add_submesh(std::shared_ptr<edyn::triangle_mesh> submesh) {
+        if (m_encoding == page_encoding::none) {
+            m_submeshes.push_back(submesh);
+            return;
+        }
+
+        auto &buffer = m_buffers.emplace_back();
+
+        if (m_encoding == page_encoding::raw) {
+            auto archive = edyn::memory_output_archive(buffer);
+            edyn::serialize(archive, *submesh);
+        } else {
+            edyn::compress_triangle_mesh(*submesh, buffer);
+        }
+
+        g_page_stored_bytes += buffer.size();
+    }
+
+private:
+    page_encoding m_encoding;
+    std::vector<std::shared_ptr<edyn::triangle_mesh>> m_submeshes;
+    std::vector<std::vector<uint8_t>> m_buffers;
+    entt::sigh<loaded_mesh_func_t> m_loaded_signal;
+};
+
+// Bodies rolling over a large paged triangle mesh whose submeshes do not all
+// fit in the cache, which continuously loads and evicts pages.
+static void make_paged_terrain(entt::registry &registry, page_encoding encoding) {
+    g_num_page_loads = 0;
+    g_page_load_bytes = 0;
+    g_page_load_counter = 0;
+    g_page_stored_bytes = 0;
+
+    std::vector<edyn::vector3> vertices;
+    std::vector<uint32_t> indices;
+    constexpr size_t num_vertices = 128;
+    constexpr scalar extent = 200;
+    edyn::make_plane_mesh(extent, extent, num_vertices, num_vertices, vertices, indices);
+
+    // Add some bumps.
+    for (auto &v : vertices) {
+        v.y = std::sin(v.x * scalar(0.3)) * std::cos(v.z * scalar(0.2)) * scalar(0.5);
+    }
+
+    auto loader = std::make_shared<memory_page_loader>(encoding);
+    auto trimesh = std::make_shared<edyn::paged_triangle_mesh>(loader);
+    edyn::create_paged_triangle_mesh(*trimesh,
+                                     vertices.begin(), vertices.end(),
+                                     indices.begin(), indices.end(),
+                                     256, {});
+
+    // Move all submeshes into the loader and start with an empty cache.
+    for (size_t i = 0; i < trimesh->num_submeshes(); ++i) {
+        loader->add_submesh(trimesh->get_submesh(i));
+    }
+
+    trimesh->clear_cache();
+
+    auto terrain_def = edyn::rigidbody_def{};
+    terrain_def.kind = edyn::rigidbody_kind::rb_static;
+    terrain_def.shape = edyn::paged_mesh_shape{trimesh};
+    edyn::make_rigidbody(registry, terrain_def);
+
+    auto def = edyn::rigidbody_def{};
+    def.mass = 50;
+    def.material->friction = 0.6;
+    def.shape = edyn::sphere_shape{0.5};
+
+    for (int i = 0; i < 16; ++i) {
+        for (int j = 0; j < 16; ++j) {
+            def.position = {scalar(i - 8) * scalar(11), 2, scalar(j - 8) * scalar(11)};
+            def.linvel = {scalar(6), 0, scalar(i % 2 == 0 ? 4 : -4)};
+            edyn::make_rigidbody(registry, def);
+        }
+    }
+}
+
+static void setup_paged_terrain(entt::registry &registry) {
+    make_paged_terrain(registry, page_encoding::none);
+}
+
+static void setup_paged_terrain_raw(entt::registry &registry) {
+    make_paged_terrain(registry, page_encoding::raw);
+}
+
+static void setup_paged_terrain_compressed(entt::registry &registry) {
+    make_paged_terrain(registry, page_encoding::compressed);
+}
+
+static std::string paged_terrain_load_summary() {
+    auto load_time = double(g_page_load_counter) / double(edyn::performance_frequency());
+    auto num_loads = g_num_page_loads.load();
+    auto mib = double(1024 * 1024);
+    auto throughput = load_time > 0 ? double(g_page_load_bytes) / mib / load_time : 0.0;
+    auto time_per_load = num_loads > 0 ? load_time * 1e6 / double(num_loads) : 0.0;
+
+    return "stored: " + std::to_string(g_page_stored_bytes / 1024) + " KiB" +
+           ", loads: " + std::to_string(num_loads) +
+           ", " + std::to_string(int(time_per_load)) + " us/load" +
+           ", " + std::to_string(int(throughput)) + " MiB/s";
+}
+
+// Many small separated islands which fall asleep during the warm-up. Ideally
+// a step should cost nearly nothing.
+static void setup_sleeping_islands(entt::registry &registry) {
+    make_ground(registry);
+
+    auto def = edyn::rigidbody_def{};
+    def.mass = 10;
+    def.material->restitution = 0;
+    def.material->friction = 0.8;
+    def.shape = edyn::box_shape{0.2, 0.2, 0.2};
+
+    for (int i = 0; i < 40; ++i) {
+        for (int j = 0; j < 40; ++j) {
+            for (int k = 0; k < 2; ++k) {
+                def.position = {scalar(i - 20), scalar(0.2) + scalar(k) * scalar(0.4), scalar(j - 20)};
+                edyn::make_rigidbody(registry, def);
+            }
+        }
+    }
+}
+
+// A fixed set of bodies which never sleep next to a field of sleeping boxes
+// whose size is given by `Size`. Sleeping entities should not add to the
+// cost of a step, thus the step time of all variants should be the same.
+template<int Size>
+static void setup_sleeping_world(entt::registry &registry) {
+    make_ground(registry);
+
+    auto def = edyn::rigidbody_def{};
+    def.mass = 10;
+    def.material->restitution = 0;
+    def.material->friction = 0.8;
+    def.shape = edyn::box_shape{0.2, 0.2, 0.2};
+    def.sleeping_disabled = true;
+
+    for (int i = 0; i < 6; ++i) {
+        for (int j = 0; j < 6; ++j) {
+            def.position = {scalar(i) * scalar(0.5), scalar(0.2), scalar(j) * scalar(0.5) - scalar(Size + 10)};
+            def.angvel = {0, scalar(1 + (i + j) % 3), 0};
+            edyn::make_rigidbody(registry, def);
+        }
+    }
+
+    def.sleeping_disabled = false;
+    def.angvel = edyn::vector3_zero;
+
+    for (int i = 0; i < Size; ++i) {
+        for (int j = 0; j < Size; ++j) {
+            for (int k = 0; k < 2; ++k) {
+                def.position = {scalar(i - Size / 2), scalar(0.2) + scalar(k) * scalar(0.4), scalar(j - Size / 2)};
+                edyn::make_rigidbody(registry, def);
+            }
+        }
+    }
+}
+
+// Many small towers standing among static posts, which topple onto their
+// neighbors. Lots of islands share the ground and the posts and are merged
+// into larger islands as they fall. Stresses island merging.
+static void setup_island_merge(entt::registry &registry) {
+    make_ground(registry);
+
+    constexpr int size = 24;
+    constexpr auto spacing = scalar(0.5);
+
+    auto post_def = edyn::rigidbody_def{};
+    post_def.kind = edyn::rigidbody_kind::rb_static;
+    post_def.shape = edyn::box_shape{0.05, 0.3, 0.05};
+
+    for (int i = 0; i < size; i += 2) {
+        for (int j = 0; j < size; j += 2) {
+            post_def.position = {
+                (scalar(i - size / 2) + scalar(0.5)) * spacing,
+                scalar(0.3),
+                (scalar(j - size / 2) + scalar(0.5)) * spacing
+            };
+            edyn::make_rigidbody(registry, post_def);
+        }
+    }
+
+    auto def = edyn::rigidbody_def{};
+    def.mass = 10;
+    def.material->restitution = 0;
+    def.material->friction = 0.6;
+    def.shape = edyn::box_shape{0.1, 0.2, 0.1};
+
+    for (int i = 0; i < size; ++i) {
+        for (int j = 0; j < size; ++j) {
+            // Tilt towers in different directions so they fall onto each other.
+            auto angle = scalar(0.3) * scalar((i * 7 + j * 3) % 5 + 1) / scalar(5);
+            auto axis = normalize(vector3{scalar((i + j) % 3) - 1, 0, scalar((i * j) % 3) - scalar(0.5)});
+            def.orientation = quaternion_axis_angle(axis, angle);
+
+            auto base = vector3{scalar(i - size / 2) * spacing, scalar(0.05), scalar(j - size / 2) * spacing};
+
+            for (int k = 0; k < 3; ++k) {
+                auto offset = vector3{0, scalar(0.2) + scalar(k) * scalar(0.41), 0};
+                def.position = base + rotate(def.orientation, offset);
+                edyn::make_rigidbody(registry, def);
+            }
+        }
+    }
+}
+
+static std::mutex g_packet_mutex;
+static uint64_t g_num_packets;
+static uint64_t g_packet_bytes;
+
+// Snapshot histories of the simulated clients and the acknowledgements they
+// would send back, which are delivered to the server before the next update.
+static std::map<entt::entity, edyn::snapshot_baseline_history> g_client_histories;
+static std::vector<std::pair<entt::entity, uint32_t>> g_pending_acks;
+
+static void count_packet(entt::entity client_entity, const edyn::packet::edyn_packet &packet) {
+    auto buffer = edyn::memory_output_archive::buffer_type{};
+    auto archive = edyn::memory_output_archive(buffer);
+    archive(const_cast<edyn::packet::edyn_packet &>(packet));
+
+    auto lock = std::lock_guard(g_packet_mutex);
+    ++g_num_packets;
+    g_packet_bytes += buffer.size();
+
+    if (auto *snapshot = std::get_if<edyn::packet::registry_snapshot>(&packet.var);
+        snapshot && !snapshot->motion.empty())
+    {
+        auto received = *snapshot;
+        auto sequence = uint32_t{};
+
+        if (edyn::decompress_registry_snapshot(received, g_client_histories[client_entity], sequence)) {
+            g_pending_acks.emplace_back(client_entity, sequence);
+        }
+    }
+}
+
+// A server with many clients observing many networked bodies. Measures the
+// cost of generating snapshots for all clients.
+static void setup_network_server(entt::registry &registry) {
+    g_num_packets = 0;
+    g_packet_bytes = 0;
+
+    edyn::init_network_server(registry);
+    edyn::network_server_packet_sink(registry).connect<&count_packet>();
+
+    for (int i = 0; i < 16; ++i) {
+        edyn::server_make_client(registry);
+    }
+
+    make_ground(registry);
+
+    auto def = edyn::rigidbody_def{};
+    def.mass = 10;
+    def.networked = true;
+    def.shape = edyn::box_shape{0.2, 0.2, 0.2};
+
+    for (int i = 0; i < 20; ++i) {
+        for (int j = 0; j < 20; ++j) {
+            def.position = {scalar(i - 10) * scalar(0.6), scalar(0.5) + scalar((i + j) % 5), scalar(j - 10) * scalar(0.6)};
+            edyn::make_rigidbody(registry, def);
+        }
+    }
+}
+
+static void teardown_network_server(entt::registry &registry) {
+    edyn::network_server_packet_sink(registry).disconnect<&count_packet>();
+    edyn::deinit_network_server(registry);
+}
+
+// Same as above with quantized and delta-encoded snapshots. Compare the amount
+// of data sent with the uncompressed scene.
+static void setup_network_server_compressed(entt::registry &registry) {
+    g_client_histories.clear();
+    g_pending_acks.clear();
+    setup_network_server(registry);
+
+    auto &settings = registry.ctx().at<edyn::settings>();
+    std::get<edyn::server_network_settings>(settings.network_settings).compress_snapshots = true;
+}
+
+static void update_network_server_compressed(entt::registry &registry) {
+    auto acks = decltype(g_pending_acks){};
+
+    {
+        auto lock = std::lock_guard(g_packet_mutex);
+        std::swap(acks, g_pending_acks);
+    }
+
+    for (auto [client_entity, sequence] : acks) {
+        auto packet = edyn::packet::edyn_packet{edyn::packet::snapshot_ack{sequence}};
+        edyn::server_receive_packet(registry, client_entity, packet);
+    }
+
+    edyn::update_network_server(registry);
+}
+
+static std::string network_server_summary() {
+    return "packets: " + std::to_string(g_num_packets) +
+           ", sent: " + std::to_string(g_packet_bytes / 1024) + " KiB";
+}
+
+const std::vector<scene> & get_scenes() {
+    static const auto scenes = [] {
+        auto scenes = std::vector<scene>{};
+
+        {
+            auto &s = scenes.emplace_back();
+            s.name = "box_pyramid";
+            s.setup = &setup_box_pyramid;
+            s.warmup_steps = 60;
+        }
+
+        {
+            auto &s = scenes.emplace_back();
+            s.name = "ragdoll_pile";
+            s.setup = &setup_ragdoll_pile;
+            s.warmup_steps = 30;
+        }
+
+        {
+            auto &s = scenes.emplace_back();
+            s.name = "paged_terrain";
+            s.setup = &setup_paged_terrain;
+            s.warmup_steps = 30;
+        }
+
+        {
+            auto &s = scenes.emplace_back();
+            s.name = "paged_terrain_raw";
+            s.setup = &setup_paged_terrain_raw;
+            s.summary = &paged_terrain_load_summary;
+            s.warmup_steps = 30;
+        }
+
+        {
+            auto &s = scenes.emplace_back();
+            s.name = "paged_terrain_compressed";
+            s.setup = &setup_paged_terrain_compressed;
+            s.summary = &paged_terrain_load_summary;
+            s.warmup_steps = 30;
+        }
+
+        {
+            auto &s = scenes.emplace_back();
+            s.name = "sleeping_islands";
+            s.setup = &setup_sleeping_islands;
+            s.warmup_steps = 300;
+        }
+
+        {
+            auto &s = scenes.emplace_back();
+            s.name = "sleeping_world_small";
+            s.setup = &setup_sleeping_world<10>;
+            s.warmup_steps = 300;
+        }
+
+        {
+            auto &s = scenes.emplace_back();
+            s.name = "sleeping_world_large";
+            s.setup = &setup_sleeping_world<80>;
+            s.warmup_steps = 300;
+        }
+
+        {
+            auto &s = scenes.emplace_back();
+            s.name = "island_merge";
+            s.setup = &setup_island_merge;
+        }
+
+        {
+            auto &s = scenes.emplace_back();
+            s.name = "network_server";
+            s.setup = &setup_network_server;
+            s.post_step = &edyn::update_network_server;
+            s.teardown = &teardown_network_server;
+            s.summary = &network_server_summary;
+            s.warmup_steps = 30;
+        }
+
+        {
+            auto &s = scenes.emplace_back();
+            s.name = "network_server_compressed";
+            s.setup = &setup_network_server_compressed;
+            s.post_step = &update_network_server_compressed;
+            s.teardown = &teardown_network_server;
+            s.summary = &network_server_summary;
+            s.warmup_steps = 30;
+        }
+
+        return scenes;
+    }();
+
+    return scenes;
+}
+
+}
@@ -20,6 +20,7 @@ class EdynConan(ConanFile):
         "fPIC": [True, False],
         "enable_assert": [True, False],
         "enable_sanitizer": [True, False],
+        "enable_profiling": [True, False],
         "floating_type": ["float", "double"],
         "build_tests": [True, False],
     }
@@ -28,6 +29,7 @@ class EdynConan(ConanFile):
         "fPIC": True,
         "enable_assert": False,
         "enable_sanitizer": False,
+        "enable_profiling": False,
         "floating_type": "float",
         "build_tests": False,
         "gtest:no_main": False,
@@ -80,6 +82,7 @@ class EdynConan(ConanFile):
         cmake.definitions["EDYN_CONFIG_DOUBLE"] = self.options.floating_type == "double"
         cmake.definitions["EDYN_DISABLE_ASSERT"] = not self.options.enable_assert
         cmake.definitions["EDYN_ENABLE_SANITIZER"] = self.options.enable_sanitizer
+        cmake.definitions["EDYN_ENABLE_PROFILING"] = self.options.enable_profiling
         cmake.configure(source_folder=self.build_folder)
         cmake.build()
         if self.options.build_tests:
@@ -16,13 +16,14 @@ class broadphase {
     // Separation threshold for new manifolds.
     constexpr static auto m_separation_threshold = contact_breaking_threshold * scalar(1.3);
 
+    void sweep_continuous_aabbs();
     void move_aabbs();
     void destroy_separated_manifolds();
 
-    void collide_tree(const dynamic_tree &tree, entt::entity entity, const AABB &offset_aabb) const;
-    void collide_tree_async(const dynamic_tree &tree, entt::entity entity, const AABB &offset_aabb, size_t result_index);
-    void collide_parallel();
-    void finish_collide();
+    void find_pairs(entt::entity entity, entity_pair_vector &pairs) const;
+    void update_pairs(bool mt);
+    void remove_inactive_pairs();
+    void create_manifolds();
 
 public:
     broadphase(entt::registry &);
@@ -47,6 +48,9 @@ public:
     void on_destroy_tree_resident(entt::registry &, entt::entity);
     void on_construct_island_aabb(entt::registry &, entt::entity);
     void on_destroy_island_tree_resident(entt::registry &, entt::entity);
+    void on_construct_inactive_tag(entt::registry &, entt::entity);
+    void on_destroy_sleeping_tag(entt::registry &, entt::entity);
+    void on_destroy_disabled_tag(entt::registry &, entt::entity);
 
 private:
     entt::registry *m_registry;
@@ -54,6 +58,15 @@ private:
     dynamic_tree m_np_tree; // Non-procedural dynamic tree.
     dynamic_tree m_island_tree; // Island AABB tree.
     std::vector<entt::entity> m_new_aabb_entities;
+    // Entities whose fat AABB changed in the tree, or which were inserted or
+    // removed from a tree since the last update. Only these are queried.
+    std::vector<entt::entity> m_moved_entities;
+    // Sorted and unique pairs of entities whose fat AABBs intersect. These
+    // are the candidates for new contact manifolds. Pairs where neither
+    // entity is an awake procedural entity are removed once entities go to
+    // sleep, and found again when they wake up.
+    entity_pair_vector m_pairs;
+    bool m_has_inactive_pairs {false};
     std::vector<entity_pair_vector> m_pair_results;
     size_t m_max_sequential_size {8};
 };
@@ -2,6 +2,7 @@
 #define EDYN_COLLISION_CONTACT_EVENT_EMITTER_HPP
 
 #include <entt/entity/fwd.hpp>
+#include <entt/entity/sparse_set.hpp>
 #include <entt/signal/sigh.hpp>
 #include "edyn/collision/contact_manifold.hpp"
 
@@ -31,9 +32,15 @@ public:
     }
 
     void on_destroy_contact_manifold(entt::registry &, entt::entity);
+    void on_update_contact_manifold_events(entt::registry &, entt::entity);
+    void on_destroy_contact_manifold_events(entt::registry &, entt::entity);
 
 private:
     entt::registry *m_registry;
+    // Manifolds whose events were modified since the last time events were
+    // consumed. Only these are visited, thus the cost does not depend on the
+    // number of manifolds, most of which could be asleep.
+    entt::sparse_set m_pending_events;
     entt::sigh<void(entt::entity)> m_contact_started_signal;
     entt::sigh<void(entt::entity)> m_contact_ended_signal;
     entt::sigh<void(entt::entity, contact_manifold::contact_id_type)> m_contact_point_created_signal;
@@ -27,6 +27,7 @@ struct contact_point {
     scalar damping {large_scalar};
     uint32_t lifetime {0}; // Incremented in each simulation step where the contact is persisted.
     scalar distance; // Signed distance along normal.
+    bool speculative {false}; // Not touching yet, thus contact events are not raised for it.
     std::optional<collision_feature> featureA; // Closest feature on A.
     std::optional<collision_feature> featureB; // Closest feature on B.
     scalar normal_impulse; // Applied normal impulse.
@@ -58,6 +59,7 @@ void serialize(Archive &archive, contact_point &cp) {
     archive(cp.damping);
     archive(cp.lifetime);
     archive(cp.distance);
+    archive(cp.speculative);
     archive(cp.featureA, cp.featureB);
     archive(cp.normal_impulse);
     archive(cp.friction_impulse);
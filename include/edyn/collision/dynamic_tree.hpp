@@ -8,6 +8,7 @@
 #include "edyn/math/geom.hpp"
 #include "edyn/collision/tree_node.hpp"
 #include "edyn/collision/query_tree.hpp"
+#include "edyn/collision/wide_tree.hpp"
 
 namespace edyn {
 
@@ -87,6 +88,21 @@ public:
     template<typename Func>
     void raycast(vector3 p0, vector3 p1, Func func) const;
 
+    /**
+     * @brief Rebuilds the 4-ary layout of this tree used to speed up queries
+     * if the tree changed since it was last built. Queries use the binary
+     * tree while the 4-ary layout is outdated. Must not be called while the
+     * tree is being queried in other threads.
+     */
+    void update_wide_tree();
+
+    /**
+     * @brief Number of leaf nodes in the tree.
+     */
+    size_t num_leaves() const {
+        return m_num_leaves;
+    }
+
     /**
      * @brief Gets a tree node.
      *
@@ -102,16 +118,28 @@ private:
 
     std::vector<tree_node> m_nodes;
     tree_node_id_t m_free_list;
+    size_t m_num_leaves {0};
+
+    wide_tree m_wide_tree;
+    bool m_wide_tree_valid {false};
 };
 
 template<typename Func>
 void dynamic_tree::query(const AABB &aabb, Func func) const {
-    query_tree(*this, m_root, null_tree_node_id, aabb, func);
+    if (m_wide_tree_valid) {
+        m_wide_tree.query(aabb, func);
+    } else {
+        query_tree(*this, m_root, null_tree_node_id, aabb, func);
+    }
 }
 
 template<typename Func>
 void dynamic_tree::raycast(vector3 p0, vector3 p1, Func func) const {
-    raycast_tree(*this, m_root, null_tree_node_id, p0, p1, func);
+    if (m_wide_tree_valid) {
+        m_wide_tree.raycast(p0, p1, func);
+    } else {
+        raycast_tree(*this, m_root, null_tree_node_id, p0, p1, func);
+    }
 }
 
 }
@@ -2,7 +2,10 @@
 #define EDYN_COLLISION_NARROWPHASE_HPP
 
 #include <array>
+#include <vector>
 #include <entt/entity/fwd.hpp>
+#include <entt/entity/sparse_set.hpp>
+#include <entt/signal/sigh.hpp>
 #include "edyn/comp/aabb.hpp"
 #include "edyn/comp/origin.hpp"
 #include "edyn/comp/shape_index.hpp"
@@ -28,15 +31,38 @@ class narrowphase {
         size_t count {0};
     };
 
+    struct prefetch_request {
+        entt::entity mesh_entity;
+        scalar priority;
+        size_t submesh_idx;
+    };
+
+    void prefetch_paged_meshes();
     void detect_collision_parallel();
     void finish_detect_collision();
-    void clear_contact_manifold_events();
+
+    void activate_manifold(entt::entity);
+    void deactivate_manifold(entt::entity);
 
 public:
     narrowphase(entt::registry &);
 
+    void on_construct_contact_manifold(entt::registry &, entt::entity);
+    void on_destroy_contact_manifold(entt::registry &, entt::entity);
+    void on_construct_inactive_tag(entt::registry &, entt::entity);
+    void on_destroy_sleeping_tag(entt::registry &, entt::entity);
+    void on_destroy_disabled_tag(entt::registry &, entt::entity);
+
     void update(bool mt);
 
+    /**
+     * @brief Manifolds which are neither asleep nor disabled, i.e. the ones
+     * processed in `update`.
+     */
+    const entt::sparse_set & active_manifolds() const {
+        return m_active_manifolds;
+    }
+
     /**
      * @brief Detects and processes collisions for the given manifolds.
      */
@@ -45,8 +71,22 @@ public:
 
 private:
     entt::registry *m_registry;
+
+    // Dense index of manifolds that are neither asleep nor disabled. It is
+    // updated as islands go to sleep and wake up, thus the narrowphase does
+    // not have to iterate over the entire manifold pool.
+    entt::sparse_set m_active_manifolds;
+
+    // Results of the parallel collision detection, with one element per
+    // active manifold. These only grow to avoid reallocations every step.
     std::vector<contact_point_construction_info> m_cp_construction_infos;
     std::vector<contact_point_destruction_info> m_cp_destruction_infos;
+
+    // Buffers used to sort submeshes to be prefetched by priority.
+    std::vector<prefetch_request> m_prefetch_requests;
+    std::vector<size_t> m_prefetch_indices;
+
+    std::vector<entt::scoped_connection> m_connections;
     size_t m_max_sequential_size {4};
 };
 
@@ -58,6 +98,8 @@ void narrowphase::update_contact_manifolds(Iterator begin, Iterator end) {
     auto tr_view = m_registry->view<position, orientation>();
     auto origin_view = m_registry->view<origin>();
     auto vel_view = m_registry->view<angvel>();
+    auto linvel_view = m_registry->view<linvel>();
+    auto continuous_view = m_registry->view<continuous_contacts_tag>();
     auto rolling_view = m_registry->view<rolling_tag>();
     auto material_view = m_registry->view<material>();
     auto orn_view = m_registry->view<orientation>();
@@ -70,17 +112,26 @@ void narrowphase::update_contact_manifolds(Iterator begin, Iterator end) {
         entt::entity manifold_entity = *it;
         auto &manifold = manifold_view.template get<contact_manifold>(manifold_entity);
         auto &events = events_view.get<contact_manifold_events>(manifold_entity);
+        events = {};
+        update_contact_distances(manifold, tr_view, origin_view);
+
         collision_result result;
-        detect_collision(manifold.body, result, body_view, origin_view, views_tuple);
+        auto displacement = get_continuous_displacement(manifold.body, linvel_view, continuous_view, dt);
+        detect_collision(manifold.body, result, body_view, origin_view, views_tuple, displacement);
 
         process_collision(manifold_entity, manifold, events, result, tr_view, vel_view,
                           rolling_view, origin_view, orn_view, material_view,
-                          mesh_shape_view, paged_mesh_shape_view, dt,
+                          mesh_shape_view, paged_mesh_shape_view, dt, displacement,
                           [&](const collision_result::collision_point &rp) {
             create_contact_point(*m_registry, manifold_entity, manifold, rp);
         }, [&](auto pt_id) {
             destroy_contact_point(*m_registry, manifold_entity, pt_id);
         });
+
+        // Speculative points that started touching have created events.
+        if (events.num_contacts_created > 0) {
+            m_registry->patch<contact_manifold_events>(manifold_entity);
+        }
     }
 }
 
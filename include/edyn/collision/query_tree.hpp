@@ -1,20 +1,58 @@
 #ifndef EDYN_COLLISION_QUERY_TREE_HPP
 #define EDYN_COLLISION_QUERY_TREE_HPP
 
+#include <array>
+#include <vector>
+#include <cstddef>
 #include "edyn/comp/aabb.hpp"
 #include "edyn/math/geom.hpp"
 
 namespace edyn {
 
+/**
+ * @brief Stack used in tree traversals which keeps its first `N` elements in
+ * inline storage and only allocates memory if it grows beyond that, which
+ * does not happen in balanced trees of any practical size.
+ */
+template<typename T, size_t N>
+class traversal_stack {
+public:
+    void push(T value) {
+        if (m_size < N) {
+            m_inline[m_size++] = value;
+        } else {
+            m_overflow.push_back(value);
+        }
+    }
+
+    T pop() {
+        if (!m_overflow.empty()) {
+            auto value = m_overflow.back();
+            m_overflow.pop_back();
+            return value;
+        }
+
+        return m_inline[--m_size];
+    }
+
+    bool empty() const {
+        return m_size == 0;
+    }
+
+private:
+    std::array<T, N> m_inline;
+    std::vector<T> m_overflow;
+    size_t m_size {0};
+};
+
 template<typename Tree, typename NodeIdType, typename TestFunc, typename VisitFunc>
 void traverse_tree(const Tree &tree, NodeIdType root_id, NodeIdType null_node_id,
                    TestFunc test_func, VisitFunc visit_func) {
-    std::vector<NodeIdType> stack;
-    stack.push_back(root_id);
+    traversal_stack<NodeIdType, 64> stack;
+    stack.push(root_id);
 
     while (!stack.empty()) {
-        auto id = stack.back();
-        stack.pop_back();
+        auto id = stack.pop();
 
         if (id == null_node_id) {
             continue;
@@ -26,8 +64,8 @@ void traverse_tree(const Tree &tree, NodeIdType root_id, NodeIdType null_node_id
             if (node.leaf()) {
                 visit_func(id);
             } else {
-                stack.push_back(node.child1);
-                stack.push_back(node.child2);
+                stack.push(node.child1);
+                stack.push(node.child2);
             }
         }
     }
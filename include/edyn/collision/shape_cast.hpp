@@ -0,0 +1,101 @@
+#ifndef EDYN_COLLISION_SHAPE_CAST_HPP
+#define EDYN_COLLISION_SHAPE_CAST_HPP
+
+#include <limits>
+#include <vector>
+#include <variant>
+#include <entt/entity/registry.hpp>
+#include <entt/signal/delegate.hpp>
+#include "edyn/math/vector3.hpp"
+#include "edyn/math/quaternion.hpp"
+#include "edyn/shapes/sphere_shape.hpp"
+#include "edyn/shapes/capsule_shape.hpp"
+#include "edyn/shapes/box_shape.hpp"
+#include "edyn/shapes/polyhedron_shape.hpp"
+#include "edyn/collision/broadphase.hpp"
+#include "edyn/util/collision_util.hpp"
+
+namespace edyn {
+
+/**
+ * @brief Types of shapes which can be swept along a segment in a shape cast.
+ */
+using cast_shapes_variant_t = std::variant<
+    sphere_shape,
+    capsule_shape,
+    box_shape,
+    polyhedron_shape
+>;
+
+/**
+ * @brief Information returned from a shape cast query.
+ */
+struct shape_cast_result {
+    // Fraction of the segment where the shape first touches another. The
+    // shape is positioned at `lerp(p0, p1, fraction)` when that happens.
+    scalar fraction { EDYN_SCALAR_MAX };
+    // Normal vector of the surface that was hit, pointing towards the cast
+    // shape.
+    vector3 normal;
+    // Point of contact in world space, on the surface that was hit.
+    vector3 point;
+    // The entity that was hit. It's set to `entt::null` if no entity is hit.
+    entt::entity entity { entt::null };
+};
+
+using shape_cast_id_type = unsigned;
+static constexpr auto invalid_shape_cast_id = std::numeric_limits<shape_cast_id_type>::max();
+using shape_cast_delegate_type = entt::delegate<void(shape_cast_id_type, const shape_cast_result &)>;
+
+/**
+ * @brief Sweeps a shape along a segment against all rigid bodies. Do not call
+ * this if Edyn was initialized with `execution_mode::asynchronous`, use
+ * `shape_cast_async` instead.
+ * @param registry Data source.
+ * @param shape Shape to be cast.
+ * @param orn Orientation of the shape, which does not change along the cast.
+ * @param p0 Initial position of the shape.
+ * @param p1 Final position of the shape.
+ * @param ignore_entities Entities to be ignored during the cast.
+ * @return Result containing the first entity that was hit by the shape.
+ * Entities the shape is already touching at `p0` are only hit if the shape
+ * moves towards them.
+ */
+shape_cast_result shape_cast(entt::registry &registry, const cast_shapes_variant_t &shape,
+                             const quaternion &orn, vector3 p0, vector3 p1,
+                             const std::vector<entt::entity> &ignore_entities = {});
+
+/**
+ * @brief Performs a shape cast query asynchronously. Only call this function
+ * if Edyn was initialized in `execution_mode::asynchronous`. Requests made
+ * before the next simulation update are processed in parallel.
+ * @param registry Data source.
+ * @param shape Shape to be cast.
+ * @param orn Orientation of the shape, which does not change along the cast.
+ * @param p0 Initial position of the shape.
+ * @param p1 Final position of the shape.
+ * @param delegate Triggered when the results are available.
+ * @param ignore_entities Entities to be ignored during the cast.
+ * @return Request id, which will be passed to the delegate when it is invoked.
+ */
+shape_cast_id_type shape_cast_async(entt::registry &registry, const cast_shapes_variant_t &shape,
+                                    const quaternion &orn, vector3 p0, vector3 p1,
+                                    const shape_cast_delegate_type &delegate,
+                                    const std::vector<entt::entity> &ignore_entities = {});
+
+/**
+ * @brief Sweeps a shape along a segment against the rigid bodies in the
+ * broadphase using views that were obtained beforehand, which makes it safe
+ * to run multiple casts in parallel.
+ */
+shape_cast_result shape_cast(const broadphase &bphase,
+                             const detect_collision_body_view_t &body_view,
+                             const origin_view_t &origin_view,
+                             const tuple_of_shape_views_t &views_tuple,
+                             const cast_shapes_variant_t &shape,
+                             const quaternion &orn, vector3 p0, vector3 p1,
+                             const std::vector<entt::entity> &ignore_entities);
+
+}
+
+#endif // EDYN_COLLISION_SHAPE_CAST_HPP
@@ -0,0 +1,53 @@
+#ifndef EDYN_COLLISION_SHAPE_CAST_SERVICE_HPP
+#define EDYN_COLLISION_SHAPE_CAST_SERVICE_HPP
+
+#include "edyn/collision/shape_cast.hpp"
+#include "edyn/math/vector3.hpp"
+#include "edyn/math/quaternion.hpp"
+#include <entt/entity/fwd.hpp>
+#include <vector>
+
+namespace edyn {
+
+/**
+ * @brief Accumulates shape cast requests and processes them in a batch, in
+ * parallel if there are many of them.
+ */
+class shape_cast_service {
+    struct cast_context {
+        unsigned id;
+        cast_shapes_variant_t shape;
+        quaternion orn;
+        vector3 p0, p1;
+        std::vector<entt::entity> ignore_entities;
+        shape_cast_result result;
+    };
+
+public:
+    shape_cast_service(entt::registry &registry);
+
+    void add_cast(const cast_shapes_variant_t &shape, const quaternion &orn,
+                  vector3 p0, vector3 p1, unsigned id,
+                  const std::vector<entt::entity> &ignore_entities) {
+        m_ctx.push_back(cast_context{id, shape, orn, p0, p1, ignore_entities});
+    }
+
+    void update(bool mt);
+
+    template<typename Func>
+    void consume_results(Func func) {
+        for (auto &ctx : m_ctx) {
+            func(ctx.id, ctx.result);
+        }
+        m_ctx.clear();
+    }
+
+private:
+    entt::registry *m_registry;
+    std::vector<cast_context> m_ctx;
+    size_t m_max_sequential_size {4};
+};
+
+}
+
+#endif // EDYN_COLLISION_SHAPE_CAST_SERVICE_HPP
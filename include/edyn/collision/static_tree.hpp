@@ -2,157 +2,376 @@
 #define EDYN_COLLISION_STATIC_TREE_HPP
 
 #include "edyn/comp/aabb.hpp"
+#include "edyn/math/geom.hpp"
+#include "edyn/config/config.h"
+#include <array>
+#include <cmath>
 #include <vector>
-#include <iterator>
+#include <cstdint>
 #include <numeric>
 #include <algorithm>
-#include "edyn/collision/query_tree.hpp"
 
 namespace edyn {
 
 constexpr uint32_t EDYN_NULL_NODE = UINT32_MAX;
 
 namespace detail {
-    template<typename Iterator_AABB, typename Iterator_ids>
-    Iterator_ids aabb_set_partition(Iterator_AABB aabb_begin, Iterator_AABB aabb_end,
-                                    Iterator_ids ids_begin, Iterator_ids ids_end,
-                                    const AABB &set_aabb) {
-        auto aabb_size = set_aabb.max - set_aabb.min;
-        auto split_axis_idx = max_index(aabb_size);
-        auto split_pos = set_aabb.center()[split_axis_idx];
-
-        std::sort(ids_begin, ids_end, [&](auto a, auto b) {
-            auto &b0 = *(aabb_begin + a);
-            auto &b1 = *(aabb_begin + b);
-            auto ca = b0.center();
-            auto cb = b1.center();
-            return ca[split_axis_idx] < cb[split_axis_idx];
-        });
-
-        for (auto it = ids_begin; it != ids_end; ++it) {
-            auto &aabb = *(aabb_begin + *it);
-            auto center = aabb.center();
-
-            if (center[split_axis_idx] > split_pos) {
-                return it;
-            }
+    // Node of the intermediate binary tree created during construction of a
+    // `static_tree`. Leaves hold a range of the primitive ids.
+    struct static_tree_build_node {
+        AABB aabb;
+        uint32_t child1;
+        uint32_t child2;
+        uint32_t begin;
+        uint32_t end;
+
+        bool leaf() const {
+            return child1 == EDYN_NULL_NODE;
         }
+    };
 
-        return ids_begin + std::distance(ids_begin, ids_end) / 2;
-    }
+    /**
+     * @brief Builds a binary tree over a set of AABBs using a binned surface
+     * area heuristic. Large sets are built in parallel using the global job
+     * dispatcher.
+     * @param aabbs AABBs of primitives.
+     * @param ids Primitive ids, i.e. indices into `aabbs`. They're reordered
+     * so that the ids of each leaf are contiguous.
+     * @param max_obj_per_leaf Maximum number of primitives in a leaf.
+     * @return Tree nodes where the root is the first.
+     */
+    std::vector<static_tree_build_node> build_static_tree(const std::vector<AABB> &aabbs,
+                                                          std::vector<uint32_t> &ids,
+                                                          uint32_t max_obj_per_leaf);
 }
 
+/**
+ * An immutable bounding volume hierarchy. Nodes are stored in depth-first
+ * order, thus the first child of a node is always the next node, and each
+ * node stores the index of the node that follows its subtree, which allows
+ * traversal without a stack. Node bounds are quantized to 16 bits in the
+ * space of the root AABB, which roughly halves the size of a node.
+ */
 class static_tree {
 public:
+    using quantized_vector = std::array<uint16_t, 3>;
+
     struct tree_node {
-        AABB aabb;
-        uint32_t child1;
-        union {
-            uint32_t child2;
-            uint32_t id;
-        };
+        quantized_vector min;
+        quantized_vector max;
+        // Index of the node following the subtree rooted at this node.
+        uint32_t skip;
+        // Leaf identifier assigned in the `report_leaf` function during
+        // construction. It is null for internal nodes.
+        uint32_t id;
 
         bool leaf() const {
-            return child1 == EDYN_NULL_NODE;
+            return id != EDYN_NULL_NODE;
         }
     };
 
     AABB root_aabb() const {
         EDYN_ASSERT(!m_nodes.empty());
-        return m_nodes.front().aabb;
+        return m_root_aabb;
     }
 
     bool empty() const {
         return m_nodes.empty();
     }
 
+    size_t size() const {
+        return m_nodes.size();
+    }
+
     const tree_node & get_node(uint32_t id) const {
         return m_nodes[id];
     }
 
+    /**
+     * @brief Conservative bounds of a node.
+     * @param id Node index.
+     * @return An AABB which contains all primitives in the subtree.
+     */
+    AABB get_node_aabb(uint32_t id) const;
+
+    /**
+     * @brief Visits all leaves which intersect the given AABB.
+     * @param aabb Query AABB.
+     * @param func Function called with the index of each leaf node.
+     */
     template<typename Func>
     void query(const AABB &aabb, Func func) const;
 
+    /**
+     * @brief Visits all leaves whose bounds intersect the given segment.
+     * @param p0 First point in segment.
+     * @param p1 Second point in segment.
+     * @param func Function called with the index of each leaf node.
+     */
     template<typename Func>
     void raycast(vector3 p0, vector3 p1, Func func) const;
 
+    /**
+     * @brief Builds the tree over a range of AABBs.
+     * @param aabb_begin Begin iterator of AABBs.
+     * @param aabb_end End iterator of AABBs.
+     * @param report_leaf Function called for each leaf with the node and a
+     * range of primitive ids. It must assign the node `id`.
+     * @param max_obj_per_leaf Maximum number of primitives in a leaf.
+     */
     template<typename Iterator, typename Func>
-    void build(Iterator aabb_begin, Iterator aabb_end, Func &report_leaf, uint32_t max_obj_per_leaf = 1) {
-        EDYN_ASSERT(aabb_begin != aabb_end);
-
-        auto count = std::distance(aabb_begin, aabb_end);
-        std::vector<uint32_t> ids(count);
-        std::iota(ids.begin(), ids.end(), 0);
-
-        // Insert root node.
-        m_nodes.emplace_back();
+    void build(Iterator aabb_begin, Iterator aabb_end, Func &report_leaf, uint32_t max_obj_per_leaf = 1);
+
+    /**
+     * @brief Builds a tree with the given layout, which is faster than
+     * `build` since split candidates are not evaluated. Node bounds are
+     * calculated from the bounds of the leaves. Used to recreate a tree that
+     * was built earlier.
+     * @param is_leaf Whether each node is a leaf, in depth-first order.
+     * @param leaf_ids Id of each leaf, in depth-first order.
+     * @param leaf_aabb Function that returns the AABB of a leaf given its id.
+     * @return False if the layout does not describe a valid tree.
+     */
+    template<typename Func>
+    bool build_from_layout(const std::vector<bool> &is_leaf, const std::vector<uint32_t> &leaf_ids,
+                           Func leaf_aabb);
 
-        recurse_build(aabb_begin, aabb_end, ids.begin(), ids.end(),
-                      0, report_leaf, max_obj_per_leaf);
+    void clear() {
+        m_nodes.clear();
     }
 
-    template<typename Iterator_AABB, typename Iterator_ids, typename Func>
-    void recurse_build(Iterator_AABB aabb_begin, Iterator_AABB aabb_end,
-                       Iterator_ids ids_begin, Iterator_ids ids_end,
-                       size_t node_idx, Func &report_leaf,
-                       uint32_t max_obj_per_leaf) {
-        EDYN_ASSERT(aabb_begin != aabb_end);
+    template<typename Archive>
+    friend void serialize(Archive &archive, static_tree &tree);
+    friend size_t serialization_sizeof(const static_tree &tree);
 
-        AABB set_aabb = *(aabb_begin + *ids_begin);
+private:
+    static constexpr scalar quantization_range = scalar(UINT16_MAX);
 
-        for (auto it = ids_begin + 1; it != ids_end; ++it) {
-            set_aabb = enclosing_aabb(set_aabb, *(aabb_begin + *it));
-        }
+    // Factor that maps offsets from the root AABB into quantized units.
+    vector3 quantization_factor() const {
+        auto extent = m_root_aabb.max - m_root_aabb.min;
+        auto factor = vector3_zero;
 
-        auto &node = m_nodes[node_idx];
-        node.aabb = set_aabb;
+        for (size_t i = 0; i < 3; ++i) {
+            if (extent[i] > scalar(0)) {
+                factor[i] = quantization_range / extent[i];
+            }
+        }
 
-        auto count = std::distance(ids_begin, ids_end);
+        return factor;
+    }
 
-        if (count <= max_obj_per_leaf) {
-            node.child1 = EDYN_NULL_NODE;
-            report_leaf(node, ids_begin, ids_end);
-        } else {
-            auto ids_middle = detail::aabb_set_partition(aabb_begin, aabb_end, ids_begin, ids_end, set_aabb);
+    // Quantization is monotonic, thus rounding minimums down and maximums
+    // up gives bounds that compare conservatively.
+    quantized_vector quantize_min(const vector3 &v, const vector3 &factor) const {
+        auto q = quantized_vector{};
 
-            auto child1 = m_nodes.size();
-            auto child2 = m_nodes.size() + 1;
+        for (size_t i = 0; i < 3; ++i) {
+            auto s = std::clamp((v[i] - m_root_aabb.min[i]) * factor[i], scalar(0), quantization_range);
+            q[i] = static_cast<uint16_t>(std::floor(s));
+        }
 
-            node.child1 = child1;
-            node.child2 = child2;
+        return q;
+    }
 
-            m_nodes.emplace_back();
-            m_nodes.emplace_back();
+    quantized_vector quantize_max(const vector3 &v, const vector3 &factor) const {
+        auto q = quantized_vector{};
 
-            recurse_build(aabb_begin, aabb_end, ids_begin, ids_middle,
-                          child1, report_leaf, max_obj_per_leaf);
-            recurse_build(aabb_begin, aabb_end, ids_middle, ids_end,
-                          child2, report_leaf, max_obj_per_leaf);
+        for (size_t i = 0; i < 3; ++i) {
+            auto s = std::clamp((v[i] - m_root_aabb.min[i]) * factor[i], scalar(0), quantization_range);
+            q[i] = static_cast<uint16_t>(std::ceil(s));
         }
-    }
 
-    void clear() {
-        m_nodes.clear();
+        return q;
     }
 
-    template<typename Archive>
-    friend void serialize(Archive &archive, static_tree &tree);
-    friend size_t serialization_sizeof(const static_tree &tree);
-
-private:
+    AABB m_root_aabb;
     std::vector<tree_node> m_nodes;
 };
 
+inline AABB static_tree::get_node_aabb(uint32_t id) const {
+    auto &node = m_nodes[id];
+    auto extent = m_root_aabb.max - m_root_aabb.min;
+    auto unit = extent / quantization_range;
+    auto aabb = AABB{};
+
+    // Expand by one unit to account for rounding errors.
+    for (size_t i = 0; i < 3; ++i) {
+        aabb.min[i] = m_root_aabb.min[i] + unit[i] * (scalar(node.min[i]) - scalar(1));
+        aabb.max[i] = m_root_aabb.min[i] + unit[i] * (scalar(node.max[i]) + scalar(1));
+    }
+
+    return aabb;
+}
+
 template<typename Func>
 void static_tree::query(const AABB &aabb, Func func) const {
-    uint32_t root_node_idx = 0;
-    query_tree(*this, root_node_idx, EDYN_NULL_NODE, aabb, func);
+    if (m_nodes.empty() || !intersect(m_root_aabb, aabb)) {
+        return;
+    }
+
+    auto factor = quantization_factor();
+    auto qmin = quantize_min(aabb.min, factor);
+    auto qmax = quantize_max(aabb.max, factor);
+    auto num_nodes = static_cast<uint32_t>(m_nodes.size());
+    uint32_t idx = 0;
+
+    while (idx < num_nodes) {
+        auto &node = m_nodes[idx];
+        auto overlaps =
+            node.min[0] <= qmax[0] && node.max[0] >= qmin[0] &&
+            node.min[1] <= qmax[1] && node.max[1] >= qmin[1] &&
+            node.min[2] <= qmax[2] && node.max[2] >= qmin[2];
+
+        if (overlaps) {
+            if (node.leaf()) {
+                func(idx);
+            }
+
+            ++idx;
+        } else {
+            idx = node.skip;
+        }
+    }
 }
 
 template<typename Func>
 void static_tree::raycast(vector3 p0, vector3 p1, Func func) const {
-    uint32_t root_node_idx = 0;
-    raycast_tree(*this, root_node_idx, EDYN_NULL_NODE, p0, p1, func);
+    auto num_nodes = static_cast<uint32_t>(m_nodes.size());
+    uint32_t idx = 0;
+
+    while (idx < num_nodes) {
+        auto &node = m_nodes[idx];
+        auto aabb = get_node_aabb(idx);
+
+        if (intersect_segment_aabb(p0, p1, aabb.min, aabb.max)) {
+            if (node.leaf()) {
+                func(idx);
+            }
+
+            ++idx;
+        } else {
+            idx = node.skip;
+        }
+    }
+}
+
+template<typename Iterator, typename Func>
+void static_tree::build(Iterator aabb_begin, Iterator aabb_end, Func &report_leaf, uint32_t max_obj_per_leaf) {
+    EDYN_ASSERT(aabb_begin != aabb_end);
+    EDYN_ASSERT(max_obj_per_leaf > 0);
+
+    auto aabbs = std::vector<AABB>(aabb_begin, aabb_end);
+    auto ids = std::vector<uint32_t>(aabbs.size());
+    std::iota(ids.begin(), ids.end(), 0);
+
+    auto build_nodes = detail::build_static_tree(aabbs, ids, max_obj_per_leaf);
+
+    m_root_aabb = build_nodes.front().aabb;
+    auto factor = quantization_factor();
+
+    // Flatten in depth-first order. Reserve to keep references valid while
+    // calling `report_leaf`.
+    m_nodes.clear();
+    m_nodes.reserve(build_nodes.size());
+
+    auto stack = std::vector<uint32_t>{};
+    stack.push_back(0);
+
+    while (!stack.empty()) {
+        auto &build_node = build_nodes[stack.back()];
+        stack.pop_back();
+
+        auto &node = m_nodes.emplace_back();
+        node.min = quantize_min(build_node.aabb.min, factor);
+        node.max = quantize_max(build_node.aabb.max, factor);
+
+        if (build_node.leaf()) {
+            node.id = 0;
+            report_leaf(node, ids.begin() + build_node.begin, ids.begin() + build_node.end);
+            EDYN_ASSERT(node.id != EDYN_NULL_NODE);
+        } else {
+            node.id = EDYN_NULL_NODE;
+            stack.push_back(build_node.child2);
+            stack.push_back(build_node.child1);
+        }
+    }
+
+    // Assign skip indices bottom-up. The first child of an internal node is
+    // the next node and the second child is the node following the first
+    // child's subtree.
+    for (auto i = m_nodes.size(); i > 0; --i) {
+        auto idx = static_cast<uint32_t>(i - 1);
+        auto &node = m_nodes[idx];
+
+        if (node.leaf()) {
+            node.skip = idx + 1;
+        } else {
+            auto child2 = m_nodes[idx + 1].skip;
+            node.skip = m_nodes[child2].skip;
+        }
+    }
+}
+
+template<typename Func>
+bool static_tree::build_from_layout(const std::vector<bool> &is_leaf, const std::vector<uint32_t> &leaf_ids,
+                                    Func leaf_aabb) {
+    m_nodes.clear();
+
+    auto num_nodes = is_leaf.size();
+
+    // A binary tree with `n` leaves has `2n - 1` nodes.
+    if (num_nodes == 0 || num_nodes != leaf_ids.size() * 2 - 1) {
+        return false;
+    }
+
+    m_nodes.resize(num_nodes);
+    auto aabbs = std::vector<AABB>(num_nodes);
+    auto leaf_idx = leaf_ids.size();
+
+    // Assign skip indices and bounds bottom-up, as in `build`.
+    for (auto i = num_nodes; i > 0; --i) {
+        auto idx = static_cast<uint32_t>(i - 1);
+        auto &node = m_nodes[idx];
+
+        if (is_leaf[idx]) {
+            if (leaf_idx == 0) {
+                m_nodes.clear();
+                return false;
+            }
+
+            node.id = leaf_ids[--leaf_idx];
+            node.skip = idx + 1;
+            aabbs[idx] = leaf_aabb(node.id);
+        } else {
+            auto child2 = idx + 1 < num_nodes ? m_nodes[idx + 1].skip : num_nodes;
+
+            if (child2 >= num_nodes) {
+                m_nodes.clear();
+                return false;
+            }
+
+            node.id = EDYN_NULL_NODE;
+            node.skip = m_nodes[child2].skip;
+            aabbs[idx] = enclosing_aabb(aabbs[idx + 1], aabbs[child2]);
+        }
+    }
+
+    // The root must span all nodes.
+    if (leaf_idx != 0 || m_nodes.front().skip != num_nodes) {
+        m_nodes.clear();
+        return false;
+    }
+
+    m_root_aabb = aabbs.front();
+    auto factor = quantization_factor();
+
+    for (size_t i = 0; i < num_nodes; ++i) {
+        m_nodes[i].min = quantize_min(aabbs[i].min, factor);
+        m_nodes[i].max = quantize_max(aabbs[i].max, factor);
+    }
+
+    return true;
 }
 
 }
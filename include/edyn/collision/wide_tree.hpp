@@ -0,0 +1,183 @@
+#ifndef EDYN_COLLISION_WIDE_TREE_HPP
+#define EDYN_COLLISION_WIDE_TREE_HPP
+
+#include <vector>
+#include <cstdint>
+#include "edyn/comp/aabb.hpp"
+#include "edyn/math/geom.hpp"
+#include "edyn/collision/tree_node.hpp"
+#include "edyn/collision/query_tree.hpp"
+
+#if defined(EDYN_DOUBLE_PRECISION)
+    #if defined(__AVX__)
+        #include <immintrin.h>
+        #define EDYN_WIDE_TREE_AVX
+    #endif
+#else
+    #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #include <xmmintrin.h>
+        #define EDYN_WIDE_TREE_SSE
+    #endif
+#endif
+
+namespace edyn {
+
+/**
+ * Node of a `wide_tree` holding the bounds of up to four children in
+ * structure-of-arrays layout, so they can be tested against a query with a
+ * single SIMD instruction per comparison.
+ */
+struct alignas(sizeof(scalar) * 4) wide_tree_node {
+    static constexpr unsigned width = 4;
+
+    scalar min_x[width];
+    scalar min_y[width];
+    scalar min_z[width];
+    scalar max_x[width];
+    scalar max_y[width];
+    scalar max_z[width];
+
+    // Index of child node, or id of leaf in the source tree with the
+    // `leaf_flag` set, or null for unused slots. Unused slots have inverted
+    // bounds which never overlap anything.
+    tree_node_id_t child[width];
+};
+
+/**
+ * @brief A 4-ary bounding volume hierarchy obtained by collapsing the nodes
+ * of a binary `dynamic_tree`. It has half the depth of the source tree and
+ * tests four children at once, thus it is faster to query, but it must be
+ * rebuilt whenever the source tree changes.
+ */
+class wide_tree final {
+public:
+    static constexpr tree_node_id_t leaf_flag = tree_node_id_t(1) << 31;
+
+    /**
+     * @brief Rebuilds this tree from a binary tree.
+     * @param nodes Nodes of the binary tree.
+     * @param root Id of the root node of the binary tree.
+     */
+    void build(const std::vector<tree_node> &nodes, tree_node_id_t root);
+
+    /**
+     * @brief Call `func` with the id of all leaves of the source tree that
+     * overlap `aabb`.
+     */
+    template<typename Func>
+    void query(const AABB &aabb, Func func) const;
+
+    /**
+     * @brief Call `func` with the id of all leaves of the source tree that
+     * intersect the segment [p0, p1].
+     */
+    template<typename Func>
+    void raycast(vector3 p0, vector3 p1, Func func) const;
+
+    void clear() {
+        m_nodes.clear();
+    }
+
+private:
+    // Bit mask with the i-th bit set if the i-th child overlaps `aabb`.
+    static unsigned overlap_mask(const wide_tree_node &node, const AABB &aabb);
+
+    template<typename TestFunc, typename VisitFunc>
+    void traverse(TestFunc test_func, VisitFunc visit_func) const;
+
+    std::vector<wide_tree_node> m_nodes;
+    std::vector<std::pair<tree_node_id_t, tree_node_id_t>> m_build_stack;
+};
+
+inline unsigned wide_tree::overlap_mask(const wide_tree_node &node, const AABB &aabb) {
+#if defined(EDYN_WIDE_TREE_SSE)
+    auto mask = _mm_and_ps(_mm_cmple_ps(_mm_load_ps(node.min_x), _mm_set1_ps(aabb.max.x)),
+                           _mm_cmpge_ps(_mm_load_ps(node.max_x), _mm_set1_ps(aabb.min.x)));
+    mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_load_ps(node.min_y), _mm_set1_ps(aabb.max.y)));
+    mask = _mm_and_ps(mask, _mm_cmpge_ps(_mm_load_ps(node.max_y), _mm_set1_ps(aabb.min.y)));
+    mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_load_ps(node.min_z), _mm_set1_ps(aabb.max.z)));
+    mask = _mm_and_ps(mask, _mm_cmpge_ps(_mm_load_ps(node.max_z), _mm_set1_ps(aabb.min.z)));
+    return static_cast<unsigned>(_mm_movemask_ps(mask));
+#elif defined(EDYN_WIDE_TREE_AVX)
+    auto mask = _mm256_and_pd(_mm256_cmp_pd(_mm256_load_pd(node.min_x), _mm256_set1_pd(aabb.max.x), _CMP_LE_OQ),
+                              _mm256_cmp_pd(_mm256_load_pd(node.max_x), _mm256_set1_pd(aabb.min.x), _CMP_GE_OQ));
+    mask = _mm256_and_pd(mask, _mm256_cmp_pd(_mm256_load_pd(node.min_y), _mm256_set1_pd(aabb.max.y), _CMP_LE_OQ));
+    mask = _mm256_and_pd(mask, _mm256_cmp_pd(_mm256_load_pd(node.max_y), _mm256_set1_pd(aabb.min.y), _CMP_GE_OQ));
+    mask = _mm256_and_pd(mask, _mm256_cmp_pd(_mm256_load_pd(node.min_z), _mm256_set1_pd(aabb.max.z), _CMP_LE_OQ));
+    mask = _mm256_and_pd(mask, _mm256_cmp_pd(_mm256_load_pd(node.max_z), _mm256_set1_pd(aabb.min.z), _CMP_GE_OQ));
+    return static_cast<unsigned>(_mm256_movemask_pd(mask));
+#else
+    unsigned mask = 0;
+
+    for (unsigned i = 0; i < wide_tree_node::width; ++i) {
+        auto overlaps =
+            node.min_x[i] <= aabb.max.x && node.max_x[i] >= aabb.min.x &&
+            node.min_y[i] <= aabb.max.y && node.max_y[i] >= aabb.min.y &&
+            node.min_z[i] <= aabb.max.z && node.max_z[i] >= aabb.min.z;
+        mask |= unsigned(overlaps) << i;
+    }
+
+    return mask;
+#endif
+}
+
+template<typename TestFunc, typename VisitFunc>
+void wide_tree::traverse(TestFunc test_func, VisitFunc visit_func) const {
+    if (m_nodes.empty()) {
+        return;
+    }
+
+    traversal_stack<tree_node_id_t, 64> stack;
+    stack.push(0);
+
+    while (!stack.empty()) {
+        auto &node = m_nodes[stack.pop()];
+        auto mask = test_func(node);
+
+        for (unsigned i = 0; i < wide_tree_node::width; ++i) {
+            if ((mask & (1u << i)) == 0) {
+                continue;
+            }
+
+            auto child = node.child[i];
+
+            if (child == null_tree_node_id) {
+                continue;
+            }
+
+            if (child & leaf_flag) {
+                visit_func(child & ~leaf_flag);
+            } else {
+                stack.push(child);
+            }
+        }
+    }
+}
+
+template<typename Func>
+void wide_tree::query(const AABB &aabb, Func func) const {
+    traverse([&](const wide_tree_node &node) {
+        return overlap_mask(node, aabb);
+    }, func);
+}
+
+template<typename Func>
+void wide_tree::raycast(vector3 p0, vector3 p1, Func func) const {
+    traverse([&](const wide_tree_node &node) {
+        unsigned mask = 0;
+
+        for (unsigned i = 0; i < wide_tree_node::width; ++i) {
+            if (node.child[i] != null_tree_node_id) {
+                auto min = vector3{node.min_x[i], node.min_y[i], node.min_z[i]};
+                auto max = vector3{node.max_x[i], node.max_y[i], node.max_z[i]};
+                mask |= unsigned(intersect_segment_aabb(p0, p1, min, max)) << i;
+            }
+        }
+
+        return mask;
+    }, func);
+}
+
+}
+
+#endif // EDYN_COLLISION_WIDE_TREE_HPP
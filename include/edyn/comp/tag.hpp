@@ -71,6 +71,14 @@ struct disabled_tag {};
  */
 struct rolling_tag {};
 
+/**
+ * A fast moving rigid body which must not tunnel through other bodies. Its
+ * AABB is swept over its displacement in each step and speculative
+ * contacts are generated for its pairs ahead of time, thus contact points
+ * might be created before the bodies touch.
+ */
+struct continuous_contacts_tag {};
+
 /**
  * An entity that was created externally and tagged via
  * `edyn::tag_external_entity` (i.e. it doesn't represent any of the internal
@@ -0,0 +1,35 @@
+#ifndef EDYN_CONFIG_DETERMINISM_CONFIG_HPP
+#define EDYN_CONFIG_DETERMINISM_CONFIG_HPP
+
+#include <entt/entity/fwd.hpp>
+
+namespace edyn {
+
+/**
+ * @brief Enable or disable deterministic mode. When enabled, contact
+ * manifolds, island constraints and bodies are processed in a canonical
+ * order, thus two simulations with the same initial state, the same
+ * identifiers for bodies and constraints and the same inputs produce
+ * bit-for-bit identical results, regardless of the history of their pools,
+ * of the identifiers assigned to contact manifolds or of the number of
+ * workers.
+ * Parallel stages keep running in parallel.
+ * @remark In asynchronous execution mode, the number of steps taken in
+ * each update depends on timing. Use `edyn::step_simulation` with a paused
+ * simulation, or a sequential execution mode, to control when steps happen.
+ * Use `edyn::hash_state` to compare simulations.
+ * @param registry Data source.
+ * @param deterministic Whether to enable deterministic mode.
+ */
+void set_deterministic(entt::registry &registry, bool deterministic);
+
+/**
+ * @brief Check whether deterministic mode is enabled.
+ * @param registry Data source.
+ * @return Whether deterministic mode is enabled.
+ */
+bool is_deterministic(const entt::registry &registry);
+
+}
+
+#endif // EDYN_CONFIG_DETERMINISM_CONFIG_HPP
@@ -0,0 +1,40 @@
+#ifndef EDYN_CONFIG_PROFILING_CONFIG_HPP
+#define EDYN_CONFIG_PROFILING_CONFIG_HPP
+
+#include <cstddef>
+#include <entt/entity/fwd.hpp>
+#include "edyn/context/step_stats.hpp"
+
+namespace edyn {
+
+/**
+ * @brief Enable or disable recording of timings and statistics of each
+ * simulation step. When enabled, a `step_stats_history` is assigned to the
+ * registry context, which holds the stats of the most recent steps.
+ * @remark Edyn must be built with `EDYN_ENABLE_PROFILING`, otherwise the
+ * instrumentation is compiled out and no stats are recorded.
+ * @param registry Data source.
+ * @param enabled Whether to record stats.
+ * @param history_size Maximum number of steps kept in the history.
+ */
+void set_profiling_enabled(entt::registry &registry, bool enabled, size_t history_size = 120);
+
+/**
+ * @brief Check whether profiling is enabled.
+ * @param registry Data source.
+ * @return Whether profiling is enabled.
+ */
+bool is_profiling_enabled(const entt::registry &registry);
+
+/**
+ * @brief Get the stats of the most recent simulation steps. In asynchronous
+ * mode, the stats are received from the simulation worker along with the
+ * state updates, thus they are only available after calls to `edyn::update`.
+ * @param registry Data source.
+ * @return Stats history or null if profiling is disabled.
+ */
+const step_stats_history * get_step_stats(const entt::registry &registry);
+
+}
+
+#endif // EDYN_CONFIG_PROFILING_CONFIG_HPP
@@ -65,6 +65,26 @@ unsigned get_solver_individual_restitution_iterations(const entt::registry &regi
  */
 void set_solver_individual_restitution_iterations(entt::registry &registry, unsigned iterations);
 
+/**
+ * @brief Get the minimum number of constraints in an island for it to be
+ * solved using colored Gauss-Seidel.
+ * @param registry Data source.
+ * @return Island coloring threshold.
+ */
+unsigned get_solver_island_coloring_threshold(const entt::registry &registry);
+
+/**
+ * @brief Set the minimum number of constraints in an island for it to be
+ * solved using colored Gauss-Seidel, which partitions its constraints into
+ * batches that can be solved in parallel and using SIMD instructions.
+ * @param registry Data source.
+ * @param threshold Minimum number of constraints. Zero disables it.
+ * @param deterministic Whether to assign colors in a canonical order which
+ * does not depend on the order of constraints in their pools.
+ */
+void set_solver_island_coloring_threshold(entt::registry &registry, unsigned threshold,
+                                          bool deterministic = true);
+
 }
 
 #endif // EDYN_CONFIG_SOLVER_ITERATION_CONFIG_HPP
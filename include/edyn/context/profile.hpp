@@ -0,0 +1,101 @@
+#ifndef EDYN_CONTEXT_PROFILE_HPP
+#define EDYN_CONTEXT_PROFILE_HPP
+
+#include <array>
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <entt/entity/fwd.hpp>
+#include "edyn/build_settings.h"
+#include "edyn/context/step_stats.hpp"
+
+namespace edyn {
+
+/**
+ * Accumulates measurements of the step being simulated. It is assigned to
+ * the context of the registry where the simulation runs, i.e. the main
+ * registry in sequential modes and the simulation worker's registry in
+ * asynchronous mode, only while profiling is enabled in the settings. Times
+ * can be added from multiple threads.
+ */
+class step_profiler {
+public:
+    void begin_step(double timestamp);
+    void end_step(entt::registry &registry);
+
+    void add_time(profile_stage stage, uint64_t counter_delta) {
+        m_stage_counter[static_cast<size_t>(stage)].fetch_add(counter_delta, std::memory_order_relaxed);
+    }
+
+    void add_tree_moves(unsigned count) {
+        m_num_tree_moves.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    // Stats of steps which ended and are yet to be published into the
+    // `step_stats_history` of the main registry.
+    std::vector<step_stats> finished;
+
+private:
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(profile_stage::count)> m_stage_counter {};
+    std::atomic<unsigned> m_num_tree_moves {0};
+    double m_timestamp {0};
+    uint64_t m_start_counter {0};
+    double m_start_busy_time {0};
+};
+
+/**
+ * Adds the time elapsed between construction and destruction to a stage of
+ * the current step. Does nothing if profiling is disabled in the settings.
+ */
+class profile_scope {
+public:
+    profile_scope(entt::registry &registry, profile_stage stage);
+    ~profile_scope();
+
+    profile_scope(const profile_scope &) = delete;
+    profile_scope & operator=(const profile_scope &) = delete;
+
+private:
+    step_profiler *m_profiler;
+    profile_stage m_stage;
+    uint64_t m_start_counter;
+};
+
+namespace internal {
+    // Assigns or removes the `step_profiler` according to the settings and
+    // starts measuring a new step.
+    void profile_begin_step(entt::registry &registry, double timestamp);
+
+    // Finishes measuring the current step.
+    void profile_end_step(entt::registry &registry);
+
+    void profile_tree_moves(entt::registry &registry, unsigned count);
+
+    // Moves finished step stats into the `step_stats_history` of the registry,
+    // or returns them to be sent to the main thread.
+    void publish_step_stats(entt::registry &registry);
+    std::vector<step_stats> take_step_stats(entt::registry &registry);
+
+    // Inserts step stats computed elsewhere into the `step_stats_history`.
+    void push_step_stats(entt::registry &registry, const std::vector<step_stats> &stats);
+}
+
+}
+
+#define EDYN_PROFILE_CONCAT_IMPL(a, b) a##b
+#define EDYN_PROFILE_CONCAT(a, b) EDYN_PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef EDYN_ENABLE_PROFILING
+    #define EDYN_PROFILE_SCOPE(registry, stage) \
+        ::edyn::profile_scope EDYN_PROFILE_CONCAT(edyn_profile_scope_, __LINE__)(registry, stage)
+    #define EDYN_PROFILE_BEGIN_STEP(registry, timestamp) ::edyn::internal::profile_begin_step(registry, timestamp)
+    #define EDYN_PROFILE_END_STEP(registry) ::edyn::internal::profile_end_step(registry)
+    #define EDYN_PROFILE_TREE_MOVES(registry, count) ::edyn::internal::profile_tree_moves(registry, count)
+#else
+    #define EDYN_PROFILE_SCOPE(registry, stage) (void)0
+    #define EDYN_PROFILE_BEGIN_STEP(registry, timestamp) (void)0
+    #define EDYN_PROFILE_END_STEP(registry) (void)0
+    #define EDYN_PROFILE_TREE_MOVES(registry, count) (void)(count)
+#endif
+
+#endif // EDYN_CONTEXT_PROFILE_HPP
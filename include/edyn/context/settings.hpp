@@ -24,6 +24,31 @@ struct settings {
     unsigned num_restitution_iterations {8};
     unsigned num_individual_restitution_iterations {3};
 
+    // Islands with at least this many constraints are solved using colored
+    // Gauss-Seidel, where rows are solved in SIMD blocks and, when running
+    // multi-threaded, a single large island is solved by multiple workers.
+    // Zero disables it.
+    unsigned island_coloring_threshold {512};
+    // Whether to color constraints in a canonical order, which makes results
+    // independent of the order of constraints in their pools.
+    bool deterministic_island_coloring {true};
+
+    // Whether to process contact manifolds, island constraints and bodies in
+    // a canonical order, which makes results depend only on the simulation
+    // state and entity identifiers, regardless of the order of entities in
+    // their pools or of the number of worker threads.
+    bool deterministic {false};
+
+    // How far ahead in time the bounds of awake bodies are extrapolated using
+    // their linear velocity to start loading pages of paged triangle meshes
+    // before they're touched. Zero disables prefetching, which is the default
+    // since it takes a pass over all awake bodies every step.
+    scalar paged_mesh_prefetch_time {scalar(0)};
+
+    // Record timings and statistics of each step. Has no effect unless Edyn
+    // is built with `EDYN_ENABLE_PROFILING`.
+    bool profiling_enabled {false};
+
     edyn::execution_mode execution_mode;
 
     init_callback_t init_callback {nullptr};
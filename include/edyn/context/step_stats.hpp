@@ -0,0 +1,130 @@
+#ifndef EDYN_CONTEXT_STEP_STATS_HPP
+#define EDYN_CONTEXT_STEP_STATS_HPP
+
+#include <array>
+#include <vector>
+#include <cstddef>
+#include "edyn/config/config.h"
+
+namespace edyn {
+
+/**
+ * @brief Stages of a simulation step which are timed when profiling.
+ */
+enum class profile_stage {
+    broadphase,
+    island_manager,
+    narrowphase,
+    restitution,
+    constraint_preparation,
+    island_solver,
+    // Summed over all islands, which are solved in parallel when running
+    // multi-threaded, thus it can be greater than the `island_solver` time.
+    position_iterations,
+    update_aabbs,
+    count
+};
+
+const char * profile_stage_name(profile_stage stage);
+
+/**
+ * @brief Measurements taken during one simulation step.
+ */
+struct step_stats {
+    // Simulation time at the beginning of the step.
+    double timestamp {0};
+
+    // Wall time of the entire step, in seconds.
+    double step_time {0};
+
+    // Wall time of each stage, in seconds, indexed by `profile_stage`.
+    std::array<double, static_cast<size_t>(profile_stage::count)> stage_time {};
+
+    unsigned num_manifolds {0};
+    unsigned num_contact_points {0};
+    unsigned num_constraint_rows {0};
+    unsigned num_islands_awake {0};
+    unsigned num_islands_asleep {0};
+
+    // Number of nodes reinserted in the broadphase trees because their AABB
+    // moved outside of the inflated node AABB.
+    unsigned num_tree_moves {0};
+
+    // Fraction of the step time the worker threads spent running jobs, in
+    // the [0, 1] range.
+    double worker_utilization {0};
+
+    double get_stage_time(profile_stage stage) const {
+        return stage_time[static_cast<size_t>(stage)];
+    }
+};
+
+/**
+ * @brief Ring buffer holding the stats of the most recent steps. It is
+ * available in the context of the main registry while profiling is enabled.
+ */
+class step_stats_history {
+public:
+    step_stats_history(size_t capacity)
+        : m_entries(capacity > 0 ? capacity : 1)
+    {}
+
+    void push(const step_stats &stats) {
+        m_entries[m_head] = stats;
+        m_head = (m_head + 1) % m_entries.size();
+
+        if (m_size < m_entries.size()) {
+            ++m_size;
+        }
+    }
+
+    /**
+     * @brief Stats of the i-th step in the buffer, where zero is the oldest.
+     */
+    const step_stats & operator[](size_t i) const {
+        EDYN_ASSERT(i < m_size);
+        return m_entries[(m_head + m_entries.size() - m_size + i) % m_entries.size()];
+    }
+
+    const step_stats & latest() const {
+        EDYN_ASSERT(m_size > 0);
+        return (*this)[m_size - 1];
+    }
+
+    /**
+     * @brief Visits all stats from oldest to latest.
+     * @param func Function with signature `void(const step_stats &)`.
+     */
+    template<typename Func>
+    void each(Func func) const {
+        for (size_t i = 0; i < m_size; ++i) {
+            func((*this)[i]);
+        }
+    }
+
+    size_t size() const {
+        return m_size;
+    }
+
+    bool empty() const {
+        return m_size == 0;
+    }
+
+    size_t capacity() const {
+        return m_entries.size();
+    }
+
+    void clear() {
+        m_head = 0;
+        m_size = 0;
+    }
+
+private:
+    std::vector<step_stats> m_entries;
+    size_t m_head {0};
+    size_t m_size {0};
+};
+
+}
+
+#endif // EDYN_CONTEXT_STEP_STATS_HPP
@@ -144,6 +144,22 @@ public:
      */
     connected_components_t connected_components();
 
+    /**
+     * @brief Finds the connected components which contain the given nodes,
+     * which used to be in a single connected component before edges or nodes
+     * were removed. A search starts at each node and searches are merged
+     * once they meet. All searches advance one node at a time, thus the cost
+     * is proportional to the size of the components that are split off
+     * instead of the size of the original component.
+     * @param node_indices Indices of connecting nodes, usually the nodes that
+     * were connected by the removed edges.
+     * @return The connected components which were separated from the
+     * component where the last unfinished search is, which is not returned
+     * since it hasn't been fully visited. Non-connecting nodes can be present
+     * in multiple connected components.
+     */
+    connected_components_t split_components(const std::vector<index_type> &node_indices) const;
+
     /**
      * @brief Traverses nodes starting at the given node. Neighbors of
      * non-connecting nodes aren't visited.
@@ -17,6 +17,20 @@ void run_island_solver_seq(entt::registry &, entt::entity island_entity,
                            unsigned num_iterations, unsigned num_position_iterations,
                            scalar dt);
 
+/**
+ * @brief Solves the constraints of an island using colored Gauss-Seidel, where
+ * the rows are partitioned into batches that do not share procedural bodies.
+ * The normal rows of each batch are packed into blocks and solved using SIMD
+ * instructions and the batches are solved in parallel if `mt` is true, in
+ * which case it blocks until done, thus it must not be called from within a
+ * job.
+ * @param deterministic Whether to color rows in a canonical order.
+ * @param mt Whether to solve each batch in parallel.
+ */
+void run_island_solver_colored(entt::registry &, entt::entity island_entity,
+                               unsigned num_iterations, unsigned num_position_iterations,
+                               scalar dt, bool deterministic, bool mt);
+
 }
 
 #endif // EDYN_DYNAMICS_ISLAND_SOLVER_HPP
@@ -1,12 +1,52 @@
 #ifndef EDYN_DYNAMICS_RESTITUTION_SOLVER_HPP
 #define EDYN_DYNAMICS_RESTITUTION_SOLVER_HPP
 
-#include "edyn/math/scalar.hpp"
+#include <vector>
+#include <utility>
 #include <entt/entity/fwd.hpp>
+#include "edyn/math/scalar.hpp"
+#include "edyn/constraints/constraint_row.hpp"
+#include "edyn/constraints/constraint_row_friction.hpp"
 
 namespace edyn {
 
-void solve_restitution(entt::registry &registry, scalar dt);
+/**
+ * @brief Storage used by `solve_restitution` which is kept from one step to
+ * the next, thus no allocations happen once it has grown large enough.
+ */
+struct restitution_solver_buffers {
+    // State of a thread solving islands. Aligned to a cache line to prevent
+    // false sharing between threads.
+    struct alignas(64) slot {
+        std::vector<constraint_row> normal_rows;
+        std::vector<constraint_row_friction> friction_rows;
+        std::vector<entt::entity> manifold_entities;
+        std::vector<size_t> to_visit;
+        // A graph node was visited in the current traversal if its stamp
+        // is equal to `visit_stamp`.
+        std::vector<unsigned> node_stamps;
+        unsigned visit_stamp {0};
+    };
+
+    // Manifolds with restitution paired with the island they reside in.
+    std::vector<std::pair<entt::entity, entt::entity>> island_manifolds;
+    // Manifolds grouped by island and the range of each island in it.
+    std::vector<entt::entity> manifolds;
+    std::vector<std::pair<size_t, size_t>> island_ranges;
+    // One slot per worker plus one for the thread running the solver.
+    std::vector<slot> slots;
+};
+
+/**
+ * @brief Applies restitution impulses to contacts that are penetrating fast
+ * enough. Islands are solved in parallel if multi-threaded.
+ * @param registry Data source.
+ * @param buffers Storage reused between steps.
+ * @param dt Time step.
+ * @param mt Whether to use the global `job_dispatcher`.
+ */
+void solve_restitution(entt::registry &registry, restitution_solver_buffers &buffers,
+                       scalar dt, bool mt);
 
 }
 
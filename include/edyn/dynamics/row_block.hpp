@@ -0,0 +1,101 @@
+#ifndef EDYN_DYNAMICS_ROW_BLOCK_HPP
+#define EDYN_DYNAMICS_ROW_BLOCK_HPP
+
+#include <vector>
+#include "edyn/math/scalar.hpp"
+#include "edyn/comp/delta_linvel.hpp"
+#include "edyn/comp/delta_angvel.hpp"
+
+namespace edyn {
+
+struct constraint_row;
+struct row_cache;
+struct row_color_batches;
+
+/**
+ * A block of constraint rows in structure-of-arrays layout, where each value
+ * is stored in an array with one element per row, i.e. a lane. This allows
+ * multiple rows to be solved at once using SIMD instructions. The rows in a
+ * block must not act upon the same body, thus each lane holds a row of a
+ * different constraint. Delta velocities are gathered from and scattered into
+ * the body slots of a `row_color_batches` by index.
+ */
+struct alignas(sizeof(scalar) * 8) constraint_row_block {
+    static constexpr unsigned width = 4;
+
+    // Jacobian indexed by [element][axis][lane].
+    scalar J[4][3][width];
+
+    // Jacobian elements premultiplied by the inverse mass or inertia of the
+    // corresponding body, i.e. the velocity change per unit of impulse. Using
+    // this instead of the inverse inertia matrices saves memory bandwidth.
+    scalar MJ[4][3][width];
+
+    scalar eff_mass[width];
+    scalar rhs[width];
+    scalar lower_limit[width];
+    scalar upper_limit[width];
+    scalar impulse[width];
+
+    // Body slot of each body of each row.
+    unsigned slotA[width];
+    unsigned slotB[width];
+
+    // Index of each row in the `row_cache`, where the impulses are written
+    // back to after solving.
+    unsigned row_index[width];
+
+    // Number of lanes in use, which are always the first lanes.
+    unsigned num_rows;
+};
+
+/**
+ * Stores the rows of the color batches of an island in blocks. It is
+ * assigned as a component for each island alongside the `row_cache`.
+ * Constraints of a color are split into groups of up to one constraint per
+ * lane which do not share bodies. The n-th block of a group holds the n-th
+ * row of each of its constraints, thus the blocks of a group must be solved
+ * in order, while different groups of a color can be solved in parallel.
+ */
+struct row_block_cache {
+    std::vector<constraint_row_block> blocks;
+
+    // Blocks of the i-th group are in the range
+    // `[group_offsets[i], group_offsets[i + 1])`.
+    std::vector<unsigned> group_offsets;
+
+    // Groups of the i-th color are in the range
+    // `[color_offsets[i], color_offsets[i + 1])`.
+    std::vector<unsigned> color_offsets;
+
+    void clear() {
+        blocks.clear();
+        group_offsets.clear();
+        color_offsets.clear();
+    }
+};
+
+/**
+ * @brief Packs the normal rows of the color batches into blocks. The rows in
+ * the overflow batch are not packed.
+ * @param cache Packed rows of an island.
+ * @param colors Color batches of an island.
+ * @param blocks Output row blocks.
+ */
+void pack_row_blocks(const row_cache &cache, const row_color_batches &colors,
+                     row_block_cache &blocks);
+
+/**
+ * @brief Solves all rows in a block simultaneously.
+ * @param block The row block.
+ * @param dv Linear velocity deltas of the body slots.
+ * @param dw Angular velocity deltas of the body slots.
+ * @param rows Row array where applied impulses are written to, since the
+ * friction rows depend on them.
+ */
+void solve(constraint_row_block &block, delta_linvel *dv, delta_angvel *dw,
+           std::vector<constraint_row> &rows);
+
+}
+
+#endif // EDYN_DYNAMICS_ROW_BLOCK_HPP
@@ -2,7 +2,9 @@
 #define EDYN_DYNAMICS_ROW_CACHE_HPP
 
 #include <type_traits>
+#include <memory>
 #include <vector>
+#include <array>
 #include <tuple>
 #include "edyn/config/config.h"
 #include "edyn/constraints/constraint_row.hpp"
@@ -51,7 +53,10 @@ struct row_cache {
  * constraint rows are inserted into this component. This allows preparation
  * to be run in parallel with per-constraint granularity since they're not
  * appending rows to a shared buffer. They are then packed together into a
- * `row_cache` for better performance during the solver iterations.
+ * `row_cache` for better performance during the solver iterations. The rows
+ * themselves are not stored in the component but in a
+ * `constraint_row_prep_arena`, thus its size does not depend on the maximum
+ * number of rows.
  */
 struct constraint_row_prep_cache {
     static constexpr unsigned max_rows = 16;
@@ -71,35 +76,34 @@ struct constraint_row_prep_cache {
         }
     };
 
-    // All rows in this entity.
-    std::array<element, max_rows> rows;
-    uint8_t num_rows;
+    // All rows in this entity. Points to storage for `max_rows` elements
+    // assigned before preparation, which is only valid until the next step.
+    element *rows {nullptr};
+    uint8_t num_rows {0};
 
     // Number of rows per constraint in the same order they appear in the
     // `constraints_tuple`, since an entity can have multiple constraints
     // of different types.
-    std::array<uint8_t, max_constraints> rows_per_constraint;
-    uint8_t num_constraints;
+    std::array<uint8_t, max_constraints> rows_per_constraint {};
+    uint8_t num_constraints {0};
 
     // Index of constraint used when packing. Since packed rows are inserted by
     // constraint type as to solve them sorted by type, the rows in this cache
     // are "consumed" per constraint.
-    uint8_t current_constraint_index;
-
-    constraint_row_prep_cache() {
-        clear();
-    }
+    uint8_t current_constraint_index {0};
 
     void add_constraint() {
+        EDYN_ASSERT(num_constraints < max_constraints);
         ++num_constraints;
     }
 
     constraint_row & add_row() {
+        EDYN_ASSERT(rows != nullptr);
         EDYN_ASSERT(num_rows < max_rows);
         EDYN_ASSERT(num_constraints > 0);
         ++rows_per_constraint[num_constraints - 1];
         auto &elem = rows[num_rows++];
-        elem.flags = 0;
+        elem.clear();
         return elem.row;
     }
 
@@ -161,19 +165,90 @@ struct constraint_row_prep_cache {
         return rows_per_constraint[current_constraint_index];
     }
 
-    void clear() {
+    // Resets the cache and assigns storage for the rows of the next step.
+    void clear(element *storage) {
+        rows = storage;
         num_rows = 0;
         num_constraints = 0;
         current_constraint_index = 0;
+        rows_per_constraint.fill(0);
+    }
+};
+
+/**
+ * Bump allocator for the rows of all `constraint_row_prep_cache` in a step.
+ * Elements are allocated in pages which are never moved, thus the rows of a
+ * cache remain valid until the arena is reset in the next step, and which are
+ * reused from one step to the next. Each thread allocates from its own slot
+ * to avoid synchronization.
+ */
+class constraint_row_prep_arena {
+public:
+    using element = constraint_row_prep_cache::element;
+
+    // Number of elements per page. The last `max_rows - 1` elements of a page
+    // might not be used if the rows of an entity could not fit.
+    static constexpr size_t page_size = 128;
+    static_assert(page_size >= constraint_row_prep_cache::max_rows);
+
+    /**
+     * @brief Makes all allocated pages available again. Must not be called
+     * while rows are being allocated.
+     * @param num_slots Number of threads which will allocate rows.
+     */
+    void reset(size_t num_slots) {
+        if (m_slots.size() < num_slots) {
+            m_slots.resize(num_slots);
+        }
 
-        for (auto &elem : rows) {
-            elem.clear();
+        for (auto &slot : m_slots) {
+            slot.page_index = 0;
+            slot.offset = 0;
+        }
+    }
+
+    /**
+     * @brief Get storage for the rows of one entity, which is large enough
+     * for `constraint_row_prep_cache::max_rows` elements. The storage is only
+     * taken once `commit` is called with the number of rows actually used.
+     * @param slot_index Slot of the current thread.
+     * @return Pointer to contiguous elements.
+     */
+    element * reserve(size_t slot_index) {
+        EDYN_ASSERT(slot_index < m_slots.size());
+        auto &slot = m_slots[slot_index];
+
+        if (slot.offset + constraint_row_prep_cache::max_rows > page_size) {
+            ++slot.page_index;
+            slot.offset = 0;
         }
 
-        for (auto &c : rows_per_constraint) {
-            c = 0;
+        if (slot.page_index == slot.pages.size()) {
+            slot.pages.push_back(std::make_unique<element[]>(page_size));
         }
+
+        return slot.pages[slot.page_index].get() + slot.offset;
     }
+
+    /**
+     * @brief Takes the first `num_rows` elements of the last reserved storage.
+     * @param slot_index Slot of the current thread.
+     * @param num_rows Number of rows used.
+     */
+    void commit(size_t slot_index, size_t num_rows) {
+        EDYN_ASSERT(num_rows <= constraint_row_prep_cache::max_rows);
+        m_slots[slot_index].offset += num_rows;
+    }
+
+private:
+    // Aligned to a cache line to prevent false sharing between threads.
+    struct alignas(64) slot {
+        std::vector<std::unique_ptr<element[]>> pages;
+        size_t page_index {0};
+        size_t offset {0};
+    };
+
+    std::vector<slot> m_slots;
 };
 
 }
@@ -0,0 +1,135 @@
+#ifndef EDYN_DYNAMICS_ROW_COLORING_HPP
+#define EDYN_DYNAMICS_ROW_COLORING_HPP
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <entt/entity/fwd.hpp>
+#include "edyn/comp/delta_linvel.hpp"
+#include "edyn/comp/delta_angvel.hpp"
+
+namespace edyn {
+
+struct row_cache;
+struct island_constraint_entities;
+
+/**
+ * Partition of the rows in a `row_cache` into batches where no two
+ * constraints in the same batch act upon the same procedural body, i.e. a
+ * coloring of the constraint graph of an island. The constraints of a batch
+ * can thus be solved in parallel and the batches are solved one after the
+ * other, which is known as colored (or batched) Gauss-Seidel. It is assigned
+ * as a component for each island alongside the `row_cache`.
+ */
+struct row_color_batches {
+    // Maximum number of colors. Constraints that cannot be assigned a color
+    // because their bodies are already present in all batches are inserted
+    // in the overflow batch, which is solved sequentially.
+    static constexpr unsigned max_colors = 64;
+
+    // Position where the indices of a constraint start in each array of a
+    // batch.
+    struct constraint_offset {
+        unsigned rows;
+        unsigned friction;
+        unsigned rolling;
+        unsigned spinning;
+    };
+
+    struct batch {
+        // Indices of rows in the `row_cache` arrays.
+        std::vector<unsigned> rows;
+        std::vector<unsigned> friction;
+        std::vector<unsigned> rolling;
+        std::vector<unsigned> spinning;
+
+        // The indices of the i-th constraint in this batch are in the range
+        // `[offsets[i], offsets[i + 1])` of each array. All rows of a
+        // constraint act upon the same bodies, thus only rows of different
+        // constraints can be solved in parallel.
+        std::vector<constraint_offset> offsets;
+
+        size_t num_constraints() const {
+            return offsets.empty() ? 0 : offsets.size() - 1;
+        }
+
+        void clear() {
+            rows.clear();
+            friction.clear();
+            rolling.clear();
+            spinning.clear();
+            offsets.clear();
+        }
+    };
+
+    // Batches are kept around to reuse their memory in the next step. Only
+    // the first `num_colors` are valid.
+    std::vector<batch> batches;
+    unsigned num_colors {0};
+    batch overflow;
+
+    // Local copies of the delta velocities of the bodies the rows act upon,
+    // which rows refer to while solving, i.e. body slots. The first
+    // `num_procedural_slots` correspond to the procedural bodies in
+    // `procedural_bodies`. The remaining are exclusive to one side of one row
+    // acting upon a non-procedural body, since all rows sharing a static or
+    // kinematic body would otherwise be writing to the same location
+    // concurrently. These deltas are always zero anyway.
+    std::vector<delta_linvel> dv;
+    std::vector<delta_angvel> dw;
+    std::vector<entt::entity> procedural_bodies;
+    unsigned num_procedural_slots {0};
+
+    // Body slot of each side of each row in the `row_cache`.
+    std::vector<std::array<unsigned, 2>> row_slots;
+
+    // Bitmask of colors used by each graph node, indexed by node index.
+    std::vector<uint64_t> node_colors;
+
+    // Body slot of each graph node, indexed by node index.
+    std::vector<unsigned> node_slots;
+
+    void clear() {
+        for (unsigned i = 0; i < num_colors; ++i) {
+            batches[i].clear();
+        }
+
+        num_colors = 0;
+        overflow.clear();
+        dv.clear();
+        dw.clear();
+        procedural_bodies.clear();
+        num_procedural_slots = 0;
+        row_slots.clear();
+    }
+};
+
+/**
+ * @brief Assigns the constraint rows of an island to color batches. Must be
+ * called right after the rows are packed into the `row_cache` since it relies
+ * on the packing order, which is recorded in `constraint_entities`.
+ * @param registry Data source.
+ * @param cache Packed rows of an island. The delta velocity pointers of all
+ * rows will be redirected into the body slots in `colors`.
+ * @param constraint_entities Constraint entities of an island.
+ * @param colors Output batches.
+ * @param deterministic Whether to assign colors in a canonical order that does
+ * not depend on the order of constraints in their pools, which might differ
+ * between two runs of the same simulation.
+ */
+void color_rows(entt::registry &registry, row_cache &cache,
+                const island_constraint_entities &constraint_entities,
+                row_color_batches &colors, bool deterministic);
+
+/**
+ * @brief Writes the delta velocities in the body slots back into the delta
+ * velocity components of the procedural bodies. Must be called once the
+ * rows are solved.
+ * @param registry Data source.
+ * @param colors Batches with body slots.
+ */
+void write_back_body_slots(entt::registry &registry, const row_color_batches &colors);
+
+}
+
+#endif // EDYN_DYNAMICS_ROW_COLORING_HPP
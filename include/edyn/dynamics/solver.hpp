@@ -7,6 +7,8 @@
 #include <entt/signal/sigh.hpp>
 #include "edyn/math/scalar.hpp"
 #include "edyn/parallel/atomic_counter.hpp"
+#include "edyn/dynamics/row_cache.hpp"
+#include "edyn/dynamics/restitution_solver.hpp"
 
 namespace edyn {
 
@@ -26,6 +28,8 @@ private:
     entt::registry *m_registry;
     std::vector<entt::scoped_connection> m_connections;
     std::unique_ptr<atomic_counter> m_counter;
+    constraint_row_prep_arena m_prep_arena;
+    restitution_solver_buffers m_restitution_buffers;
 };
 
 }
@@ -4,6 +4,8 @@
 #include "edyn/build_settings.h"
 #include "edyn/config/execution_mode.hpp"
 #include "edyn/config/solver_iteration_config.hpp"
+#include "edyn/config/profiling_config.hpp"
+#include "edyn/config/determinism_config.hpp"
 #include "math/constants.hpp"
 #include "math/scalar.hpp"
 #include "math/vector3.hpp"
@@ -18,9 +20,11 @@
 #include "util/exclude_collision.hpp"
 #include "util/gravity_util.hpp"
 #include "util/insert_material_mixing.hpp"
+#include "util/state_hash.hpp"
 #include "collision/contact_signal.hpp"
 #include "context/step_callback.hpp"
 #include "collision/raycast.hpp"
+#include "collision/shape_cast.hpp"
 #include "shapes/shapes.hpp"
 #include "comp/shared_comp.hpp"
 #include "comp/present_position.hpp"
@@ -57,6 +57,7 @@ static const auto networked_components = std::tuple_cat(std::tuple<
     rigidbody_tag,
     constraint_tag,
     rolling_tag,
+    continuous_contacts_tag,
     roll_direction,
     null_constraint,
     gravity_constraint,
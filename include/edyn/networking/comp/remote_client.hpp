@@ -7,6 +7,7 @@
 #include "edyn/replication/entity_map.hpp"
 #include "edyn/networking/packet/edyn_packet.hpp"
 #include "edyn/networking/util/clock_sync.hpp"
+#include "edyn/networking/util/snapshot_compression.hpp"
 
 namespace edyn {
 
@@ -40,6 +41,15 @@ struct remote_client {
     // Rate of registry snapshots, i.e. registry snapshots sent per second.
     double snapshot_rate {10};
 
+    // Compressed snapshots sent to this client and the last one it
+    // acknowledged.
+    snapshot_baseline_history snapshot_history;
+
+    // Registry snapshot packets exported in the last update. Only the first
+    // `num_snapshot_packets` are valid. Kept to reuse their buffers.
+    std::vector<packet::edyn_packet> snapshot_packets;
+    size_t num_snapshot_packets {0};
+
     // Whether this client will be given temporary ownership of all entities in
     // the island where entities owned by it reside, thus allowing the state of
     // those entities to be set by the client.
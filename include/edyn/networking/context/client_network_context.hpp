@@ -8,6 +8,7 @@
 #include "edyn/networking/util/client_snapshot_importer.hpp"
 #include "edyn/networking/util/client_snapshot_exporter.hpp"
 #include "edyn/networking/util/clock_sync.hpp"
+#include "edyn/networking/util/snapshot_compression.hpp"
 #include "edyn/networking/extrapolation/extrapolation_worker.hpp"
 #include "edyn/networking/extrapolation/extrapolation_modified_comp.hpp"
 #include "edyn/replication/registry_operation.hpp"
@@ -44,6 +45,10 @@ struct client_network_context {
     double last_snapshot_time {0};
     double server_playout_delay {0.3};
 
+    // Compressed snapshots received from the server, which are the baselines
+    // of the next ones.
+    snapshot_baseline_history snapshot_history;
+
     // Without full ownership, the client will only send input components to server.
     bool allow_full_ownership {true};
 
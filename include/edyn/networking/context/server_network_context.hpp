@@ -14,6 +14,9 @@ struct server_network_context {
 
     std::vector<entt::entity> pending_created_clients;
 
+    // Clients which are due a registry snapshot in the current update.
+    std::vector<entt::entity> snapshot_client_entities;
+
     std::shared_ptr<server_snapshot_importer> snapshot_importer;
     std::shared_ptr<server_snapshot_exporter> snapshot_exporter;
 
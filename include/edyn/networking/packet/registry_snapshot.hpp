@@ -21,6 +21,11 @@ struct registry_snapshot {
     std::vector<entt::entity> entities;
     std::vector<pool_snapshot> pools;
 
+    // Positions, orientations and velocities in the compact encoding of
+    // `compress_registry_snapshot`, which replaces their pools. Empty if
+    // the snapshot is not compressed.
+    std::vector<uint8_t> motion;
+
     void convert_remloc(const entt::registry &registry, const entity_map &emap) {
         for (auto &entity : entities) {
             entity = emap.at(entity);
@@ -37,6 +42,7 @@ void serialize(Archive &archive, registry_snapshot &snapshot) {
     archive(snapshot.timestamp);
     archive(snapshot.entities);
     archive(snapshot.pools);
+    archive(snapshot.motion);
 }
 
 }
@@ -63,16 +69,33 @@ namespace edyn::internal {
         return typed_pool;
     }
 
+    // Index of each entity already in the snapshot, which is kept by the
+    // exporter while it inserts components to find entities quickly.
+    inline pool_snapshot_data::entity_index_map make_entity_index_map(const packet::registry_snapshot &snap) {
+        auto index_map = pool_snapshot_data::entity_index_map{};
+        index_map.reserve(snap.entities.size());
+
+        for (size_t i = 0; i < snap.entities.size(); ++i) {
+            index_map.emplace(snap.entities[i], static_cast<pool_snapshot_data::index_type>(i));
+        }
+
+        return index_map;
+    }
+
     template<typename Component>
     void snapshot_insert_entity(const entt::registry &registry, entt::entity entity,
-                                packet::registry_snapshot &snap, component_index_type component_index) {
-        get_pool<Component>(snap.pools, component_index)->insert_single(registry, entity, snap.entities);
+                                packet::registry_snapshot &snap,
+                                pool_snapshot_data::entity_index_map &index_map,
+                                component_index_type component_index) {
+        get_pool<Component>(snap.pools, component_index)->insert_single(registry, entity, snap.entities, index_map);
     }
 
     template<typename Component, typename It>
     void snapshot_insert_entities(const entt::registry &registry, It first, It last,
-                                  packet::registry_snapshot &snap, component_index_type component_index) {
-        get_pool<Component>(snap.pools, component_index)->insert(registry, first, last, snap.entities);
+                                  packet::registry_snapshot &snap,
+                                  pool_snapshot_data::entity_index_map &index_map,
+                                  component_index_type component_index) {
+        get_pool<Component>(snap.pools, component_index)->insert(registry, first, last, snap.entities, index_map);
     }
 }
 
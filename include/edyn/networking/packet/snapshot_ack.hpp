@@ -0,0 +1,23 @@
+#ifndef EDYN_NETWORKING_PACKET_SNAPSHOT_ACK_HPP
+#define EDYN_NETWORKING_PACKET_SNAPSHOT_ACK_HPP
+
+#include <cstdint>
+
+namespace edyn::packet {
+
+/**
+ * @brief Sent by the client when it receives a compressed registry snapshot,
+ * allowing the server to use it as the baseline for the next snapshots.
+ */
+struct snapshot_ack {
+    uint32_t sequence;
+};
+
+template<typename Archive>
+void serialize(Archive &archive, snapshot_ack &ack) {
+    archive(ack.sequence);
+}
+
+}
+
+#endif // EDYN_NETWORKING_PACKET_SNAPSHOT_ACK_HPP
@@ -1,8 +1,30 @@
 #ifndef EDYN_NETWORKING_SETTINGS_SERVER_NETWORK_SETTINGS_HPP
 #define EDYN_NETWORKING_SETTINGS_SERVER_NETWORK_SETTINGS_HPP
 
+#include <cstdint>
+#include "edyn/math/scalar.hpp"
+
 namespace edyn {
 
+/**
+ * @brief Precision of the motion components in compressed registry snapshots.
+ * Values are stored in fixed-point with the given number of fractional bits
+ * and clamped to the given bounds, i.e. positions have a resolution of
+ * `2^-position_fraction_bits` meters.
+ */
+struct snapshot_quantization {
+    uint8_t position_fraction_bits {10};
+    scalar position_bound {8192};
+
+    // Used for linear and angular velocity.
+    uint8_t velocity_fraction_bits {8};
+    scalar velocity_bound {1024};
+
+    // Number of bits of each of the three smallest components of the
+    // orientation quaternions.
+    uint8_t orientation_bits {12};
+};
+
 struct server_network_settings {
     // Client playout delay buffer length will be calculated as the greatest
     // latency among all clients in its AABB of interest multiplied by this
@@ -15,6 +37,18 @@ struct server_network_settings {
     // longer be delayed, they'll be applied immediately instead, which can lead
     // to jitter.
     double max_playout_delay {2};
+
+    // Send registry snapshots with positions, orientations and velocities
+    // quantized and delta-encoded against the last snapshot acknowledged by
+    // each client. Greatly reduces the size of snapshots at the cost of
+    // precision.
+    bool compress_snapshots {false};
+    snapshot_quantization quantization {};
+
+    // Registry snapshots with more entities than this are split into many
+    // packets. Entities nearest to the center of the client's AABB of
+    // interest are placed in the first packets.
+    uint32_t max_snapshot_entities {256};
 };
 
 }
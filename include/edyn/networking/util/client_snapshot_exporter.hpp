@@ -131,21 +131,23 @@ class client_snapshot_exporter_impl : public client_snapshot_exporter {
 
     void export_modified(const entt::registry &registry, entt::entity entity,
                          const modified_components &modified,
-                         packet::registry_snapshot &snap) const {
+                         packet::registry_snapshot &snap,
+                         pool_snapshot_data::entity_index_map &index_map) const {
         static const auto components_tuple = std::tuple<Components...>{};
 
         for (unsigned i = 0; i < modified.count; ++i) {
             auto comp_index = modified.entry[i].index;
             visit_tuple(components_tuple, comp_index, [&](auto &&c) {
                 using CompType = std::decay_t<decltype(c)>;
-                internal::snapshot_insert_entity<CompType>(registry, entity, snap, comp_index);
+                internal::snapshot_insert_entity<CompType>(registry, entity, snap, index_map, comp_index);
             });
         }
     }
 
     void export_modified_inputs(const entt::registry &registry, entt::entity entity,
                                 const modified_components &modified,
-                                packet::registry_snapshot &snap) const {
+                                packet::registry_snapshot &snap,
+                                pool_snapshot_data::entity_index_map &index_map) const {
         static const auto components_tuple = std::tuple<Components...>{};
 
         for (unsigned i = 0; i < modified.count; ++i) {
@@ -153,7 +155,7 @@ class client_snapshot_exporter_impl : public client_snapshot_exporter {
             visit_tuple(components_tuple, comp_index, [&](auto &&c) {
                 using CompType = std::decay_t<decltype(c)>;
                 if constexpr(std::is_base_of_v<network_input, CompType>) {
-                    internal::snapshot_insert_entity<CompType>(registry, entity, snap, comp_index);
+                    internal::snapshot_insert_entity<CompType>(registry, entity, snap, index_map, comp_index);
                 }
             });
         }
@@ -179,11 +181,13 @@ public:
 
     template<typename It>
     void export_all(packet::registry_snapshot &snap, It first, It last) const {
+        auto index_map = internal::make_entity_index_map(snap);
+
         for (; first != last; ++first) {
             auto entity = *first;
             unsigned i = 0;
             (((m_registry->all_of<Components>(entity) ?
-                internal::snapshot_insert_entity<Components>(*m_registry, entity, snap, i) : void(0)), ++i), ...);
+                internal::snapshot_insert_entity<Components>(*m_registry, entity, snap, index_map, i) : void(0)), ++i), ...);
         }
     }
 
@@ -201,6 +205,7 @@ public:
         auto modified_view = registry.view<modified_components>();
         auto parent_view = registry.view<parent_comp>();
         auto child_view = registry.view<child_list>();
+        auto index_map = internal::make_entity_index_map(snap);
 
         if (allow_full_ownership) {
             // Include all networked entities in the islands that contain an entity
@@ -282,7 +287,7 @@ public:
                         bump_component<position, orientation, linvel, angvel>(modified);
                     }
 
-                    export_modified(registry, entity, modified, snap);
+                    export_modified(registry, entity, modified, snap, index_map);
 
                     // Export child entities.
                     if (parent_view.contains(entity)) {
@@ -294,7 +299,7 @@ public:
 
                             if (modified_view.contains(child_entity)) {
                                 auto [child_modified] = modified_view.get(child_entity);
-                                export_modified(registry, child_entity, child_modified, snap);
+                                export_modified(registry, child_entity, child_modified, snap, index_map);
                             }
 
                             child_entity = child.next;
@@ -307,7 +312,7 @@ public:
             // input component are included.
             for (auto entity : owned_entities) {
                 auto [modified] = modified_view.get(entity);
-                export_modified_inputs(registry, entity, modified, snap);
+                export_modified_inputs(registry, entity, modified, snap, index_map);
             }
         }
 
@@ -317,7 +322,7 @@ public:
 
         for (auto entity : owned_entities) {
             if (history_view.contains(entity) && !std::get<0>(history_view.get(entity)).entries.empty()) {
-                internal::snapshot_insert_entity<action_history>(registry, entity, snap, action_history_index);
+                internal::snapshot_insert_entity<action_history>(registry, entity, snap, index_map, action_history_index);
             }
         }
     }
@@ -2,23 +2,30 @@
 #define EDYN_NETWORKING_UTIL_POOL_SNAPSHOT_DATA_HPP
 
 #include <iterator>
+#include <limits>
 #include <memory>
 #include <vector>
 #include <utility>
+#include <unordered_map>
 #include <entt/entity/fwd.hpp>
 #include "edyn/comp/merge_component.hpp"
 #include "edyn/comp/tag.hpp"
 #include "edyn/replication/map_child_entity.hpp"
 #include "edyn/serialization/std_s11n.hpp"
 #include "edyn/serialization/memory_archive.hpp"
+#include "edyn/serialization/varint.hpp"
 #include "edyn/replication/entity_map.hpp"
 #include "edyn/config/config.h"
 
 namespace edyn {
 
 struct pool_snapshot_data {
-    // Snapshot is not expected to have more than 256 entities.
-    using index_type = uint8_t;
+    // Indices are written to the wire as variable length deltas, thus large
+    // snapshots are supported while small ones take a single byte per index.
+    using index_type = uint32_t;
+    static constexpr auto null_index = std::numeric_limits<index_type>::max();
+    // Maps entities to their index in the snapshot's entity list.
+    using entity_index_map = std::unordered_map<entt::entity, index_type>;
     std::vector<index_type> entity_indices;
 
     virtual ~pool_snapshot_data() = default;
@@ -26,6 +33,20 @@ struct pool_snapshot_data {
     virtual void write(memory_output_archive &archive) = 0;
     virtual void read(memory_input_archive &archive) = 0;
 
+    /**
+     * @brief Distributes the entries of this pool among the pools of multiple
+     * fragments in a single pass.
+     * @param fragment_indices Fragment of each entity in this pool's snapshot,
+     * or `null_index` if the entity must be left out.
+     * @param new_indices Index of each entity in its fragment.
+     * @param fragment_pools Pools of each fragment, which are created as
+     * entries are inserted into them. Fragments without entries in this pool
+     * are left with a null pool.
+     */
+    virtual void split(const std::vector<index_type> &fragment_indices,
+                       const std::vector<index_type> &new_indices,
+                       std::vector<std::unique_ptr<pool_snapshot_data>> &fragment_pools) const = 0;
+
     virtual void replace_into_registry(entt::registry &registry,
                                        const std::vector<entt::entity> &entities,
                                        const entity_map &emap) = 0;
@@ -45,6 +66,57 @@ struct pool_snapshot_data_impl : public pool_snapshot_data {
     static constexpr auto is_empty_type = std::is_empty_v<Component>;
     std::vector<Component> components;
 
+private:
+    static index_type find_or_insert_entity(entt::entity entity, std::vector<entt::entity> &pool_entities,
+                                            entity_index_map &index_map) {
+        // The entity list can be modified without updating the map, e.g.
+        // cleared to be reused, thus entries must be validated.
+        auto [it, inserted] = index_map.try_emplace(entity, null_index);
+
+        if (!inserted && it->second < pool_entities.size() && pool_entities[it->second] == entity) {
+            return it->second;
+        }
+
+        EDYN_ASSERT(pool_entities.size() < null_index);
+        it->second = static_cast<index_type>(pool_entities.size());
+        pool_entities.push_back(entity);
+        return it->second;
+    }
+
+    static void write_index_varint(memory_output_archive &archive, uint64_t value) {
+        while (value >= 0x80) {
+            auto byte = static_cast<uint8_t>(static_cast<uint8_t>(value) | 0x80);
+            archive(byte);
+            value >>= 7;
+        }
+
+        auto byte = static_cast<uint8_t>(value);
+        archive(byte);
+    }
+
+    static uint64_t read_index_varint(memory_input_archive &archive) {
+        uint64_t value = 0;
+
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            uint8_t byte = 0;
+            archive(byte);
+
+            if (archive.failed()) {
+                return 0;
+            }
+
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+
+            if ((byte & 0x80) == 0) {
+                break;
+            }
+        }
+
+        return value;
+    }
+
+public:
+
     void convert_remloc(const entt::registry &registry, const entity_map &emap) override {
         // TODO: should be no-op if component type has no child entities.
         if constexpr(!is_empty_type) {
@@ -55,11 +127,15 @@ struct pool_snapshot_data_impl : public pool_snapshot_data {
     }
 
     void write(memory_output_archive &archive) override {
-        index_type num_entities = static_cast<index_type>(entity_indices.size());
-        archive(num_entities);
+        write_index_varint(archive, entity_indices.size());
 
-        for (auto &idx : entity_indices) {
-            archive(idx);
+        // Entities are usually inserted in order, thus the difference between
+        // consecutive indices is small.
+        int64_t prev_idx = -1;
+
+        for (auto idx : entity_indices) {
+            write_index_varint(archive, zigzag_encode(int64_t(idx) - prev_idx));
+            prev_idx = idx;
         }
 
         if constexpr(!is_empty_type) {
@@ -70,14 +146,18 @@ struct pool_snapshot_data_impl : public pool_snapshot_data {
     }
 
     void read(memory_input_archive &archive) override {
-        index_type num_entities;
-        archive(num_entities);
-        entity_indices.resize(num_entities);
-
-        for (auto &idx : entity_indices) {
-            archive(idx);
+        auto num_entities = read_index_varint(archive);
+        entity_indices.clear();
+        int64_t prev_idx = -1;
+
+        // Stop at the end of the data in case the count is invalid.
+        for (uint64_t i = 0; i < num_entities && !archive.failed(); ++i) {
+            prev_idx += zigzag_decode(read_index_varint(archive));
+            entity_indices.push_back(static_cast<index_type>(prev_idx));
         }
 
+        num_entities = entity_indices.size();
+
         if constexpr(!is_empty_type) {
             components.resize(num_entities);
 
@@ -87,6 +167,31 @@ struct pool_snapshot_data_impl : public pool_snapshot_data {
         }
     }
 
+    void split(const std::vector<index_type> &fragment_indices,
+               const std::vector<index_type> &new_indices,
+               std::vector<std::unique_ptr<pool_snapshot_data>> &fragment_pools) const override {
+        for (size_t i = 0; i < entity_indices.size(); ++i) {
+            auto fragment_idx = fragment_indices[entity_indices[i]];
+
+            if (fragment_idx == null_index) {
+                continue;
+            }
+
+            auto &ptr = fragment_pools[fragment_idx];
+
+            if (!ptr) {
+                ptr = std::make_unique<pool_snapshot_data_impl<Component>>();
+            }
+
+            auto *pool = static_cast<pool_snapshot_data_impl<Component> *>(ptr.get());
+            pool->entity_indices.push_back(new_indices[entity_indices[i]]);
+
+            if constexpr(!is_empty_type) {
+                pool->components.push_back(components[i]);
+            }
+        }
+    }
+
     void replace_into_registry(entt::registry &registry,
                                const std::vector<entt::entity> &pool_entities,
                                const entity_map &emap) override {
@@ -132,20 +237,11 @@ struct pool_snapshot_data_impl : public pool_snapshot_data {
     }
 
     void insert_single(const entt::registry &registry, entt::entity entity,
-                       std::vector<entt::entity> &pool_entities) {
+                       std::vector<entt::entity> &pool_entities,
+                       entity_index_map &index_map) {
         EDYN_ASSERT((registry.all_of<networked_tag, Component>(entity)));
 
-        auto found_it = std::find(pool_entities.begin(), pool_entities.end(), entity);
-        index_type idx;
-
-        if (found_it != pool_entities.end()) {
-            idx = std::distance(pool_entities.begin(), found_it);
-        } else {
-            idx = pool_entities.size();
-            pool_entities.push_back(entity);
-        }
-
-        entity_indices.push_back(idx);
+        entity_indices.push_back(find_or_insert_entity(entity, pool_entities, index_map));
 
         if constexpr(!is_empty_type) {
             auto &comp = registry.get<Component>(entity);
@@ -155,24 +251,15 @@ struct pool_snapshot_data_impl : public pool_snapshot_data {
 
     template<typename It>
     void insert(const entt::registry &registry, It first, It last,
-                std::vector<entt::entity> &pool_entities) {
+                std::vector<entt::entity> &pool_entities,
+                entity_index_map &index_map) {
         auto view = registry.view<Component>();
 
         for (; first != last; ++first) {
             auto entity = *first;
             EDYN_ASSERT((registry.all_of<networked_tag, Component>(entity)));
 
-            auto found_it = std::find(pool_entities.begin(), pool_entities.end(), entity);
-            index_type idx;
-
-            if (found_it != pool_entities.end()) {
-                idx = std::distance(pool_entities.begin(), found_it);
-            } else {
-                idx = pool_entities.size();
-                pool_entities.push_back(entity);
-            }
-
-            entity_indices.push_back(idx);
+            entity_indices.push_back(find_or_insert_entity(entity, pool_entities, index_map));
 
             if constexpr(!is_empty_type) {
                 auto [comp] = view.get(entity);
@@ -3,6 +3,8 @@
 
 #include <entt/entity/registry.hpp>
 #include <entt/signal/sigh.hpp>
+#include <algorithm>
+#include <iterator>
 #include <numeric>
 #include <type_traits>
 #include <vector>
@@ -89,7 +91,8 @@ class server_snapshot_exporter_impl : public server_snapshot_exporter {
     void export_modified_entity(const entt::registry &registry, entt::entity entity,
                                 const modified_components &modified,
                                 bool owned_by_destination,
-                                packet::registry_snapshot &snap) const {
+                                packet::registry_snapshot &snap,
+                                pool_snapshot_data::entity_index_map &index_map) const {
         static const auto components_tuple = std::tuple<Components...>{};
 
         for (unsigned i = 0; i < modified.count; ++i) {
@@ -102,14 +105,15 @@ class server_snapshot_exporter_impl : public server_snapshot_exporter {
                 // Must not send action history or input state of entities
                 // owned by destination client.
                 if (!(is_action && owned_by_destination) && !(is_input && owned_by_destination)) {
-                    internal::snapshot_insert_entity<CompType>(registry, entity, snap, comp_index);
+                    internal::snapshot_insert_entity<CompType>(registry, entity, snap, index_map, comp_index);
                 }
             });
         }
     }
 
     template<typename Component, typename It>
-    void export_single(packet::registry_snapshot &snap, It first, It last, size_t index) const {
+    void export_single(packet::registry_snapshot &snap, pool_snapshot_data::entity_index_map &index_map,
+                       It first, It last, size_t index) const {
         constexpr auto is_action = std::is_same_v<Component, action_history>;
 
         // Actions must not be shared among clients.
@@ -118,7 +122,7 @@ class server_snapshot_exporter_impl : public server_snapshot_exporter {
                 auto entity = *first;
 
                 if (m_registry->all_of<Component>(entity)) {
-                    internal::snapshot_insert_entity<Component>(*m_registry, entity, snap, index);
+                    internal::snapshot_insert_entity<Component>(*m_registry, entity, snap, index_map, index);
                 }
             }
         }
@@ -126,7 +130,8 @@ class server_snapshot_exporter_impl : public server_snapshot_exporter {
 
     template<typename It, size_t... Indexes>
     void export_all_indices(packet::registry_snapshot &snap, It first, It last, std::index_sequence<Indexes...>) const {
-        (export_single<Components>(snap, first, last, Indexes), ...);
+        auto index_map = internal::make_entity_index_map(snap);
+        (export_single<Components>(snap, index_map, first, last, Indexes), ...);
     }
 
 public:
@@ -158,16 +163,19 @@ public:
     void export_modified(packet::registry_snapshot &snap,
                          const entt::sparse_set &entities_of_interest,
                          entt::entity dest_client_entity) const override {
-        auto &registry = *m_registry;
+        // Only reads from the registry, thus it is safe to export snapshots
+        // for many clients in parallel.
+        const auto &registry = *m_registry;
         auto &graph = registry.ctx().at<entity_graph>();
-        auto node_view = registry.view<graph_node>();
-        auto edge_view = registry.view<graph_edge>();
+        auto node_view = registry.view<const graph_node>();
+        auto edge_view = registry.view<const graph_edge>();
         auto owner_view = registry.view<const entity_owner>();
         auto modified_view = registry.view<const modified_components>();
-        auto parent_view = registry.view<parent_comp>();
-        auto child_view = registry.view<child_list>();
+        auto parent_view = registry.view<const parent_comp>();
+        auto child_view = registry.view<const child_list>();
 
         bool allow_ownership = registry.get<remote_client>(dest_client_entity).allow_full_ownership;
+        auto index_map = internal::make_entity_index_map(snap);
 
         // Do not include input components of entities owned by destination
         // client as to not override client input on the client-side.
@@ -238,7 +246,7 @@ public:
             const auto owned_by_destination =
                 owner_view.contains(entity) &&
                 std::get<0>(owner_view.get(entity)).client_entity == dest_client_entity;
-            export_modified_entity(registry, entity, modified, owned_by_destination, snap);
+            export_modified_entity(registry, entity, modified, owned_by_destination, snap, index_map);
 
             // Include child entities
             if (is_parent) {
@@ -248,7 +256,7 @@ public:
                 while (child_entity != entt::null) {
                     if (modified_view.contains(child_entity)) {
                         auto [child_modified] = modified_view.get(child_entity);
-                        export_modified_entity(registry, child_entity, child_modified, owned_by_destination, snap);
+                        export_modified_entity(registry, child_entity, child_modified, owned_by_destination, snap, index_map);
                     }
 
                     auto [child] = child_view.get(child_entity);
@@ -262,12 +270,20 @@ public:
                            const std::vector<component_index_type> &indices) const override {
         static const auto tuple = std::tuple<Components...>{};
 
+        // Only this entity is inserted, thus only it has to be looked up.
+        auto index_map = pool_snapshot_data::entity_index_map{};
+        auto found = std::find(snap.entities.begin(), snap.entities.end(), entity);
+
+        if (found != snap.entities.end()) {
+            index_map.emplace(entity, static_cast<pool_snapshot_data::index_type>(std::distance(snap.entities.begin(), found)));
+        }
+
         for (auto index : indices) {
             if (index < sizeof...(Components)) {
                 visit_tuple(tuple, index, [&](auto &&c) {
                     using CompType = std::decay_t<decltype(c)>;
                     if (m_registry->all_of<CompType>(entity)) {
-                        internal::snapshot_insert_entity<CompType>(*m_registry, entity, snap, index);
+                        internal::snapshot_insert_entity<CompType>(*m_registry, entity, snap, index_map, index);
                     }
                 });
             }
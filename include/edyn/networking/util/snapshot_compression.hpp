@@ -0,0 +1,121 @@
+#ifndef EDYN_NETWORKING_UTIL_SNAPSHOT_COMPRESSION_HPP
+#define EDYN_NETWORKING_UTIL_SNAPSHOT_COMPRESSION_HPP
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <entt/entity/fwd.hpp>
+#include "edyn/networking/settings/server_network_settings.hpp"
+
+namespace edyn {
+
+namespace packet {
+    struct registry_snapshot;
+}
+
+/**
+ * @brief Quantized motion components of recently sent or received compressed
+ * registry snapshots. These are the baselines the motion components of newer
+ * snapshots are delta-encoded against. The server keeps one for each client
+ * and the client keeps one for the server.
+ */
+class snapshot_baseline_history {
+public:
+    struct entry {
+        entt::entity entity;
+        uint8_t type;
+        std::array<int32_t, 4> values;
+    };
+
+    // Number of snapshots kept. Older snapshots cannot be used as baselines.
+    static constexpr size_t max_size = 32;
+
+    /**
+     * @brief Stores the quantized values of a snapshot, replacing the oldest.
+     * @param sequence Sequence number of the snapshot. Must not be zero.
+     * @param entries Values sorted by entity and type.
+     * @param fragment Index of the fragment if the snapshot was split.
+     */
+    void insert(uint32_t sequence, std::vector<entry> entries, uint32_t fragment = 0);
+
+    /**
+     * @brief Get the quantized values of a snapshot.
+     * @param sequence Sequence number of the snapshot.
+     * @return Pointer to values or null if the snapshot is not available.
+     */
+    const std::vector<entry> * find(uint32_t sequence) const;
+
+    /**
+     * @brief Obtain the sequence number for a new snapshot to be sent.
+     */
+    uint32_t next_sequence();
+
+    /**
+     * @brief Records that a snapshot was received on the other end.
+     * @param sequence Sequence number of the snapshot.
+     */
+    void acknowledge(uint32_t sequence);
+
+    /**
+     * @brief Latest acknowledged sequence number of a fragment, or zero if
+     * none. Fragments with the same index are likely to contain the same
+     * entities, which makes them good baselines for each other.
+     * @param fragment Index of the fragment.
+     */
+    uint32_t acked_sequence(uint32_t fragment = 0) const {
+        return fragment < m_acked_sequences.size() ? m_acked_sequences[fragment] : 0;
+    }
+
+    void clear();
+
+private:
+    struct snapshot {
+        uint32_t sequence {0};
+        uint32_t fragment {0};
+        std::vector<entry> entries;
+    };
+
+    std::array<snapshot, max_size> m_snapshots;
+    uint32_t m_last_sequence {0};
+    std::vector<uint32_t> m_acked_sequences;
+};
+
+/**
+ * @brief Replaces the position, orientation, linear and angular velocity pools
+ * of a registry snapshot by a compact encoding in `snapshot.motion`. Values
+ * are quantized to fixed-point, orientations use the smallest-three encoding,
+ * and each value is stored as a variable length delta from its value in the
+ * last snapshot acknowledged by the receiver, if it was present there.
+ * Nothing is done if the snapshot does not contain any of these components.
+ * @param snapshot Registry snapshot with entities in the sender's space.
+ * @param quantization Precision of values.
+ * @param history Snapshot history of the receiver, where the quantized values
+ * are inserted.
+ * @param fragment Index of the fragment if the snapshot was split. The last
+ * acknowledged fragment with the same index is used as the baseline.
+ */
+void compress_registry_snapshot(packet::registry_snapshot &snapshot,
+                                const snapshot_quantization &quantization,
+                                snapshot_baseline_history &history,
+                                uint32_t fragment = 0);
+
+/**
+ * @brief Restores the pools of a registry snapshot compressed with
+ * `compress_registry_snapshot`. Must be done before converting its entities
+ * into the local space.
+ * @param snapshot Registry snapshot with non-empty `motion`.
+ * @param history Snapshot history of the sender, where the quantized values
+ * are inserted.
+ * @param sequence Sequence number of the snapshot, which should be
+ * acknowledged.
+ * @return False if the data is invalid or if the baseline it was encoded
+ * against is not available anymore.
+ */
+bool decompress_registry_snapshot(packet::registry_snapshot &snapshot,
+                                  snapshot_baseline_history &history,
+                                  uint32_t &sequence);
+
+}
+
+#endif // EDYN_NETWORKING_UTIL_SNAPSHOT_COMPRESSION_HPP
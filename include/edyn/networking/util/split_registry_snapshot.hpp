@@ -0,0 +1,29 @@
+#ifndef EDYN_NETWORKING_UTIL_SPLIT_REGISTRY_SNAPSHOT_HPP
+#define EDYN_NETWORKING_UTIL_SPLIT_REGISTRY_SNAPSHOT_HPP
+
+#include <vector>
+#include <cstddef>
+#include "edyn/networking/packet/registry_snapshot.hpp"
+
+namespace edyn {
+
+/**
+ * @brief Splits a registry snapshot into fragments which can be sent and
+ * applied independently, each containing all components of at most
+ * `max_entities` entities.
+ * @param snapshot Snapshot to be split.
+ * @param order Indices of the entities in the snapshot in order of priority.
+ * The entities of higher priority are placed in the first fragments. Must be
+ * a permutation of the entity indices.
+ * @param max_entities Maximum number of entities per fragment.
+ * @return Fragments in order of priority, with the same timestamp as the
+ * snapshot.
+ */
+std::vector<packet::registry_snapshot>
+split_registry_snapshot(const packet::registry_snapshot &snapshot,
+                        const std::vector<size_t> &order,
+                        size_t max_entities);
+
+}
+
+#endif // EDYN_NETWORKING_UTIL_SPLIT_REGISTRY_SNAPSHOT_HPP
@@ -7,6 +7,7 @@
 #include <thread>
 #include <mutex>
 #include <shared_mutex>
+#include <condition_variable>
 #include "edyn/parallel/worker.hpp"
 
 namespace edyn {
@@ -16,7 +17,11 @@ class job_queue;
 class job_queue_scheduler;
 
 /**
- * Manages a set of worker threads and dispatches jobs to them.
+ * Manages a set of worker threads and dispatches jobs to them. Each worker
+ * has its own work-stealing deque where jobs scheduled by jobs running in that
+ * worker are inserted. Jobs scheduled from other threads are distributed
+ * among workers in a round-robin fashion. Idle workers steal jobs from the
+ * others.
  */
 class job_dispatcher {
 public:
@@ -31,7 +36,8 @@ public:
     bool running() const;
 
     /**
-     * Schedules a job to run asynchronously in a worker thread.
+     * Schedules a job to run asynchronously in a worker thread. If called
+     * from a worker thread, the job is inserted in that worker's deque.
      */
     void async(const job &);
 
@@ -72,9 +78,39 @@ public:
      */
     size_t num_workers() const;
 
+    /**
+     * Total time in seconds the background workers spent running jobs. Only
+     * measured if profiling is enabled at compile time.
+     */
+    double busy_time() const;
+
 private:
+    friend class worker;
+
+    // Attempts to steal a job from any worker other than the thief.
+    bool steal(job &, size_t thief_index, uint32_t &random_state);
+
+    // Puts the calling worker thread to sleep until jobs are scheduled or
+    // the dispatcher is stopped.
+    void park();
+
+    // Wakes up one sleeping worker, if any.
+    void unpark_one();
+
+    bool has_jobs() const;
+
+    bool is_worker_thread() const;
+
     std::vector<std::unique_ptr<std::thread>> m_threads;
-    std::map<std::thread::id, std::unique_ptr<worker>> m_workers;
+    std::vector<std::unique_ptr<worker>> m_workers;
+    std::atomic<bool> m_running {false};
+
+    // Sleeping workers wait on the condition variable until the epoch
+    // changes.
+    std::mutex m_park_mutex;
+    std::condition_variable m_park_cv;
+    std::atomic<size_t> m_num_parked {0};
+    uint64_t m_park_epoch {0};
 
     // Job queue for regular threads.
     std::vector<job_queue *> m_queues;
@@ -84,7 +120,8 @@ private:
     // Job queue for this thread.
     static thread_local job_queue m_queue;
 
-    std::atomic<size_t> m_start;
+    // Index of the next worker to receive a job from a non-worker thread.
+    std::atomic<size_t> m_next_worker {0};
 };
 
 }
@@ -3,11 +3,13 @@
 
 #include <entt/entity/fwd.hpp>
 #include "edyn/collision/raycast.hpp"
+#include "edyn/collision/shape_cast.hpp"
 #include "edyn/comp/aabb.hpp"
 #include "edyn/comp/island.hpp"
 #include "edyn/context/registry_operation_context.hpp"
 #include "edyn/math/vector3.hpp"
 #include "edyn/context/settings.hpp"
+#include "edyn/context/step_stats.hpp"
 #include "edyn/dynamics/material_mixing.hpp"
 #include "edyn/networking/extrapolation/extrapolation_modified_comp.hpp"
 #include "edyn/networking/util/input_state_history.hpp"
@@ -48,6 +50,9 @@ struct set_com {
 struct step_update {
     registry_operation ops;
     double timestamp;
+    // Stats of the steps performed since the last update. Only present if
+    // profiling is enabled.
+    std::vector<step_stats> stats;
 };
 
 /**
@@ -79,6 +84,19 @@ struct raycast_response {
     raycast_result result;
 };
 
+struct shape_cast_request {
+    unsigned id;
+    cast_shapes_variant_t shape;
+    quaternion orn;
+    vector3 p0, p1;
+    std::vector<entt::entity> ignore_entities;
+};
+
+struct shape_cast_response {
+    unsigned id;
+    shape_cast_result result;
+};
+
 struct query_aabb_request {
     unsigned id;
     AABB aabb;
@@ -71,7 +71,7 @@ void parallel_for_async_job_func(job::data_type &data) {
         }
     }
 
-    auto ref_count = ctx->ref_counter.fetch_sub(1, std::memory_order_relaxed) - 1;
+    auto ref_count = ctx->ref_counter.fetch_sub(1, std::memory_order_acq_rel) - 1;
     EDYN_ASSERT(ref_count >= 0);
 
     if (ref_count == 0) {
@@ -147,7 +147,7 @@ void parallel_for_each_async_job_func(job::data_type &data) {
         }
     }
 
-    auto ref_count = ctx->ref_counter.fetch_sub(1, std::memory_order_relaxed) - 1;
+    auto ref_count = ctx->ref_counter.fetch_sub(1, std::memory_order_acq_rel) - 1;
     EDYN_ASSERT(ref_count >= 0);
 
     if (ref_count == 0) {
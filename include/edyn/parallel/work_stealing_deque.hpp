@@ -0,0 +1,185 @@
+#ifndef EDYN_PARALLEL_WORK_STEALING_DEQUE_HPP
+#define EDYN_PARALLEL_WORK_STEALING_DEQUE_HPP
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "edyn/parallel/job.hpp"
+
+namespace edyn {
+
+/**
+ * Lock-free double-ended queue of jobs where the owner thread pushes and pops
+ * jobs at the bottom and other threads steal jobs from the top, i.e. a
+ * Chase-Lev deque, with the memory orderings described in "Correct and
+ * Efficient Work-Stealing for Weak Memory Models" by Lê et al.
+ */
+class work_stealing_deque {
+    static_assert(std::is_trivially_copyable_v<job>);
+    static constexpr size_t num_words = (sizeof(job) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    // A job stored as atomic words, since a thief might read a slot while the
+    // owner overwrites it. In that case the thief's compare-and-swap fails and
+    // the torn job is discarded.
+    struct slot {
+        std::array<std::atomic<uint64_t>, num_words> words;
+
+        void store(const job &j) {
+            std::array<uint64_t, num_words> tmp {};
+            std::memcpy(tmp.data(), &j, sizeof(job));
+
+            for (size_t i = 0; i < num_words; ++i) {
+                words[i].store(tmp[i], std::memory_order_relaxed);
+            }
+        }
+
+        void load(job &j) const {
+            std::array<uint64_t, num_words> tmp;
+
+            for (size_t i = 0; i < num_words; ++i) {
+                tmp[i] = words[i].load(std::memory_order_relaxed);
+            }
+
+            std::memcpy(&j, tmp.data(), sizeof(job));
+        }
+    };
+
+    struct ring_buffer {
+        int64_t mask;
+        std::unique_ptr<slot[]> slots;
+
+        ring_buffer(int64_t capacity)
+            : mask(capacity - 1)
+            , slots(new slot[capacity])
+        {}
+
+        int64_t capacity() const {
+            return mask + 1;
+        }
+
+        slot & operator[](int64_t index) {
+            return slots[index & mask];
+        }
+    };
+
+public:
+    /**
+     * @param capacity Initial capacity. Must be a power of two.
+     */
+    work_stealing_deque(int64_t capacity = 256) {
+        m_buffers.push_back(std::make_unique<ring_buffer>(capacity));
+        m_buffer.store(m_buffers.back().get(), std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Inserts a job at the bottom. Must only be called by the owner.
+     */
+    void push(const job &j) {
+        auto bottom = m_bottom.load(std::memory_order_relaxed);
+        auto top = m_top.load(std::memory_order_acquire);
+        auto *buffer = m_buffer.load(std::memory_order_relaxed);
+
+        if (bottom - top > buffer->capacity() - 1) {
+            buffer = grow(buffer, top, bottom);
+        }
+
+        (*buffer)[bottom].store(j);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Removes the job at the bottom. Must only be called by the owner.
+     * @param j Receives the job.
+     * @return Whether a job was removed.
+     */
+    bool pop(job &j) {
+        auto bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+        auto *buffer = m_buffer.load(std::memory_order_relaxed);
+        m_bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto top = m_top.load(std::memory_order_relaxed);
+
+        if (top > bottom) {
+            // Empty.
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        (*buffer)[bottom].load(j);
+
+        if (top == bottom) {
+            // Last job. Race against thieves.
+            auto won = m_top.compare_exchange_strong(top, top + 1,
+                                                     std::memory_order_seq_cst,
+                                                     std::memory_order_relaxed);
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return won;
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Removes the job at the top. Can be called from any thread.
+     * @param j Receives the job.
+     * @return Whether a job was stolen.
+     */
+    bool steal(job &j) {
+        auto top = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto bottom = m_bottom.load(std::memory_order_acquire);
+
+        if (top >= bottom) {
+            return false;
+        }
+
+        auto *buffer = m_buffer.load(std::memory_order_acquire);
+        (*buffer)[top].load(j);
+
+        return m_top.compare_exchange_strong(top, top + 1,
+                                             std::memory_order_seq_cst,
+                                             std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Approximate check for emptiness which can be called from any
+     * thread.
+     */
+    bool empty() const {
+        auto bottom = m_bottom.load(std::memory_order_relaxed);
+        auto top = m_top.load(std::memory_order_relaxed);
+        return top >= bottom;
+    }
+
+private:
+    ring_buffer * grow(ring_buffer *buffer, int64_t top, int64_t bottom) {
+        auto grown = std::make_unique<ring_buffer>(buffer->capacity() * 2);
+        job j;
+
+        for (auto i = top; i < bottom; ++i) {
+            (*buffer)[i].load(j);
+            (*grown)[i].store(j);
+        }
+
+        // Thieves might still be reading from previous buffers, thus they're
+        // kept alive until the deque is destroyed.
+        auto *ptr = grown.get();
+        m_buffers.push_back(std::move(grown));
+        m_buffer.store(ptr, std::memory_order_release);
+        return ptr;
+    }
+
+    std::atomic<int64_t> m_top {0};
+    std::atomic<int64_t> m_bottom {0};
+    std::atomic<ring_buffer *> m_buffer;
+    std::vector<std::unique_ptr<ring_buffer>> m_buffers;
+};
+
+}
+
+#endif // EDYN_PARALLEL_WORK_STEALING_DEQUE_HPP
@@ -3,59 +3,78 @@
 
 #include <atomic>
 #include <memory>
+#include <cstdint>
+#include "edyn/build_settings.h"
 #include "edyn/parallel/job_queue.hpp"
+#include "edyn/parallel/work_stealing_deque.hpp"
 
 namespace edyn {
 
+class job_dispatcher;
+
 /**
- * A worker that runs jobs in a thread.
+ * A worker that runs jobs in a thread. Jobs scheduled from the worker thread
+ * itself go into a work-stealing deque, from which idle workers steal. Jobs
+ * scheduled from other threads go into the inbox. When out of jobs, it spins
+ * for a while looking for jobs to steal before going to sleep.
  */
 class worker {
 public:
-    void push_job(const job &j) {
-        m_queue.push(j);
-        ++m_size;
-    }
+    worker(job_dispatcher &dispatcher, size_t index);
 
-    void run() {
-        m_running = true;
+    /**
+     * Schedules a job from the thread running this worker.
+     */
+    void push_local(const job &);
 
-        for (;;) {
-            auto j = m_queue.pop();
-            j();
-            --m_size;
+    /**
+     * Schedules a job from any thread.
+     */
+    void push(const job &);
 
-            if (!m_running) {
-                break;
-            }
-        }
-    }
+    /**
+     * Takes a job from this worker to be run in another thread.
+     */
+    bool steal(job &);
 
-    void once() {
-        job j;
-        while (m_queue.try_pop(j)) {
-            j();
-            --m_size;
-        }
-    }
+    bool has_jobs() const;
 
-    void stop() {
-        m_running = false;
-        m_queue.push(job::noop()); // Unblock queue with a no-op job.
+    void run();
+
+    /**
+     * Returns the worker running in the current thread, if any.
+     */
+    static worker * current();
+
+    job_dispatcher & get_dispatcher() {
+        return *m_dispatcher;
     }
 
-    size_t size() {
-        return m_size.load();
+    /**
+     * Index of this worker in its dispatcher.
+     */
+    size_t index() const {
+        return m_index;
     }
 
-    job_queue &get_queue() {
-        return m_queue;
+    /**
+     * Total time spent running jobs in units of the performance counter. Only
+     * measured if profiling is enabled at compile time.
+     */
+    uint64_t busy_counter() const {
+        return m_busy_counter.load(std::memory_order_relaxed);
     }
 
 private:
-    std::atomic_bool m_running {false};
-    job_queue m_queue;
-    std::atomic<size_t> m_size {0};
+    bool find_job(job &);
+    void execute(job &);
+
+    job_dispatcher *m_dispatcher;
+    size_t m_index;
+    work_stealing_deque m_deque;
+    job_queue m_inbox;
+    uint32_t m_random_state;
+    std::atomic<uint64_t> m_busy_counter {0};
 };
 
 }
@@ -39,6 +39,14 @@ public:
         return m_file.eof();
     }
 
+    bool failed() const {
+        return m_file.fail();
+    }
+
+    void set_failed() {
+        m_file.setstate(std::ios::failbit);
+    }
+
     template<typename T>
     void operator()(T& t) {
         if constexpr(std::is_fundamental_v<T>) {
@@ -60,6 +68,15 @@ public:
         return m_file.tellg();
     }
 
+    /**
+     * @brief Reads a block of bytes.
+     * @return Whether all bytes were read.
+     */
+    bool read_raw(void *data, size_t size) {
+        m_file.read(reinterpret_cast<char *>(data), size);
+        return static_cast<size_t>(m_file.gcount()) == size;
+    }
+
 protected:
     template<typename T>
     void read_bytes(T &t) {
@@ -99,6 +116,13 @@ public:
         m_file.close();
     }
 
+    /**
+     * @brief Writes a block of bytes.
+     */
+    void write_raw(const void *data, size_t size) {
+        m_file.write(reinterpret_cast<const char *>(data), size);
+    }
+
 private:
     template<typename T>
     void write_bytes(T &t) {
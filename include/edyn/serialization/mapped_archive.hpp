@@ -0,0 +1,195 @@
+#ifndef EDYN_SERIALIZATION_MAPPED_ARCHIVE_HPP
+#define EDYN_SERIALIZATION_MAPPED_ARCHIVE_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include "edyn/config/config.h"
+#include "edyn/serialization/std_s11n.hpp"
+
+namespace edyn {
+
+/**
+ * Archives with a layout suited to be memory-mapped. The contents of vectors
+ * of trivially copyable types are stored contiguously and aligned to
+ * `mapped_archive_alignment` bytes relative to the start of the buffer, thus
+ * they can be accessed in place or copied with a single `memcpy`. Sizes are
+ * 64-bit.
+ */
+constexpr size_t mapped_archive_alignment = 16;
+
+class mapped_output_archive {
+public:
+    using data_type = uint8_t;
+    using buffer_type = std::vector<data_type>;
+    using is_input = std::false_type;
+    using is_output = std::true_type;
+
+    mapped_output_archive(buffer_type &buffer)
+        : m_buffer(&buffer)
+    {}
+
+    template<typename T>
+    void operator()(T& t) {
+        if constexpr(std::is_fundamental_v<T>) {
+            write_bytes(&t, sizeof(T));
+        } else if constexpr(!std::is_empty_v<T>) {
+            serialize(*this, t);
+        }
+    }
+
+    template<typename... Ts>
+    void operator()(Ts&... t) {
+        (operator()(t), ...);
+    }
+
+    void align(size_t alignment = mapped_archive_alignment) {
+        auto size = m_buffer->size();
+        m_buffer->resize((size + alignment - 1) / alignment * alignment, 0);
+    }
+
+    void write_bytes(const void *data, size_t size) {
+        if (size == 0) {
+            return;
+        }
+
+        auto *bytes = static_cast<const data_type *>(data);
+        m_buffer->insert(m_buffer->end(), bytes, bytes + size);
+    }
+
+private:
+    buffer_type *m_buffer;
+};
+
+class mapped_input_archive {
+public:
+    using data_type = uint8_t;
+    using buffer_type = const data_type*;
+    using is_input = std::true_type;
+    using is_output = std::false_type;
+
+    mapped_input_archive(buffer_type buffer, size_t size)
+        : m_buffer(buffer)
+        , m_size(size)
+    {}
+
+    template<typename T>
+    void operator()(T& t) {
+        if constexpr(std::is_fundamental_v<T>) {
+            read_bytes(&t, sizeof(T));
+        } else if constexpr(!std::is_empty_v<T>) {
+            serialize(*this, t);
+        }
+    }
+
+    template<typename... Ts>
+    void operator()(Ts&... t) {
+        (operator()(t), ...);
+    }
+
+    void align(size_t alignment = mapped_archive_alignment) {
+        m_position = (m_position + alignment - 1) / alignment * alignment;
+    }
+
+    /**
+     * @brief Returns a pointer to the next `size` bytes and advances past them,
+     * or null if there are not enough bytes left.
+     */
+    buffer_type consume(uint64_t size) {
+        if (m_failed || m_position > m_size || size > m_size - m_position) {
+            m_failed = true;
+            return nullptr;
+        }
+
+        auto *ptr = m_buffer + m_position;
+        m_position += size;
+        return ptr;
+    }
+
+    void read_bytes(void *data, size_t size) {
+        if (auto *ptr = consume(size)) {
+            std::memcpy(data, ptr, size);
+        }
+    }
+
+    bool failed() const {
+        return m_failed;
+    }
+
+    void set_failed() {
+        m_failed = true;
+    }
+
+private:
+    buffer_type m_buffer;
+    size_t m_size;
+    size_t m_position {0};
+    bool m_failed {false};
+};
+
+template<typename T>
+void serialize(mapped_output_archive &archive, std::vector<T> &vector) {
+    auto size = static_cast<uint64_t>(vector.size());
+    archive(size);
+
+    if constexpr(std::is_trivially_copyable_v<T>) {
+        archive.align();
+        archive.write_bytes(vector.data(), vector.size() * sizeof(T));
+    } else {
+        for (auto &value : vector) {
+            archive(value);
+        }
+    }
+}
+
+template<typename T>
+void serialize(mapped_input_archive &archive, std::vector<T> &vector) {
+    uint64_t size = 0;
+    archive(size);
+
+    if constexpr(std::is_trivially_copyable_v<T>) {
+        archive.align();
+
+        // Size might be invalid if the data is corrupted.
+        auto num_bytes = size <= UINT64_MAX / sizeof(T) ? size * sizeof(T) : UINT64_MAX;
+
+        if (auto *ptr = archive.consume(num_bytes); ptr && size > 0) {
+            vector.resize(size);
+            std::memcpy(vector.data(), ptr, num_bytes);
+        } else {
+            vector.clear();
+        }
+    } else {
+        vector.clear();
+
+        for (uint64_t i = 0; i < size && !archive.failed(); ++i) {
+            archive(vector.emplace_back());
+        }
+    }
+}
+
+// Bits are stored as bytes so they can be read without unpacking.
+inline void serialize(mapped_output_archive &archive, std::vector<bool> &vector) {
+    auto size = static_cast<uint64_t>(vector.size());
+    archive(size);
+
+    for (bool value : vector) {
+        auto byte = static_cast<uint8_t>(value);
+        archive(byte);
+    }
+}
+
+inline void serialize(mapped_input_archive &archive, std::vector<bool> &vector) {
+    uint64_t size = 0;
+    archive(size);
+
+    if (auto *ptr = archive.consume(size)) {
+        vector.assign(ptr, ptr + size);
+    }
+}
+
+}
+
+#endif // EDYN_SERIALIZATION_MAPPED_ARCHIVE_HPP
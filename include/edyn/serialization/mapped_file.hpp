@@ -0,0 +1,58 @@
+#ifndef EDYN_SERIALIZATION_MAPPED_FILE_HPP
+#define EDYN_SERIALIZATION_MAPPED_FILE_HPP
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace edyn {
+
+/**
+ * @brief A read-only memory mapping of an entire file. Pages are loaded on
+ * demand by the operating system and cached in the page cache, thus they are
+ * shared among all mappings of the same file and survive closing the mapping.
+ */
+class mapped_file {
+public:
+    mapped_file() = default;
+    mapped_file(const std::string &path);
+    ~mapped_file();
+
+    mapped_file(const mapped_file &) = delete;
+    mapped_file & operator=(const mapped_file &) = delete;
+    mapped_file(mapped_file &&) noexcept;
+    mapped_file & operator=(mapped_file &&) noexcept;
+
+    bool open(const std::string &path);
+    void close();
+
+    bool is_open() const {
+        return m_data != nullptr;
+    }
+
+    const uint8_t * data() const {
+        return m_data;
+    }
+
+    size_t size() const {
+        return m_size;
+    }
+
+    /**
+     * @brief Hints that a range of the file will be accessed soon, which
+     * allows the operating system to start reading it in the background.
+     * @param offset Start of range in bytes.
+     * @param size Size of range in bytes.
+     */
+    void will_need(size_t offset, size_t size) const;
+
+private:
+    const uint8_t *m_data {nullptr};
+    size_t m_size {0};
+    // Platform-specific handle of the mapping.
+    void *m_handle {nullptr};
+};
+
+}
+
+#endif // EDYN_SERIALIZATION_MAPPED_FILE_HPP
@@ -44,6 +44,10 @@ public:
         return m_failed;
     }
 
+    void set_failed() {
+        m_failed = true;
+    }
+
 protected:
     template<typename T>
     void read_bytes(T &t) {
@@ -0,0 +1,93 @@
+#ifndef EDYN_SERIALIZATION_PAGED_TRIANGLE_MESH_MAPPED_HPP
+#define EDYN_SERIALIZATION_PAGED_TRIANGLE_MESH_MAPPED_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <entt/signal/sigh.hpp>
+#include "edyn/parallel/job.hpp"
+#include "edyn/serialization/mapped_file.hpp"
+#include "edyn/shapes/triangle_mesh_page_loader.hpp"
+
+namespace edyn {
+
+class paged_triangle_mesh;
+
+/**
+ * @brief Writes a `paged_triangle_mesh` and all its submeshes into a single
+ * file with a layout suited to be memory-mapped and loaded with
+ * `paged_triangle_mesh_mapped_loader`. Each submesh is stored in a contiguous
+ * block aligned to `mapped_submesh_alignment`, where the arrays of vertices,
+ * indices, normals and tree nodes are stored contiguously.
+ * @param path Destination file path.
+ * @param paged_tri_mesh The paged triangle mesh, with all submeshes loaded.
+ * @return Whether the file was written successfully.
+ */
+bool write_mapped_paged_triangle_mesh(const std::string &path, paged_triangle_mesh &paged_tri_mesh);
+
+/**
+ * Page loader which memory-maps a file written with
+ * `write_mapped_paged_triangle_mesh`. Reading a submesh does not involve any
+ * system calls besides page faults. It is not zero-copy: each array is
+ * copied into the `triangle_mesh` with a single `memcpy` from the operating
+ * system's page cache. Multiple submeshes can be loaded concurrently.
+ */
+class paged_triangle_mesh_mapped_loader : public triangle_mesh_page_loader_base {
+public:
+    static constexpr size_t mapped_submesh_alignment = 64;
+
+    paged_triangle_mesh_mapped_loader() = default;
+    paged_triangle_mesh_mapped_loader(const std::string &path);
+
+    bool open(const std::string &path);
+
+    bool is_open() const {
+        return m_file.is_open();
+    }
+
+    /**
+     * @brief Reads the tree and submesh information into a paged triangle
+     * mesh, which should use this loader.
+     * @param paged_tri_mesh The paged triangle mesh.
+     * @return Whether the data is valid.
+     */
+    bool read(paged_triangle_mesh &paged_tri_mesh) const;
+
+    /**
+     * @brief Loads a submesh in a background job and publishes it once done.
+     * The operating system is advised to start reading its pages while the
+     * job is queued. A null mesh is published if the data is invalid.
+     * @param index Submesh index.
+     */
+    void load(size_t index) override;
+
+    /**
+     * @brief Loads a submesh in the calling thread.
+     * @param index Submesh index.
+     * @return The submesh or null if the data is invalid.
+     */
+    std::shared_ptr<triangle_mesh> load_submesh(size_t index) const;
+
+    entt::sink<entt::sigh<loaded_mesh_func_t>> on_load_sink() override {
+        return {m_loaded_signal};
+    }
+
+    friend void load_mapped_mesh_job_func(job::data_type &);
+
+private:
+    struct submesh_location {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    mapped_file m_file;
+    std::vector<submesh_location> m_locations;
+    entt::sigh<loaded_mesh_func_t> m_loaded_signal;
+};
+
+void load_mapped_mesh_job_func(job::data_type &);
+
+}
+
+#endif // EDYN_SERIALIZATION_PAGED_TRIANGLE_MESH_MAPPED_HPP
@@ -5,6 +5,7 @@
 #include "edyn/shapes/paged_triangle_mesh.hpp"
 #include "edyn/shapes/triangle_mesh_page_loader.hpp"
 #include "edyn/serialization/file_archive.hpp"
+#include "edyn/serialization/triangle_mesh_compression.hpp"
 #include "edyn/parallel/job_queue_scheduler.hpp"
 #include "edyn/parallel/job.hpp"
 #include <entt/signal/sigh.hpp>
@@ -36,7 +37,18 @@ enum class paged_triangle_mesh_serialization_mode: uint8_t {
     /**
      * Writes to/reads from separate individual files for each submesh as needed.
      */
-    external
+    external,
+
+    /**
+     * Same as `embedded` with submeshes encoded using `compress_triangle_mesh`,
+     * which makes files several times smaller at the cost of precision.
+     */
+    embedded_compressed,
+
+    /**
+     * Same as `external` with submeshes encoded using `compress_triangle_mesh`.
+     */
+    external_compressed
 };
 
 template<typename Archive>
@@ -61,12 +73,20 @@ class paged_triangle_mesh_file_output_archive: public file_output_archive {
 public:
     using super = file_output_archive;
 
+    /**
+     * @param path Path of output file.
+     * @param mode How submeshes are written.
+     * @param quantization_step Grid spacing of vertices in the compressed
+     * modes. See `compress_triangle_mesh`.
+     */
     paged_triangle_mesh_file_output_archive(const std::string &path,
-                                            paged_triangle_mesh_serialization_mode mode)
+                                            paged_triangle_mesh_serialization_mode mode,
+                                            scalar quantization_step = default_triangle_mesh_quantization_step)
         : super(path)
         , m_path(path)
         , m_triangle_mesh_index(0)
         , m_mode(mode)
+        , m_quantization_step(quantization_step)
     {}
 
     template<typename... Ts>
@@ -92,6 +112,7 @@ private:
     std::string m_path;
     size_t m_triangle_mesh_index;
     paged_triangle_mesh_serialization_mode m_mode;
+    scalar m_quantization_step;
 };
 
 /**
@@ -2,34 +2,60 @@
 #define EDYN_SERIALIZATION_STATIC_TREE_S11N_HPP
 
 #include "edyn/collision/static_tree.hpp"
+#include "edyn/serialization/std_s11n.hpp"
+#include <cstdint>
 
 namespace edyn {
 
 template<typename Archive>
 void serialize(Archive &archive, static_tree::tree_node &node) {
-    archive(node.aabb.min);
-    archive(node.aabb.max);
-    archive(node.child1);
-    archive(node.child2);
+    archive(node.min);
+    archive(node.max);
+    archive(node.skip);
+    archive(node.id);
 }
 
+/**
+ * @brief Version of the serialized layout of a `static_tree`. It is written
+ * ahead of the tree and an input archive is marked as failed if it does not
+ * match, since trees written with a different node layout cannot be read.
+ */
+constexpr uint32_t static_tree_serialization_version = 2;
+
 template<typename Archive>
 void serialize(Archive &archive, static_tree &tree) {
+    auto version = static_tree_serialization_version;
+    archive(version);
+
+    if constexpr(Archive::is_input::value) {
+        if (version != static_tree_serialization_version) {
+            tree.m_root_aabb = {};
+            tree.m_nodes.clear();
+            archive.set_failed();
+            return;
+        }
+    }
+
+    archive(tree.m_root_aabb);
     archive(tree.m_nodes);
 }
 
 inline
 size_t serialization_sizeof(const static_tree::tree_node &node) {
     return 
-        sizeof(node.aabb.min) +
-        sizeof(node.aabb.max) +
-        sizeof(node.child1) +
-        sizeof(node.child2);
+        sizeof(node.min) +
+        sizeof(node.max) +
+        sizeof(node.skip) +
+        sizeof(node.id);
 }
 
 inline
 size_t serialization_sizeof(const static_tree &tree) {
-    return serialization_sizeof(tree.m_nodes);
+    return
+        sizeof(static_tree_serialization_version) +
+        sizeof(tree.m_root_aabb.min) +
+        sizeof(tree.m_root_aabb.max) +
+        serialization_sizeof(tree.m_nodes);
 }
 
 }
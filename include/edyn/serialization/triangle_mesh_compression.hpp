@@ -0,0 +1,49 @@
+#ifndef EDYN_SERIALIZATION_TRIANGLE_MESH_COMPRESSION_HPP
+#define EDYN_SERIALIZATION_TRIANGLE_MESH_COMPRESSION_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "edyn/math/scalar.hpp"
+
+namespace edyn {
+
+class triangle_mesh;
+
+/**
+ * @brief Default distance between points of the grid vertices are snapped to
+ * when compressing a triangle mesh, which is about one millimeter.
+ */
+constexpr scalar default_triangle_mesh_quantization_step = scalar(1) / scalar(1024);
+
+/**
+ * @brief Encodes a triangle mesh in a compact lossy format. Vertices are
+ * snapped to a grid with the given spacing which is anchored at the origin,
+ * thus vertices shared by neighboring submeshes of a paged triangle mesh
+ * remain coincident after compression. They're stored as variable length
+ * deltas from the minimum of the bounds of the mesh in grid units. Vertex
+ * indices are stored as variable length deltas as well. Face normals and
+ * edges are not stored since they can be recalculated. Only the layout of
+ * the triangle tree is stored, which avoids building it from scratch. Edge
+ * convexity and adjacent normals of boundary edges are stored since
+ * they might depend on triangles which are not part of the mesh.
+ * @param tri_mesh A fully initialized triangle mesh.
+ * @param output Buffer where data is appended.
+ * @param quantization_step Grid spacing. Should be much smaller than the
+ * smallest triangle to avoid producing degenerate triangles.
+ */
+void compress_triangle_mesh(const triangle_mesh &tri_mesh, std::vector<uint8_t> &output,
+                            scalar quantization_step = default_triangle_mesh_quantization_step);
+
+/**
+ * @brief Decodes a triangle mesh encoded with `compress_triangle_mesh`.
+ * @param data Pointer to encoded data.
+ * @param size Size of encoded data in bytes.
+ * @param tri_mesh An empty triangle mesh which will be initialized.
+ * @return Whether the data is valid.
+ */
+bool decompress_triangle_mesh(const uint8_t *data, size_t size, triangle_mesh &tri_mesh);
+
+}
+
+#endif // EDYN_SERIALIZATION_TRIANGLE_MESH_COMPRESSION_HPP
@@ -0,0 +1,68 @@
+#ifndef EDYN_SERIALIZATION_VARINT_HPP
+#define EDYN_SERIALIZATION_VARINT_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace edyn {
+
+/**
+ * @brief Appends an unsigned integer using a variable length encoding where
+ * each byte holds 7 bits of the value and the high bit indicates whether
+ * more bytes follow.
+ * @param output Buffer where data is appended.
+ * @param value Value to be encoded.
+ */
+inline void write_varint(std::vector<uint8_t> &output, uint64_t value) {
+    while (value >= 0x80) {
+        output.push_back(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+
+    output.push_back(static_cast<uint8_t>(value));
+}
+
+/**
+ * @brief Decodes an unsigned integer encoded with `write_varint`.
+ * @param data Pointer to encoded data.
+ * @param size Size of encoded data in bytes.
+ * @param position Offset where the value starts. Advanced past the value.
+ * @param value Decoded value.
+ * @return False if the data ends before the value does or if the value does
+ * not fit in 64 bits.
+ */
+inline bool read_varint(const uint8_t *data, size_t size, size_t &position, uint64_t &value) {
+    value = 0;
+
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (position >= size) {
+            return false;
+        }
+
+        auto byte = data[position++];
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Maps signed integers to unsigned so that values of small magnitude
+ * have a short variable length encoding.
+ */
+inline uint64_t zigzag_encode(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t zigzag_decode(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+}
+
+#endif // EDYN_SERIALIZATION_VARINT_HPP
@@ -38,7 +38,7 @@ struct submesh_builder {
                VertexIterator vertex_begin, IndexIterator index_begin,
                const std::vector<vector3> &vertex_colors) {
         // Allocate space in cache for all submeshes.
-        paged_tri_mesh.m_cache.resize(infos.size());
+        paged_tri_mesh.init_cache(infos.size());
 
         // Create submeshes using the triangle indices stored in the `build_info`s.
         parallel_for(size_t{0}, infos.size(), [&](size_t idx) {
@@ -221,12 +221,8 @@ void create_paged_triangle_mesh(
     paged_tri_mesh.m_tree.build(aabbs.begin(), aabbs.end(), builder, max_tri_per_submesh);
     builder.build(paged_tri_mesh, global_tri_mesh, vertex_begin, index_begin, vertex_colors);
 
-    // Resize LRU queue to have the number of leaves.
-    paged_tri_mesh.m_lru_indices.resize(paged_tri_mesh.m_cache.size());
-    std::iota(paged_tri_mesh.m_lru_indices.begin(),
-              paged_tri_mesh.m_lru_indices.end(), 0);
-
-    paged_tri_mesh.m_is_loading_submesh = std::make_unique<std::atomic<bool>[]>(paged_tri_mesh.m_cache.size());
+    // All submeshes start loaded.
+    paged_tri_mesh.track_loaded_nodes();
 }
 
 }
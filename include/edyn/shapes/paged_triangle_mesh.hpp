@@ -5,6 +5,8 @@
 #include <vector>
 #include <atomic>
 #include <memory>
+#include <string>
+#include <limits>
 #include "edyn/math/constants.hpp"
 #include "edyn/shapes/triangle_mesh.hpp"
 #include "edyn/shapes/triangle_mesh_page_loader.hpp"
@@ -13,6 +15,7 @@ namespace edyn {
 
 class paged_triangle_mesh_file_input_archive;
 class paged_triangle_mesh_file_output_archive;
+class paged_triangle_mesh_mapped_loader;
 class finish_load_mesh_job;
 
 // Forward declaration of `detail::submesh_builder` needed by `friend`
@@ -26,11 +29,32 @@ namespace detail {
  */
 class paged_triangle_mesh {
 public:
+    static constexpr size_t null_node = std::numeric_limits<size_t>::max();
+
     struct triangle_mesh_node {
         size_t num_vertices;
         size_t num_indices;
         // Triangle mesh pointer. Will be nullptr if mesh is not loaded.
         std::shared_ptr<triangle_mesh> trimesh;
+        // Set if the loader failed to load this submesh, e.g. due to corrupt
+        // data, in which case it is not requested again.
+        bool load_failed {false};
+        // Neighbors in the circular list of loaded submeshes which is swept
+        // by the clock hand when looking for a submesh to unload.
+        size_t clock_prev {null_node};
+        size_t clock_next {null_node};
+    };
+
+    /**
+     * @brief Cache usage counters. A hit is a visit to a submesh that was
+     * already loaded and a miss is a visit to a submesh that was not.
+     */
+    struct cache_stats {
+        size_t hits;
+        size_t misses;
+        size_t evictions;
+        // Number of loads started by `prefetch_submeshes`.
+        size_t prefetches;
     };
 
     paged_triangle_mesh(std::shared_ptr<triangle_mesh_page_loader_base> loader);
@@ -45,17 +69,46 @@ public:
      */
     template<typename Func>
     void visit_submeshes(const AABB &aabb, Func func) {
+        auto counts = cache_query_counts{};
+
         m_tree.query(aabb, [&](auto tree_node_idx) {
             auto mesh_idx = m_tree.get_node(tree_node_idx).id;
-            load_node_if_needed(mesh_idx);
+            load_node_if_needed(mesh_idx, counts);
 
             if (m_cache[mesh_idx].trimesh) {
                 func(mesh_idx);
                 mark_recent_visit(mesh_idx);
             }
         });
+
+        add_cache_counts(counts);
     }
 
+    /**
+     * @brief Visits submeshes which intersect the given AABB without loading
+     * them.
+     * @tparam Func Type of the function object to invoke.
+     * @param aabb Query AABB.
+     * @param func Will be called with the submesh index and its bounds.
+     */
+    template<typename Func>
+    void visit_submesh_bounds(const AABB &aabb, Func func) const {
+        m_tree.query(aabb, [&](auto tree_node_idx) {
+            func(size_t(m_tree.get_node(tree_node_idx).id), m_tree.get_node_aabb(tree_node_idx));
+        });
+    }
+
+    /**
+     * @brief Starts loading the given submeshes ahead of a query, in order.
+     * Submeshes which are already loaded are marked as recently visited so
+     * they are not unloaded before the query. Stops once the submeshes being
+     * loaded would not fit in the free space of the cache plus the space of
+     * submeshes not visited recently, or would take more than half of the
+     * cache, to avoid unloading submeshes which are still in use.
+     * @param indices Submesh indices sorted by decreasing priority.
+     */
+    void prefetch_submeshes(const std::vector<size_t> &indices);
+
     /**
      * @brief Loops over all edges present in the cache.
      * @tparam Func Type of the function object to invoke.
@@ -86,9 +139,11 @@ public:
      */
     template<typename Func>
     void visit_triangles(const AABB &aabb, Func func) {
+        auto counts = cache_query_counts{};
+
         m_tree.query(aabb, [&](auto tree_node_idx) {
             auto mesh_idx = m_tree.get_node(tree_node_idx).id;
-            load_node_if_needed(mesh_idx);
+            load_node_if_needed(mesh_idx, counts);
             auto trimesh = m_cache[mesh_idx].trimesh;
 
             if (trimesh) {
@@ -98,6 +153,8 @@ public:
                 mark_recent_visit(mesh_idx);
             }
         });
+
+        add_cache_counts(counts);
     }
 
     /**
@@ -158,9 +215,11 @@ public:
      */
     template<typename Func>
     void raycast(const vector3 &p0, const vector3 &p1, Func func) {
+        auto counts = cache_query_counts{};
+
         m_tree.raycast(p0, p1, [&](auto tree_node_idx) {
             auto mesh_idx = m_tree.get_node(tree_node_idx).id;
-            load_node_if_needed(mesh_idx);
+            load_node_if_needed(mesh_idx, counts);
             auto trimesh = m_cache[mesh_idx].trimesh;
 
             if (trimesh) {
@@ -170,6 +229,8 @@ public:
                 mark_recent_visit(mesh_idx);
             }
         });
+
+        add_cache_counts(counts);
     }
 
     /**
@@ -203,10 +264,21 @@ public:
     }
 
     /**
-     * @brief Returns the number of vertices currently in the cache.
+     * @brief Returns the number of vertices currently in the cache, including
+     * submeshes which are still being loaded.
      * @return The size of the cache in number of vertices.
      */
-    size_t cache_num_vertices() const;
+    size_t cache_num_vertices() const {
+        return m_cache_num_vertices.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Returns the cache usage counters accumulated since creation or
+     * since the last call to `reset_cache_stats`.
+     */
+    cache_stats get_cache_stats() const;
+
+    void reset_cache_stats();
 
     size_t num_submeshes() const {
         return m_cache.size();
@@ -231,8 +303,8 @@ public:
 
     /**
      * @brief Maximum number of vertices in the cache. Before a new triangle mesh
-     * is loaded, if the number of vertices would exceed this number, the
-     * least recently visited nodes will be unloaded until the new total
+     * is loaded, if the number of vertices would exceed this number, nodes
+     * that were not visited recently will be unloaded until the new total
      * number of vertices stays below this value.
      */
     size_t m_max_cache_num_vertices = 1 << 13;
@@ -256,16 +328,62 @@ public:
     friend void serialize(paged_triangle_mesh_file_input_archive &archive,
                           paged_triangle_mesh &paged_tri_mesh);
 
+    friend class paged_triangle_mesh_mapped_loader;
+    friend bool write_mapped_paged_triangle_mesh(const std::string &path,
+                                                 paged_triangle_mesh &paged_tri_mesh);
+
 private:
-    void load_node_if_needed(size_t trimesh_idx);
-    void mark_recent_visit(size_t trimesh_idx);
-    void unload_least_recently_visited_node();
+    // Resizes the cache to hold the given number of submeshes, all unloaded.
+    void init_cache(size_t num_submeshes);
+    // Inserts the submeshes which are already loaded in the clock and
+    // recalculates the number of vertices in the cache.
+    void track_loaded_nodes();
+    // Hits and misses are counted locally during a query and added to the
+    // shared counters once at the end to avoid contention among threads
+    // visiting submeshes concurrently.
+    struct cache_query_counts {
+        size_t hits {0};
+        size_t misses {0};
+    };
+
+    void load_node_if_needed(size_t trimesh_idx, cache_query_counts &counts);
+    void add_cache_counts(const cache_query_counts &counts);
+    // Number of vertices that can be prefetched without unloading submeshes
+    // which were visited recently.
+    size_t prefetch_budget();
+    // Starts loading a submesh unless it is loaded or being loaded already.
+    // Returns whether the load was started.
+    bool start_loading(size_t trimesh_idx);
+
+    // Visits only set a flag, which is cleared as the clock hand sweeps
+    // over the node. Avoid writing to the flag if it's already set to keep
+    // the cache line shared among threads.
+    void mark_recent_visit(size_t trimesh_idx) {
+        auto &visited = m_recently_visited[trimesh_idx];
+
+        if (!visited.load(std::memory_order_relaxed)) {
+            visited.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    // All of the following must be called with `m_cache_mutex` locked.
+    void clock_insert(size_t trimesh_idx);
+    void clock_erase(size_t trimesh_idx);
+    // Unloads the first node found by the clock hand which was not visited
+    // since the last sweep. Returns false if no node is loaded.
+    bool unload_node();
 
     static_tree m_tree;
     std::vector<triangle_mesh_node> m_cache;
-    std::vector<size_t> m_lru_indices;
-    std::mutex m_lru_mutex;
+    size_t m_clock_hand {null_node};
+    std::mutex m_cache_mutex;
+    std::atomic<size_t> m_cache_num_vertices {0};
+    std::atomic<size_t> m_num_cache_hits {0};
+    std::atomic<size_t> m_num_cache_misses {0};
+    std::atomic<size_t> m_num_cache_evictions {0};
+    std::atomic<size_t> m_num_cache_prefetches {0};
     std::unique_ptr<std::atomic<bool>[]> m_is_loading_submesh;
+    std::unique_ptr<std::atomic<bool>[]> m_recently_visited;
     std::shared_ptr<triangle_mesh_page_loader_base> m_page_loader;
 };
 
@@ -186,6 +186,8 @@ public:
     friend void serialize(Archive &, triangle_mesh &);
     friend size_t serialization_sizeof(const triangle_mesh &);
     friend struct detail::submesh_builder;
+    friend void compress_triangle_mesh(const triangle_mesh &, std::vector<uint8_t> &, scalar);
+    friend bool decompress_triangle_mesh(const uint8_t *, size_t, triangle_mesh &);
 
 private:
     // Vertex positions.
@@ -1,10 +1,13 @@
 #ifndef EDYN_SIMULATION_ISLAND_MANAGER_HPP
 #define EDYN_SIMULATION_ISLAND_MANAGER_HPP
 
+#include <map>
 #include <vector>
+#include <unordered_map>
 #include <entt/entity/fwd.hpp>
 #include <entt/signal/sigh.hpp>
 #include <entt/entity/sparse_set.hpp>
+#include "edyn/core/entity_pair.hpp"
 
 namespace edyn {
 
@@ -12,12 +15,22 @@ class island_manager {
     void init_new_nodes_and_edges();
     entt::entity create_island();
     void insert_to_island(entt::entity island_entity,
-                          const std::vector<entt::entity> &nodes,
+                          const entt::sparse_set &nodes,
                           const std::vector<entt::entity> &edges);
-    void merge_islands(const std::vector<entt::entity> &island_entities,
-                       const std::vector<entt::entity> &new_nodes,
-                       const std::vector<entt::entity> &new_edges);
+    // Moves all entities into the biggest island. New nodes and edges are
+    // passed in the containers that will receive the entities of the other
+    // islands.
+    void merge_islands(const entt::sparse_set &island_entities,
+                       entt::sparse_set &nodes,
+                       std::vector<entt::entity> &edges);
+    // Keep track of the number of edges connecting a non-procedural node to
+    // each island. Erasing returns the non-procedural node if it has no edges
+    // left in the island, or null otherwise.
+    void insert_non_procedural_edge(entt::entity edge_entity, entt::entity island_entity);
+    entt::entity erase_non_procedural_edge(entt::entity edge_entity, entt::entity island_entity);
+    void remove_non_procedural_node(entt::entity node_entity, entt::entity island_entity);
     void split_islands();
+    void split_island(entt::entity island_entity, const std::vector<entt::entity> &seed_nodes);
     void wake_up_islands();
 
     bool could_go_to_sleep(entt::entity island_entity) const;
@@ -47,7 +60,15 @@ private:
     std::vector<entt::entity> m_new_graph_nodes;
     std::vector<entt::entity> m_new_graph_edges;
     entt::sparse_set m_islands_to_split;
+    // Procedural nodes which were connected by edges that were destroyed.
+    // Splits are searched starting at these nodes.
+    std::vector<entt::entity> m_split_seed_nodes;
     entt::sparse_set m_islands_to_wake_up;
+    // Non-procedural node of edges in islands that have one.
+    std::unordered_map<entt::entity, entt::entity> m_edge_non_procedural_nodes;
+    // Number of edges of a non-procedural node in an island, keyed by the
+    // node and the island.
+    std::map<entity_pair, unsigned> m_non_procedural_edge_counts;
     std::vector<entt::scoped_connection> m_connections;
     double m_last_time;
 };
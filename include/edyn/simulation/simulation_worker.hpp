@@ -7,6 +7,7 @@
 #include <entt/entity/fwd.hpp>
 #include "edyn/collision/raycast.hpp"
 #include "edyn/collision/raycast_service.hpp"
+#include "edyn/collision/shape_cast_service.hpp"
 #include "edyn/collision/contact_manifold.hpp"
 #include "edyn/dynamics/solver.hpp"
 #include "edyn/parallel/message.hpp"
@@ -35,6 +36,7 @@ class simulation_worker final {
 
     void wake_up_affected_islands(const registry_operation &ops);
     void consume_raycast_results();
+    void consume_shape_cast_results();
     void mark_transforms_replaced();
 
 public:
@@ -54,6 +56,7 @@ public:
     void on_set_material_table(message<msg::set_material_table> &msg);
     void on_set_com(message<msg::set_com> &);
     void on_raycast_request(message<msg::raycast_request> &);
+    void on_shape_cast_request(message<msg::shape_cast_request> &);
     void on_query_aabb_request(message<msg::query_aabb_request> &);
     void on_query_aabb_of_interest_request(message<msg::query_aabb_of_interest_request> &);
     void on_apply_network_pools(message<msg::apply_network_pools> &);
@@ -69,6 +72,7 @@ private:
     entt::registry m_registry;
     entity_map m_entity_map;
     raycast_service m_raycast_service;
+    shape_cast_service m_shape_cast_service;
     island_manager m_island_manager;
     polyhedron_shape_initializer m_poly_initializer;
     solver m_solver;
@@ -84,6 +88,7 @@ private:
         msg::apply_network_pools,
         msg::wake_up_residents,
         msg::raycast_request,
+        msg::shape_cast_request,
         msg::query_aabb_request,
         msg::query_aabb_of_interest_request,
         extrapolation_result> m_message_queue;
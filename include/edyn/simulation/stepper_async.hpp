@@ -7,6 +7,7 @@
 #include <entt/signal/sigh.hpp>
 #include "edyn/collision/query_aabb.hpp"
 #include "edyn/collision/raycast.hpp"
+#include "edyn/collision/shape_cast.hpp"
 #include "edyn/comp/aabb.hpp"
 #include "edyn/config/config.h"
 #include "edyn/simulation/simulation_worker.hpp"
@@ -34,6 +35,10 @@ class stepper_async final {
         raycast_delegate_type delegate;
     };
 
+    struct worker_shape_cast_context {
+        shape_cast_delegate_type delegate;
+    };
+
     struct worker_query_aabb_context {
         AABB aabb;
         query_aabb_delegate_type delegate;
@@ -51,6 +56,7 @@ public:
 
     void on_step_update(message<msg::step_update> &);
     void on_raycast_response(message<msg::raycast_response> &);
+    void on_shape_cast_response(message<msg::shape_cast_response> &);
     void on_query_aabb_response(message<msg::query_aabb_response> &);
 
     void update(double current_time);
@@ -83,6 +89,11 @@ public:
                             const raycast_delegate_type &delegate,
                             std::vector<entt::entity> ignore_entities = {});
 
+    shape_cast_id_type shape_cast(const cast_shapes_variant_t &shape, const quaternion &orn,
+                                  vector3 p0, vector3 p1,
+                                  const shape_cast_delegate_type &delegate,
+                                  std::vector<entt::entity> ignore_entities = {});
+
     query_aabb_id_type query_aabb(const AABB &aabb, const query_aabb_delegate_type &delegate,
                                   bool query_procedural,
                                   bool query_non_procedural,
@@ -101,6 +112,7 @@ private:
     message_queue_handle<
         msg::step_update,
         msg::raycast_response,
+        msg::shape_cast_response,
         msg::query_aabb_response
     > m_message_queue_handle;
 
@@ -115,6 +127,9 @@ private:
     raycast_id_type m_next_raycast_id {};
     std::map<raycast_id_type, worker_raycast_context> m_raycast_ctx;
 
+    shape_cast_id_type m_next_shape_cast_id {};
+    std::map<shape_cast_id_type, worker_shape_cast_context> m_shape_cast_ctx;
+
     query_aabb_id_type m_next_query_aabb_id {};
     std::map<query_aabb_id_type, worker_query_aabb_context> m_query_aabb_ctx;
 
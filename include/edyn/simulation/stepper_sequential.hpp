@@ -32,6 +32,10 @@ public:
         return m_island_manager;
     }
 
+    auto & get_solver() {
+        return m_solver;
+    }
+
 private:
     entt::registry *m_registry;
     island_manager m_island_manager;
@@ -21,7 +21,14 @@ void update_aabbs(entt::registry &registry);
  */
 void update_aabb(entt::registry &registry, entt::entity entity);
 
-void update_island_aabbs(entt::registry &registry);
+/**
+ * @brief Update AABBs of all awake islands to enclose the AABBs of their
+ * procedural nodes.
+ * @param registry The registry to be updated.
+ * @param mt Whether to run in parallel using the job dispatcher when there
+ * are many islands.
+ */
+void update_island_aabbs(entt::registry &registry, bool mt = false);
 
 }
 
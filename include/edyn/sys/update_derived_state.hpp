@@ -0,0 +1,22 @@
+#ifndef EDYN_SYS_UPDATE_DERIVED_STATE_HPP
+#define EDYN_SYS_UPDATE_DERIVED_STATE_HPP
+
+#include <entt/entity/fwd.hpp>
+
+namespace edyn {
+
+/**
+ * @brief Updates everything that derives from the position and orientation
+ * of awake bodies in a single pass over each body, i.e. origins, rotated
+ * meshes, AABBs and world-space inertias, and then the island AABBs. It is
+ * equivalent to calling `update_origins`, `update_rotated_meshes`,
+ * `update_aabbs`, `update_island_aabbs` and `update_inertias` in sequence.
+ * @param registry The registry to be updated.
+ * @param mt Whether to run in parallel using the job dispatcher when there
+ * are many bodies.
+ */
+void update_derived_state(entt::registry &registry, bool mt);
+
+}
+
+#endif // EDYN_SYS_UPDATE_DERIVED_STATE_HPP
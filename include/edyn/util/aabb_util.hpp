@@ -3,6 +3,7 @@
 
 #include "edyn/comp/aabb.hpp"
 #include "edyn/shapes/shapes.hpp"
+#include <type_traits>
 
 namespace edyn {
 
@@ -67,6 +68,27 @@ AABB shape_aabb(const compound_shape &sh, const vector3 &pos, const quaternion &
  */
 AABB shape_aabb(const shapes_variant_t &var, const vector3 &pos, const quaternion &orn);
 
+/**
+ * @brief Calculates the AABB of a shape after its transform changes.
+ * Polyhedrons use their rotated mesh instead of rotating each vertex, thus
+ * it must be updated beforehand.
+ * @param shape The shape.
+ * @param pos Shape's origin.
+ * @param orn Shape's orientation.
+ * @return The AABB.
+ */
+template<typename ShapeType>
+AABB updated_aabb(const ShapeType &shape, const vector3 &pos, const quaternion &orn) {
+    if constexpr(std::is_same_v<ShapeType, polyhedron_shape>) {
+        auto aabb = point_cloud_aabb(shape.rotated->vertices);
+        aabb.min += pos;
+        aabb.max += pos;
+        return aabb;
+    } else {
+        return shape_aabb(shape, pos, orn);
+    }
+}
+
 }
 
 #endif // EDYN_UTIL_AABB_UTIL_HPP
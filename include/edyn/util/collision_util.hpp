@@ -10,11 +10,14 @@
 #include "edyn/comp/orientation.hpp"
 #include "edyn/comp/origin.hpp"
 #include "edyn/comp/angvel.hpp"
+#include "edyn/comp/linvel.hpp"
+#include "edyn/comp/tag.hpp"
 #include "edyn/shapes/shapes.hpp"
 #include "edyn/collision/contact_point.hpp"
 #include "edyn/collision/contact_manifold.hpp"
 #include "edyn/collision/contact_manifold_events.hpp"
 #include "edyn/collision/collision_result.hpp"
+#include "edyn/math/transform.hpp"
 
 namespace edyn {
 
@@ -73,13 +76,22 @@ void create_contact_point(entt::registry &registry,
                           const collision_result::collision_point& rp);
 
 /**
- * Removes a contact point from a manifold if it's separating.
+ * Marks speculative points which are now touching as regular contact points
+ * and adds contact created events for them.
+ */
+void promote_touching_points(contact_manifold &manifold, contact_manifold_events &events);
+
+/**
+ * Removes a contact point from a manifold if it's separating. Speculative
+ * points are kept while the first body approaches the second along the
+ * contact normal by `displacement` and is within reach in the next step.
  */
 bool maybe_remove_point(contact_manifold &manifold,
                         contact_manifold_events &events,
                         size_t pt_idx,
                         const vector3 &posA, const quaternion &ornA,
-                        const vector3 &posB, const quaternion &ornB);
+                        const vector3 &posB, const quaternion &ornB,
+                        const vector3 &displacement);
 
 /**
  * Destroys a contact point that has been removed from the manifold
@@ -94,6 +106,25 @@ using detect_collision_body_view_t = entt::basic_view<entt::entity,
 
 using origin_view_t = entt::basic_view<entt::entity, entt::get_t<origin>, entt::exclude_t<>>;
 
+/**
+ * Update distance of persisted contact points of a single manifold.
+ */
+template<typename TransformView>
+void update_contact_distances(contact_manifold &manifold, TransformView &tr_view,
+                              const origin_view_t &origin_view) {
+    auto [posA, ornA] = tr_view.template get<position, orientation>(manifold.body[0]);
+    auto [posB, ornB] = tr_view.template get<position, orientation>(manifold.body[1]);
+    auto originA = origin_view.contains(manifold.body[0]) ? origin_view.get<origin>(manifold.body[0]) : static_cast<vector3>(posA);
+    auto originB = origin_view.contains(manifold.body[1]) ? origin_view.get<origin>(manifold.body[1]) : static_cast<vector3>(posB);
+
+    for (unsigned i = 0; i < manifold.num_points; ++i) {
+        auto &cp = manifold.get_point(i);
+        auto pivotA_world = to_world_space(cp.pivotA, originA, ornA);
+        auto pivotB_world = to_world_space(cp.pivotB, originB, ornB);
+        cp.distance = dot(cp.normal, pivotA_world - pivotB_world);
+    }
+}
+
 /**
  * Detects collision between two bodies and adds closest points to the given
  * collision result
@@ -102,12 +133,37 @@ void detect_collision(std::array<entt::entity, 2> body, collision_result &,
                       const detect_collision_body_view_t &, const origin_view_t &,
                       const tuple_of_shape_views_t &);
 
+/**
+ * Detects collision between two bodies where the first moves by
+ * `displacement` relative to the second in the next step. Points up to the
+ * length of the displacement apart are added as speculative contacts. If one
+ * of them is a mesh, the other is advanced along the displacement until the
+ * first impact and the points found there are added instead, thus thin
+ * geometry cannot be skipped.
+ */
+void detect_collision(std::array<entt::entity, 2> body, collision_result &,
+                      const detect_collision_body_view_t &, const origin_view_t &,
+                      const tuple_of_shape_views_t &, const vector3 &displacement);
+
+using linvel_view_t = entt::basic_view<entt::entity, entt::get_t<linvel>, entt::exclude_t<>>;
+using continuous_contacts_view_t = entt::basic_view<entt::entity, entt::get_t<continuous_contacts_tag>, entt::exclude_t<>>;
+
+/**
+ * Displacement of the first body relative to the second in the next step if
+ * any of them has a `continuous_contacts_tag`, or zero otherwise.
+ */
+vector3 get_continuous_displacement(std::array<entt::entity, 2> body,
+                                    const linvel_view_t &, const continuous_contacts_view_t &,
+                                    scalar dt);
+
 /**
  * Processes a collision result and inserts/replaces points into the manifold.
  * It also removes points in the manifold that are separating. `new_point_func`
  * is called for each point that is created and `destroy_point_func` is called
  * for every point that is removed (remember to call `destroy_contact_point`
- * when appropriate for each point that is removed).
+ * when appropriate for each point that is removed). `displacement` is the
+ * relative displacement of the bodies in the next step, as returned by
+ * `get_continuous_displacement`.
  */
 template<typename TransformView, typename VelView, typename RollingView,
          typename NewPointFunc, typename DestroyPointFunc>
@@ -123,7 +179,7 @@ void process_collision(entt::entity manifold_entity,
                        const material_view_t &material_view,
                        const mesh_shape_view_t &mesh_shape_view,
                        const paged_mesh_shape_view_t &paged_mesh_shape_view,
-                       scalar dt,
+                       scalar dt, const vector3 &displacement,
                        NewPointFunc new_point_func,
                        DestroyPointFunc destroy_point_func) {
     auto [posA, ornA] = tr_view.template get<position, orientation>(manifold.body[0]);
@@ -165,7 +221,7 @@ void process_collision(entt::entity manifold_entity,
         if (nearest_idx < result.num_points && !merged_indices[nearest_idx]) {
             merge_point(manifold.body, result.point[nearest_idx], cp, orn_view, material_view, mesh_shape_view, paged_mesh_shape_view);
             merged_indices[nearest_idx] = true;
-        } else if (maybe_remove_point(manifold, events, pt_idx, originA, ornA, originB, ornB)) {
+        } else if (maybe_remove_point(manifold, events, pt_idx, originA, ornA, originB, ornB, displacement)) {
             destroy_point_func(pt_id);
         }
     }
@@ -173,6 +229,7 @@ void process_collision(entt::entity manifold_entity,
     // Do not continue if all result points were merged.
     auto merged_indices_end = merged_indices.begin() + result.num_points;
     if (std::find(merged_indices.begin(), merged_indices_end, false) == merged_indices_end) {
+        promote_touching_points(manifold, events);
         return;
     }
 
@@ -281,7 +338,9 @@ void process_collision(entt::entity manifold_entity,
                         --manifold.num_points;
 
                         // Register contact destroyed event.
-                        events.contacts_destroyed[events.num_contacts_destroyed++] = local_pt.pt_id;
+                        if (!manifold.point[local_pt.pt_id].speculative) {
+                            events.contacts_destroyed[events.num_contacts_destroyed++] = local_pt.pt_id;
+                        }
                         break;
                     }
                 }
@@ -292,6 +351,10 @@ void process_collision(entt::entity manifold_entity,
             break;
         }
     }
+
+    // Only points that were already in the manifold are promoted. New points
+    // are assigned their state when created.
+    promote_touching_points(manifold, events);
 }
 
 }
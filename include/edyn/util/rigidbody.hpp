@@ -68,6 +68,10 @@ struct rigidbody_def {
     // Prevent this rigid body from sleeping while it barely moves.
     bool sleeping_disabled {false};
 
+    // Prevent this rigid body from tunneling through other bodies, especially
+    // thin meshes, when moving fast. Only used for dynamic rigid bodies.
+    bool continuous_contacts {false};
+
     // Share this rigid body over the network.
     bool networked {false};
 };
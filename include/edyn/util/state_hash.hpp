@@ -0,0 +1,34 @@
+#ifndef EDYN_UTIL_STATE_HASH_HPP
+#define EDYN_UTIL_STATE_HASH_HPP
+
+#include <cstdint>
+#include <entt/entity/fwd.hpp>
+
+namespace edyn {
+
+/**
+ * @brief Calculates a hash of the state of all rigid bodies, i.e. their
+ * position, orientation and linear and angular velocity. Bodies are visited
+ * in order of entity identifier, thus the result does not depend on the
+ * order of entities in their pools. Comparing the hashes of two simulations
+ * after each step tells at which step they diverge.
+ * @remark The bits of each value are hashed, thus any difference, however
+ * small, results in a different hash.
+ * @param registry Data source.
+ * @return Hash of the state of all bodies.
+ */
+uint64_t hash_state(const entt::registry &registry);
+
+/**
+ * @brief Calculates a hash of the state of a single rigid body. Useful to
+ * find which bodies diverged once `hash_state(const entt::registry &)`
+ * differs.
+ * @param registry Data source.
+ * @param entity Rigid body entity.
+ * @return Hash of the state of the body.
+ */
+uint64_t hash_state(const entt::registry &registry, entt::entity entity);
+
+}
+
+#endif // EDYN_UTIL_STATE_HASH_HPP
@@ -1,9 +1,8 @@
 #include "edyn/collision/broadphase.hpp"
 #include "edyn/collision/tree_node.hpp"
 #include "edyn/comp/aabb.hpp"
-#include "edyn/comp/collision_exclusion.hpp"
-#include "edyn/comp/collision_filter.hpp"
 #include "edyn/comp/island.hpp"
+#include "edyn/comp/linvel.hpp"
 #include "edyn/comp/tree_resident.hpp"
 #include "edyn/collision/contact_manifold.hpp"
 #include "edyn/collision/contact_manifold_map.hpp"
@@ -12,9 +11,11 @@
 #include "edyn/parallel/parallel_for.hpp"
 #include "edyn/util/constraint_util.hpp"
 #include "edyn/context/settings.hpp"
+#include "edyn/context/profile.hpp"
 #include "edyn/util/entt_util.hpp"
 #include "edyn/util/island_util.hpp"
 #include <entt/entity/registry.hpp>
+#include <algorithm>
 
 namespace edyn {
 
@@ -29,13 +30,10 @@ broadphase::broadphase(entt::registry &registry)
     registry.on_destroy<tree_resident>().connect<&broadphase::on_destroy_tree_resident>(*this);
     registry.on_construct<island_AABB>().connect<&broadphase::on_construct_island_aabb>(*this);
     registry.on_destroy<island_tree_resident>().connect<&broadphase::on_destroy_island_tree_resident>(*this);
-
-    // The `should_collide_func` function will be invoked in parallel when
-    // running broadphase in parallel, in the call to `broadphase::collide_tree_async`.
-    // Avoid multi-threading issues by pre-allocating the pools that will be
-    // needed in `should_collide_func`.
-    static_cast<void>(registry.storage<collision_filter>());
-    static_cast<void>(registry.storage<collision_exclusion>());
+    registry.on_construct<sleeping_tag>().connect<&broadphase::on_construct_inactive_tag>(*this);
+    registry.on_construct<disabled_tag>().connect<&broadphase::on_construct_inactive_tag>(*this);
+    registry.on_destroy<sleeping_tag>().connect<&broadphase::on_destroy_sleeping_tag>(*this);
+    registry.on_destroy<disabled_tag>().connect<&broadphase::on_destroy_disabled_tag>(*this);
 }
 
 void broadphase::on_construct_aabb(entt::registry &, entt::entity entity) {
@@ -51,6 +49,9 @@ void broadphase::on_destroy_tree_resident(entt::registry &registry, entt::entity
     } else {
         m_np_tree.destroy(node.id);
     }
+
+    // Remove its pairs in the next update.
+    m_moved_entities.push_back(entity);
 }
 
 void broadphase::on_construct_island_aabb(entt::registry &registry, entt::entity entity) {
@@ -64,6 +65,26 @@ void broadphase::on_destroy_island_tree_resident(entt::registry &registry, entt:
     m_island_tree.destroy(node.id);
 }
 
+void broadphase::on_construct_inactive_tag(entt::registry &registry, entt::entity entity) {
+    if (registry.all_of<tree_resident>(entity)) {
+        m_has_inactive_pairs = true;
+    }
+}
+
+void broadphase::on_destroy_sleeping_tag(entt::registry &registry, entt::entity entity) {
+    // The tag is still assigned while the signal is emitted. Query the
+    // entity in the next update to find its pairs again.
+    if (registry.all_of<tree_resident>(entity) && !registry.all_of<disabled_tag>(entity)) {
+        m_moved_entities.push_back(entity);
+    }
+}
+
+void broadphase::on_destroy_disabled_tag(entt::registry &registry, entt::entity entity) {
+    if (registry.all_of<tree_resident>(entity) && !registry.all_of<sleeping_tag>(entity)) {
+        m_moved_entities.push_back(entity);
+    }
+}
+
 void broadphase::init_new_aabb_entities() {
     if (m_new_aabb_entities.empty()) {
         return;
@@ -81,29 +102,53 @@ void broadphase::init_new_aabb_entities() {
         auto &tree = procedural ? m_tree : m_np_tree;
         tree_node_id_t id = tree.create(aabb, entity);
         m_registry->emplace<tree_resident>(entity, id, procedural);
+        m_moved_entities.push_back(entity);
     }
 
     m_new_aabb_entities.clear();
 }
 
+void broadphase::sweep_continuous_aabbs() {
+    auto dt = m_registry->ctx().at<settings>().fixed_dt;
+    auto continuous_view = m_registry->view<AABB, linvel, continuous_contacts_tag>(exclude_sleeping_disabled);
+
+    // Enclose the displacement of fast bodies in the next step so that pairs
+    // are found and manifolds are created before they collide. AABBs are
+    // recalculated from scratch at the end of the step.
+    continuous_view.each([dt](AABB &aabb, linvel &v) {
+        auto displacement = v * dt;
+        aabb = enclosing_aabb(aabb, AABB{aabb.min + displacement, aabb.max + displacement});
+    });
+}
+
 void broadphase::move_aabbs() {
+    unsigned num_moves = 0;
+
     // Update AABBs of procedural nodes in the dynamic tree.
     auto proc_aabb_node_view = m_registry->view<tree_resident, AABB, procedural_tag>(exclude_sleeping_disabled);
-    proc_aabb_node_view.each([&](tree_resident &node, AABB &aabb) {
-        m_tree.move(node.id, aabb);
+    proc_aabb_node_view.each([&](entt::entity entity, tree_resident &node, AABB &aabb) {
+        if (m_tree.move(node.id, aabb)) {
+            m_moved_entities.push_back(entity);
+            ++num_moves;
+        }
     });
 
     // Update kinematic AABBs in non-procedural tree.
     // TODO: only do this for kinematic entities that had their AABB updated.
     auto kinematic_aabb_node_view = m_registry->view<tree_resident, AABB, kinematic_tag>(exclude_sleeping_disabled);
-    kinematic_aabb_node_view.each([&](tree_resident &node, AABB &aabb) {
-        m_np_tree.move(node.id, aabb);
+    kinematic_aabb_node_view.each([&](entt::entity entity, tree_resident &node, AABB &aabb) {
+        if (m_np_tree.move(node.id, aabb)) {
+            m_moved_entities.push_back(entity);
+            ++num_moves;
+        }
     });
 
     auto island_aabb_node_view = m_registry->view<island_tree_resident, island_AABB>(exclude_sleeping_disabled);
     island_aabb_node_view.each([&](island_tree_resident &node, island_AABB &aabb) {
-        m_island_tree.move(node.id, aabb);
+        num_moves += m_island_tree.move(node.id, aabb);
     });
+
+    EDYN_PROFILE_TREE_MOVES(*m_registry, num_moves);
 }
 
 void broadphase::destroy_separated_manifolds() {
@@ -122,100 +167,181 @@ void broadphase::destroy_separated_manifolds() {
     });
 }
 
-void broadphase::collide_tree(const dynamic_tree &tree, entt::entity entity,
-                              const AABB &offset_aabb) const {
-    auto aabb_view = m_registry->view<AABB>();
-    auto &settings = m_registry->ctx().at<edyn::settings>();
-    auto &manifold_map = m_registry->ctx().at<contact_manifold_map>();
-    auto disabled_view = m_registry->view<disabled_tag>();
+void broadphase::find_pairs(entt::entity entity, entity_pair_vector &pairs) const {
+    auto resident_view = m_registry->view<tree_resident>();
 
-    tree.query(offset_aabb, [&](tree_node_id_t id) {
-        auto &node = tree.get_node(id);
-        auto collides = (*settings.should_collide_func)(*m_registry, entity, node.entity);
+    // Entity might've been destroyed, thus skip it.
+    if (!resident_view.contains(entity)) {
+        return;
+    }
 
-        if (collides && !manifold_map.contains(entity, node.entity) && !disabled_view.contains(node.entity)) {
-            auto [other_aabb] = aabb_view.get(node.entity);
+    auto [resident] = resident_view.get(entity);
+    auto &tree = resident.procedural ? m_tree : m_np_tree;
+    // Query with the fat AABB so that pairs remain valid for as long as
+    // the AABBs stay within their fat bounds in the tree.
+    auto query_aabb = tree.get_node(resident.id).aabb.inset(m_aabb_offset);
 
-            if (intersect(offset_aabb, other_aabb)) {
-                make_contact_manifold(*m_registry, entity, node.entity, m_separation_threshold);
-            }
+    auto add_pair = [&](entt::entity other) {
+        if (other != entity) {
+            pairs.push_back(entity < other ? entity_pair(entity, other) : entity_pair(other, entity));
         }
+    };
+
+    m_tree.query(query_aabb, [&](tree_node_id_t id) {
+        add_pair(m_tree.get_node(id).entity);
     });
+
+    // Non-procedural entities do not collide with one another.
+    if (resident.procedural) {
+        m_np_tree.query(query_aabb, [&](tree_node_id_t id) {
+            add_pair(m_np_tree.get_node(id).entity);
+        });
+    }
 }
 
-void broadphase::collide_tree_async(const dynamic_tree &tree, entt::entity entity,
-                                    const AABB &offset_aabb, size_t result_index) {
-    auto aabb_view = m_registry->view<AABB>();
-    auto &settings = m_registry->ctx().at<edyn::settings>();
-    auto disabled_view = m_registry->view<disabled_tag>();
+// Building the 4-ary layout of a tree takes time proportional to its size,
+// thus it is only worth it if there are enough queries to make up for it.
+static void maybe_update_wide_tree(dynamic_tree &tree, size_t num_queries) {
+    if (num_queries * 8 >= tree.num_leaves()) {
+        tree.update_wide_tree();
+    }
+}
 
-    tree.query(offset_aabb, [&](tree_node_id_t id) {
-        auto &node = tree.get_node(id);
+void broadphase::update_pairs(bool mt) {
+    if (m_moved_entities.empty()) {
+        return;
+    }
 
-        if ((*settings.should_collide_func)(*m_registry, entity, node.entity) && !disabled_view.contains(node.entity)) {
-            auto [other_aabb] = aabb_view.get(node.entity);
+    // Must be done before querying in parallel.
+    maybe_update_wide_tree(m_tree, m_moved_entities.size());
+    maybe_update_wide_tree(m_np_tree, m_moved_entities.size());
 
-            if (intersect(offset_aabb, other_aabb)) {
-                m_pair_results[result_index].emplace_back(entity, node.entity);
-            }
-        }
-    });
-}
+    std::sort(m_moved_entities.begin(), m_moved_entities.end());
+    m_moved_entities.erase(std::unique(m_moved_entities.begin(), m_moved_entities.end()), m_moved_entities.end());
 
-void broadphase::update(bool mt) {
-    init_new_aabb_entities();
-    destroy_separated_manifolds();
-    move_aabbs();
+    auto moved = [&](entt::entity entity) {
+        return std::binary_search(m_moved_entities.begin(), m_moved_entities.end(), entity);
+    };
 
-    // Search for new AABB intersections and create manifolds.
-    auto aabb_proc_view = m_registry->view<AABB, procedural_tag>(exclude_sleeping_disabled);
+    // Remove pairs involving moved entities. They'll be found again below
+    // if their fat AABBs still intersect.
+    m_pairs.erase(std::remove_if(m_pairs.begin(), m_pairs.end(), [&](const entity_pair &pair) {
+        return moved(pair.first) || moved(pair.second);
+    }), m_pairs.end());
+
+    auto num_pairs = m_pairs.size();
+
+    if (mt && m_moved_entities.size() > m_max_sequential_size) {
+        m_pair_results.resize(m_moved_entities.size());
+        auto &dispatcher = job_dispatcher::global();
+
+        parallel_for(dispatcher, size_t{}, m_moved_entities.size(), size_t{1}, [&](size_t index) {
+            find_pairs(m_moved_entities[index], m_pair_results[index]);
+        });
 
-    if (mt && calculate_view_size(aabb_proc_view) > m_max_sequential_size) {
-        collide_parallel();
-        finish_collide();
+        for (auto &pairs : m_pair_results) {
+            m_pairs.insert(m_pairs.end(), pairs.begin(), pairs.end());
+            pairs.clear();
+        }
     } else {
-        for (auto [entity, aabb] : aabb_proc_view.each()) {
-            auto offset_aabb = aabb.inset(m_aabb_offset);
-            collide_tree(m_tree, entity, offset_aabb);
-            collide_tree(m_np_tree, entity, offset_aabb);
+        for (auto entity : m_moved_entities) {
+            find_pairs(entity, m_pairs);
         }
     }
+
+    m_moved_entities.clear();
+
+    // New pairs contain duplicates when both entities moved. Sort them and
+    // merge into the existing pairs, which are disjoint from the new ones.
+    std::sort(m_pairs.begin() + num_pairs, m_pairs.end());
+    m_pairs.erase(std::unique(m_pairs.begin() + num_pairs, m_pairs.end()), m_pairs.end());
+    std::inplace_merge(m_pairs.begin(), m_pairs.begin() + num_pairs, m_pairs.end());
 }
 
-void broadphase::collide_parallel() {
-    auto aabb_proc_view = m_registry->view<AABB, procedural_tag>(exclude_sleeping_disabled);
-    m_pair_results.resize(calculate_view_size(aabb_proc_view));
-    auto &dispatcher = job_dispatcher::global();
+void broadphase::remove_inactive_pairs() {
+    if (!m_has_inactive_pairs) {
+        return;
+    }
+
+    m_has_inactive_pairs = false;
 
-    auto for_loop_body = [this, aabb_proc_view](entt::entity entity, size_t index) {
-        auto &aabb = aabb_proc_view.get<AABB>(entity);
-        auto offset_aabb = aabb.inset(m_aabb_offset);
-        collide_tree_async(m_tree, entity, offset_aabb, index);
-        collide_tree_async(m_np_tree, entity, offset_aabb, index);
+    auto procedural_view = m_registry->view<procedural_tag>();
+    auto sleeping_view = m_registry->view<sleeping_tag>();
+    auto disabled_view = m_registry->view<disabled_tag>();
+
+    auto awake_procedural = [&](entt::entity entity) {
+        return procedural_view.contains(entity) &&
+               !sleeping_view.contains(entity) &&
+               !disabled_view.contains(entity);
     };
 
-    parallel_for_each(dispatcher, aabb_proc_view.begin(), aabb_proc_view.end(), for_loop_body);
+    // Pairs without an awake procedural entity cannot generate manifolds.
+    // Removing them keeps the cost of the pair updates independent of the
+    // number of sleeping entities. Removal preserves the order.
+    m_pairs.erase(std::remove_if(m_pairs.begin(), m_pairs.end(), [&](const entity_pair &pair) {
+        return !awake_procedural(pair.first) && !awake_procedural(pair.second);
+    }), m_pairs.end());
 }
 
-void broadphase::finish_collide() {
+void broadphase::create_manifolds() {
+    auto aabb_view = m_registry->view<AABB>();
+    auto procedural_view = m_registry->view<procedural_tag>();
+    auto sleeping_view = m_registry->view<sleeping_tag>();
+    auto disabled_view = m_registry->view<disabled_tag>();
+    auto &settings = m_registry->ctx().at<edyn::settings>();
     auto &manifold_map = m_registry->ctx().at<contact_manifold_map>();
 
-    for (auto &pairs : m_pair_results) {
-        for (auto &pair : pairs) {
-            if (!manifold_map.contains(pair.first, pair.second)) {
-                make_contact_manifold(*m_registry, pair.first, pair.second, m_separation_threshold);
+    auto awake_procedural = [&](entt::entity entity) {
+        return procedural_view.contains(entity) &&
+               !sleeping_view.contains(entity) &&
+               !disabled_view.contains(entity);
+    };
+
+    for (auto [entity, other] : m_pairs) {
+        // At least one of the entities must be an awake procedural entity.
+        if (!awake_procedural(entity)) {
+            std::swap(entity, other);
+
+            if (!awake_procedural(entity)) {
+                continue;
             }
         }
-        pairs.clear();
+
+        if (disabled_view.contains(other) || manifold_map.contains(entity, other)) {
+            continue;
+        }
+
+        auto [aabb] = aabb_view.get(entity);
+        auto [other_aabb] = aabb_view.get(other);
+
+        if (intersect(aabb.inset(m_aabb_offset), other_aabb) &&
+            (*settings.should_collide_func)(*m_registry, entity, other)) {
+            make_contact_manifold(*m_registry, entity, other, m_separation_threshold);
+        }
     }
 }
 
+void broadphase::update(bool mt) {
+    sweep_continuous_aabbs();
+    init_new_aabb_entities();
+    destroy_separated_manifolds();
+    move_aabbs();
+    remove_inactive_pairs();
+
+    // Search for new AABB intersections and create manifolds.
+    update_pairs(mt);
+    create_manifolds();
+}
+
 void broadphase::clear() {
     m_tree.clear();
     m_np_tree.clear();
     m_island_tree.clear();
     m_new_aabb_entities.clear();
+    m_moved_entities.clear();
+    m_pairs.clear();
     m_pair_results.clear();
+    m_has_inactive_pairs = false;
 }
 
 }
@@ -7,14 +7,24 @@ contact_event_emitter::contact_event_emitter(entt::registry &registry)
     : m_registry(&registry)
 {
     registry.on_destroy<contact_manifold>().connect<&contact_event_emitter::on_destroy_contact_manifold>(*this);
+    registry.on_construct<contact_manifold_events>().connect<&contact_event_emitter::on_update_contact_manifold_events>(*this);
+    registry.on_update<contact_manifold_events>().connect<&contact_event_emitter::on_update_contact_manifold_events>(*this);
+    registry.on_destroy<contact_manifold_events>().connect<&contact_event_emitter::on_destroy_contact_manifold_events>(*this);
 }
 
 contact_event_emitter::~contact_event_emitter() {
     m_registry->on_destroy<contact_manifold>().disconnect<&contact_event_emitter::on_destroy_contact_manifold>(*this);
+    m_registry->on_construct<contact_manifold_events>().disconnect<&contact_event_emitter::on_update_contact_manifold_events>(*this);
+    m_registry->on_update<contact_manifold_events>().disconnect<&contact_event_emitter::on_update_contact_manifold_events>(*this);
+    m_registry->on_destroy<contact_manifold_events>().disconnect<&contact_event_emitter::on_destroy_contact_manifold_events>(*this);
 }
 
 void contact_event_emitter::consume_events() {
-    for (auto [entity, events] : m_registry->view<contact_manifold_events>().each()) {
+    auto events_view = m_registry->view<contact_manifold_events>();
+
+    for (auto entity : m_pending_events) {
+        auto [events] = events_view.get(entity);
+
         // Contact could have ended and started again in the same step. Do not
         // generate event in that case.
         if (events.contact_started && !events.contact_ended) {
@@ -35,19 +45,38 @@ void contact_event_emitter::consume_events() {
 
         events = {};
     }
+
+    m_pending_events.clear();
 }
 
 void contact_event_emitter::on_destroy_contact_manifold(entt::registry &registry, entt::entity entity) {
     // Trigger contact destroyed events.
+    // Speculative points never raised a created event.
     auto &manifold = registry.get<contact_manifold>(entity);
+    auto touching = false;
 
-    if (manifold.num_points > 0) {
-        for (unsigned i = 0; i < manifold.num_points; ++i) {
+    for (unsigned i = 0; i < manifold.num_points; ++i) {
+        if (!manifold.get_point(i).speculative) {
             m_contact_point_destroyed_signal.publish(entity, manifold.ids[i]);
+            touching = true;
         }
+    }
 
+    if (touching) {
         m_contact_ended_signal.publish(entity);
     }
 }
 
+void contact_event_emitter::on_update_contact_manifold_events(entt::registry &, entt::entity entity) {
+    // Events are modified via `registry.patch` in the narrowphase and when
+    // importing snapshots from the simulation worker.
+    if (!m_pending_events.contains(entity)) {
+        m_pending_events.emplace(entity);
+    }
+}
+
+void contact_event_emitter::on_destroy_contact_manifold_events(entt::registry &, entt::entity entity) {
+    m_pending_events.remove(entity);
+}
+
 }
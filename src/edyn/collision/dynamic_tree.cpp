@@ -46,6 +46,7 @@ tree_node_id_t dynamic_tree::create(const AABB &aabb, entt::entity entity) {
     node.aabb = aabb.inset(aabb_inset);
 
     insert(id);
+    ++m_num_leaves;
 
     return id;
 }
@@ -54,6 +55,7 @@ void dynamic_tree::destroy(tree_node_id_t id) {
     EDYN_ASSERT(m_nodes[id].leaf());
     remove(id);
     free(id);
+    --m_num_leaves;
 }
 
 bool dynamic_tree::move(tree_node_id_t id, const AABB &aabb) {
@@ -124,6 +126,8 @@ tree_node_id_t dynamic_tree::best(const AABB &aabb) {
 }
 
 void dynamic_tree::insert(tree_node_id_t leaf) {
+    m_wide_tree_valid = false;
+
     if (m_root == null_tree_node_id) {
         m_root = leaf;
         m_nodes[m_root].parent = null_tree_node_id;
@@ -175,6 +179,8 @@ void dynamic_tree::insert(tree_node_id_t leaf) {
 }
 
 void dynamic_tree::remove(tree_node_id_t leaf) {
+    m_wide_tree_valid = false;
+
     if (leaf == m_root) {
         m_root = null_tree_node_id;
         return;
@@ -343,9 +349,19 @@ const tree_node & dynamic_tree::get_node(tree_node_id_t id) const {
     return m_nodes[id];
 }
 
+void dynamic_tree::update_wide_tree() {
+    if (!m_wide_tree_valid) {
+        m_wide_tree.build(m_nodes, m_root);
+        m_wide_tree_valid = true;
+    }
+}
+
 void dynamic_tree::clear() {
     m_root = null_tree_node_id;
     m_free_list = null_tree_node_id;
+    m_num_leaves = 0;
+    m_wide_tree.clear();
+    m_wide_tree_valid = false;
 
     if (!m_nodes.empty()) {
         m_free_list = 0;
@@ -1,36 +1,160 @@
 #include "edyn/collision/narrowphase.hpp"
+#include "edyn/collision/broadphase.hpp"
 #include "edyn/collision/contact_manifold.hpp"
 #include "edyn/collision/contact_point.hpp"
 #include "edyn/config/constants.hpp"
 #include "edyn/parallel/parallel_for.hpp"
 #include "edyn/comp/material.hpp"
+#include "edyn/comp/linvel.hpp"
 #include "edyn/util/entt_util.hpp"
 #include "edyn/util/island_util.hpp"
+#include <entt/entity/registry.hpp>
+#include <algorithm>
+#include <tuple>
 
 namespace edyn {
 
-narrowphase::narrowphase(entt::registry &reg)
-    : m_registry(&reg)
-{}
+narrowphase::narrowphase(entt::registry &registry)
+    : m_registry(&registry)
+{
+    m_connections.push_back(registry.on_construct<contact_manifold>().connect<&narrowphase::on_construct_contact_manifold>(*this));
+    m_connections.push_back(registry.on_destroy<contact_manifold>().connect<&narrowphase::on_destroy_contact_manifold>(*this));
+    m_connections.push_back(registry.on_construct<sleeping_tag>().connect<&narrowphase::on_construct_inactive_tag>(*this));
+    m_connections.push_back(registry.on_construct<disabled_tag>().connect<&narrowphase::on_construct_inactive_tag>(*this));
+    m_connections.push_back(registry.on_destroy<sleeping_tag>().connect<&narrowphase::on_destroy_sleeping_tag>(*this));
+    m_connections.push_back(registry.on_destroy<disabled_tag>().connect<&narrowphase::on_destroy_disabled_tag>(*this));
+
+    for (auto entity : registry.view<contact_manifold>(exclude_sleeping_disabled)) {
+        m_active_manifolds.emplace(entity);
+    }
+}
 
-void narrowphase::clear_contact_manifold_events() {
-    m_registry->view<contact_manifold_events>().each([](auto &events) {
-        events = {};
+void narrowphase::activate_manifold(entt::entity entity) {
+    if (!m_active_manifolds.contains(entity)) {
+        m_active_manifolds.emplace(entity);
+    }
+}
+
+void narrowphase::deactivate_manifold(entt::entity entity) {
+    m_active_manifolds.remove(entity);
+}
+
+void narrowphase::on_construct_contact_manifold(entt::registry &registry, entt::entity entity) {
+    if (!registry.any_of<sleeping_tag, disabled_tag>(entity)) {
+        activate_manifold(entity);
+    }
+}
+
+void narrowphase::on_destroy_contact_manifold(entt::registry &, entt::entity entity) {
+    deactivate_manifold(entity);
+}
+
+void narrowphase::on_construct_inactive_tag(entt::registry &, entt::entity entity) {
+    deactivate_manifold(entity);
+}
+
+void narrowphase::on_destroy_sleeping_tag(entt::registry &registry, entt::entity entity) {
+    // The tag is still assigned while the signal is emitted.
+    if (registry.all_of<contact_manifold>(entity) && !registry.all_of<disabled_tag>(entity)) {
+        activate_manifold(entity);
+    }
+}
+
+void narrowphase::on_destroy_disabled_tag(entt::registry &registry, entt::entity entity) {
+    if (registry.all_of<contact_manifold>(entity) && !registry.all_of<sleeping_tag>(entity)) {
+        activate_manifold(entity);
+    }
+}
+
+void narrowphase::prefetch_paged_meshes() {
+    auto prefetch_time = m_registry->ctx().at<settings>().paged_mesh_prefetch_time;
+    auto mesh_view = m_registry->view<paged_mesh_shape>();
+
+    if (!(prefetch_time > 0) || mesh_view.empty()) {
+        return;
+    }
+
+    auto &bphase = m_registry->ctx().at<broadphase>();
+    auto body_view = m_registry->view<AABB, linvel, procedural_tag>(exclude_sleeping_disabled);
+    m_prefetch_requests.clear();
+
+    for (auto [entity, aabb, v] : body_view.each()) {
+        auto displacement = v * prefetch_time;
+
+        // Submeshes touched by slow bodies are loaded by the collision
+        // queries just as well.
+        if (length_sqr(displacement) < EDYN_EPSILON) {
+            continue;
+        }
+
+        auto swept_aabb = enclosing_aabb(aabb, AABB{aabb.min + displacement, aabb.max + displacement});
+        auto speed = length(v);
+
+        // Only visit the meshes in the path of the body instead of testing
+        // each body against every mesh.
+        bphase.query_non_procedural(swept_aabb, [&](entt::entity mesh_entity) {
+            if (!mesh_view.contains(mesh_entity)) {
+                return;
+            }
+
+            auto [shape] = mesh_view.get(mesh_entity);
+
+            shape.trimesh->visit_submesh_bounds(swept_aabb, [&](size_t submesh_idx, const AABB &submesh_aabb) {
+                // Estimate time until the body reaches the submesh so that
+                // submeshes that will be needed sooner are loaded first.
+                auto gap = max(max(submesh_aabb.min - aabb.max, aabb.min - submesh_aabb.max), vector3_zero);
+                m_prefetch_requests.push_back({mesh_entity, length(gap) / speed, submesh_idx});
+            });
+        });
+    }
+
+    if (m_prefetch_requests.empty()) {
+        return;
+    }
+
+    // Keep the highest priority of each submesh of each mesh.
+    std::sort(m_prefetch_requests.begin(), m_prefetch_requests.end(), [](auto &lhs, auto &rhs) {
+        return std::tie(lhs.mesh_entity, lhs.submesh_idx, lhs.priority) <
+               std::tie(rhs.mesh_entity, rhs.submesh_idx, rhs.priority);
+    });
+    auto last = std::unique(m_prefetch_requests.begin(), m_prefetch_requests.end(), [](auto &lhs, auto &rhs) {
+        return lhs.mesh_entity == rhs.mesh_entity && lhs.submesh_idx == rhs.submesh_idx;
     });
+    m_prefetch_requests.erase(last, m_prefetch_requests.end());
+
+    // Requests are grouped by mesh. Order the submeshes of each mesh by
+    // priority.
+    auto first = m_prefetch_requests.begin();
+
+    while (first != m_prefetch_requests.end()) {
+        auto mesh_entity = first->mesh_entity;
+        auto end = std::find_if(first, m_prefetch_requests.end(), [mesh_entity](auto &request) {
+            return request.mesh_entity != mesh_entity;
+        });
+        std::stable_sort(first, end, [](auto &lhs, auto &rhs) {
+            return lhs.priority < rhs.priority;
+        });
+
+        m_prefetch_indices.clear();
+
+        for (auto it = first; it != end; ++it) {
+            m_prefetch_indices.push_back(it->submesh_idx);
+        }
+
+        auto [shape] = mesh_view.get(mesh_entity);
+        shape.trimesh->prefetch_submeshes(m_prefetch_indices);
+        first = end;
+    }
 }
 
 void narrowphase::update(bool mt) {
-    clear_contact_manifold_events();
-    update_contact_distances(*m_registry);
+    prefetch_paged_meshes();
 
-    auto manifold_view = m_registry->view<contact_manifold>(exclude_sleeping_disabled);
-    auto num_active_manifolds = calculate_view_size(manifold_view);
-
-    if (mt && num_active_manifolds > m_max_sequential_size) {
+    if (mt && m_active_manifolds.size() > m_max_sequential_size) {
         detect_collision_parallel();
         finish_detect_collision();
     } else {
-        update_contact_manifolds(manifold_view.begin(), manifold_view.end());
+        update_contact_manifolds(m_active_manifolds.begin(), m_active_manifolds.end());
     }
 }
 
@@ -40,6 +164,8 @@ void narrowphase::detect_collision_parallel() {
     auto body_view = m_registry->view<AABB, shape_index, position, orientation>();
     auto tr_view = m_registry->view<position, orientation>();
     auto vel_view = m_registry->view<angvel>();
+    auto linvel_view = m_registry->view<linvel>();
+    auto continuous_view = m_registry->view<continuous_contacts_tag>();
     auto rolling_view = m_registry->view<rolling_tag>();
     auto origin_view = m_registry->view<origin>();
     auto material_view = m_registry->view<material>();
@@ -49,26 +175,37 @@ void narrowphase::detect_collision_parallel() {
     auto shapes_views_tuple = get_tuple_of_shape_views(*m_registry);
     auto dt = m_registry->ctx().at<settings>().fixed_dt;
 
-    // Resize result collection vectors to allocate one slot for each iteration
-    // of the parallel_for.
-    m_cp_construction_infos.resize(manifold_view.size());
-    m_cp_destruction_infos.resize(manifold_view.size());
+    // Allocate one slot for each active manifold. Slots are reset in the
+    // loop body.
+    auto num_manifolds = m_active_manifolds.size();
+
+    if (m_cp_construction_infos.size() < num_manifolds) {
+        m_cp_construction_infos.resize(num_manifolds);
+        m_cp_destruction_infos.resize(num_manifolds);
+    }
+
     auto &dispatcher = job_dispatcher::global();
 
-    auto for_loop_body = [this, body_view, tr_view, vel_view, rolling_view, origin_view,
-             manifold_view, events_view, orn_view, material_view, mesh_shape_view,
-             paged_mesh_shape_view, shapes_views_tuple, dt](size_t index) {
-        auto entity = manifold_view[index];
+    auto for_loop_body = [this, body_view, tr_view, vel_view, linvel_view, continuous_view,
+             rolling_view, origin_view, manifold_view, events_view, orn_view, material_view,
+             mesh_shape_view, paged_mesh_shape_view, shapes_views_tuple, dt](size_t index) {
+        auto entity = m_active_manifolds[index];
         auto [manifold] = manifold_view.get(entity);
         auto [events] = events_view.get(entity);
+        events = {};
+        update_contact_distances(manifold, tr_view, origin_view);
+
         collision_result result;
         auto &construction_info = m_cp_construction_infos[index];
         auto &destruction_info = m_cp_destruction_infos[index];
+        construction_info.count = 0;
+        destruction_info.count = 0;
 
-        detect_collision(manifold.body, result, body_view, origin_view, shapes_views_tuple);
+        auto displacement = get_continuous_displacement(manifold.body, linvel_view, continuous_view, dt);
+        detect_collision(manifold.body, result, body_view, origin_view, shapes_views_tuple, displacement);
         process_collision(entity, manifold, events, result, tr_view, vel_view,
                           rolling_view, origin_view, orn_view, material_view,
-                          mesh_shape_view, paged_mesh_shape_view, dt,
+                          mesh_shape_view, paged_mesh_shape_view, dt, displacement,
                           [&construction_info](const collision_result::collision_point &rp) {
             construction_info.point[construction_info.count++] = rp;
         }, [&destruction_info](auto pt_id) {
@@ -77,25 +214,32 @@ void narrowphase::detect_collision_parallel() {
         });
     };
 
-    parallel_for(dispatcher, size_t{}, manifold_view.size(), size_t{1}, for_loop_body);
+    parallel_for(dispatcher, size_t{}, num_manifolds, size_t{1}, for_loop_body);
 }
 
 void narrowphase::finish_detect_collision() {
     auto manifold_view = m_registry->view<contact_manifold>();
+    auto events_view = m_registry->view<contact_manifold_events>();
+    auto num_manifolds = m_active_manifolds.size();
 
     // Destroy contact points.
-    for (size_t i = 0; i < manifold_view.size(); ++i) {
-        auto entity = manifold_view[i];
+    for (size_t i = 0; i < num_manifolds; ++i) {
+        auto entity = m_active_manifolds[i];
         auto &info_result = m_cp_destruction_infos[i];
 
+        // Speculative points that started touching have created events.
+        if (events_view.get<contact_manifold_events>(entity).num_contacts_created > 0) {
+            m_registry->patch<contact_manifold_events>(entity);
+        }
+
         for (size_t j = 0; j < info_result.count; ++j) {
             destroy_contact_point(*m_registry, entity, info_result.point_id[j]);
         }
     }
 
     // Create contact points.
-    for (size_t i = 0; i < manifold_view.size(); ++i) {
-        auto entity = manifold_view[i];
+    for (size_t i = 0; i < num_manifolds; ++i) {
+        auto entity = m_active_manifolds[i];
         auto &manifold = manifold_view.get<contact_manifold>(entity);
         auto &info_result = m_cp_construction_infos[i];
 
@@ -103,9 +247,6 @@ void narrowphase::finish_detect_collision() {
             create_contact_point(*m_registry, entity, manifold, info_result.point[j]);
         }
     }
-
-    m_cp_destruction_infos.clear();
-    m_cp_construction_infos.clear();
 }
 
 }
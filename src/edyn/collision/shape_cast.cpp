@@ -0,0 +1,201 @@
+#include "edyn/collision/shape_cast.hpp"
+#include "edyn/collision/collide.hpp"
+#include "edyn/math/math.hpp"
+#include "edyn/math/transform.hpp"
+#include "edyn/shapes/convex_mesh.hpp"
+#include "edyn/simulation/stepper_async.hpp"
+#include "edyn/util/aabb_util.hpp"
+#include "edyn/util/vector_util.hpp"
+#include <algorithm>
+#include <type_traits>
+
+namespace edyn {
+
+// Distance below which the cast shape is considered to be touching another.
+static constexpr auto shape_cast_tolerance = scalar(0.001);
+
+// Maximum number of times the cast shape is advanced towards another shape
+// looking for the first impact. If exceeded, the last position is reported
+// as the impact, which is slightly before the actual impact.
+static constexpr unsigned max_shape_cast_iterations = 32;
+
+struct shape_cast_context {
+    // Initial and final position and orientation of the cast shape.
+    vector3 p0, p1;
+    quaternion orn;
+    // AABB enclosing the cast shape along the entire segment.
+    AABB aabb;
+
+    // Position, orientation and AABB of the shape it is cast against.
+    vector3 posB;
+    quaternion ornB;
+    AABB aabbB;
+};
+
+template<typename CastShapeType, typename ShapeType>
+static shape_cast_result cast_against_shape(const CastShapeType &cast_shape, const ShapeType &shape,
+                                            const shape_cast_context &ctx) {
+    // Conservative advancement: find the closest points between the shapes
+    // and move the cast shape along the segment by the largest amount that
+    // cannot make it go past any of them, until they touch. Collision is
+    // detected with a threshold equal to the remaining length of the segment
+    // so that anything that cannot be reached is ignored.
+    auto displacement = ctx.p1 - ctx.p0;
+    auto travel = length(displacement);
+    auto col_ctx = collision_context{ctx.p0, ctx.orn, ctx.aabb,
+                                     ctx.posB, ctx.ornB, ctx.aabbB,
+                                     travel + shape_cast_tolerance};
+    auto fraction = scalar(0);
+
+    for (unsigned i = 0; i < max_shape_cast_iterations; ++i) {
+        auto result = collision_result{};
+        collide(cast_shape, shape, col_ctx, result);
+
+        // Only points the shape is moving towards can be hit.
+        auto closest_idx = result.num_points;
+        auto advance = EDYN_SCALAR_MAX;
+
+        for (size_t pt_idx = 0; pt_idx < result.num_points; ++pt_idx) {
+            auto &rp = result.point[pt_idx];
+            auto approach = -dot(rp.normal, displacement);
+
+            if (approach < EDYN_EPSILON) {
+                continue;
+            }
+
+            if (closest_idx == result.num_points || rp.distance < result.point[closest_idx].distance) {
+                closest_idx = pt_idx;
+            }
+
+            advance = std::min(rp.distance / approach, advance);
+        }
+
+        if (closest_idx == result.num_points) {
+            return {};
+        }
+
+        auto &closest = result.point[closest_idx];
+
+        if (closest.distance <= shape_cast_tolerance || i + 1 == max_shape_cast_iterations) {
+            // The closest points could have been dropped from the result
+            // in favor of a larger contact area in the previous iteration,
+            // which causes the shape to advance too far. Move it back along
+            // the normal if it is penetrating.
+            if (closest.distance < 0) {
+                auto approach = -dot(closest.normal, displacement);
+                fraction = std::max(fraction + closest.distance / approach, scalar(0));
+            }
+
+            auto cast_result = shape_cast_result{};
+            cast_result.fraction = fraction;
+            cast_result.normal = closest.normal;
+            cast_result.point = to_world_space(closest.pivotB, ctx.posB, ctx.ornB);
+            return cast_result;
+        }
+
+        if (fraction + advance > 1) {
+            return {};
+        }
+
+        fraction += advance;
+        col_ctx.posA = lerp(ctx.p0, ctx.p1, fraction);
+        col_ctx.threshold = travel * (1 - fraction) + shape_cast_tolerance;
+    }
+
+    return {};
+}
+
+template<typename CastShapeType>
+static shape_cast_result cast_against_bodies(const broadphase &bphase,
+                                             const detect_collision_body_view_t &body_view,
+                                             const origin_view_t &origin_view,
+                                             const tuple_of_shape_views_t &views_tuple,
+                                             const CastShapeType &cast_shape,
+                                             const quaternion &orn, vector3 p0, vector3 p1,
+                                             const std::vector<entt::entity> &ignore_entities) {
+    auto ctx = shape_cast_context{};
+    ctx.p0 = p0;
+    ctx.p1 = p1;
+    ctx.orn = orn;
+    ctx.aabb = enclosing_aabb(shape_aabb(cast_shape, p0, orn), shape_aabb(cast_shape, p1, orn));
+
+    auto result = shape_cast_result{};
+
+    auto cast_against_body = [&](entt::entity entity) {
+        if (vector_contains(ignore_entities, entity)) {
+            return;
+        }
+
+        auto [aabb, sh_idx, pos, body_orn] = body_view.get(entity);
+        ctx.posB = origin_view.contains(entity) ?
+            static_cast<vector3>(origin_view.get<origin>(entity)) :
+            static_cast<vector3>(pos);
+        ctx.ornB = body_orn;
+        ctx.aabbB = aabb;
+
+        visit_shape(sh_idx, entity, views_tuple, [&](auto &&shape) {
+            auto res = cast_against_shape(cast_shape, shape, ctx);
+
+            if (res.fraction < result.fraction) {
+                result = res;
+                result.entity = entity;
+            }
+        });
+    };
+
+    bphase.query_procedural(ctx.aabb, cast_against_body);
+    bphase.query_non_procedural(ctx.aabb, cast_against_body);
+
+    return result;
+}
+
+shape_cast_result shape_cast(const broadphase &bphase,
+                             const detect_collision_body_view_t &body_view,
+                             const origin_view_t &origin_view,
+                             const tuple_of_shape_views_t &views_tuple,
+                             const cast_shapes_variant_t &shape,
+                             const quaternion &orn, vector3 p0, vector3 p1,
+                             const std::vector<entt::entity> &ignore_entities) {
+    auto result = shape_cast_result{};
+
+    std::visit([&](auto &&cast_shape) {
+        using ShapeType = std::decay_t<decltype(cast_shape)>;
+
+        if constexpr(std::is_same_v<ShapeType, polyhedron_shape>) {
+            // Polyhedron collision uses the rotated mesh, which is not
+            // available for shapes that do not belong to a rigid body.
+            auto rotated = make_rotated_mesh(*cast_shape.mesh, orn);
+            auto poly = cast_shape;
+            poly.rotated = &rotated;
+            result = cast_against_bodies(bphase, body_view, origin_view, views_tuple,
+                                         poly, orn, p0, p1, ignore_entities);
+        } else {
+            result = cast_against_bodies(bphase, body_view, origin_view, views_tuple,
+                                         cast_shape, orn, p0, p1, ignore_entities);
+        }
+    }, shape);
+
+    return result;
+}
+
+shape_cast_result shape_cast(entt::registry &registry, const cast_shapes_variant_t &shape,
+                             const quaternion &orn, vector3 p0, vector3 p1,
+                             const std::vector<entt::entity> &ignore_entities) {
+    auto &bphase = registry.ctx().at<broadphase>();
+    auto body_view = registry.view<AABB, shape_index, position, orientation>();
+    auto origin_view = registry.view<origin>();
+    auto views_tuple = get_tuple_of_shape_views(registry);
+
+    return shape_cast(bphase, body_view, origin_view, views_tuple,
+                      shape, orn, p0, p1, ignore_entities);
+}
+
+shape_cast_id_type shape_cast_async(entt::registry &registry, const cast_shapes_variant_t &shape,
+                                    const quaternion &orn, vector3 p0, vector3 p1,
+                                    const shape_cast_delegate_type &delegate,
+                                    const std::vector<entt::entity> &ignore_entities) {
+    auto &stepper = registry.ctx().at<stepper_async>();
+    return stepper.shape_cast(shape, orn, p0, p1, delegate, ignore_entities);
+}
+
+}
@@ -0,0 +1,42 @@
+#include "edyn/collision/shape_cast_service.hpp"
+#include "edyn/parallel/job_dispatcher.hpp"
+#include "edyn/parallel/parallel_for.hpp"
+
+namespace edyn {
+
+shape_cast_service::shape_cast_service(entt::registry &registry)
+    : m_registry(&registry)
+{}
+
+void shape_cast_service::update(bool mt) {
+    if (m_ctx.empty()) {
+        return;
+    }
+
+    auto &bphase = m_registry->ctx().at<broadphase>();
+    auto body_view = m_registry->view<AABB, shape_index, position, orientation>();
+    auto origin_view = m_registry->view<origin>();
+    auto views_tuple = get_tuple_of_shape_views(*m_registry);
+
+    // Each cast queries the broadphase trees and then sweeps the shape
+    // against the candidates, which only reads from the registry.
+    auto cast = [&bphase, body_view, origin_view, views_tuple](cast_context &ctx) {
+        ctx.result = shape_cast(bphase, body_view, origin_view, views_tuple,
+                                ctx.shape, ctx.orn, ctx.p0, ctx.p1, ctx.ignore_entities);
+    };
+
+    if (mt && m_ctx.size() > m_max_sequential_size) {
+        auto &dispatcher = job_dispatcher::global();
+        auto *ctxes = &m_ctx;
+
+        parallel_for(dispatcher, size_t{}, ctxes->size(), size_t{1}, [ctxes, &cast](size_t index) {
+            cast((*ctxes)[index]);
+        });
+    } else {
+        for (auto &ctx : m_ctx) {
+            cast(ctx);
+        }
+    }
+}
+
+}
@@ -0,0 +1,283 @@
+#include "edyn/collision/static_tree.hpp"
+#include "edyn/parallel/job_dispatcher.hpp"
+#include "edyn/parallel/parallel_for.hpp"
+#include "edyn/parallel/worker.hpp"
+#include <limits>
+
+namespace edyn::detail {
+
+// Maximum number of bins used to evaluate split candidates.
+// Small sets use fewer bins since the cost of evaluating the bins dominates.
+static constexpr size_t num_sah_bins = 16;
+
+// Sets with at least this many primitives are built in parallel.
+static constexpr size_t min_parallel_build_size = 8192;
+
+// Subtrees with fewer primitives are not split into further parallel tasks.
+static constexpr size_t min_parallel_task_size = 1024;
+
+// Primitives are partitioned by value instead of by id so that memory is
+// accessed sequentially as the ranges get smaller.
+struct static_tree_build_primitive {
+    AABB aabb;
+    vector3 centroid;
+    uint32_t id;
+};
+
+struct static_tree_build_context {
+    std::vector<static_tree_build_primitive> primitives;
+    uint32_t max_obj_per_leaf;
+};
+
+struct static_tree_build_task {
+    uint32_t node_idx;
+    uint32_t begin;
+    uint32_t end;
+};
+
+// Bins start with inverted bounds so that primitives can be added without
+// branching.
+struct sah_bin {
+    AABB aabb {vector3_max, -vector3_max};
+    uint32_t count {0};
+
+    void add(const AABB &other, uint32_t other_count = 1) {
+        aabb = enclosing_aabb(aabb, other);
+        count += other_count;
+    }
+};
+
+static size_t sah_bin_index(scalar centroid, scalar min, scalar factor, size_t num_bins) {
+    auto idx = static_cast<size_t>((centroid - min) * factor);
+    return std::min(idx, num_bins - 1);
+}
+
+// Partitions the primitives in the given range in two subsets using a
+// surface area heuristic binned along the axis of greatest extent of the
+// centroids and returns the position where the second subset begins.
+static uint32_t partition_sah(static_tree_build_context &ctx, uint32_t begin, uint32_t end,
+                              const AABB &centroid_aabb) {
+    auto extent = centroid_aabb.max - centroid_aabb.min;
+    auto axis = max_index(extent);
+
+    if (!(extent[axis] > EDYN_EPSILON)) {
+        // All centroids are coincident. Split in the middle.
+        return begin + (end - begin) / 2;
+    }
+
+    auto count = end - begin;
+    auto num_bins = std::min(num_sah_bins, size_t(count));
+    auto factor = scalar(num_bins) / extent[axis];
+    auto axis_min = centroid_aabb.min[axis];
+    std::array<sah_bin, num_sah_bins> bins;
+
+    for (auto i = begin; i < end; ++i) {
+        auto &prim = ctx.primitives[i];
+        bins[sah_bin_index(prim.centroid[axis], axis_min, factor, num_bins)].add(prim.aabb);
+    }
+
+    // Sweep from the right to accumulate the cost of the right side of each
+    // split plane, then sweep from the left to find the cheapest plane.
+    std::array<scalar, num_sah_bins> right_cost;
+    auto right = sah_bin{};
+
+    for (auto i = num_bins - 1; i > 0; --i) {
+        right.add(bins[i].aabb, bins[i].count);
+        right_cost[i - 1] = right.count > 0 ? right.aabb.area() * scalar(right.count) : scalar(0);
+    }
+
+    auto left = sah_bin{};
+    auto best_cost = std::numeric_limits<scalar>::max();
+    auto best_split = num_bins;
+
+    for (size_t i = 0; i < num_bins - 1; ++i) {
+        left.add(bins[i].aabb, bins[i].count);
+
+        if (left.count == 0 || left.count == count) {
+            continue;
+        }
+
+        auto cost = left.aabb.area() * scalar(left.count) + right_cost[i];
+
+        if (cost < best_cost) {
+            best_cost = cost;
+            best_split = i;
+        }
+    }
+
+    if (best_split == num_bins) {
+        // All primitives fell in the same bin.
+        return begin + count / 2;
+    }
+
+    auto first = ctx.primitives.begin();
+    auto it = std::partition(first + begin, first + end, [&](const static_tree_build_primitive &prim) {
+        return sah_bin_index(prim.centroid[axis], axis_min, factor, num_bins) <= best_split;
+    });
+
+    return static_cast<uint32_t>(std::distance(first, it));
+}
+
+// Calculates the bounds of the node and splits it. Returns false if the
+// node is a leaf.
+static bool split_node(static_tree_build_context &ctx, static_tree_build_node &node,
+                       uint32_t begin, uint32_t end, uint32_t &middle) {
+    auto &first = ctx.primitives[begin];
+    node.aabb = first.aabb;
+    node.begin = begin;
+    node.end = end;
+    node.child1 = node.child2 = EDYN_NULL_NODE;
+
+    auto centroid_aabb = AABB{first.centroid, first.centroid};
+
+    for (auto i = begin + 1; i < end; ++i) {
+        auto &prim = ctx.primitives[i];
+        node.aabb = enclosing_aabb(node.aabb, prim.aabb);
+        centroid_aabb.min = min(centroid_aabb.min, prim.centroid);
+        centroid_aabb.max = max(centroid_aabb.max, prim.centroid);
+    }
+
+    if (end - begin <= ctx.max_obj_per_leaf) {
+        return false;
+    }
+
+    middle = partition_sah(ctx, begin, end, centroid_aabb);
+    EDYN_ASSERT(middle > begin && middle < end);
+    return true;
+}
+
+static void build_subtree(static_tree_build_context &ctx, std::vector<static_tree_build_node> &nodes,
+                          uint32_t node_idx, uint32_t begin, uint32_t end) {
+    uint32_t middle;
+
+    if (!split_node(ctx, nodes[node_idx], begin, end, middle)) {
+        return;
+    }
+
+    auto child1 = static_cast<uint32_t>(nodes.size());
+    auto child2 = child1 + 1;
+    nodes[node_idx].child1 = child1;
+    nodes[node_idx].child2 = child2;
+    nodes.emplace_back();
+    nodes.emplace_back();
+
+    build_subtree(ctx, nodes, child1, begin, middle);
+    build_subtree(ctx, nodes, child2, middle, end);
+}
+
+// Builds the top levels of the tree and collects the remaining subtrees
+// into tasks to be built in parallel.
+static void build_top_levels(static_tree_build_context &ctx, std::vector<static_tree_build_node> &nodes,
+                             std::vector<static_tree_build_task> &tasks, size_t depth,
+                             uint32_t node_idx, uint32_t begin, uint32_t end) {
+    if (depth == 0 || end - begin < min_parallel_task_size) {
+        tasks.push_back({node_idx, begin, end});
+        return;
+    }
+
+    uint32_t middle;
+
+    if (!split_node(ctx, nodes[node_idx], begin, end, middle)) {
+        return;
+    }
+
+    auto child1 = static_cast<uint32_t>(nodes.size());
+    auto child2 = child1 + 1;
+    nodes[node_idx].child1 = child1;
+    nodes[node_idx].child2 = child2;
+    nodes.emplace_back();
+    nodes.emplace_back();
+
+    build_top_levels(ctx, nodes, tasks, depth - 1, child1, begin, middle);
+    build_top_levels(ctx, nodes, tasks, depth - 1, child2, middle, end);
+}
+
+// Writes primitive ids in their final order, where the ids of each leaf are
+// contiguous.
+static void assign_ids(const static_tree_build_context &ctx, std::vector<uint32_t> &ids) {
+    for (size_t i = 0; i < ids.size(); ++i) {
+        ids[i] = ctx.primitives[i].id;
+    }
+}
+
+static bool should_build_in_parallel(size_t count) {
+    if (count < min_parallel_build_size) {
+        return false;
+    }
+
+    // Avoid blocking a worker thread while waiting for other workers, which
+    // could deadlock if all workers are building trees.
+    auto &dispatcher = job_dispatcher::global();
+    return dispatcher.running() && dispatcher.num_workers() > 1 && worker::current() == nullptr;
+}
+
+std::vector<static_tree_build_node> build_static_tree(const std::vector<AABB> &aabbs,
+                                                      std::vector<uint32_t> &ids,
+                                                      uint32_t max_obj_per_leaf) {
+    EDYN_ASSERT(!aabbs.empty());
+    EDYN_ASSERT(aabbs.size() == ids.size());
+
+    auto ctx = static_tree_build_context{};
+    ctx.max_obj_per_leaf = max_obj_per_leaf;
+    ctx.primitives.reserve(ids.size());
+
+    for (auto id : ids) {
+        auto &aabb = aabbs[id];
+        ctx.primitives.push_back({aabb, aabb.center(), id});
+    }
+
+    auto count = static_cast<uint32_t>(ids.size());
+    auto nodes = std::vector<static_tree_build_node>{};
+    // A binary tree with `n` leaves has `2n - 1` nodes.
+    nodes.reserve(2 * (count / max_obj_per_leaf + 1));
+    nodes.emplace_back();
+
+    if (!should_build_in_parallel(count)) {
+        build_subtree(ctx, nodes, 0, 0, count);
+        assign_ids(ctx, ids);
+        return nodes;
+    }
+
+    // Split the top levels sequentially until there are a few tasks per
+    // worker, then build the subtrees in parallel into separate arrays.
+    size_t depth = 0;
+
+    while ((size_t(1) << depth) < job_dispatcher::global().num_workers() * 4) {
+        ++depth;
+    }
+
+    auto tasks = std::vector<static_tree_build_task>{};
+    build_top_levels(ctx, nodes, tasks, depth, 0, 0, count);
+
+    auto subtrees = std::vector<std::vector<static_tree_build_node>>(tasks.size());
+
+    parallel_for(size_t{0}, tasks.size(), [&](size_t i) {
+        auto &task = tasks[i];
+        auto &subtree = subtrees[i];
+        subtree.emplace_back();
+        build_subtree(ctx, subtree, 0, task.begin, task.end);
+    });
+
+    // Insert subtrees into the final array. The subtree root replaces the
+    // task node and the other nodes are appended.
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        auto &subtree = subtrees[i];
+        auto offset = static_cast<uint32_t>(nodes.size()) - 1;
+
+        for (auto &node : subtree) {
+            if (!node.leaf()) {
+                node.child1 += offset;
+                node.child2 += offset;
+            }
+        }
+
+        nodes[tasks[i].node_idx] = subtree.front();
+        nodes.insert(nodes.end(), subtree.begin() + 1, subtree.end());
+    }
+
+    assign_ids(ctx, ids);
+
+    return nodes;
+}
+
+}
@@ -0,0 +1,93 @@
+#include "edyn/collision/wide_tree.hpp"
+#include "edyn/config/config.h"
+#include <array>
+#include <limits>
+
+namespace edyn {
+
+void wide_tree::build(const std::vector<tree_node> &nodes, tree_node_id_t root) {
+    m_nodes.clear();
+
+    if (root == null_tree_node_id) {
+        return;
+    }
+
+    constexpr auto width = wide_tree_node::width;
+    constexpr auto large = std::numeric_limits<scalar>::max();
+
+    // Pairs of binary node id and the index of the wide node it becomes.
+    m_build_stack.clear();
+    m_build_stack.emplace_back(root, tree_node_id_t{0});
+    m_nodes.emplace_back();
+
+    while (!m_build_stack.empty()) {
+        auto [id, index] = m_build_stack.back();
+        m_build_stack.pop_back();
+
+        // Collect up to four descendants by repeatedly opening the internal
+        // node with the largest surface area, which gives tighter nodes.
+        auto children = std::array<tree_node_id_t, width>{};
+        unsigned count = 0;
+
+        if (nodes[id].leaf()) {
+            children[count++] = id;
+        } else {
+            children[count++] = nodes[id].child1;
+            children[count++] = nodes[id].child2;
+
+            while (count < width) {
+                auto best_idx = width;
+                auto best_area = -large;
+
+                for (unsigned i = 0; i < count; ++i) {
+                    auto &child = nodes[children[i]];
+
+                    if (!child.leaf() && child.aabb.area() > best_area) {
+                        best_area = child.aabb.area();
+                        best_idx = i;
+                    }
+                }
+
+                if (best_idx == width) {
+                    break;
+                }
+
+                auto &opened = nodes[children[best_idx]];
+                children[best_idx] = opened.child1;
+                children[count++] = opened.child2;
+            }
+        }
+
+        auto wide_node = wide_tree_node{};
+
+        for (unsigned i = 0; i < width; ++i) {
+            if (i < count) {
+                auto &child = nodes[children[i]];
+                wide_node.min_x[i] = child.aabb.min.x;
+                wide_node.min_y[i] = child.aabb.min.y;
+                wide_node.min_z[i] = child.aabb.min.z;
+                wide_node.max_x[i] = child.aabb.max.x;
+                wide_node.max_y[i] = child.aabb.max.y;
+                wide_node.max_z[i] = child.aabb.max.z;
+
+                if (child.leaf()) {
+                    EDYN_ASSERT((children[i] & leaf_flag) == 0);
+                    wide_node.child[i] = children[i] | leaf_flag;
+                } else {
+                    auto child_index = static_cast<tree_node_id_t>(m_nodes.size());
+                    m_nodes.emplace_back();
+                    m_build_stack.emplace_back(children[i], child_index);
+                    wide_node.child[i] = child_index;
+                }
+            } else {
+                wide_node.min_x[i] = wide_node.min_y[i] = wide_node.min_z[i] = large;
+                wide_node.max_x[i] = wide_node.max_y[i] = wide_node.max_z[i] = -large;
+                wide_node.child[i] = null_tree_node_id;
+            }
+        }
+
+        m_nodes[index] = wide_node;
+    }
+}
+
+}
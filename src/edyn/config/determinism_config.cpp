@@ -0,0 +1,26 @@
+#include "edyn/config/determinism_config.hpp"
+#include "edyn/context/settings.hpp"
+#include "edyn/networking/context/client_network_context.hpp"
+#include "edyn/simulation/stepper_async.hpp"
+#include <entt/entity/registry.hpp>
+
+namespace edyn {
+
+void set_deterministic(entt::registry &registry, bool deterministic) {
+    auto &settings = registry.ctx().at<edyn::settings>();
+    settings.deterministic = deterministic;
+
+    if (auto *stepper = registry.ctx().find<stepper_async>()) {
+        stepper->settings_changed();
+    }
+
+    if (auto *ctx = registry.ctx().find<client_network_context>()) {
+        ctx->extrapolator->set_settings(settings);
+    }
+}
+
+bool is_deterministic(const entt::registry &registry) {
+    return registry.ctx().at<settings>().deterministic;
+}
+
+}
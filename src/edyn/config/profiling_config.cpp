@@ -0,0 +1,38 @@
+#include "edyn/config/profiling_config.hpp"
+#include "edyn/context/settings.hpp"
+#include "edyn/networking/context/client_network_context.hpp"
+#include "edyn/simulation/stepper_async.hpp"
+#include <entt/entity/registry.hpp>
+
+namespace edyn {
+
+void set_profiling_enabled(entt::registry &registry, bool enabled, size_t history_size) {
+    auto &settings = registry.ctx().at<edyn::settings>();
+    settings.profiling_enabled = enabled;
+
+    if (registry.ctx().contains<step_stats_history>()) {
+        registry.ctx().erase<step_stats_history>();
+    }
+
+    if (enabled) {
+        registry.ctx().emplace<step_stats_history>(history_size);
+    }
+
+    if (auto *stepper = registry.ctx().find<stepper_async>()) {
+        stepper->settings_changed();
+    }
+
+    if (auto *ctx = registry.ctx().find<client_network_context>()) {
+        ctx->extrapolator->set_settings(settings);
+    }
+}
+
+bool is_profiling_enabled(const entt::registry &registry) {
+    return registry.ctx().at<settings>().profiling_enabled;
+}
+
+const step_stats_history * get_step_stats(const entt::registry &registry) {
+    return registry.ctx().find<step_stats_history>();
+}
+
+}
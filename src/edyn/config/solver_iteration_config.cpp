@@ -74,4 +74,23 @@ void set_solver_individual_restitution_iterations(entt::registry &registry, unsi
     }
 }
 
+unsigned get_solver_island_coloring_threshold(const entt::registry &registry) {
+    return registry.ctx().at<settings>().island_coloring_threshold;
+}
+
+void set_solver_island_coloring_threshold(entt::registry &registry, unsigned threshold,
+                                          bool deterministic) {
+    auto &settings = registry.ctx().at<edyn::settings>();
+    settings.island_coloring_threshold = threshold;
+    settings.deterministic_island_coloring = deterministic;
+
+    if (auto *stepper = registry.ctx().find<stepper_async>()) {
+        stepper->settings_changed();
+    }
+
+    if (auto *ctx = registry.ctx().find<client_network_context>()) {
+        ctx->extrapolator->set_settings(settings);
+    }
+}
+
 }
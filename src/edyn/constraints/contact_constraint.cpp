@@ -4,6 +4,7 @@
 #include "edyn/collision/contact_manifold.hpp"
 #include "edyn/dynamics/position_solver.hpp"
 #include "edyn/dynamics/row_cache.hpp"
+#include "edyn/config/constants.hpp"
 #include "edyn/math/constants.hpp"
 #include "edyn/math/transform.hpp"
 #include "edyn/context/settings.hpp"
@@ -37,9 +38,14 @@ void contact_constraint::prepare(
 
         auto &normal_options = cache.get_options();
 
+        // Points further apart than the breaking threshold are speculative
+        // contacts of bodies with continuous contacts, which must only
+        // prevent the gap from being crossed in this step.
+        auto speculative = cp.distance > contact_breaking_threshold;
+
         // Do not use the traditional restitution path if the restitution solver
         // is being used.
-        if (settings.num_restitution_iterations == 0) {
+        if (settings.num_restitution_iterations == 0 && !speculative) {
             normal_options.restitution = cp.restitution;
         }
 
@@ -63,6 +69,11 @@ void contact_constraint::prepare(
             // penetration after the following physics update.
             normal_options.error = cp.distance / dt;
             normal_row.upper_limit = large_scalar;
+
+            // Allow the entire gap to be closed in one step.
+            if (speculative) {
+                normal_options.erp = 1;
+            }
         }
 
         // Create special friction rows.
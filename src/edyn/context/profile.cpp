@@ -0,0 +1,154 @@
+#include "edyn/context/profile.hpp"
+#include "edyn/context/settings.hpp"
+#include "edyn/collision/contact_manifold.hpp"
+#include "edyn/comp/tag.hpp"
+#include "edyn/dynamics/row_cache.hpp"
+#include "edyn/parallel/job_dispatcher.hpp"
+#include "edyn/time/time.hpp"
+#include "edyn/util/island_util.hpp"
+#include <entt/entity/registry.hpp>
+#include <algorithm>
+
+namespace edyn {
+
+const char * profile_stage_name(profile_stage stage) {
+    switch (stage) {
+    case profile_stage::broadphase: return "broadphase";
+    case profile_stage::island_manager: return "island_manager";
+    case profile_stage::narrowphase: return "narrowphase";
+    case profile_stage::restitution: return "restitution";
+    case profile_stage::constraint_preparation: return "constraint_preparation";
+    case profile_stage::island_solver: return "island_solver";
+    case profile_stage::position_iterations: return "position_iterations";
+    case profile_stage::update_aabbs: return "update_aabbs";
+    case profile_stage::count: break;
+    }
+
+    return "";
+}
+
+void step_profiler::begin_step(double timestamp) {
+    for (auto &counter : m_stage_counter) {
+        counter.store(0, std::memory_order_relaxed);
+    }
+
+    m_num_tree_moves.store(0, std::memory_order_relaxed);
+    m_timestamp = timestamp;
+    m_start_busy_time = job_dispatcher::global().busy_time();
+    m_start_counter = performance_counter();
+}
+
+void step_profiler::end_step(entt::registry &registry) {
+    auto frequency = static_cast<double>(performance_frequency());
+
+    auto stats = step_stats{};
+    stats.timestamp = m_timestamp;
+    stats.step_time = static_cast<double>(performance_counter() - m_start_counter) / frequency;
+
+    for (size_t i = 0; i < m_stage_counter.size(); ++i) {
+        stats.stage_time[i] = static_cast<double>(m_stage_counter[i].load(std::memory_order_relaxed)) / frequency;
+    }
+
+    stats.num_tree_moves = m_num_tree_moves.load(std::memory_order_relaxed);
+
+    auto &dispatcher = job_dispatcher::global();
+    auto num_workers = dispatcher.num_workers();
+
+    if (num_workers > 0 && stats.step_time > 0) {
+        auto busy_time = dispatcher.busy_time() - m_start_busy_time;
+        stats.worker_utilization = std::min(busy_time / (stats.step_time * num_workers), 1.0);
+    }
+
+    auto manifold_view = registry.view<contact_manifold>(exclude_sleeping_disabled);
+
+    for (auto [entity, manifold] : manifold_view.each()) {
+        ++stats.num_manifolds;
+        stats.num_contact_points += manifold.num_points;
+    }
+
+    for (auto [island_entity, cache] : registry.view<row_cache>(exclude_sleeping_disabled).each()) {
+        stats.num_constraint_rows += cache.rows.size();
+    }
+
+    for (auto island_entity : registry.view<island_tag>(entt::exclude_t<disabled_tag>{})) {
+        if (registry.all_of<sleeping_tag>(island_entity)) {
+            ++stats.num_islands_asleep;
+        } else {
+            ++stats.num_islands_awake;
+        }
+    }
+
+    finished.push_back(stats);
+}
+
+profile_scope::profile_scope(entt::registry &registry, profile_stage stage)
+    : m_profiler(registry.ctx().find<step_profiler>())
+    , m_stage(stage)
+    , m_start_counter(m_profiler ? performance_counter() : 0)
+{}
+
+profile_scope::~profile_scope() {
+    if (m_profiler) {
+        m_profiler->add_time(m_stage, performance_counter() - m_start_counter);
+    }
+}
+
+namespace internal {
+    void profile_begin_step(entt::registry &registry, double timestamp) {
+        auto &settings = registry.ctx().at<edyn::settings>();
+
+        if (!settings.profiling_enabled) {
+            if (registry.ctx().contains<step_profiler>()) {
+                registry.ctx().erase<step_profiler>();
+            }
+            return;
+        }
+
+        auto *profiler = registry.ctx().find<step_profiler>();
+
+        if (!profiler) {
+            profiler = &registry.ctx().emplace<step_profiler>();
+        }
+
+        profiler->begin_step(timestamp);
+    }
+
+    void profile_end_step(entt::registry &registry) {
+        if (auto *profiler = registry.ctx().find<step_profiler>()) {
+            profiler->end_step(registry);
+        }
+    }
+
+    void profile_tree_moves(entt::registry &registry, unsigned count) {
+        if (auto *profiler = registry.ctx().find<step_profiler>()) {
+            profiler->add_tree_moves(count);
+        }
+    }
+
+    void publish_step_stats(entt::registry &registry) {
+        if (auto *profiler = registry.ctx().find<step_profiler>()) {
+            push_step_stats(registry, profiler->finished);
+            profiler->finished.clear();
+        }
+    }
+
+    std::vector<step_stats> take_step_stats(entt::registry &registry) {
+        if (auto *profiler = registry.ctx().find<step_profiler>()) {
+            auto stats = std::move(profiler->finished);
+            profiler->finished.clear();
+            return stats;
+        }
+
+        return {};
+    }
+
+    void push_step_stats(entt::registry &registry, const std::vector<step_stats> &stats) {
+        if (auto *history = registry.ctx().find<step_stats_history>()) {
+            for (auto &s : stats) {
+                history->push(s);
+            }
+        }
+    }
+}
+
+}
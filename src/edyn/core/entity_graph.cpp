@@ -1,5 +1,8 @@
 #include "edyn/core/entity_graph.hpp"
 #include "edyn/config/config.h"
+#include <numeric>
+#include <algorithm>
+#include <unordered_map>
 
 namespace edyn {
 
@@ -496,6 +499,177 @@ entity_graph::connected_components_t entity_graph::connected_components() {
     return components;
 }
 
+entity_graph::connected_components_t
+entity_graph::split_components(const std::vector<index_type> &node_indices) const {
+    struct search {
+        std::vector<index_type> to_visit;
+        size_t cursor {0};
+        // Index of the search this one was merged into.
+        size_t parent;
+        std::vector<index_type> non_connecting_indices;
+        connected_component component;
+    };
+
+    struct visit_state {
+        // Index of the search that visited the node first.
+        size_t search_idx;
+        // Whether the edges of the node have been visited.
+        bool expanded;
+    };
+
+    auto components = entity_graph::connected_components_t{};
+    auto searches = std::vector<search>{};
+    // A hash map is used so the cost does not depend on the graph size.
+    auto visited = std::unordered_map<index_type, visit_state>{};
+
+    // Collects the entities of all edges between a pair of nodes.
+    auto visit_edge_entities = [&](index_type edge_index, std::vector<entt::entity> &edge_entities) {
+        while (edge_index != null_index) {
+            auto &edge = m_edges[edge_index];
+            EDYN_ASSERT(edge.entity != entt::null);
+            edge_entities.push_back(edge.entity);
+            edge_index = edge.next;
+        }
+    };
+
+    auto find_root = [&](size_t search_idx) {
+        while (searches[search_idx].parent != search_idx) {
+            search_idx = searches[search_idx].parent;
+        }
+        return search_idx;
+    };
+
+    for (auto node_index : node_indices) {
+        EDYN_ASSERT(node_index < m_nodes.size());
+        EDYN_ASSERT(m_nodes[node_index].entity != entt::null);
+        EDYN_ASSERT(!m_nodes[node_index].non_connecting);
+
+        if (visited.count(node_index)) {
+            continue;
+        }
+
+        auto search_idx = searches.size();
+        auto &s = searches.emplace_back();
+        s.parent = search_idx;
+        s.to_visit.push_back(node_index);
+        s.component.nodes.push_back(m_nodes[node_index].entity);
+        visited[node_index] = {search_idx, false};
+    }
+
+    auto num_active = searches.size();
+    auto is_active = std::vector<bool>(searches.size(), true);
+    auto active_indices = std::vector<size_t>(searches.size());
+    std::iota(active_indices.begin(), active_indices.end(), size_t{0});
+
+    while (num_active > 1) {
+        // Searches become inactive as they finish or are merged.
+        active_indices.erase(std::remove_if(active_indices.begin(), active_indices.end(),
+                                            [&](size_t idx) { return !is_active[idx]; }),
+                             active_indices.end());
+
+        for (size_t i = 0; i < active_indices.size() && num_active > 1; ++i) {
+            auto search_idx = active_indices[i];
+
+            if (!is_active[search_idx]) {
+                continue;
+            }
+
+            auto &s = searches[search_idx];
+
+            if (s.cursor == s.to_visit.size()) {
+                // All reachable nodes were visited without meeting another
+                // search, thus this is a separate connected component.
+                components.push_back(std::move(s.component));
+                is_active[search_idx] = false;
+                --num_active;
+                continue;
+            }
+
+            auto node_index = s.to_visit[s.cursor++];
+            visited[node_index].expanded = true;
+            auto adj_index = m_nodes[node_index].adjacency_index;
+
+            while (adj_index != null_index) {
+                auto &adj = m_adjacencies[adj_index];
+                auto neighbor_index = adj.node_index;
+                auto &neighbor = m_nodes[neighbor_index];
+                auto edge_index = adj.edge_index;
+                adj_index = adj.next;
+
+                // Non-connecting nodes are not walked through and are shared
+                // among connected components.
+                if (neighbor.non_connecting) {
+                    if (std::find(s.non_connecting_indices.begin(), s.non_connecting_indices.end(),
+                                  neighbor_index) == s.non_connecting_indices.end()) {
+                        s.non_connecting_indices.push_back(neighbor_index);
+                        s.component.nodes.push_back(neighbor.entity);
+                    }
+
+                    visit_edge_entities(edge_index, s.component.edges);
+                    continue;
+                }
+
+                auto it = visited.find(neighbor_index);
+
+                if (it == visited.end()) {
+                    visited[neighbor_index] = {search_idx, false};
+                    s.to_visit.push_back(neighbor_index);
+                    s.component.nodes.push_back(neighbor.entity);
+                    visit_edge_entities(edge_index, s.component.edges);
+                    continue;
+                }
+
+                // Edges to expanded nodes were visited from the other side.
+                if (!it->second.expanded) {
+                    visit_edge_entities(edge_index, s.component.edges);
+                }
+
+                auto other_idx = find_root(it->second.search_idx);
+
+                if (other_idx == search_idx) {
+                    continue;
+                }
+
+                // Met another search, thus they're in the same connected
+                // component. Merge the smaller state into the larger one and
+                // keep it in this search.
+                auto &other = searches[other_idx];
+                EDYN_ASSERT(is_active[other_idx]);
+
+                if (other.component.nodes.size() > s.component.nodes.size()) {
+                    std::swap(s.to_visit, other.to_visit);
+                    std::swap(s.cursor, other.cursor);
+                    std::swap(s.non_connecting_indices, other.non_connecting_indices);
+                    std::swap(s.component, other.component);
+                }
+
+                s.to_visit.insert(s.to_visit.end(), other.to_visit.begin() + other.cursor, other.to_visit.end());
+                s.component.nodes.insert(s.component.nodes.end(), other.component.nodes.begin(), other.component.nodes.end());
+                s.component.edges.insert(s.component.edges.end(), other.component.edges.begin(), other.component.edges.end());
+
+                for (auto idx : other.non_connecting_indices) {
+                    if (std::find(s.non_connecting_indices.begin(), s.non_connecting_indices.end(),
+                                  idx) != s.non_connecting_indices.end()) {
+                        // Remove duplicate non-connecting node.
+                        auto entity_it = std::find(s.component.nodes.rbegin(), s.component.nodes.rend(),
+                                                   m_nodes[idx].entity);
+                        s.component.nodes.erase(std::next(entity_it).base());
+                    } else {
+                        s.non_connecting_indices.push_back(idx);
+                    }
+                }
+
+                other = search{};
+                other.parent = search_idx;
+                is_active[other_idx] = false;
+                --num_active;
+            }
+        }
+    }
+
+    return components;
+}
+
 double entity_graph::efficiency() const {
     if (m_nodes.empty()) {
         return 0;
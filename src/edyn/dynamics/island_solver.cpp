@@ -15,9 +15,12 @@
 #include "edyn/constraints/constraint.hpp"
 #include "edyn/constraints/constraint_row_friction.hpp"
 #include "edyn/constraints/contact_constraint.hpp"
+#include "edyn/context/profile.hpp"
 #include "edyn/dynamics/island_constraint_entities.hpp"
 #include "edyn/dynamics/position_solver.hpp"
 #include "edyn/dynamics/row_cache.hpp"
+#include "edyn/dynamics/row_block.hpp"
+#include "edyn/dynamics/row_coloring.hpp"
 #include "edyn/parallel/atomic_counter.hpp"
 #include "edyn/parallel/atomic_counter_sync.hpp"
 #include "edyn/parallel/job_dispatcher.hpp"
@@ -126,6 +129,108 @@ static void warm_start(row_cache &cache) {
     }
 }
 
+// Calls `func` for each index in `[0, count)`, in parallel if large enough.
+template<typename Func>
+static void for_each_batch_index(size_t count, bool mt, Func func) {
+    constexpr size_t max_sequential_size = 32;
+
+    if (!mt || count <= max_sequential_size) {
+        for (size_t i = 0; i < count; ++i) {
+            func(i);
+        }
+    } else {
+        auto &dispatcher = job_dispatcher::global();
+        parallel_for(dispatcher, size_t{0}, count, size_t{1}, func);
+    }
+}
+
+// Calls `func` for each index of one kind of row in all color batches, one
+// batch after the other, followed by the overflow batch. The constraints in a
+// batch do not share any bodies, thus they're visited in parallel. The rows of
+// a single constraint act upon the same bodies and are visited sequentially.
+template<typename Func>
+static void for_each_colored(const row_color_batches &colors,
+                             std::vector<unsigned> row_color_batches::batch::*indices,
+                             unsigned row_color_batches::constraint_offset::*offset,
+                             bool mt, Func func) {
+    for (unsigned i = 0; i < colors.num_colors; ++i) {
+        auto &batch = colors.batches[i];
+        auto &batch_indices = batch.*indices;
+        for_each_batch_index(batch.num_constraints(), mt, [&](size_t j) {
+            auto first = batch.offsets[j].*offset;
+            auto last = batch.offsets[j + 1].*offset;
+
+            for (auto k = first; k < last; ++k) {
+                func(batch_indices[k]);
+            }
+        });
+    }
+
+    for (auto index : colors.overflow.*indices) {
+        func(index);
+    }
+}
+
+static void warm_start(row_cache &cache, const row_color_batches &colors, bool mt) {
+    using batch = row_color_batches::batch;
+    using offset = row_color_batches::constraint_offset;
+
+    for_each_colored(colors, &batch::rows, &offset::rows, mt, [&](unsigned i) {
+        warm_start(cache.rows[i]);
+    });
+
+    for_each_colored(colors, &batch::friction, &offset::friction, mt, [&](unsigned i) {
+        warm_start(cache.friction[i], cache.rows);
+    });
+
+    for_each_colored(colors, &batch::rolling, &offset::rolling, mt, [&](unsigned i) {
+        warm_start(cache.rolling[i], cache.rows);
+    });
+
+    for_each_colored(colors, &batch::spinning, &offset::spinning, mt, [&](unsigned i) {
+        warm_start(cache.spinning[i], cache.rows);
+    });
+}
+
+static void solve(row_cache &cache, const row_color_batches &colors,
+                  row_block_cache &blocks, bool mt) {
+    using batch = row_color_batches::batch;
+    using offset = row_color_batches::constraint_offset;
+
+    // Normal rows of each color are solved in blocks, multiple rows at once.
+    // Groups of blocks do not share bodies and are solved in parallel, while
+    // the blocks of a group are solved in order.
+    for (unsigned i = 0; i < colors.num_colors; ++i) {
+        auto first_group = blocks.color_offsets[i];
+        auto num_groups = blocks.color_offsets[i + 1] - first_group;
+        for_each_batch_index(num_groups, mt, [&](size_t j) {
+            auto group = first_group + j;
+
+            for (auto k = blocks.group_offsets[group]; k < blocks.group_offsets[group + 1]; ++k) {
+                solve(blocks.blocks[k], colors.dv.data(), colors.dw.data(), cache.rows);
+            }
+        });
+    }
+
+    for (auto i : colors.overflow.rows) {
+        auto &row = cache.rows[i];
+        auto delta_impulse = solve(row);
+        apply_row_impulse(delta_impulse, row);
+    }
+
+    for_each_colored(colors, &batch::friction, &offset::friction, mt, [&](unsigned i) {
+        solve_friction(cache.friction[i], cache.rows);
+    });
+
+    for_each_colored(colors, &batch::rolling, &offset::rolling, mt, [&](unsigned i) {
+        solve_friction(cache.rolling[i], cache.rows);
+    });
+
+    for_each_colored(colors, &batch::spinning, &offset::spinning, mt, [&](unsigned i) {
+        solve_spin_friction(cache.spinning[i], cache.rows);
+    });
+}
+
 static void solve(row_cache &cache) {
     for (auto &row : cache.rows) {
         auto delta_impulse = solve(row);
@@ -205,8 +310,6 @@ void pack_rows(entt::registry &registry, row_cache &cache, const entt::sparse_se
     std::apply([&](auto ... c) {
         (insert_rows<decltype(c)>(registry, cache, entities, constraint_entities), ...);
     }, constraints_tuple);
-
-    warm_start(cache);
 }
 
 template<typename C>
@@ -377,6 +480,7 @@ scalar solve_position_constraints(entt::registry &registry, const island_constra
 }
 
 static bool solve_position_constraints(entt::registry &registry, const island_constraint_entities &constraint_entities) {
+    EDYN_PROFILE_SCOPE(registry, profile_stage::position_iterations);
     auto error = solve_position_constraints(registry, constraint_entities, constraints_tuple);
     return error < scalar(0.005);
 }
@@ -443,6 +547,7 @@ static void island_solver_update(island_solver_context &ctx) {
         auto &constraint_entities = ctx.registry->get<island_constraint_entities>(ctx.island_entity);
         auto &cache = ctx.registry->get<row_cache>(ctx.island_entity);
         pack_rows(*ctx.registry, cache, island.edges, constraint_entities);
+        warm_start(cache);
 
         ctx.state = island_solver_state::solve_constraints;
         ctx.iteration = 0;
@@ -516,6 +621,7 @@ void run_island_solver_seq(entt::registry &registry, entt::entity island_entity,
     auto &constraint_entities = registry.get<island_constraint_entities>(island_entity);
     auto &cache = registry.get<row_cache>(island_entity);
     pack_rows(registry, cache, island.edges, constraint_entities);
+    warm_start(cache);
 
     for (unsigned i = 0; i < num_iterations; ++i) {
         solve(cache);
@@ -533,6 +639,37 @@ void run_island_solver_seq(entt::registry &registry, entt::entity island_entity,
     }
 }
 
+void run_island_solver_colored(entt::registry &registry, entt::entity island_entity,
+                               unsigned num_iterations, unsigned num_position_iterations,
+                               scalar dt, bool deterministic, bool mt) {
+    auto &island = registry.get<edyn::island>(island_entity);
+    auto &constraint_entities = registry.get<island_constraint_entities>(island_entity);
+    auto &cache = registry.get<row_cache>(island_entity);
+    auto &colors = registry.get<row_color_batches>(island_entity);
+    auto &blocks = registry.get<row_block_cache>(island_entity);
+    pack_rows(registry, cache, island.edges, constraint_entities);
+    color_rows(registry, cache, constraint_entities, colors, deterministic);
+    warm_start(cache, colors, mt);
+    pack_row_blocks(cache, colors, blocks);
+
+    for (unsigned i = 0; i < num_iterations; ++i) {
+        solve(cache, colors, blocks, mt);
+    }
+
+    write_back_body_slots(registry, colors);
+
+    const auto exec_mode = mt ? execution_mode::sequential_multithreaded : execution_mode::sequential;
+    apply_solution(registry, dt, island.nodes, exec_mode);
+
+    assign_applied_impulses(registry, cache, constraint_entities);
+
+    for (unsigned i = 0; i < num_position_iterations; ++i) {
+        if (solve_position_constraints(registry, constraint_entities)) {
+            break;
+        }
+    }
+}
+
 static void island_solver_job_func(job::data_type &data) {
     auto archive = memory_input_archive(data.data(), data.size());
     island_solver_context ctx;
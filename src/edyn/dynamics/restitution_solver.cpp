@@ -7,6 +7,7 @@
 #include "edyn/constraints/constraint_row_options.hpp"
 #include "edyn/collision/contact_manifold.hpp"
 #include "edyn/collision/contact_point.hpp"
+#include "edyn/config/constants.hpp"
 #include "edyn/util/constraint_util.hpp"
 #include "edyn/comp/position.hpp"
 #include "edyn/comp/orientation.hpp"
@@ -24,14 +25,24 @@
 #include "edyn/comp/graph_node.hpp"
 #include "edyn/context/settings.hpp"
 #include "edyn/util/island_util.hpp"
+#include "edyn/parallel/job_dispatcher.hpp"
+#include "edyn/parallel/parallel_for.hpp"
 #include <entt/entity/registry.hpp>
 #include <entt/entity/utility.hpp>
+#include <algorithm>
+#include <vector>
 
 namespace edyn {
 
+// Whether a contact point will be reached in the next step. Speculative points
+// of bodies with continuous contacts could still be far apart.
+static bool will_touch(const contact_point &cp, scalar normal_relvel, scalar dt) {
+    return cp.distance + normal_relvel * dt <= contact_breaking_threshold;
+}
+
 template<typename BodyView, typename OriginView>
 scalar get_manifold_min_relvel(const contact_manifold &manifold, const BodyView &body_view,
-                               const OriginView &origin_view) {
+                               const OriginView &origin_view, scalar dt) {
     if (manifold.num_points == 0) {
         return EDYN_SCALAR_MAX;
     }
@@ -57,21 +68,22 @@ scalar get_manifold_min_relvel(const contact_manifold &manifold, const BodyView
         auto vB = linvelB + cross(angvelB, rB);
         auto relvel = vA - vB;
         auto normal_relvel = dot(relvel, normal);
-        min_relvel = std::min(normal_relvel, min_relvel);
+
+        if (will_touch(cp, normal_relvel, dt)) {
+            min_relvel = std::min(normal_relvel, min_relvel);
+        }
     }
 
     return min_relvel;
 }
 
-bool solve_restitution_iteration(entt::registry &registry, entt::entity island_entity,
+template<typename Iterator, typename BodyView, typename OriginView, typename ManifoldView, typename NodeView>
+bool solve_restitution_iteration(const entity_graph &graph,
+                                 Iterator manifolds_begin, Iterator manifolds_end,
+                                 restitution_solver_buffers::slot &slot,
+                                 const BodyView &body_view, const OriginView &origin_view,
+                                 const ManifoldView &manifold_view, const NodeView &node_view,
                                  scalar dt, unsigned individual_iterations) {
-    auto body_view = registry.view<position, orientation, linvel, angvel,
-                                   mass_inv, inertia_world_inv,
-                                   delta_linvel, delta_angvel>();
-    auto origin_view = registry.view<origin>();
-    auto restitution_view = registry.view<contact_manifold_with_restitution>();
-    auto manifold_view = registry.view<contact_manifold>();
-
     // Solve manifolds in small groups, these groups being all manifolds connected
     // to one rigid body, usually a fast moving one. Ignore manifolds which are
     // separating, i.e. positive normal relative velocity. Initially, pick the
@@ -84,15 +96,11 @@ bool solve_restitution_iteration(entt::registry &registry, entt::entity island_e
     // Find manifold with highest penetration velocity.
     auto min_relvel = EDYN_SCALAR_MAX;
     auto fastest_manifold_entity = entt::entity{entt::null};
-    auto &island = registry.get<edyn::island>(island_entity);
 
-    for (auto entity : island.edges) {
-        if (!restitution_view.contains(entity)) {
-            continue;
-        }
-
-        auto &manifold = manifold_view.get<contact_manifold>(entity);
-        auto local_min_relvel = get_manifold_min_relvel(manifold, body_view, origin_view);
+    for (auto it = manifolds_begin; it != manifolds_end; ++it) {
+        auto entity = *it;
+        auto &manifold = manifold_view.template get<contact_manifold>(entity);
+        auto local_min_relvel = get_manifold_min_relvel(manifold, body_view, origin_view, dt);
 
         if (local_min_relvel < min_relvel) {
             min_relvel = local_min_relvel;
@@ -108,7 +116,7 @@ bool solve_restitution_iteration(entt::registry &registry, entt::entity island_e
     // In order to prevent bodies from bouncing forever, calculate a minimum
     // penetration velocity that must be met for the restitution impulse to
     // be applied.
-    auto &fastest_manifold = manifold_view.get<contact_manifold>(fastest_manifold_entity);
+    auto &fastest_manifold = manifold_view.template get<contact_manifold>(fastest_manifold_entity);
     auto relvel_threshold = scalar(-0.005);
 
     if (min_relvel > relvel_threshold) {
@@ -117,26 +125,23 @@ bool solve_restitution_iteration(entt::registry &registry, entt::entity island_e
     }
 
     // Reuse collections of rows to prevent a high number of allocations.
-    auto normal_rows = std::vector<constraint_row>{};
-    auto friction_rows = std::vector<constraint_row_friction>{};
-
-    normal_rows.reserve(10);
-    friction_rows.reserve(10);
+    auto &normal_rows = slot.normal_rows;
+    auto &friction_rows = slot.friction_rows;
 
     auto solve_manifolds = [&](const std::vector<entt::entity> &manifold_entities) {
         normal_rows.clear();
         friction_rows.clear();
 
         for (auto manifold_entity : manifold_entities) {
-            auto &manifold = manifold_view.get<contact_manifold>(manifold_entity);
+            auto &manifold = manifold_view.template get<contact_manifold>(manifold_entity);
 
             auto [posA, ornA, linvelA, angvelA, inv_mA, inv_IA, dvA, dwA] = body_view.get(manifold.body[0]);
             auto [posB, ornB, linvelB, angvelB, inv_mB, inv_IB, dvB, dwB] = body_view.get(manifold.body[1]);
 
             auto originA = origin_view.contains(manifold.body[0]) ?
-                origin_view.get<origin>(manifold.body[0]) : static_cast<vector3>(posA);
+                origin_view.template get<origin>(manifold.body[0]) : static_cast<vector3>(posA);
             auto originB = origin_view.contains(manifold.body[1]) ?
-                origin_view.get<origin>(manifold.body[1]) : static_cast<vector3>(posB);
+                origin_view.template get<origin>(manifold.body[1]) : static_cast<vector3>(posB);
 
             // Create constraint rows for non-penetration constraints for each
             // contact point.
@@ -160,7 +165,19 @@ bool solve_restitution_iteration(entt::registry &registry, entt::entity island_e
                 normal_row.upper_limit = large_scalar;
 
                 auto normal_options = constraint_row_options{};
-                normal_options.restitution = cp.restitution;
+                auto normal_relvel = get_relative_speed(normal_row.J, linvelA, angvelA, linvelB, angvelB);
+
+                // Speculative points of bodies with continuous contacts must
+                // allow the gap to be closed and must only bounce if they
+                // will be reached in this step.
+                if (cp.distance > contact_breaking_threshold) {
+                    normal_options.error = cp.distance / dt;
+                    normal_options.erp = 1;
+                }
+
+                if (will_touch(cp, normal_relvel, dt)) {
+                    normal_options.restitution = cp.restitution;
+                }
 
                 prepare_row(normal_row, normal_options, linvelA, angvelA, linvelB, angvelB);
 
@@ -199,7 +216,7 @@ bool solve_restitution_iteration(entt::registry &registry, entt::entity island_e
         size_t row_idx = 0;
 
         for (auto manifold_entity : manifold_entities) {
-            auto &manifold = manifold_view.get<contact_manifold>(manifold_entity);
+            auto &manifold = manifold_view.template get<contact_manifold>(manifold_entity);
 
             for (size_t pt_idx = 0; pt_idx < manifold.num_points; ++pt_idx) {
                 auto &cp = manifold.get_point(pt_idx);
@@ -218,13 +235,13 @@ bool solve_restitution_iteration(entt::registry &registry, entt::entity island_e
 
         // Apply delta velocities.
         for (auto manifold_entity : manifold_entities) {
-            auto &manifold = manifold_view.get<contact_manifold>(manifold_entity);
+            auto &manifold = manifold_view.template get<contact_manifold>(manifold_entity);
 
             for (auto body_entity : manifold.body) {
                 // There are duplicates among all manifold bodies but this
                 // operation is idempotent since the delta velocity is set
                 // to zero.
-                auto [v, w, dv, dw] = body_view.get<linvel, angvel, delta_linvel, delta_angvel>(body_entity);
+                auto [v, w, dv, dw] = body_view.template get<linvel, angvel, delta_linvel, delta_angvel>(body_entity);
                 v += dv;
                 w += dw;
                 dv = vector3_zero;
@@ -237,47 +254,74 @@ bool solve_restitution_iteration(entt::registry &registry, entt::entity island_e
     // select the one that has the highest velocity.
     // Traversal is done over connecting nodes, thus ignore non-connecting nodes
     // (i.e. static and kinematic rigid bodies).
-    auto &graph = registry.ctx().at<entity_graph>();
     entity_graph::index_type start_node_index;
 
-    if (length_sqr(body_view.get<linvel>(fastest_manifold.body[0])) >
-        length_sqr(body_view.get<linvel>(fastest_manifold.body[1]))) {
-        auto &node0 = registry.get<graph_node>(fastest_manifold.body[0]);
+    if (length_sqr(body_view.template get<linvel>(fastest_manifold.body[0])) >
+        length_sqr(body_view.template get<linvel>(fastest_manifold.body[1]))) {
+        auto [node0] = node_view.get(fastest_manifold.body[0]);
 
         if (graph.is_connecting_node(node0.node_index)) {
             start_node_index = node0.node_index;
         } else {
-            auto &node1 = registry.get<graph_node>(fastest_manifold.body[1]);
+            auto [node1] = node_view.get(fastest_manifold.body[1]);
             EDYN_ASSERT(graph.is_connecting_node(node1.node_index));
             start_node_index = node1.node_index;
         }
     } else {
-        auto &node1 = registry.get<graph_node>(fastest_manifold.body[1]);
+        auto [node1] = node_view.get(fastest_manifold.body[1]);
 
         if (graph.is_connecting_node(node1.node_index)) {
             start_node_index = node1.node_index;
         } else {
-            auto &node0 = registry.get<graph_node>(fastest_manifold.body[0]);
+            auto [node0] = node_view.get(fastest_manifold.body[0]);
             EDYN_ASSERT(graph.is_connecting_node(node0.node_index));
             start_node_index = node0.node_index;
         }
     }
 
-    std::vector<entt::entity> manifold_entities;
+    auto &manifold_entities = slot.manifold_entities;
+    auto &to_visit = slot.to_visit;
+    auto &node_stamps = slot.node_stamps;
+
+    // Traverse the graph breadth-first starting at the fastest body. Visited
+    // nodes are stamped in a buffer which is not cleared between traversals
+    // instead of using `entity_graph::traverse`, which allocates state for
+    // the entire graph on every iteration, while only the island is reached.
+    if (++slot.visit_stamp == 0) {
+        std::fill(node_stamps.begin(), node_stamps.end(), 0u);
+        slot.visit_stamp = 1;
+    }
+
+    auto visit = [&](entity_graph::index_type node_index) {
+        if (node_index >= node_stamps.size()) {
+            node_stamps.resize(node_index + 1, 0u);
+        }
+
+        if (node_stamps[node_index] != slot.visit_stamp) {
+            node_stamps[node_index] = slot.visit_stamp;
+            to_visit.push_back(node_index);
+        }
+    };
+
+    manifold_entities.clear();
+    to_visit.clear();
+    visit(start_node_index);
+
+    for (size_t visit_idx = 0; visit_idx < to_visit.size(); ++visit_idx) {
+        auto node_index = to_visit[visit_idx];
 
-    graph.traverse(start_node_index, [&](auto node_index) {
         // Ignore non-procedural entities.
-        if (!graph.is_connecting_node(node_index)) return;
+        if (!graph.is_connecting_node(node_index)) continue;
 
         graph.visit_edges(node_index, [&](auto edge_index) {
             auto edge_entity = graph.edge_entity(edge_index);
 
             if (!manifold_view.contains(edge_entity)) return;
 
-            auto &manifold = manifold_view.get<contact_manifold>(edge_entity);
+            auto &manifold = manifold_view.template get<contact_manifold>(edge_entity);
 
             // Ignore manifolds which are not penetrating fast enough.
-            auto local_min_relvel = get_manifold_min_relvel(manifold, body_view, origin_view);
+            auto local_min_relvel = get_manifold_min_relvel(manifold, body_view, origin_view, dt);
 
             if (local_min_relvel < relvel_threshold) {
                 manifold_entities.push_back(edge_entity);
@@ -289,25 +333,94 @@ bool solve_restitution_iteration(entt::registry &registry, entt::entity island_e
         }
 
         manifold_entities.clear();
-    });
+
+        graph.visit_neighbors(node_index, [&](entt::entity neighbor) {
+            auto [neighbor_node] = node_view.get(neighbor);
+            visit(neighbor_node.node_index);
+        });
+    }
 
     return false;
 }
 
-void solve_restitution(entt::registry &registry, scalar dt) {
+// Index of the buffers slot of the current thread. Workers of the dispatcher
+// have their own slot and any other thread uses the first.
+static size_t current_slot_index(job_dispatcher &dispatcher) {
+    auto *w = worker::current();
+    return w && &w->get_dispatcher() == &dispatcher ? w->index() + 1 : 0;
+}
+
+void solve_restitution(entt::registry &registry, restitution_solver_buffers &buffers,
+                       scalar dt, bool mt) {
     auto &settings = registry.ctx().at<edyn::settings>();
+    auto &graph = registry.ctx().at<entity_graph>();
+    auto body_view = registry.view<position, orientation, linvel, angvel,
+                                   mass_inv, inertia_world_inv,
+                                   delta_linvel, delta_angvel>();
+    auto origin_view = registry.view<origin>();
+    auto manifold_view = registry.view<contact_manifold>();
+    auto node_view = registry.view<graph_node>();
     auto island_view = registry.view<island_tag>(exclude_sleeping_disabled);
+    auto restitution_view = registry.view<contact_manifold_with_restitution, island_resident>(exclude_sleeping_disabled);
+
+    // Group manifolds with restitution by island, so that each iteration only
+    // has to look at these instead of all edges in the island. They're sorted
+    // by island in place since a map of vectors would allocate every step.
+    auto &island_manifolds = buffers.island_manifolds;
+    island_manifolds.clear();
+
+    for (auto [manifold_entity, resident] : restitution_view.each()) {
+        if (island_view.contains(resident.island_entity)) {
+            island_manifolds.emplace_back(resident.island_entity, manifold_entity);
+        }
+    }
+
+    std::sort(island_manifolds.begin(), island_manifolds.end());
+
+    auto &manifolds = buffers.manifolds;
+    auto &island_ranges = buffers.island_ranges;
+    manifolds.clear();
+    island_ranges.clear();
+
+    for (size_t i = 0; i < island_manifolds.size(); ++i) {
+        if (i == 0 || island_manifolds[i].first != island_manifolds[i - 1].first) {
+            island_ranges.emplace_back(i, i);
+        }
+
+        manifolds.push_back(island_manifolds[i].second);
+        ++island_ranges.back().second;
+    }
 
-    for (unsigned i = 0; i < settings.num_restitution_iterations; ++i) {
-        bool all_solved = true;
+    auto &dispatcher = job_dispatcher::global();
 
-        for (auto island_entity : island_view) {
-            all_solved &= solve_restitution_iteration(registry, island_entity, dt,
+    if (buffers.slots.size() < dispatcher.num_workers() + 1) {
+        buffers.slots.resize(dispatcher.num_workers() + 1);
+    }
+
+    // Islands are independent, thus each one iterates until its relative
+    // velocities are within threshold regardless of the others.
+    auto solve_island = [&, body_view, origin_view, manifold_view, node_view](size_t index) {
+        auto [begin, end] = island_ranges[index];
+        auto &slot = buffers.slots[current_slot_index(dispatcher)];
+
+        for (unsigned i = 0; i < settings.num_restitution_iterations; ++i) {
+            auto solved = solve_restitution_iteration(graph, manifolds.begin() + begin,
+                                                      manifolds.begin() + end, slot,
+                                                      body_view, origin_view,
+                                                      manifold_view, node_view, dt,
                                                       settings.num_individual_restitution_iterations);
+
+            if (solved) {
+                break;
+            }
         }
+    };
 
-        if (all_solved) {
-            break;
+    if (mt && island_ranges.size() > 1 && dispatcher.running()) {
+        parallel_for(dispatcher, size_t{}, island_ranges.size(), size_t{1}, solve_island);
+    } else {
+        for (size_t index = 0; index < island_ranges.size(); ++index) {
+            solve_island(index);
         }
     }
 }
@@ -0,0 +1,324 @@
+#include "edyn/dynamics/row_block.hpp"
+#include "edyn/dynamics/row_cache.hpp"
+#include "edyn/dynamics/row_coloring.hpp"
+#include "edyn/constraints/constraint_row.hpp"
+#include "edyn/config/config.h"
+#include <algorithm>
+#include <array>
+#include <numeric>
+
+#if defined(EDYN_DOUBLE_PRECISION)
+    #if defined(__AVX__)
+        #include <immintrin.h>
+        #define EDYN_ROW_BLOCK_AVX
+    #endif
+#else
+    #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #include <emmintrin.h>
+        #define EDYN_ROW_BLOCK_SSE
+    #endif
+#endif
+
+namespace edyn {
+
+namespace {
+
+constexpr auto width = constraint_row_block::width;
+
+// Thin wrapper over a SIMD register holding one value per row of a block, with
+// a portable fallback.
+#if defined(EDYN_ROW_BLOCK_SSE)
+    struct lane {
+        __m128 v;
+
+        static lane load(const scalar *p) { return {_mm_load_ps(p)}; }
+        void store(scalar *p) const { _mm_store_ps(p, v); }
+        friend lane operator+(lane a, lane b) { return {_mm_add_ps(a.v, b.v)}; }
+        friend lane operator-(lane a, lane b) { return {_mm_sub_ps(a.v, b.v)}; }
+        friend lane operator*(lane a, lane b) { return {_mm_mul_ps(a.v, b.v)}; }
+        friend lane operator<(lane a, lane b) { return {_mm_cmplt_ps(a.v, b.v)}; }
+        friend lane operator>(lane a, lane b) { return {_mm_cmpgt_ps(a.v, b.v)}; }
+        // Selects `a` where `mask` is set, `b` otherwise.
+        static lane select(lane mask, lane a, lane b) {
+            return {_mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v))};
+        }
+    };
+#elif defined(EDYN_ROW_BLOCK_AVX)
+    struct lane {
+        __m256d v;
+
+        static lane load(const scalar *p) { return {_mm256_load_pd(p)}; }
+        void store(scalar *p) const { _mm256_store_pd(p, v); }
+        friend lane operator+(lane a, lane b) { return {_mm256_add_pd(a.v, b.v)}; }
+        friend lane operator-(lane a, lane b) { return {_mm256_sub_pd(a.v, b.v)}; }
+        friend lane operator*(lane a, lane b) { return {_mm256_mul_pd(a.v, b.v)}; }
+        friend lane operator<(lane a, lane b) { return {_mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ)}; }
+        friend lane operator>(lane a, lane b) { return {_mm256_cmp_pd(a.v, b.v, _CMP_GT_OQ)}; }
+        static lane select(lane mask, lane a, lane b) {
+            return {_mm256_blendv_pd(b.v, a.v, mask.v)};
+        }
+    };
+#else
+    struct lane {
+        scalar v[width];
+        // Non-zero where a comparison is true.
+        bool m[width];
+
+        static lane load(const scalar *p) {
+            lane r;
+            for (unsigned i = 0; i < width; ++i) r.v[i] = p[i];
+            return r;
+        }
+        void store(scalar *p) const {
+            for (unsigned i = 0; i < width; ++i) p[i] = v[i];
+        }
+        template<typename Op>
+        static lane apply(lane a, lane b, Op op) {
+            lane r;
+            for (unsigned i = 0; i < width; ++i) r.v[i] = op(a.v[i], b.v[i]);
+            return r;
+        }
+        friend lane operator+(lane a, lane b) { return apply(a, b, [](scalar x, scalar y) { return x + y; }); }
+        friend lane operator-(lane a, lane b) { return apply(a, b, [](scalar x, scalar y) { return x - y; }); }
+        friend lane operator*(lane a, lane b) { return apply(a, b, [](scalar x, scalar y) { return x * y; }); }
+        friend lane operator<(lane a, lane b) {
+            lane r;
+            for (unsigned i = 0; i < width; ++i) r.m[i] = a.v[i] < b.v[i];
+            return r;
+        }
+        friend lane operator>(lane a, lane b) {
+            lane r;
+            for (unsigned i = 0; i < width; ++i) r.m[i] = a.v[i] > b.v[i];
+            return r;
+        }
+        static lane select(lane mask, lane a, lane b) {
+            lane r;
+            for (unsigned i = 0; i < width; ++i) r.v[i] = mask.m[i] ? a.v[i] : b.v[i];
+            return r;
+        }
+    };
+#endif
+
+// Gathered velocity deltas of one side of the rows in a block, indexed by
+// [axis][lane].
+struct alignas(sizeof(scalar) * 8) gathered_deltas {
+    scalar v[3][width];
+};
+
+void gather(const vector3 *deltas, const unsigned *slots, unsigned num_rows, gathered_deltas &out) {
+    for (unsigned i = 0; i < num_rows; ++i) {
+        auto &d = deltas[slots[i]];
+        out.v[0][i] = d.x;
+        out.v[1][i] = d.y;
+        out.v[2][i] = d.z;
+    }
+
+    for (unsigned i = num_rows; i < width; ++i) {
+        out.v[0][i] = out.v[1][i] = out.v[2][i] = 0;
+    }
+}
+
+void scatter(vector3 *deltas, const unsigned *slots, unsigned num_rows, const gathered_deltas &in) {
+    for (unsigned i = 0; i < num_rows; ++i) {
+        auto &d = deltas[slots[i]];
+        d.x = in.v[0][i];
+        d.y = in.v[1][i];
+        d.z = in.v[2][i];
+    }
+}
+
+lane dot(const scalar (&J)[3][width], const gathered_deltas &d) {
+    return lane::load(J[0]) * lane::load(d.v[0]) +
+           lane::load(J[1]) * lane::load(d.v[1]) +
+           lane::load(J[2]) * lane::load(d.v[2]);
+}
+
+void apply_impulse(const scalar (&MJ)[3][width], lane impulse, gathered_deltas &d) {
+    for (unsigned i = 0; i < 3; ++i) {
+        (lane::load(d.v[i]) + lane::load(MJ[i]) * impulse).store(d.v[i]);
+    }
+}
+
+void assign_lane(scalar (&dest)[3][width], unsigned lane_index, const vector3 &v) {
+    dest[0][lane_index] = v.x;
+    dest[1][lane_index] = v.y;
+    dest[2][lane_index] = v.z;
+}
+
+void clear_lane(constraint_row_block &block, unsigned lane_index) {
+    for (unsigned i = 0; i < 4; ++i) {
+        assign_lane(block.J[i], lane_index, vector3_zero);
+        assign_lane(block.MJ[i], lane_index, vector3_zero);
+    }
+
+    block.eff_mass[lane_index] = 0;
+    block.rhs[lane_index] = 0;
+    block.lower_limit[lane_index] = 0;
+    block.upper_limit[lane_index] = 0;
+    block.impulse[lane_index] = 0;
+    block.slotA[lane_index] = 0;
+    block.slotB[lane_index] = 0;
+    block.row_index[lane_index] = 0;
+}
+
+void assign_row(constraint_row_block &block, unsigned lane_index,
+                const constraint_row &row, unsigned row_index,
+                const std::array<unsigned, 2> &slots) {
+    for (unsigned j = 0; j < 4; ++j) {
+        assign_lane(block.J[j], lane_index, row.J[j]);
+    }
+
+    assign_lane(block.MJ[0], lane_index, row.inv_mA * row.J[0]);
+    assign_lane(block.MJ[1], lane_index, row.inv_IA * row.J[1]);
+    assign_lane(block.MJ[2], lane_index, row.inv_mB * row.J[2]);
+    assign_lane(block.MJ[3], lane_index, row.inv_IB * row.J[3]);
+
+    block.eff_mass[lane_index] = row.eff_mass;
+    block.rhs[lane_index] = row.rhs;
+    block.lower_limit[lane_index] = row.lower_limit;
+    block.upper_limit[lane_index] = row.upper_limit;
+    block.impulse[lane_index] = row.impulse;
+    block.slotA[lane_index] = slots[0];
+    block.slotB[lane_index] = slots[1];
+    block.row_index[lane_index] = row_index;
+}
+
+} // namespace
+
+void pack_row_blocks(const row_cache &cache, const row_color_batches &colors,
+                     row_block_cache &blocks) {
+    blocks.clear();
+    blocks.group_offsets.push_back(0);
+    blocks.color_offsets.push_back(0);
+
+    std::vector<unsigned> constraint_order;
+
+    for (unsigned c = 0; c < colors.num_colors; ++c) {
+        auto &batch = colors.batches[c];
+        auto num_constraints = batch.num_constraints();
+
+        auto num_rows_of = [&](unsigned con_idx) {
+            return batch.offsets[con_idx + 1].rows - batch.offsets[con_idx].rows;
+        };
+
+        // Group constraints with the most rows first, so that constraints in
+        // a group have a similar number of rows, which reduces empty lanes.
+        // Since lanes of constraints with fewer rows come last, the lanes in
+        // use are always the first ones.
+        constraint_order.resize(num_constraints);
+        std::iota(constraint_order.begin(), constraint_order.end(), 0u);
+        std::stable_sort(constraint_order.begin(), constraint_order.end(), [&](auto lhs, auto rhs) {
+            return num_rows_of(lhs) > num_rows_of(rhs);
+        });
+
+        // Constraints without rows have nothing to solve.
+        while (!constraint_order.empty() && num_rows_of(constraint_order.back()) == 0) {
+            constraint_order.pop_back();
+        }
+
+        num_constraints = constraint_order.size();
+        size_t order_idx = 0;
+
+        while (order_idx < num_constraints) {
+            // Assign the next constraints to the lanes of a group as long as
+            // they do not share a body slot with the constraints already in
+            // it. All rows of a constraint act upon the same bodies, thus it
+            // is enough to look at the first row. Constraints of the same
+            // color never share bodies, but this ensures lanes never
+            // overwrite each other's delta velocities.
+            std::array<unsigned, width> group;
+            unsigned group_size = 0;
+
+            while (order_idx < num_constraints && group_size < width) {
+                auto con_idx = constraint_order[order_idx];
+                auto &slots = colors.row_slots[batch.rows[batch.offsets[con_idx].rows]];
+                auto overlaps = false;
+
+                for (unsigned i = 0; i < group_size; ++i) {
+                    auto &other_slots = colors.row_slots[batch.rows[batch.offsets[group[i]].rows]];
+
+                    for (auto slot : slots) {
+                        if (slot == other_slots[0] || slot == other_slots[1]) {
+                            overlaps = true;
+                        }
+                    }
+                }
+
+                if (overlaps) {
+                    break;
+                }
+
+                group[group_size++] = con_idx;
+                ++order_idx;
+            }
+
+            EDYN_ASSERT(group_size > 0);
+
+            for (unsigned n = 0; n < num_rows_of(group[0]); ++n) {
+                auto &block = blocks.blocks.emplace_back();
+                block.num_rows = 0;
+
+                for (unsigned i = 0; i < group_size && n < num_rows_of(group[i]); ++i) {
+                    auto row_index = batch.rows[batch.offsets[group[i]].rows + n];
+                    assign_row(block, i, cache.rows[row_index], row_index, colors.row_slots[row_index]);
+                    ++block.num_rows;
+                }
+
+                for (auto i = block.num_rows; i < width; ++i) {
+                    clear_lane(block, i);
+                }
+            }
+
+            blocks.group_offsets.push_back(blocks.blocks.size());
+        }
+
+        blocks.color_offsets.push_back(blocks.group_offsets.size() - 1);
+    }
+}
+
+void solve(constraint_row_block &block, delta_linvel *dv, delta_angvel *dw,
+           std::vector<constraint_row> &rows) {
+    gathered_deltas dvA, dwA, dvB, dwB;
+    gather(dv, block.slotA, block.num_rows, dvA);
+    gather(dw, block.slotA, block.num_rows, dwA);
+    gather(dv, block.slotB, block.num_rows, dvB);
+    gather(dw, block.slotB, block.num_rows, dwB);
+
+    auto delta_relvel = dot(block.J[0], dvA) +
+                        dot(block.J[1], dwA) +
+                        dot(block.J[2], dvB) +
+                        dot(block.J[3], dwB);
+
+    auto rhs = lane::load(block.rhs);
+    auto eff_mass = lane::load(block.eff_mass);
+    auto lower_limit = lane::load(block.lower_limit);
+    auto upper_limit = lane::load(block.upper_limit);
+    auto prev_impulse = lane::load(block.impulse);
+
+    auto delta_impulse = (rhs - delta_relvel) * eff_mass;
+    auto impulse = prev_impulse + delta_impulse;
+
+    // Clamp impulse to limits, same as `solve(constraint_row &)`.
+    auto below = impulse < lower_limit;
+    auto above = impulse > upper_limit;
+    delta_impulse = lane::select(below, lower_limit - prev_impulse,
+                    lane::select(above, upper_limit - prev_impulse, delta_impulse));
+    impulse = lane::select(below, lower_limit, lane::select(above, upper_limit, impulse));
+    impulse.store(block.impulse);
+
+    apply_impulse(block.MJ[0], delta_impulse, dvA);
+    apply_impulse(block.MJ[1], delta_impulse, dwA);
+    apply_impulse(block.MJ[2], delta_impulse, dvB);
+    apply_impulse(block.MJ[3], delta_impulse, dwB);
+
+    scatter(dv, block.slotA, block.num_rows, dvA);
+    scatter(dw, block.slotA, block.num_rows, dwA);
+    scatter(dv, block.slotB, block.num_rows, dvB);
+    scatter(dw, block.slotB, block.num_rows, dwB);
+
+    for (unsigned i = 0; i < block.num_rows; ++i) {
+        rows[block.row_index[i]].impulse = block.impulse[i];
+    }
+}
+
+}
@@ -0,0 +1,258 @@
+#include "edyn/dynamics/row_coloring.hpp"
+#include "edyn/dynamics/row_cache.hpp"
+#include "edyn/dynamics/island_constraint_entities.hpp"
+#include "edyn/comp/graph_edge.hpp"
+#include "edyn/core/entity_graph.hpp"
+#include "edyn/config/config.h"
+#include <entt/entity/registry.hpp>
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <tuple>
+
+namespace edyn {
+
+namespace {
+    struct colored_constraint {
+        entt::entity entity;
+        unsigned type_index;
+        std::array<entity_graph::index_type, 2> node_index;
+        unsigned row_start;
+        unsigned num_rows;
+        unsigned friction_start;
+        unsigned rolling_start;
+        unsigned spinning_start;
+    };
+}
+
+void color_rows(entt::registry &registry, row_cache &cache,
+                const island_constraint_entities &constraint_entities,
+                row_color_batches &colors, bool deterministic) {
+    colors.clear();
+
+    auto &graph = registry.ctx().at<entity_graph>();
+    auto edge_view = registry.view<graph_edge>();
+
+    // Recover the range of rows of each constraint from the packing order.
+    // Rows are packed per constraint type in the order they appear in
+    // `constraints_tuple` and the number of rows of each constraint is
+    // recorded in `row_cache::con_num_rows`.
+    std::vector<colored_constraint> constraints;
+    constraints.reserve(cache.con_num_rows.size());
+    unsigned con_idx = 0;
+    unsigned row_idx = 0;
+    unsigned friction_idx = 0;
+    unsigned rolling_idx = 0;
+    unsigned spinning_idx = 0;
+
+    for (unsigned type_index = 0; type_index < constraint_entities.entities.size(); ++type_index) {
+        for (auto entity : constraint_entities.entities[type_index]) {
+            auto [edge] = edge_view.get(entity);
+            auto &con = constraints.emplace_back();
+            con.entity = entity;
+            con.type_index = type_index;
+            con.node_index = graph.edge_node_indices(edge.edge_index);
+            con.row_start = row_idx;
+            con.num_rows = cache.con_num_rows[con_idx++];
+            con.friction_start = friction_idx;
+            con.rolling_start = rolling_idx;
+            con.spinning_start = spinning_idx;
+
+            for (unsigned i = 0; i < con.num_rows; ++i) {
+                auto flags = cache.flags[row_idx++];
+
+                if (flags & constraint_row_flag_friction) {
+                    ++friction_idx;
+                }
+
+                if (flags & constraint_row_flag_rolling_friction) {
+                    ++rolling_idx;
+                }
+
+                if (flags & constraint_row_flag_spinning_friction) {
+                    ++spinning_idx;
+                }
+            }
+        }
+    }
+
+    EDYN_ASSERT(row_idx == cache.rows.size());
+
+    if (deterministic) {
+        // Greedy coloring depends on the order in which constraints are
+        // visited. Visit them in order of the bodies they connect instead of
+        // pool order. Identifiers of contact manifolds depend on the history
+        // of the registry, thus they're only used to break ties.
+        auto key = [&](const colored_constraint &con) {
+            return std::make_tuple(entt::to_integral(graph.node_entity(con.node_index[0])),
+                                   entt::to_integral(graph.node_entity(con.node_index[1])),
+                                   con.type_index,
+                                   entt::to_integral(con.entity));
+        };
+
+        std::sort(constraints.begin(), constraints.end(), [&](auto &lhs, auto &rhs) {
+            return key(lhs) < key(rhs);
+        });
+    }
+
+    // Assign body slots. Procedural bodies come first, followed by one slot
+    // for each side of each row that acts upon a non-procedural body.
+    static constexpr auto null_slot = std::numeric_limits<unsigned>::max();
+    unsigned num_non_procedural_sides = 0;
+
+    for (auto &con : constraints) {
+        for (auto node_index : con.node_index) {
+            if (!graph.is_connecting_node(node_index)) {
+                num_non_procedural_sides += con.num_rows;
+                continue;
+            }
+
+            if (node_index >= colors.node_slots.size()) {
+                colors.node_slots.resize(node_index + 1, null_slot);
+                colors.node_colors.resize(node_index + 1, 0);
+            }
+
+            if (colors.node_slots[node_index] == null_slot) {
+                colors.node_slots[node_index] = colors.procedural_bodies.size();
+                colors.procedural_bodies.push_back(graph.node_entity(node_index));
+            }
+        }
+    }
+
+    colors.num_procedural_slots = colors.procedural_bodies.size();
+    auto num_slots = colors.num_procedural_slots + num_non_procedural_sides;
+    colors.dv.resize(num_slots);
+    colors.dw.resize(num_slots);
+    colors.row_slots.resize(cache.rows.size());
+
+    auto delta_view = registry.view<delta_linvel, delta_angvel>();
+
+    for (unsigned i = 0; i < colors.num_procedural_slots; ++i) {
+        auto [dv, dw] = delta_view.get(colors.procedural_bodies[i]);
+        colors.dv[i] = dv;
+        colors.dw[i] = dw;
+    }
+
+    for (auto i = colors.num_procedural_slots; i < num_slots; ++i) {
+        colors.dv[i] = vector3_zero;
+        colors.dw[i] = vector3_zero;
+    }
+
+    auto next_non_procedural_slot = colors.num_procedural_slots;
+
+    // Greedily assign the lowest color not yet used by either body. All rows
+    // of a constraint share the same color since they act upon the same pair
+    // of bodies. Non-connecting nodes, i.e. non-procedural bodies, are not
+    // affected by impulses thus they do not restrict coloring.
+    for (auto &con : constraints) {
+        uint64_t used_colors = 0;
+
+        for (auto node_index : con.node_index) {
+            if (graph.is_connecting_node(node_index)) {
+                used_colors |= colors.node_colors[node_index];
+            }
+        }
+
+        row_color_batches::batch *batch;
+
+        if (used_colors == ~uint64_t{0}) {
+            batch = &colors.overflow;
+        } else {
+            unsigned color = 0;
+
+            while (used_colors & (uint64_t{1} << color)) {
+                ++color;
+            }
+
+            EDYN_ASSERT(color < row_color_batches::max_colors);
+
+            for (auto node_index : con.node_index) {
+                if (graph.is_connecting_node(node_index)) {
+                    colors.node_colors[node_index] |= uint64_t{1} << color;
+                }
+            }
+
+            if (color >= colors.batches.size()) {
+                colors.batches.resize(color + 1);
+            }
+
+            colors.num_colors = std::max(colors.num_colors, color + 1);
+            batch = &colors.batches[color];
+        }
+
+        if (batch->offsets.empty()) {
+            batch->offsets.push_back({0, 0, 0, 0});
+        }
+
+        auto friction_idx = con.friction_start;
+        auto rolling_idx = con.rolling_start;
+        auto spinning_idx = con.spinning_start;
+
+        for (auto i = con.row_start; i < con.row_start + con.num_rows; ++i) {
+            batch->rows.push_back(i);
+            auto flags = cache.flags[i];
+
+            if (flags & constraint_row_flag_friction) {
+                batch->friction.push_back(friction_idx++);
+            }
+
+            if (flags & constraint_row_flag_rolling_friction) {
+                batch->rolling.push_back(rolling_idx++);
+            }
+
+            if (flags & constraint_row_flag_spinning_friction) {
+                batch->spinning.push_back(spinning_idx++);
+            }
+
+            // Redirect deltas into body slots. The first node of the graph
+            // edge corresponds to the first body of the constraint.
+            auto &slots = colors.row_slots[i];
+
+            for (unsigned j = 0; j < 2; ++j) {
+                auto node_index = con.node_index[j];
+
+                if (graph.is_connecting_node(node_index)) {
+                    slots[j] = colors.node_slots[node_index];
+                } else {
+                    slots[j] = next_non_procedural_slot++;
+                }
+            }
+
+            auto &row = cache.rows[i];
+            row.dvA = &colors.dv[slots[0]];
+            row.dwA = &colors.dw[slots[0]];
+            row.dvB = &colors.dv[slots[1]];
+            row.dwB = &colors.dw[slots[1]];
+        }
+
+        auto &offset = batch->offsets.emplace_back();
+        offset.rows = static_cast<unsigned>(batch->rows.size());
+        offset.friction = static_cast<unsigned>(batch->friction.size());
+        offset.rolling = static_cast<unsigned>(batch->rolling.size());
+        offset.spinning = static_cast<unsigned>(batch->spinning.size());
+    }
+
+    EDYN_ASSERT(next_non_procedural_slot == num_slots);
+
+    // Reset node colors and slots for the next step.
+    for (auto &con : constraints) {
+        for (auto node_index : con.node_index) {
+            if (node_index < colors.node_colors.size()) {
+                colors.node_colors[node_index] = 0;
+                colors.node_slots[node_index] = null_slot;
+            }
+        }
+    }
+}
+
+void write_back_body_slots(entt::registry &registry, const row_color_batches &colors) {
+    auto delta_view = registry.view<delta_linvel, delta_angvel>();
+
+    for (unsigned i = 0; i < colors.num_procedural_slots; ++i) {
+        auto [dv, dw] = delta_view.get(colors.procedural_bodies[i]);
+        dv = colors.dv[i];
+        dw = colors.dw[i];
+    }
+}
+
+}
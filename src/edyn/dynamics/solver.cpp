@@ -12,15 +12,15 @@
 #include "edyn/constraints/constraint_body.hpp"
 #include "edyn/dynamics/island_constraint_entities.hpp"
 #include "edyn/dynamics/row_cache.hpp"
+#include "edyn/dynamics/row_block.hpp"
+#include "edyn/dynamics/row_coloring.hpp"
 #include "edyn/parallel/atomic_counter_sync.hpp"
 #include "edyn/parallel/job_dispatcher.hpp"
 #include "edyn/parallel/parallel_for.hpp"
+#include "edyn/parallel/worker.hpp"
 #include "edyn/serialization/s11n_util.hpp"
 #include "edyn/sys/apply_gravity.hpp"
-#include "edyn/sys/update_aabbs.hpp"
-#include "edyn/sys/update_rotated_meshes.hpp"
-#include "edyn/sys/update_inertias.hpp"
-#include "edyn/sys/update_origins.hpp"
+#include "edyn/sys/update_derived_state.hpp"
 #include "edyn/constraints/constraint_row.hpp"
 #include "edyn/comp/linvel.hpp"
 #include "edyn/comp/angvel.hpp"
@@ -31,9 +31,13 @@
 #include "edyn/dynamics/restitution_solver.hpp"
 #include "edyn/dynamics/island_solver.hpp"
 #include "edyn/context/settings.hpp"
+#include "edyn/context/profile.hpp"
 #include "edyn/util/entt_util.hpp"
+#include "edyn/core/entity_graph.hpp"
 #include <entt/entity/registry.hpp>
+#include <algorithm>
 #include <optional>
+#include <tuple>
 #include <type_traits>
 
 namespace edyn {
@@ -44,6 +48,8 @@ solver::solver(entt::registry &registry)
     m_connections.emplace_back(registry.on_construct<linvel>().connect<&entt::registry::emplace<delta_linvel>>());
     m_connections.emplace_back(registry.on_construct<angvel>().connect<&entt::registry::emplace<delta_angvel>>());
     m_connections.emplace_back(registry.on_construct<island_tag>().connect<&entt::registry::emplace<row_cache>>());
+    m_connections.emplace_back(registry.on_construct<island_tag>().connect<&entt::registry::emplace<row_color_batches>>());
+    m_connections.emplace_back(registry.on_construct<island_tag>().connect<&entt::registry::emplace<row_block_cache>>());
     m_connections.emplace_back(registry.on_construct<island_tag>().connect<&entt::registry::emplace<island_constraint_entities>>());
     m_connections.emplace_back(registry.on_construct<constraint_tag>().connect<&entt::registry::emplace<constraint_row_prep_cache>>());
 }
@@ -92,7 +98,16 @@ void invoke_prepare_constraint(entt::registry &registry, entt::entity entity, C
     }
 }
 
-static void prepare_constraints(entt::registry &registry, scalar dt, bool mt) {
+// Index of the slot in the row arena where the current thread allocates rows.
+// Workers of the dispatcher have their own slot and any other thread uses the
+// first, since only the thread running the solver is not a worker.
+static size_t current_prep_arena_slot(job_dispatcher &dispatcher) {
+    auto *w = worker::current();
+    return w && &w->get_dispatcher() == &dispatcher ? w->index() + 1 : 0;
+}
+
+static void prepare_constraints(entt::registry &registry, constraint_row_prep_arena &arena,
+                                scalar dt, bool mt) {
     auto body_view = registry.view<position, orientation,
                                    linvel, angvel,
                                    mass_inv, inertia_world_inv,
@@ -101,24 +116,31 @@ static void prepare_constraints(entt::registry &registry, scalar dt, bool mt) {
     auto cache_view = registry.view<constraint_row_prep_cache>(exclude_sleeping_disabled);
     auto manifold_view = registry.view<contact_manifold>();
     auto con_view_tuple = get_tuple_of_views(registry, constraints_tuple);
+    auto &dispatcher = job_dispatcher::global();
+
+    // Rows of the previous step were already packed, thus their storage
+    // can be reused.
+    arena.reset(dispatcher.num_workers() + 1);
 
-    auto for_loop_body = [&registry, body_view, cache_view, origin_view,
+    auto for_loop_body = [&registry, &arena, &dispatcher, body_view, cache_view, origin_view,
                           manifold_view, con_view_tuple, dt](entt::entity entity) {
+        auto slot = current_prep_arena_slot(dispatcher);
         auto &prep_cache = cache_view.get<constraint_row_prep_cache>(entity);
-        prep_cache.clear();
+        prep_cache.clear(arena.reserve(slot));
 
         std::apply([&](auto &&... con_view) {
             ((con_view.contains(entity) ?
                 invoke_prepare_constraint(registry, entity, std::get<0>(con_view.get(entity)), prep_cache,
                                           dt, body_view, origin_view, manifold_view) : void(0)), ...);
         }, con_view_tuple);
+
+        arena.commit(slot, prep_cache.num_rows);
     };
 
     const size_t max_sequential_size = 4;
     auto num_constraints = calculate_view_size(cache_view);
 
     if (mt && num_constraints > max_sequential_size) {
-        auto &dispatcher = job_dispatcher::global();
         parallel_for_each(dispatcher, cache_view.begin(), cache_view.end(), for_loop_body);
     } else {
         for (auto entity : cache_view) {
@@ -127,51 +149,156 @@ static void prepare_constraints(entt::registry &registry, scalar dt, bool mt) {
     }
 }
 
+// Sorts the nodes and edges of all awake islands, which determines the order
+// in which constraints are solved. Nodes are sorted by entity identifier and
+// edges by the identifiers of the nodes they connect, since the identifiers of
+// edges created by the simulation, such as contact manifolds, depend on the
+// order in which entities were destroyed before. Membership rarely changes
+// between steps, thus islands which are still sorted are only checked.
+static void canonicalize_islands(entt::registry &registry, bool mt) {
+    auto island_view = registry.view<island>(exclude_sleeping_disabled);
+    auto edge_view = registry.view<graph_edge>();
+    auto &graph = registry.ctx().at<entity_graph>();
+
+    auto for_loop_body = [island_view, edge_view, &graph](entt::entity island_entity) {
+        auto [island] = island_view.get(island_entity);
+
+        auto compare_nodes = [](entt::entity lhs, entt::entity rhs) {
+            return entt::to_integral(lhs) < entt::to_integral(rhs);
+        };
+
+        if (!std::is_sorted(island.nodes.begin(), island.nodes.end(), compare_nodes)) {
+            island.nodes.sort(compare_nodes);
+        }
+
+        auto edge_key = [&](entt::entity entity) {
+            auto [edge] = edge_view.get(entity);
+            auto nodes = graph.edge_node_entities(edge.edge_index);
+            return std::make_tuple(entt::to_integral(nodes.first),
+                                   entt::to_integral(nodes.second),
+                                   entt::to_integral(entity));
+        };
+
+        auto compare_edges = [&](entt::entity lhs, entt::entity rhs) {
+            return edge_key(lhs) < edge_key(rhs);
+        };
+
+        if (!std::is_sorted(island.edges.begin(), island.edges.end(), compare_edges)) {
+            island.edges.sort(compare_edges);
+        }
+    };
+
+    const size_t max_sequential_size = 4;
+
+    if (mt && calculate_view_size(island_view) > max_sequential_size) {
+        auto &dispatcher = job_dispatcher::global();
+        parallel_for_each(dispatcher, island_view.begin(), island_view.end(), for_loop_body);
+    } else {
+        for (auto island_entity : island_view) {
+            for_loop_body(island_entity);
+        }
+    }
+}
+
 void solver::update(bool mt) {
     auto &registry = *m_registry;
     auto &settings = registry.ctx().at<edyn::settings>();
     auto dt = settings.fixed_dt;
 
-    solve_restitution(registry, dt);
+    if (settings.deterministic) {
+        canonicalize_islands(registry, mt);
+    }
+
+    {
+        EDYN_PROFILE_SCOPE(registry, profile_stage::restitution);
+        solve_restitution(registry, m_restitution_buffers, dt, mt);
+    }
+
     apply_gravity(registry, dt);
 
-    prepare_constraints(registry, dt, mt);
+    {
+        EDYN_PROFILE_SCOPE(registry, profile_stage::constraint_preparation);
+        prepare_constraints(registry, m_prep_arena, dt, mt);
+    }
 
     auto island_view = registry.view<island>(exclude_sleeping_disabled);
     auto num_islands = calculate_view_size(island_view);
 
-    if (mt && num_islands > 1) {
-        auto counter = atomic_counter_sync(num_islands);
-
-        for (auto island_entity : island_view) {
-            run_island_solver_seq_mt(registry, island_entity,
-                                     settings.num_solver_velocity_iterations,
-                                     settings.num_solver_position_iterations,
-                                     dt, &counter);
-        }
+    // Large islands are solved with colored Gauss-Seidel in this thread,
+    // which solves multiple rows at once using SIMD and, if multi-threaded,
+    // uses all workers to solve a single island.
+    auto is_colored = [&](entt::entity island_entity) {
+        return settings.island_coloring_threshold > 0 &&
+            island_view.get<island>(island_entity).edges.size() >= settings.island_coloring_threshold;
+    };
 
-        counter.wait();
-    } else {
-        for (auto island_entity : island_view) {
-            run_island_solver_seq(registry, island_entity,
+    auto run_colored = [&](entt::entity island_entity) {
+        run_island_solver_colored(registry, island_entity,
                                   settings.num_solver_velocity_iterations,
-                                  settings.num_solver_position_iterations, dt);
-        }
-    }
+                                  settings.num_solver_position_iterations,
+                                  dt, settings.deterministic_island_coloring || settings.deterministic, mt);
+    };
+
+    {
+        EDYN_PROFILE_SCOPE(registry, profile_stage::island_solver);
+
+        if (mt && num_islands > 1) {
+            size_t num_colored_islands = 0;
+
+            for (auto island_entity : island_view) {
+                if (is_colored(island_entity)) {
+                    ++num_colored_islands;
+                }
+            }
 
-    update_origins(registry);
+            // Dispatch small islands to be solved in workers first, then solve
+            // large islands in this thread while they run.
+            auto num_job_islands = num_islands - num_colored_islands;
+            std::optional<atomic_counter_sync> counter;
 
-    // Update rotated vertices of convex meshes after rotations change. It is
-    // important to do this before `update_aabbs` because the rotated meshes
-    // will be used to calculate AABBs of polyhedrons.
-    update_rotated_meshes(registry);
+            if (num_job_islands > 0) {
+                counter.emplace(num_job_islands);
 
-    // Update AABBs after transforms change.
-    update_aabbs(registry);
-    update_island_aabbs(registry);
+                for (auto island_entity : island_view) {
+                    if (!is_colored(island_entity)) {
+                        run_island_solver_seq_mt(registry, island_entity,
+                                                 settings.num_solver_velocity_iterations,
+                                                 settings.num_solver_position_iterations,
+                                                 dt, &*counter);
+                    }
+                }
+            }
 
-    // Update world-space moment of inertia.
-    update_inertias(registry);
+            if (num_colored_islands > 0) {
+                for (auto island_entity : island_view) {
+                    if (is_colored(island_entity)) {
+                        run_colored(island_entity);
+                    }
+                }
+            }
+
+            if (counter) {
+                counter->wait();
+            }
+        } else {
+            for (auto island_entity : island_view) {
+                if (is_colored(island_entity)) {
+                    run_colored(island_entity);
+                } else {
+                    run_island_solver_seq(registry, island_entity,
+                                          settings.num_solver_velocity_iterations,
+                                          settings.num_solver_position_iterations, dt);
+                }
+            }
+        }
+    }
+
+    // Update origins, rotated meshes, AABBs and inertias after transforms
+    // change.
+    {
+        EDYN_PROFILE_SCOPE(registry, profile_stage::update_aabbs);
+        update_derived_state(registry, mt);
+    }
 }
 
 }
@@ -30,6 +30,7 @@
 #include "edyn/networking/extrapolation/extrapolation_worker.hpp"
 #include "edyn/comp/tag.hpp"
 #include "edyn/networking/util/snap_to_pool_snapshot.hpp"
+#include "edyn/networking/util/snapshot_compression.hpp"
 #include "edyn/parallel/message_dispatcher.hpp"
 #include "edyn/simulation/stepper_async.hpp"
 #include "edyn/parallel/job_dispatcher.hpp"
@@ -688,6 +689,21 @@ static void snap_to_registry_snapshot(entt::registry &registry, packet::registry
 }
 
 static void process_packet(entt::registry &registry, packet::registry_snapshot &snapshot) {
+    auto &ctx = registry.ctx().at<client_network_context>();
+
+    if (!snapshot.motion.empty()) {
+        uint32_t sequence;
+
+        // Drop snapshot if its baseline is not available anymore. It will not
+        // be acknowledged, thus the server will eventually send a snapshot
+        // with a baseline that is still available or with absolute values.
+        if (!decompress_registry_snapshot(snapshot, ctx.snapshot_history, sequence)) {
+            return;
+        }
+
+        ctx.packet_signal.publish(packet::edyn_packet{packet::snapshot_ack{sequence}});
+    }
+
     if (contains_unknown_entities(registry, snapshot.entities)) {
         // Do not perform extrapolation if it contains unknown entities as the
         // result would not make much sense if all parts are not involved.
@@ -695,7 +711,6 @@ static void process_packet(entt::registry &registry, packet::registry_snapshot &
         return;
     }
 
-    auto &ctx = registry.ctx().at<client_network_context>();
     auto &settings = registry.ctx().at<edyn::settings>();
     auto &client_settings = std::get<client_network_settings>(settings.network_settings);
 
@@ -815,6 +830,7 @@ static void process_packet(entt::registry &registry, packet::asset_sync_response
 static void process_packet(entt::registry &, const packet::set_aabb_of_interest &) {}
 static void process_packet(entt::registry &, const packet::query_entity &) {}
 static void process_packet(entt::registry &, const packet::asset_sync &) {}
+static void process_packet(entt::registry &, const packet::snapshot_ack &) {}
 
 void client_receive_packet(entt::registry &registry, packet::edyn_packet &packet) {
     std::visit([&](auto &&inner_packet) {
@@ -28,8 +28,11 @@
 #include "edyn/networking/context/server_network_context.hpp"
 #include "edyn/networking/util/process_update_entity_map_packet.hpp"
 #include "edyn/networking/util/snap_to_pool_snapshot.hpp"
+#include "edyn/networking/util/snapshot_compression.hpp"
+#include "edyn/networking/util/split_registry_snapshot.hpp"
 #include "edyn/simulation/stepper_async.hpp"
 #include "edyn/parallel/message.hpp"
+#include "edyn/parallel/parallel_for.hpp"
 #include "edyn/time/time.hpp"
 #include "edyn/replication/entity_map.hpp"
 #include "edyn/util/island_util.hpp"
@@ -213,6 +216,11 @@ static void process_packet(entt::registry &registry, entt::entity client_entity,
     clock_sync_process_time_response(client.clock_sync, res);
 }
 
+static void process_packet(entt::registry &registry, entt::entity client_entity, const packet::snapshot_ack &ack) {
+    auto &client = registry.get<remote_client>(client_entity);
+    client.snapshot_history.acknowledge(ack.sequence);
+}
+
 static void process_packet(entt::registry &registry, entt::entity client_entity, const packet::set_aabb_of_interest &aabb) {
     if (!(aabb.max > aabb.min)) {
         return;
@@ -449,25 +457,125 @@ static void process_aabb_of_interest_entities_entered(entt::registry &registry,
     aabboi.entities_entered.clear();
 }
 
-static void maybe_publish_client_registry_snapshot(entt::registry &registry,
-                                                   entt::entity client_entity,
-                                                   remote_client &client,
-                                                   aabb_of_interest &aabboi,
-                                                   double time) {
-    if (time - client.last_snapshot_time < 1 / client.snapshot_rate) {
+// Order of entities in a snapshot from nearest to farthest from the center of
+// the AABB of interest. Entities without a position go first since they're
+// usually constraints which connect the nearby bodies.
+static std::vector<size_t> get_snapshot_priority_order(const entt::registry &registry,
+                                                       const packet::registry_snapshot &snapshot,
+                                                       const aabb_of_interest &aabboi) {
+    auto pos_view = registry.view<const position>();
+    auto center = aabboi.aabb.center();
+    auto distances = std::vector<scalar>(snapshot.entities.size(), scalar(0));
+    auto order = std::vector<size_t>(snapshot.entities.size());
+
+    for (size_t i = 0; i < snapshot.entities.size(); ++i) {
+        auto entity = snapshot.entities[i];
+        order[i] = i;
+
+        if (pos_view.contains(entity)) {
+            auto [pos] = pos_view.get(entity);
+            distances[i] = distance_sqr(pos, center);
+        }
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+        return distances[lhs] < distances[rhs];
+    });
+
+    return order;
+}
+
+// Exports the registry snapshot of a client into its snapshot packets, which
+// are published later. Does not modify the registry, thus it can run for many
+// clients in parallel.
+static void export_client_registry_snapshot(const entt::registry &registry,
+                                            entt::entity client_entity,
+                                            remote_client &client,
+                                            const aabb_of_interest &aabboi,
+                                            double timestamp) {
+    auto &ctx = registry.ctx().at<server_network_context>();
+    auto &settings = registry.ctx().at<edyn::settings>();
+    auto &server_settings = std::get<server_network_settings>(settings.network_settings);
+    auto &packets = client.snapshot_packets;
+    client.num_snapshot_packets = 0;
+
+    if (packets.empty()) {
+        packets.emplace_back(packet::edyn_packet{packet::registry_snapshot{}});
+    }
+
+    // Clear the first snapshot instead of replacing it to keep its buffers.
+    auto &snapshot = std::get<packet::registry_snapshot>(packets.front().var);
+    snapshot.entities.clear();
+    snapshot.pools.clear();
+    snapshot.motion.clear();
+    ctx.snapshot_exporter->export_modified(snapshot, aabboi.entities, client_entity);
+
+    if (snapshot.entities.empty() || snapshot.pools.empty()) {
         return;
     }
 
-    client.last_snapshot_time = time;
+    snapshot.timestamp = timestamp;
+    size_t num_packets = 1;
+
+    if (snapshot.entities.size() > server_settings.max_snapshot_entities) {
+        auto fragments = split_registry_snapshot(snapshot, get_snapshot_priority_order(registry, snapshot, aabboi),
+                                                 server_settings.max_snapshot_entities);
+        num_packets = fragments.size();
+
+        if (packets.size() < num_packets) {
+            packets.resize(num_packets);
+        }
+
+        for (size_t i = 0; i < num_packets; ++i) {
+            packets[i].var = std::move(fragments[i]);
+        }
+    }
+
+    if (server_settings.compress_snapshots) {
+        for (size_t i = 0; i < num_packets; ++i) {
+            auto &fragment = std::get<packet::registry_snapshot>(packets[i].var);
+            compress_registry_snapshot(fragment, server_settings.quantization,
+                                       client.snapshot_history, static_cast<uint32_t>(i));
+        }
+    }
+
+    client.num_snapshot_packets = num_packets;
+}
+
+static void export_client_registry_snapshots(entt::registry &registry,
+                                             const std::vector<entt::entity> &client_entities) {
+    auto timestamp = get_simulation_timestamp(registry);
+    auto view = registry.view<remote_client, aabb_of_interest>();
+    const auto &const_registry = registry;
 
+    auto export_snapshot = [&](size_t index) {
+        auto client_entity = client_entities[index];
+        auto [client, aabboi] = view.get(client_entity);
+        export_client_registry_snapshot(const_registry, client_entity, client, aabboi, timestamp);
+    };
+
+    auto &dispatcher = job_dispatcher::global();
+
+    if (client_entities.size() > 1 && dispatcher.running()) {
+        parallel_for(dispatcher, size_t{}, client_entities.size(), size_t{1}, export_snapshot);
+    } else {
+        for (size_t i = 0; i < client_entities.size(); ++i) {
+            export_snapshot(i);
+        }
+    }
+}
+
+static void publish_client_registry_snapshot(entt::registry &registry,
+                                             entt::entity client_entity,
+                                             remote_client &client) {
     auto &ctx = registry.ctx().at<server_network_context>();
-    auto packet = packet::registry_snapshot{};
-    ctx.snapshot_exporter->export_modified(packet, aabboi.entities, client_entity);
 
-    if (!packet.entities.empty() && !packet.pools.empty()) {
-        packet.timestamp = get_simulation_timestamp(registry);
-        ctx.packet_signal.publish(client_entity, packet::edyn_packet{packet});
+    // Packets are not moved into the signal so their buffers can be reused.
+    for (size_t i = 0; i < client.num_snapshot_packets; ++i) {
+        ctx.packet_signal.publish(client_entity, client.snapshot_packets[i]);
     }
+
+    client.num_snapshot_packets = 0;
 }
 
 static void calculate_client_playout_delay(entt::registry &registry,
@@ -505,10 +613,28 @@ static void calculate_client_playout_delay(entt::registry &registry,
 }
 
 static void process_aabbs_of_interest(entt::registry &registry, double time) {
-    for (auto [client_entity, client, aabboi] : registry.view<remote_client, aabb_of_interest>().each()) {
+    auto &ctx = registry.ctx().at<server_network_context>();
+    auto view = registry.view<remote_client, aabb_of_interest>();
+    auto &snapshot_clients = ctx.snapshot_client_entities;
+    snapshot_clients.clear();
+
+    for (auto [client_entity, client, aabboi] : view.each()) {
         process_aabb_of_interest_entities_exited(registry, client_entity, aabboi);
         process_aabb_of_interest_entities_entered(registry, client_entity, aabboi);
-        maybe_publish_client_registry_snapshot(registry, client_entity, client, aabboi, time);
+
+        if (time - client.last_snapshot_time >= 1 / client.snapshot_rate) {
+            client.last_snapshot_time = time;
+            snapshot_clients.push_back(client_entity);
+        }
+    }
+
+    // Exporting snapshots is the most expensive part and can be done for all
+    // clients in parallel. Packets are published afterwards in the order of
+    // the view to keep the order deterministic.
+    export_client_registry_snapshots(registry, snapshot_clients);
+
+    for (auto [client_entity, client, aabboi] : view.each()) {
+        publish_client_registry_snapshot(registry, client_entity, client);
         calculate_client_playout_delay(registry, client_entity, client, aabboi);
     }
 }
@@ -0,0 +1,437 @@
+#include "edyn/networking/util/snapshot_compression.hpp"
+#include "edyn/networking/packet/registry_snapshot.hpp"
+#include "edyn/networking/comp/networked_comp.hpp"
+#include "edyn/serialization/varint.hpp"
+#include "edyn/util/tuple_util.hpp"
+#include "edyn/config/config.h"
+#include <entt/entity/entity.hpp>
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+
+namespace edyn {
+
+// Components stored in the motion data, in this order. The position of a
+// component in this tuple is the type of its baseline entries.
+using motion_components_t = std::tuple<position, orientation, linvel, angvel>;
+
+// Largest magnitude of quantized values. Leaves room for deltas to fit
+// in 32 bits.
+static constexpr scalar max_fixed_magnitude = scalar(1 << 30);
+
+// Fixed-point scales and bounds of each value.
+struct motion_quantizer {
+    scalar position_scale;
+    scalar position_limit;
+    scalar velocity_scale;
+    scalar velocity_limit;
+    scalar orientation_scale;
+
+    motion_quantizer(uint8_t position_fraction_bits, scalar position_bound,
+                     uint8_t velocity_fraction_bits, scalar velocity_bound,
+                     uint8_t orientation_bits)
+        : position_scale(std::ldexp(scalar(1), position_fraction_bits))
+        , position_limit(std::min(position_bound, max_fixed_magnitude / position_scale))
+        , velocity_scale(std::ldexp(scalar(1), velocity_fraction_bits))
+        , velocity_limit(std::min(velocity_bound, max_fixed_magnitude / velocity_scale))
+        // Each of the three smallest components of a unit quaternion lies
+        // within [-1/sqrt(2), 1/sqrt(2)].
+        , orientation_scale(scalar((1 << (orientation_bits - 1)) - 1) * std::sqrt(scalar(2)))
+    {}
+};
+
+static bool valid_quantization_bits(uint8_t position_fraction_bits,
+                                    uint8_t velocity_fraction_bits,
+                                    uint8_t orientation_bits) {
+    return position_fraction_bits <= 24 && velocity_fraction_bits <= 24 &&
+           orientation_bits >= 2 && orientation_bits <= 24;
+}
+
+template<typename Component>
+static constexpr size_t num_motion_values = std::is_base_of_v<quaternion, Component> ? 4 : 3;
+
+static int32_t to_fixed(scalar value, scalar scale, scalar limit) {
+    return static_cast<int32_t>(std::round(std::clamp(value, -limit, limit) * scale));
+}
+
+static void quantize_vector(const vector3 &v, scalar scale, scalar limit,
+                            std::array<int32_t, 4> &values) {
+    for (size_t i = 0; i < 3; ++i) {
+        values[i] = to_fixed(v[i], scale, limit);
+    }
+}
+
+static vector3 dequantize_vector(const std::array<int32_t, 4> &values, scalar scale) {
+    return vector3{scalar(values[0]), scalar(values[1]), scalar(values[2])} / scale;
+}
+
+// Smallest-three encoding. The first value is the index of the component
+// with greatest magnitude, which is omitted and made positive by negating
+// the quaternion if necessary, since both represent the same rotation.
+static void quantize_orientation(const quaternion &q, scalar scale,
+                                 std::array<int32_t, 4> &values) {
+    auto largest = size_t{0};
+
+    for (size_t i = 1; i < 4; ++i) {
+        if (std::abs(q[i]) > std::abs(q[largest])) {
+            largest = i;
+        }
+    }
+
+    auto sign = q[largest] < 0 ? scalar(-1) : scalar(1);
+    values[0] = static_cast<int32_t>(largest);
+
+    for (size_t i = 0, j = 1; i < 4; ++i) {
+        if (i != largest) {
+            values[j++] = to_fixed(q[i] * sign, scale, scalar(1));
+        }
+    }
+}
+
+static quaternion dequantize_orientation(const std::array<int32_t, 4> &values, scalar scale) {
+    auto q = quaternion{};
+    auto largest = static_cast<size_t>(values[0]);
+    auto sum_sqr = scalar(0);
+
+    for (size_t i = 0, j = 1; i < 4; ++i) {
+        if (i != largest) {
+            q[i] = scalar(values[j++]) / scale;
+            sum_sqr += q[i] * q[i];
+        }
+    }
+
+    q[largest] = std::sqrt(std::max(scalar(1) - sum_sqr, scalar(0)));
+    return normalize(q);
+}
+
+static void quantize(const position &pos, const motion_quantizer &quantizer,
+                     std::array<int32_t, 4> &values) {
+    quantize_vector(pos, quantizer.position_scale, quantizer.position_limit, values);
+}
+
+static void quantize(const orientation &orn, const motion_quantizer &quantizer,
+                     std::array<int32_t, 4> &values) {
+    quantize_orientation(orn, quantizer.orientation_scale, values);
+}
+
+static void quantize(const linvel &v, const motion_quantizer &quantizer,
+                     std::array<int32_t, 4> &values) {
+    quantize_vector(v, quantizer.velocity_scale, quantizer.velocity_limit, values);
+}
+
+static void quantize(const angvel &w, const motion_quantizer &quantizer,
+                     std::array<int32_t, 4> &values) {
+    quantize_vector(w, quantizer.velocity_scale, quantizer.velocity_limit, values);
+}
+
+static void dequantize(const std::array<int32_t, 4> &values,
+                       const motion_quantizer &quantizer, position &pos) {
+    pos = dequantize_vector(values, quantizer.position_scale);
+}
+
+static void dequantize(const std::array<int32_t, 4> &values,
+                       const motion_quantizer &quantizer, orientation &orn) {
+    orn = dequantize_orientation(values, quantizer.orientation_scale);
+}
+
+static void dequantize(const std::array<int32_t, 4> &values,
+                       const motion_quantizer &quantizer, linvel &v) {
+    v = dequantize_vector(values, quantizer.velocity_scale);
+}
+
+static void dequantize(const std::array<int32_t, 4> &values,
+                       const motion_quantizer &quantizer, angvel &w) {
+    w = dequantize_vector(values, quantizer.velocity_scale);
+}
+
+static bool entry_less(const snapshot_baseline_history::entry &lhs,
+                       const snapshot_baseline_history::entry &rhs) {
+    return entt::to_integral(lhs.entity) < entt::to_integral(rhs.entity) ||
+        (lhs.entity == rhs.entity && lhs.type < rhs.type);
+}
+
+// Values of a component in the baseline, or zero if not present.
+static std::array<int32_t, 4> find_baseline_values(const std::vector<snapshot_baseline_history::entry> *baseline,
+                                                   entt::entity entity, uint8_t type) {
+    if (baseline != nullptr) {
+        auto key = snapshot_baseline_history::entry{entity, type, {}};
+        auto it = std::lower_bound(baseline->begin(), baseline->end(), key, &entry_less);
+
+        if (it != baseline->end() && it->entity == entity && it->type == type) {
+            return it->values;
+        }
+    }
+
+    return {};
+}
+
+template<typename Component>
+static pool_snapshot_data_impl<Component> * find_motion_pool(std::vector<pool_snapshot> &pools) {
+    auto component_index = tuple_index_of<component_index_type, Component>(networked_components);
+    auto it = std::find_if(pools.begin(), pools.end(), [component_index](auto &&pool) {
+        return pool.component_index == component_index;
+    });
+
+    if (it == pools.end()) {
+        return nullptr;
+    }
+
+    return static_cast<pool_snapshot_data_impl<Component> *>(it->ptr.get());
+}
+
+template<typename Component>
+static void erase_motion_pool(std::vector<pool_snapshot> &pools) {
+    auto component_index = tuple_index_of<component_index_type, Component>(networked_components);
+    pools.erase(std::remove_if(pools.begin(), pools.end(), [component_index](auto &&pool) {
+        return pool.component_index == component_index;
+    }), pools.end());
+}
+
+void snapshot_baseline_history::insert(uint32_t sequence, std::vector<entry> entries, uint32_t fragment) {
+    EDYN_ASSERT(sequence != 0);
+    EDYN_ASSERT(std::is_sorted(entries.begin(), entries.end(), &entry_less));
+    auto &snapshot = m_snapshots[sequence % max_size];
+    snapshot.sequence = sequence;
+    snapshot.fragment = fragment;
+    snapshot.entries = std::move(entries);
+}
+
+const std::vector<snapshot_baseline_history::entry> * snapshot_baseline_history::find(uint32_t sequence) const {
+    auto &snapshot = m_snapshots[sequence % max_size];
+
+    if (sequence == 0 || snapshot.sequence != sequence) {
+        return nullptr;
+    }
+
+    return &snapshot.entries;
+}
+
+uint32_t snapshot_baseline_history::next_sequence() {
+    return ++m_last_sequence;
+}
+
+void snapshot_baseline_history::acknowledge(uint32_t sequence) {
+    auto &snapshot = m_snapshots[sequence % max_size];
+
+    // Too old to be used as a baseline.
+    if (sequence == 0 || snapshot.sequence != sequence) {
+        return;
+    }
+
+    if (snapshot.fragment >= m_acked_sequences.size()) {
+        m_acked_sequences.resize(snapshot.fragment + 1, 0);
+    }
+
+    // Acknowledgements can arrive out of order.
+    auto &acked = m_acked_sequences[snapshot.fragment];
+    acked = std::max(acked, sequence);
+}
+
+void snapshot_baseline_history::clear() {
+    m_snapshots = {};
+    m_last_sequence = 0;
+    m_acked_sequences.clear();
+}
+
+void compress_registry_snapshot(packet::registry_snapshot &snapshot,
+                                const snapshot_quantization &quantization,
+                                snapshot_baseline_history &history,
+                                uint32_t fragment) {
+    EDYN_ASSERT(valid_quantization_bits(quantization.position_fraction_bits,
+                                        quantization.velocity_fraction_bits,
+                                        quantization.orientation_bits));
+
+    auto has_motion = std::apply([&](auto &&... c) {
+        return ((find_motion_pool<std::decay_t<decltype(c)>>(snapshot.pools) != nullptr) || ...);
+    }, motion_components_t{});
+
+    if (!has_motion) {
+        return;
+    }
+
+    auto sequence = history.next_sequence();
+    auto baseline_sequence = history.acked_sequence(fragment);
+    auto *baseline = history.find(baseline_sequence);
+
+    if (baseline == nullptr) {
+        // Acknowledged snapshot is too old. Send absolute values.
+        baseline_sequence = 0;
+    }
+
+    auto quantizer = motion_quantizer(quantization.position_fraction_bits, quantization.position_bound,
+                                      quantization.velocity_fraction_bits, quantization.velocity_bound,
+                                      quantization.orientation_bits);
+
+    auto &output = snapshot.motion;
+    output.clear();
+    write_varint(output, sequence);
+    write_varint(output, baseline_sequence);
+    output.push_back(quantization.position_fraction_bits);
+    output.push_back(quantization.velocity_fraction_bits);
+    output.push_back(quantization.orientation_bits);
+
+    auto entries = std::vector<snapshot_baseline_history::entry>{};
+    uint8_t type = 0;
+
+    auto encode = [&](auto &&c) {
+        using CompType = std::decay_t<decltype(c)>;
+        auto *pool = find_motion_pool<CompType>(snapshot.pools);
+
+        if (pool == nullptr) {
+            write_varint(output, 0);
+            ++type;
+            return;
+        }
+
+        write_varint(output, pool->entity_indices.size());
+        int64_t previous_index = 0;
+
+        for (size_t i = 0; i < pool->entity_indices.size(); ++i) {
+            auto index = pool->entity_indices[i];
+            write_varint(output, zigzag_encode(static_cast<int64_t>(index) - previous_index));
+            previous_index = index;
+
+            auto &entry = entries.emplace_back();
+            entry.entity = snapshot.entities[index];
+            entry.type = type;
+            entry.values = {};
+            quantize(pool->components[i], quantizer, entry.values);
+
+            auto base_values = find_baseline_values(baseline, entry.entity, type);
+
+            for (size_t j = 0; j < num_motion_values<CompType>; ++j) {
+                auto delta = static_cast<int64_t>(entry.values[j]) - base_values[j];
+                write_varint(output, zigzag_encode(delta));
+            }
+        }
+
+        erase_motion_pool<CompType>(snapshot.pools);
+        ++type;
+    };
+
+    std::apply([&](auto &&... c) { (encode(c), ...); }, motion_components_t{});
+
+    std::sort(entries.begin(), entries.end(), &entry_less);
+    history.insert(sequence, std::move(entries), fragment);
+}
+
+bool decompress_registry_snapshot(packet::registry_snapshot &snapshot,
+                                  snapshot_baseline_history &history,
+                                  uint32_t &sequence) {
+    auto *data = snapshot.motion.data();
+    auto size = snapshot.motion.size();
+    size_t position = 0;
+    uint64_t sequence_value, baseline_sequence;
+
+    if (!read_varint(data, size, position, sequence_value) ||
+        !read_varint(data, size, position, baseline_sequence) ||
+        sequence_value == 0 || sequence_value > UINT32_MAX ||
+        baseline_sequence > UINT32_MAX || size - position < 3) {
+        return false;
+    }
+
+    auto position_fraction_bits = data[position++];
+    auto velocity_fraction_bits = data[position++];
+    auto orientation_bits = data[position++];
+
+    if (!valid_quantization_bits(position_fraction_bits, velocity_fraction_bits, orientation_bits)) {
+        return false;
+    }
+
+    const std::vector<snapshot_baseline_history::entry> *baseline = nullptr;
+
+    if (baseline_sequence != 0) {
+        baseline = history.find(static_cast<uint32_t>(baseline_sequence));
+
+        if (baseline == nullptr) {
+            return false;
+        }
+    }
+
+    // Bounds are only used for clamping while quantizing.
+    auto quantizer = motion_quantizer(position_fraction_bits, scalar(0),
+                                      velocity_fraction_bits, scalar(0),
+                                      orientation_bits);
+
+    auto entries = std::vector<snapshot_baseline_history::entry>{};
+    auto failed = false;
+    uint8_t type = 0;
+
+    auto decode = [&](auto &&c) {
+        using CompType = std::decay_t<decltype(c)>;
+        uint64_t count;
+
+        if (failed || !read_varint(data, size, position, count) || count > size - position) {
+            failed = true;
+            return;
+        }
+
+        if (count == 0) {
+            ++type;
+            return;
+        }
+
+        auto component_index = tuple_index_of<component_index_type, CompType>(networked_components);
+        auto *pool = internal::get_pool<CompType>(snapshot.pools, component_index);
+        int64_t index = 0;
+
+        for (uint64_t i = 0; i < count; ++i) {
+            uint64_t value;
+
+            if (!read_varint(data, size, position, value)) {
+                failed = true;
+                return;
+            }
+
+            index += zigzag_decode(value);
+
+            if (index < 0 || static_cast<uint64_t>(index) >= snapshot.entities.size()) {
+                failed = true;
+                return;
+            }
+
+            auto &entry = entries.emplace_back();
+            entry.entity = snapshot.entities[index];
+            entry.type = type;
+            entry.values = find_baseline_values(baseline, entry.entity, type);
+
+            for (size_t j = 0; j < num_motion_values<CompType>; ++j) {
+                if (!read_varint(data, size, position, value)) {
+                    failed = true;
+                    return;
+                }
+
+                entry.values[j] = static_cast<int32_t>(entry.values[j] + zigzag_decode(value));
+            }
+
+            if constexpr(std::is_same_v<CompType, orientation>) {
+                if (entry.values[0] < 0 || entry.values[0] > 3) {
+                    failed = true;
+                    return;
+                }
+            }
+
+            auto comp = CompType{};
+            dequantize(entry.values, quantizer, comp);
+            pool->entity_indices.push_back(static_cast<pool_snapshot_data::index_type>(index));
+            pool->components.push_back(comp);
+        }
+
+        ++type;
+    };
+
+    std::apply([&](auto &&... c) { (decode(c), ...); }, motion_components_t{});
+
+    if (failed || position != size) {
+        return false;
+    }
+
+    std::sort(entries.begin(), entries.end(), &entry_less);
+    sequence = static_cast<uint32_t>(sequence_value);
+    history.insert(sequence, std::move(entries));
+    snapshot.motion.clear();
+
+    return true;
+}
+
+}
@@ -0,0 +1,47 @@
+#include "edyn/networking/util/split_registry_snapshot.hpp"
+#include "edyn/config/config.h"
+
+namespace edyn {
+
+std::vector<packet::registry_snapshot>
+split_registry_snapshot(const packet::registry_snapshot &snapshot,
+                        const std::vector<size_t> &order,
+                        size_t max_entities) {
+    EDYN_ASSERT(max_entities > 0);
+    EDYN_ASSERT(order.size() == snapshot.entities.size());
+
+    using index_type = pool_snapshot_data::index_type;
+    auto num_fragments = (order.size() + max_entities - 1) / max_entities;
+    auto fragments = std::vector<packet::registry_snapshot>(num_fragments);
+    auto fragment_indices = std::vector<index_type>(snapshot.entities.size(), pool_snapshot_data::null_index);
+    auto new_indices = std::vector<index_type>(snapshot.entities.size(), pool_snapshot_data::null_index);
+
+    for (size_t i = 0; i < order.size(); ++i) {
+        auto &fragment = fragments[i / max_entities];
+        fragment_indices[order[i]] = static_cast<index_type>(i / max_entities);
+        new_indices[order[i]] = static_cast<index_type>(i % max_entities);
+        fragment.entities.push_back(snapshot.entities[order[i]]);
+    }
+
+    for (auto &fragment : fragments) {
+        fragment.timestamp = snapshot.timestamp;
+    }
+
+    // Pools keep their relative order so the components are still
+    // constructed in the same order on the other end.
+    auto fragment_pools = std::vector<std::unique_ptr<pool_snapshot_data>>(num_fragments);
+
+    for (auto &pool : snapshot.pools) {
+        pool.ptr->split(fragment_indices, new_indices, fragment_pools);
+
+        for (size_t i = 0; i < num_fragments; ++i) {
+            if (fragment_pools[i]) {
+                fragments[i].pools.push_back(pool_snapshot{pool.component_index, std::move(fragment_pools[i])});
+            }
+        }
+    }
+
+    return fragments;
+}
+
+}
@@ -3,7 +3,9 @@
 #include "edyn/parallel/job_queue_scheduler.hpp"
 #include "edyn/parallel/worker.hpp"
 #include "edyn/config/config.h"
+#include "edyn/time/time.hpp"
 #include <cstdint>
+#include <mutex>
 
 namespace edyn {
 
@@ -22,27 +24,35 @@ void job_dispatcher::start(size_t num_worker_threads) {
     EDYN_ASSERT(num_worker_threads > 0);
     EDYN_ASSERT(m_workers.empty());
 
+    // Create all workers before starting threads since workers access each
+    // other to steal jobs.
     for (size_t i = 0; i < num_worker_threads; ++i) {
-        auto w = std::make_unique<worker>();
-        auto t = std::make_unique<std::thread>(&worker::run, w.get());
-        auto id = t->get_id();
+        m_workers.push_back(std::make_unique<worker>(*this, i));
+    }
+
+    m_running.store(true, std::memory_order_release);
 
-        m_threads.push_back(std::move(t));
-        m_workers[id] = std::move(w);
+    for (auto &w : m_workers) {
+        m_threads.push_back(std::make_unique<std::thread>(&worker::run, w.get()));
     }
 }
 
 void job_dispatcher::stop() {
-    for (auto &pair : m_workers) {
-        pair.second->stop();
+    m_running.store(false, std::memory_order_release);
+
+    {
+        auto lock = std::lock_guard(m_park_mutex);
+        ++m_park_epoch;
     }
 
+    m_park_cv.notify_all();
+
     for (auto &t : m_threads) {
         t->join();
     }
 
-    m_workers.clear();
     m_threads.clear();
+    m_workers.clear();
 }
 
 bool job_dispatcher::running() const {
@@ -52,39 +62,86 @@ bool job_dispatcher::running() const {
 void job_dispatcher::async(const job &j) {
     EDYN_ASSERT(!m_workers.empty());
 
-    if (m_workers.size() == 1) {
-        m_workers.begin()->second->push_job(j);
-        return;
+    if (auto *w = worker::current(); w && &w->get_dispatcher() == this) {
+        w->push_local(j);
+    } else {
+        auto index = m_next_worker.fetch_add(1, std::memory_order_relaxed) % m_workers.size();
+        m_workers[index]->push(j);
     }
 
-    // Find least busy worker to insert job into. Start search from a different
-    // worker each time to create a better spread. This prevents the first
-    // worker from being prioritized and getting most jobs.
-    auto best_id = std::thread::id();
-    auto min_num_jobs = SIZE_MAX;
-    auto start = m_start.fetch_add(1, std::memory_order_relaxed) % m_workers.size();
-    auto end = start + m_workers.size();
-
-    for (size_t i = start; i < end; ++i) {
-        auto k = i % m_workers.size();
-        auto first = m_workers.begin();
-        std::advance(first, k);
-        auto &pair = *first;
-
-        auto s = pair.second->size();
-        if (s == 0) {
-            pair.second->push_job(j);
-            return;
+    unpark_one();
+}
+
+bool job_dispatcher::steal(job &j, size_t thief_index, uint32_t &random_state) {
+    auto num_workers = m_workers.size();
+
+    if (num_workers < 2) {
+        return false;
+    }
+
+    // Start at a random victim to spread contention.
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    auto start = random_state % num_workers;
+
+    for (size_t i = 0; i < num_workers; ++i) {
+        auto index = (start + i) % num_workers;
+
+        if (index != thief_index && m_workers[index]->steal(j)) {
+            return true;
         }
-        if (s < min_num_jobs) {
-            min_num_jobs = s;
-            best_id = pair.first;
+    }
+
+    return false;
+}
+
+bool job_dispatcher::has_jobs() const {
+    for (auto &w : m_workers) {
+        if (w->has_jobs()) {
+            return true;
         }
     }
 
-    EDYN_ASSERT(m_workers.count(best_id));
+    return false;
+}
+
+void job_dispatcher::park() {
+    auto lock = std::unique_lock(m_park_mutex);
+    m_num_parked.fetch_add(1, std::memory_order_seq_cst);
+
+    // Pairs with the fence in `unpark_one`. Either the job pushed right
+    // before is visible here or the parked count is visible there.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (m_running.load(std::memory_order_acquire) && !has_jobs()) {
+        auto epoch = m_park_epoch;
+        m_park_cv.wait(lock, [&] {
+            return m_park_epoch != epoch || !m_running.load(std::memory_order_acquire);
+        });
+    }
+
+    m_num_parked.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void job_dispatcher::unpark_one() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (m_num_parked.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
 
-    m_workers[best_id]->push_job(j);
+    {
+        auto lock = std::lock_guard(m_park_mutex);
+        ++m_park_epoch;
+    }
+
+    m_park_cv.notify_one();
+}
+
+bool job_dispatcher::is_worker_thread() const {
+    auto *w = worker::current();
+    return w && &w->get_dispatcher() == this;
 }
 
 void job_dispatcher::async(std::thread::id id, const job &j) {
@@ -111,7 +168,7 @@ job_queue_scheduler job_dispatcher::get_current_scheduler() {
 void job_dispatcher::assure_current_queue() {
     auto id = std::this_thread::get_id();
     // Must not be called from a worker thread.
-    EDYN_ASSERT(!m_workers.count(id));
+    EDYN_ASSERT(!is_worker_thread());
 
     auto lock = std::lock_guard(m_queues_mutex);
     if (!m_queues_map.count(id)) {
@@ -139,4 +196,14 @@ size_t job_dispatcher::num_workers() const {
     return m_workers.size();
 }
 
+double job_dispatcher::busy_time() const {
+    uint64_t counter = 0;
+
+    for (auto &w : m_workers) {
+        counter += w->busy_counter();
+    }
+
+    return static_cast<double>(counter) / static_cast<double>(performance_frequency());
+}
+
 }
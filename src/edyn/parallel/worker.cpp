@@ -0,0 +1,97 @@
+#include "edyn/parallel/worker.hpp"
+#include "edyn/parallel/job_dispatcher.hpp"
+#include "edyn/config/config.h"
+#include "edyn/time/time.hpp"
+#include <thread>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #include <immintrin.h>
+    #define EDYN_CPU_RELAX() _mm_pause()
+#elif defined(__aarch64__) || defined(__arm__)
+    #define EDYN_CPU_RELAX() asm volatile("yield")
+#else
+    #define EDYN_CPU_RELAX() std::this_thread::yield()
+#endif
+
+namespace edyn {
+
+// Number of attempts to find a job before going to sleep. The first are
+// separated by a short pause and the remaining by yielding the thread.
+static constexpr unsigned num_spins = 64;
+static constexpr unsigned num_yields = 16;
+
+static thread_local worker *t_current_worker = nullptr;
+
+worker::worker(job_dispatcher &dispatcher, size_t index)
+    : m_dispatcher(&dispatcher)
+    , m_index(index)
+    , m_random_state(static_cast<uint32_t>(index) * 2654435761u + 1)
+{}
+
+worker * worker::current() {
+    return t_current_worker;
+}
+
+void worker::push_local(const job &j) {
+    EDYN_ASSERT(t_current_worker == this);
+    m_deque.push(j);
+}
+
+void worker::push(const job &j) {
+    m_inbox.push(j);
+}
+
+bool worker::steal(job &j) {
+    return m_deque.steal(j) || m_inbox.try_pop(j);
+}
+
+bool worker::has_jobs() const {
+    return !m_deque.empty() || m_inbox.size() > 0;
+}
+
+bool worker::find_job(job &j) {
+    return m_deque.pop(j) ||
+           m_inbox.try_pop(j) ||
+           m_dispatcher->steal(j, m_index, m_random_state);
+}
+
+void worker::execute(job &j) {
+#ifdef EDYN_ENABLE_PROFILING
+    auto start = performance_counter();
+    j();
+    m_busy_counter.fetch_add(performance_counter() - start, std::memory_order_relaxed);
+#else
+    j();
+#endif
+}
+
+void worker::run() {
+    t_current_worker = this;
+    unsigned idle_count = 0;
+
+    while (m_dispatcher->m_running.load(std::memory_order_acquire)) {
+        job j;
+
+        if (find_job(j)) {
+            execute(j);
+            idle_count = 0;
+            continue;
+        }
+
+        if (idle_count < num_spins) {
+            EDYN_CPU_RELAX();
+        } else if (idle_count < num_spins + num_yields) {
+            std::this_thread::yield();
+        } else {
+            m_dispatcher->park();
+            idle_count = 0;
+            continue;
+        }
+
+        ++idle_count;
+    }
+
+    t_current_worker = nullptr;
+}
+
+}
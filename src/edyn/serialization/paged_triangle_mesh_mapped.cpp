@@ -0,0 +1,217 @@
+#include "edyn/serialization/paged_triangle_mesh_mapped.hpp"
+#include "edyn/serialization/mapped_archive.hpp"
+#include "edyn/serialization/triangle_mesh_s11n.hpp"
+#include "edyn/serialization/static_tree_s11n.hpp"
+#include "edyn/serialization/math_s11n.hpp"
+#include "edyn/serialization/memory_archive.hpp"
+#include "edyn/shapes/paged_triangle_mesh.hpp"
+#include "edyn/parallel/job_dispatcher.hpp"
+#include <fstream>
+
+namespace edyn {
+
+// Identifies the file format, i.e. "EPTM" in little-endian.
+static constexpr uint32_t mapped_paged_mesh_magic = 0x4d545045;
+static constexpr uint32_t mapped_paged_mesh_version = 1;
+
+struct mapped_submesh_entry {
+    uint64_t num_vertices;
+    uint64_t num_indices;
+    uint64_t offset;
+    uint64_t size;
+};
+
+// The table of submeshes comes first so it can be read without reading the
+// tree.
+template<typename Archive>
+static bool serialize_header(Archive &archive, std::vector<mapped_submesh_entry> &entries) {
+    auto magic = mapped_paged_mesh_magic;
+    auto version = mapped_paged_mesh_version;
+    archive(magic, version);
+
+    if (magic != mapped_paged_mesh_magic || version != mapped_paged_mesh_version) {
+        return false;
+    }
+
+    archive(entries);
+
+    return true;
+}
+
+static size_t align_size(size_t size, size_t alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+bool write_mapped_paged_triangle_mesh(const std::string &path, paged_triangle_mesh &paged_tri_mesh) {
+    constexpr auto alignment = paged_triangle_mesh_mapped_loader::mapped_submesh_alignment;
+    auto num_submeshes = paged_tri_mesh.m_cache.size();
+    auto submesh_buffers = std::vector<std::vector<uint8_t>>(num_submeshes);
+    auto entries = std::vector<mapped_submesh_entry>(num_submeshes);
+
+    for (size_t i = 0; i < num_submeshes; ++i) {
+        auto &node = paged_tri_mesh.m_cache[i];
+        EDYN_ASSERT(node.trimesh);
+        auto archive = mapped_output_archive(submesh_buffers[i]);
+        serialize(archive, *node.trimesh);
+
+        entries[i].num_vertices = node.num_vertices;
+        entries[i].num_indices = node.num_indices;
+        entries[i].size = submesh_buffers[i].size();
+    }
+
+    // Calculate the size of the header with placeholder offsets, which
+    // doesn't change once the offsets are assigned.
+    auto header = std::vector<uint8_t>{};
+    {
+        auto archive = mapped_output_archive(header);
+        serialize_header(archive, entries);
+        archive(paged_tri_mesh.m_tree);
+    }
+
+    auto offset = align_size(header.size(), alignment);
+
+    for (auto &entry : entries) {
+        entry.offset = offset;
+        offset = align_size(offset + entry.size, alignment);
+    }
+
+    header.clear();
+    {
+        auto archive = mapped_output_archive(header);
+        serialize_header(archive, entries);
+        archive(paged_tri_mesh.m_tree);
+    }
+
+    auto file = std::ofstream(path, std::ios::binary | std::ios::out);
+
+    if (!file) {
+        return false;
+    }
+
+    static const char padding[alignment] = {};
+    file.write(reinterpret_cast<const char *>(header.data()), header.size());
+    size_t position = header.size();
+
+    for (size_t i = 0; i < num_submeshes; ++i) {
+        file.write(padding, entries[i].offset - position);
+        file.write(reinterpret_cast<const char *>(submesh_buffers[i].data()), submesh_buffers[i].size());
+        position = entries[i].offset + entries[i].size;
+    }
+
+    return file.good();
+}
+
+paged_triangle_mesh_mapped_loader::paged_triangle_mesh_mapped_loader(const std::string &path) {
+    open(path);
+}
+
+bool paged_triangle_mesh_mapped_loader::open(const std::string &path) {
+    m_locations.clear();
+
+    if (!m_file.open(path)) {
+        return false;
+    }
+
+    auto archive = mapped_input_archive(m_file.data(), m_file.size());
+    auto entries = std::vector<mapped_submesh_entry>{};
+
+    if (!serialize_header(archive, entries) || archive.failed()) {
+        m_file.close();
+        return false;
+    }
+
+    for (auto &entry : entries) {
+        if (entry.offset > m_file.size() || entry.size > m_file.size() - entry.offset) {
+            m_file.close();
+            return false;
+        }
+
+        m_locations.push_back({entry.offset, entry.size});
+    }
+
+    return true;
+}
+
+bool paged_triangle_mesh_mapped_loader::read(paged_triangle_mesh &paged_tri_mesh) const {
+    EDYN_ASSERT(is_open());
+    auto archive = mapped_input_archive(m_file.data(), m_file.size());
+    auto entries = std::vector<mapped_submesh_entry>{};
+
+    if (!serialize_header(archive, entries)) {
+        return false;
+    }
+
+    archive(paged_tri_mesh.m_tree);
+
+    if (archive.failed()) {
+        return false;
+    }
+
+    paged_tri_mesh.init_cache(entries.size());
+
+    for (size_t i = 0; i < entries.size(); ++i) {
+        auto &node = paged_tri_mesh.m_cache[i];
+        node.num_vertices = entries[i].num_vertices;
+        node.num_indices = entries[i].num_indices;
+    }
+
+    return true;
+}
+
+std::shared_ptr<triangle_mesh> paged_triangle_mesh_mapped_loader::load_submesh(size_t index) const {
+    EDYN_ASSERT(index < m_locations.size());
+    auto &location = m_locations[index];
+    auto archive = mapped_input_archive(m_file.data() + location.offset, location.size);
+    auto mesh = std::make_shared<triangle_mesh>();
+    serialize(archive, *mesh);
+
+    if (archive.failed()) {
+        return {};
+    }
+
+    return mesh;
+}
+
+struct load_mapped_mesh_context {
+    // Integral value of a pointer to an instance of
+    // `paged_triangle_mesh_mapped_loader`.
+    intptr_t m_loader;
+    // Index of submesh to be loaded.
+    size_t m_index;
+};
+
+template<typename Archive>
+void serialize(Archive &archive, load_mapped_mesh_context &ctx) {
+    archive(ctx.m_loader);
+    archive(ctx.m_index);
+}
+
+void paged_triangle_mesh_mapped_loader::load(size_t index) {
+    EDYN_ASSERT(index < m_locations.size());
+    auto &location = m_locations[index];
+    m_file.will_need(location.offset, location.size);
+
+    auto ctx = load_mapped_mesh_context();
+    ctx.m_loader = reinterpret_cast<intptr_t>(this);
+    ctx.m_index = index;
+
+    auto j = job();
+    j.func = &load_mapped_mesh_job_func;
+    auto archive = fixed_memory_output_archive(j.data.data(), j.data.size());
+    serialize(archive, ctx);
+    job_dispatcher::global().async(j);
+}
+
+void load_mapped_mesh_job_func(job::data_type &data) {
+    load_mapped_mesh_context ctx;
+    auto archive = memory_input_archive(data.data(), data.size());
+    serialize(archive, ctx);
+
+    auto *loader = reinterpret_cast<paged_triangle_mesh_mapped_loader *>(ctx.m_loader);
+    // A null mesh is published if the data is corrupt, which marks the
+    // submesh as failed so that it is not requested again.
+    auto mesh = loader->load_submesh(ctx.m_index);
+    loader->m_loaded_signal.publish(ctx.m_index, mesh);
+}
+
+}
@@ -4,10 +4,12 @@
 #include "edyn/serialization/math_s11n.hpp"
 #include "edyn/serialization/std_s11n.hpp"
 #include "edyn/serialization/memory_archive.hpp"
+#include "edyn/serialization/triangle_mesh_compression.hpp"
 #include "edyn/parallel/job_dispatcher.hpp"
 #include "edyn/shapes/triangle_mesh.hpp"
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace edyn {
 
@@ -24,6 +26,26 @@ std::string get_submesh_path(const std::string &paged_triangle_mesh_path, size_t
     return submesh_path;
 }
 
+// Compressed submeshes are written as a block of bytes preceded by its size.
+static void write_compressed_block(file_output_archive &archive, const std::vector<uint8_t> &buffer) {
+    uint64_t size = buffer.size();
+    archive(size);
+    archive.write_raw(buffer.data(), buffer.size());
+}
+
+static bool read_compressed_triangle_mesh(file_input_archive &archive, triangle_mesh &tri_mesh) {
+    uint64_t size = 0;
+    archive(size);
+
+    auto buffer = std::vector<uint8_t>(size);
+
+    if (!archive.read_raw(buffer.data(), buffer.size())) {
+        return false;
+    }
+
+    return decompress_triangle_mesh(buffer.data(), buffer.size(), tri_mesh);
+}
+
 void paged_triangle_mesh_file_output_archive::operator()(triangle_mesh &tri_mesh) {
     switch(m_mode) {
     case paged_triangle_mesh_serialization_mode::embedded:
@@ -35,6 +57,20 @@ void paged_triangle_mesh_file_output_archive::operator()(triangle_mesh &tri_mesh
         serialize(archive, tri_mesh);
         break;
     }
+    case paged_triangle_mesh_serialization_mode::embedded_compressed: {
+        auto buffer = std::vector<uint8_t>{};
+        compress_triangle_mesh(tri_mesh, buffer, m_quantization_step);
+        write_compressed_block(*this, buffer);
+        break;
+    }
+    case paged_triangle_mesh_serialization_mode::external_compressed: {
+        auto tri_mesh_path = get_submesh_path(m_path, m_triangle_mesh_index);
+        auto archive = file_output_archive(tri_mesh_path);
+        auto buffer = std::vector<uint8_t>{};
+        compress_triangle_mesh(tri_mesh, buffer, m_quantization_step);
+        write_compressed_block(archive, buffer);
+        break;
+    }
     }
     ++m_triangle_mesh_index;
 }
@@ -62,6 +98,22 @@ void serialize(paged_triangle_mesh_file_output_archive &archive,
             auto tri_mesh_size = serialization_sizeof(*paged_tri_mesh.m_cache[i].trimesh);
             tri_mesh_offset += tri_mesh_size;
         }
+    } else if (archive.m_mode == paged_triangle_mesh_serialization_mode::embedded_compressed) {
+        // Compress all submeshes first to calculate their offsets.
+        auto buffers = std::vector<std::vector<uint8_t>>(num_submeshes);
+        size_t tri_mesh_offset = 0;
+
+        for (size_t i = 0; i < num_submeshes; ++i) {
+            archive(tri_mesh_offset);
+            compress_triangle_mesh(*paged_tri_mesh.m_cache[i].trimesh, buffers[i], archive.m_quantization_step);
+            tri_mesh_offset += sizeof(uint64_t) + buffers[i].size();
+        }
+
+        for (auto &buffer : buffers) {
+            write_compressed_block(archive, buffer);
+        }
+
+        return;
     }
 
     for (auto &entry : paged_tri_mesh.m_cache) {
@@ -73,9 +125,14 @@ void serialize(paged_triangle_mesh_file_input_archive &archive,
                paged_triangle_mesh &paged_tri_mesh) {
     archive(paged_tri_mesh.m_tree);
 
+    // The tree was written with an incompatible layout.
+    if (archive.failed()) {
+        return;
+    }
+
     size_t num_submeshes;
     archive(num_submeshes);
-    paged_tri_mesh.m_cache.resize(num_submeshes);
+    paged_tri_mesh.init_cache(num_submeshes);
 
     for (size_t i = 0; i < num_submeshes; ++i) {
         auto &entry = paged_tri_mesh.m_cache[i];
@@ -85,7 +142,8 @@ void serialize(paged_triangle_mesh_file_input_archive &archive,
 
     archive(archive.m_mode);
 
-    if (archive.m_mode == paged_triangle_mesh_serialization_mode::embedded) {
+    if (archive.m_mode == paged_triangle_mesh_serialization_mode::embedded ||
+        archive.m_mode == paged_triangle_mesh_serialization_mode::embedded_compressed) {
         archive.m_offsets.resize(num_submeshes);
 
         for (size_t i = 0; i < num_submeshes; ++i) {
@@ -94,13 +152,6 @@ void serialize(paged_triangle_mesh_file_input_archive &archive,
 
         archive.m_base_offset = archive.tell_position();
     }
-
-    // Resize LRU queue to have the number of submeshes.
-    paged_tri_mesh.m_lru_indices.resize(num_submeshes);
-    std::iota(paged_tri_mesh.m_lru_indices.begin(),
-              paged_tri_mesh.m_lru_indices.end(), 0);
-
-    paged_tri_mesh.m_is_loading_submesh = std::make_unique<std::atomic<bool>[]>(num_submeshes);
 }
 
 template<typename Archive>
@@ -133,11 +184,35 @@ void load_mesh_job_func(job::data_type &data) {
     case paged_triangle_mesh_serialization_mode::embedded:
         input->seek_position(input->m_base_offset + input->m_offsets[ctx.m_index]);
         serialize(*input, *mesh);
+
+        if (input->failed()) {
+            mesh.reset();
+        }
         break;
     case paged_triangle_mesh_serialization_mode::external: {
         auto tri_mesh_path = get_submesh_path(input->m_path, ctx.m_index);
         auto tri_mesh_archive = file_input_archive(tri_mesh_path);
         serialize(tri_mesh_archive, *mesh);
+
+        if (tri_mesh_archive.failed()) {
+            mesh.reset();
+        }
+        break;
+    }
+    case paged_triangle_mesh_serialization_mode::embedded_compressed:
+        input->seek_position(input->m_base_offset + input->m_offsets[ctx.m_index]);
+
+        if (!read_compressed_triangle_mesh(*input, *mesh)) {
+            mesh.reset();
+        }
+        break;
+    case paged_triangle_mesh_serialization_mode::external_compressed: {
+        auto tri_mesh_path = get_submesh_path(input->m_path, ctx.m_index);
+        auto tri_mesh_archive = file_input_archive(tri_mesh_path);
+
+        if (!read_compressed_triangle_mesh(tri_mesh_archive, *mesh)) {
+            mesh.reset();
+        }
         break;
     }
     }
@@ -0,0 +1,360 @@
+#include "edyn/serialization/triangle_mesh_compression.hpp"
+#include "edyn/shapes/triangle_mesh.hpp"
+#include "edyn/serialization/varint.hpp"
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <algorithm>
+
+namespace edyn {
+
+static constexpr uint8_t compressed_triangle_mesh_version = 1;
+
+// Flags stored in the header.
+static constexpr uint8_t compressed_has_vertex_coefficients = 1 << 0;
+
+static constexpr scalar snorm16_max = scalar(32767);
+
+template<typename T>
+static void write_value(std::vector<uint8_t> &output, T value) {
+    auto idx = output.size();
+    output.resize(idx + sizeof(T));
+    std::memcpy(output.data() + idx, &value, sizeof(T));
+}
+
+static scalar sign_not_zero(scalar s) {
+    return s < 0 ? scalar(-1) : scalar(1);
+}
+
+// Octahedral encoding of unit vectors into two 16-bit signed integers.
+static std::array<int16_t, 2> encode_octahedral(const vector3 &n) {
+    auto sum = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+    auto px = n.x / sum;
+    auto py = n.y / sum;
+
+    if (n.z < 0) {
+        auto ox = (1 - std::abs(py)) * sign_not_zero(px);
+        auto oy = (1 - std::abs(px)) * sign_not_zero(py);
+        px = ox;
+        py = oy;
+    }
+
+    return {
+        static_cast<int16_t>(std::round(std::clamp(px, scalar(-1), scalar(1)) * snorm16_max)),
+        static_cast<int16_t>(std::round(std::clamp(py, scalar(-1), scalar(1)) * snorm16_max))
+    };
+}
+
+static vector3 decode_octahedral(int16_t x, int16_t y) {
+    auto px = std::max(scalar(x) / snorm16_max, scalar(-1));
+    auto py = std::max(scalar(y) / snorm16_max, scalar(-1));
+    auto v = vector3{px, py, 1 - std::abs(px) - std::abs(py)};
+
+    if (v.z < 0) {
+        v.x = (1 - std::abs(py)) * sign_not_zero(px);
+        v.y = (1 - std::abs(px)) * sign_not_zero(py);
+    }
+
+    return normalize(v);
+}
+
+// Reads values from a buffer. Sets the failed flag instead of reading past
+// the end.
+struct compressed_reader {
+    const uint8_t *data;
+    size_t size;
+    size_t position {0};
+    bool failed {false};
+
+    size_t remaining() const {
+        return size - position;
+    }
+
+    uint64_t read_varint() {
+        uint64_t value;
+
+        if (!edyn::read_varint(data, size, position, value)) {
+            failed = true;
+            return 0;
+        }
+
+        return value;
+    }
+
+    template<typename T>
+    T read_value() {
+        T value {};
+
+        if (remaining() < sizeof(T)) {
+            failed = true;
+            return value;
+        }
+
+        std::memcpy(&value, data + position, sizeof(T));
+        position += sizeof(T);
+        return value;
+    }
+};
+
+void compress_triangle_mesh(const triangle_mesh &tri_mesh, std::vector<uint8_t> &output,
+                            scalar quantization_step) {
+    EDYN_ASSERT(quantization_step > 0);
+    EDYN_ASSERT(!tri_mesh.m_vertices.empty() && !tri_mesh.m_indices.empty());
+    EDYN_ASSERT(tri_mesh.m_face_edge_indices.size() == tri_mesh.m_indices.size());
+
+    auto num_vertices = tri_mesh.m_vertices.size();
+    auto num_edges = tri_mesh.m_edge_vertex_indices.size();
+    auto has_coefficients = !tri_mesh.m_friction.empty();
+    uint8_t flags = has_coefficients ? compressed_has_vertex_coefficients : 0;
+
+    write_value(output, compressed_triangle_mesh_version);
+    write_value(output, flags);
+    write_value(output, quantization_step);
+    write_varint(output, num_vertices);
+    write_varint(output, tri_mesh.m_indices.size());
+    write_varint(output, num_edges);
+
+    // Snap vertices to the grid and store the minimum of their bounds
+    // followed by deltas between consecutive vertices.
+    auto grid_coordinates = std::vector<std::array<int64_t, 3>>(num_vertices);
+    auto grid_min = std::array<int64_t, 3>{};
+    grid_min.fill(std::numeric_limits<int64_t>::max());
+
+    for (size_t i = 0; i < num_vertices; ++i) {
+        for (size_t j = 0; j < 3; ++j) {
+            auto coord = std::llround(tri_mesh.m_vertices[i][j] / quantization_step);
+            grid_coordinates[i][j] = coord;
+            grid_min[j] = std::min(grid_min[j], static_cast<int64_t>(coord));
+        }
+    }
+
+    for (auto coord : grid_min) {
+        write_varint(output, zigzag_encode(coord));
+    }
+
+    auto previous = grid_min;
+
+    for (auto &coords : grid_coordinates) {
+        for (size_t j = 0; j < 3; ++j) {
+            write_varint(output, zigzag_encode(coords[j] - previous[j]));
+            previous[j] = coords[j];
+        }
+    }
+
+    // Vertex indices of neighboring triangles tend to be close.
+    int64_t previous_index = 0;
+
+    for (auto &indices : tri_mesh.m_indices) {
+        for (auto index : indices) {
+            write_varint(output, zigzag_encode(static_cast<int64_t>(index) - previous_index));
+            previous_index = index;
+        }
+    }
+
+    // Convexity of each edge packed as bits.
+    for (size_t i = 0; i < num_edges; i += 8) {
+        uint8_t bits = 0;
+
+        for (size_t j = 0; j < 8 && i + j < num_edges; ++j) {
+            bits |= static_cast<uint8_t>(tri_mesh.m_is_convex_edge[i + j]) << j;
+        }
+
+        output.push_back(bits);
+    }
+
+    // The adjacent normals of the remaining edges are the normals of faces
+    // in this mesh.
+    for (size_t face_idx = 0; face_idx < tri_mesh.m_indices.size(); ++face_idx) {
+        for (size_t i = 0; i < 3; ++i) {
+            auto edge_idx = tri_mesh.m_face_edge_indices[face_idx][i];
+
+            if (tri_mesh.m_is_boundary_edge[edge_idx]) {
+                auto encoded = encode_octahedral(tri_mesh.m_adjacent_normals[face_idx][i]);
+                write_value(output, encoded[0]);
+                write_value(output, encoded[1]);
+            }
+        }
+    }
+
+    // Store the layout of the triangle tree, which is much faster to rebuild
+    // than evaluating the splits again. Each leaf holds one triangle.
+    auto &tree = tri_mesh.m_triangle_tree;
+    auto num_nodes = static_cast<uint32_t>(tree.size());
+    EDYN_ASSERT(num_nodes == tri_mesh.m_indices.size() * 2 - 1);
+
+    for (uint32_t i = 0; i < num_nodes; i += 8) {
+        uint8_t bits = 0;
+
+        for (uint32_t j = 0; j < 8 && i + j < num_nodes; ++j) {
+            bits |= static_cast<uint8_t>(tree.get_node(i + j).leaf()) << j;
+        }
+
+        output.push_back(bits);
+    }
+
+    // Triangles in neighboring leaves tend to have close indices.
+    int64_t previous_id = 0;
+
+    for (uint32_t i = 0; i < num_nodes; ++i) {
+        auto &node = tree.get_node(i);
+
+        if (node.leaf()) {
+            write_varint(output, zigzag_encode(static_cast<int64_t>(node.id) - previous_id));
+            previous_id = node.id;
+        }
+    }
+
+    if (has_coefficients) {
+        EDYN_ASSERT(tri_mesh.m_friction.size() == num_vertices);
+        EDYN_ASSERT(tri_mesh.m_restitution.size() == num_vertices);
+
+        for (size_t i = 0; i < num_vertices; ++i) {
+            write_value(output, tri_mesh.m_friction[i]);
+            write_value(output, tri_mesh.m_restitution[i]);
+        }
+    }
+}
+
+bool decompress_triangle_mesh(const uint8_t *data, size_t size, triangle_mesh &tri_mesh) {
+    EDYN_ASSERT(tri_mesh.m_vertices.empty() && tri_mesh.m_indices.empty());
+
+    auto reader = compressed_reader{data, size};
+    auto version = reader.read_value<uint8_t>();
+    auto flags = reader.read_value<uint8_t>();
+    auto quantization_step = reader.read_value<scalar>();
+    auto num_vertices = reader.read_varint();
+    auto num_triangles = reader.read_varint();
+    auto num_edges = reader.read_varint();
+
+    // Each vertex coordinate and each vertex index takes at least one byte,
+    // which bounds the sizes before allocating memory.
+    if (reader.failed || version != compressed_triangle_mesh_version ||
+        !(quantization_step > 0) || num_vertices == 0 || num_triangles == 0 ||
+        num_vertices > std::numeric_limits<triangle_mesh::index_type>::max() ||
+        num_vertices > reader.remaining() / 3 ||
+        num_triangles > reader.remaining() / 3 ||
+        num_edges > num_triangles * 3) {
+        return false;
+    }
+
+    auto grid_min = std::array<int64_t, 3>{};
+
+    for (auto &coord : grid_min) {
+        coord = zigzag_decode(reader.read_varint());
+    }
+
+    tri_mesh.m_vertices.resize(num_vertices);
+    auto previous = grid_min;
+
+    for (auto &vertex : tri_mesh.m_vertices) {
+        for (size_t j = 0; j < 3; ++j) {
+            previous[j] += zigzag_decode(reader.read_varint());
+            vertex[j] = static_cast<scalar>(previous[j]) * quantization_step;
+        }
+    }
+
+    tri_mesh.m_indices.resize(num_triangles);
+    int64_t previous_index = 0;
+
+    for (auto &indices : tri_mesh.m_indices) {
+        for (auto &index : indices) {
+            previous_index += zigzag_decode(reader.read_varint());
+
+            if (previous_index < 0 || static_cast<uint64_t>(previous_index) >= num_vertices) {
+                return false;
+            }
+
+            index = static_cast<triangle_mesh::index_type>(previous_index);
+        }
+    }
+
+    if (reader.failed) {
+        return false;
+    }
+
+    tri_mesh.calculate_face_normals();
+    tri_mesh.init_edge_indices();
+
+    if (tri_mesh.m_edge_vertex_indices.size() != num_edges) {
+        return false;
+    }
+
+    tri_mesh.m_is_convex_edge.resize(num_edges);
+
+    for (size_t i = 0; i < num_edges; i += 8) {
+        auto bits = reader.read_value<uint8_t>();
+
+        for (size_t j = 0; j < 8 && i + j < num_edges; ++j) {
+            tri_mesh.m_is_convex_edge[i + j] = (bits & (1 << j)) != 0;
+        }
+    }
+
+    tri_mesh.m_adjacent_normals.resize(num_triangles);
+
+    for (size_t face_idx = 0; face_idx < num_triangles; ++face_idx) {
+        for (size_t i = 0; i < 3; ++i) {
+            auto edge_idx = tri_mesh.m_face_edge_indices[face_idx][i];
+
+            if (tri_mesh.m_is_boundary_edge[edge_idx]) {
+                auto x = reader.read_value<int16_t>();
+                auto y = reader.read_value<int16_t>();
+                tri_mesh.m_adjacent_normals[face_idx][i] = decode_octahedral(x, y);
+            } else {
+                auto &edge_face_indices = tri_mesh.m_edge_face_indices[edge_idx];
+                auto other_face_idx = edge_face_indices[0] == face_idx ? edge_face_indices[1] : edge_face_indices[0];
+                tri_mesh.m_adjacent_normals[face_idx][i] = tri_mesh.m_normals[other_face_idx];
+            }
+        }
+    }
+
+    auto num_nodes = num_triangles * 2 - 1;
+    auto is_leaf = std::vector<bool>(num_nodes);
+
+    for (size_t i = 0; i < num_nodes; i += 8) {
+        auto bits = reader.read_value<uint8_t>();
+
+        for (size_t j = 0; j < 8 && i + j < num_nodes; ++j) {
+            is_leaf[i + j] = (bits & (1 << j)) != 0;
+        }
+    }
+
+    auto leaf_ids = std::vector<uint32_t>(num_triangles);
+    int64_t previous_id = 0;
+
+    for (auto &id : leaf_ids) {
+        previous_id += zigzag_decode(reader.read_varint());
+
+        if (previous_id < 0 || static_cast<uint64_t>(previous_id) >= num_triangles) {
+            return false;
+        }
+
+        id = static_cast<uint32_t>(previous_id);
+    }
+
+    if (flags & compressed_has_vertex_coefficients) {
+        if (reader.remaining() < num_vertices * 2 * sizeof(scalar)) {
+            return false;
+        }
+
+        tri_mesh.m_friction.resize(num_vertices);
+        tri_mesh.m_restitution.resize(num_vertices);
+
+        for (size_t i = 0; i < num_vertices; ++i) {
+            tri_mesh.m_friction[i] = reader.read_value<scalar>();
+            tri_mesh.m_restitution[i] = reader.read_value<scalar>();
+        }
+    }
+
+    if (reader.failed) {
+        return false;
+    }
+
+    auto leaf_aabb = [&](uint32_t tri_idx) {
+        return get_triangle_aabb(tri_mesh.get_triangle_vertices(tri_idx));
+    };
+
+    return tri_mesh.m_triangle_tree.build_from_layout(is_leaf, leaf_ids, leaf_aabb);
+}
+
+}
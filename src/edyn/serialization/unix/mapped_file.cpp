@@ -0,0 +1,85 @@
+#include "edyn/serialization/mapped_file.hpp"
+#include "edyn/config/config.h"
+#include <utility>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace edyn {
+
+mapped_file::mapped_file(const std::string &path) {
+    open(path);
+}
+
+mapped_file::~mapped_file() {
+    close();
+}
+
+mapped_file::mapped_file(mapped_file &&other) noexcept
+    : m_data(std::exchange(other.m_data, nullptr))
+    , m_size(std::exchange(other.m_size, 0))
+    , m_handle(std::exchange(other.m_handle, nullptr))
+{}
+
+mapped_file & mapped_file::operator=(mapped_file &&other) noexcept {
+    if (this != &other) {
+        close();
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+        m_handle = std::exchange(other.m_handle, nullptr);
+    }
+
+    return *this;
+}
+
+bool mapped_file::open(const std::string &path) {
+    close();
+
+    auto fd = ::open(path.c_str(), O_RDONLY);
+
+    if (fd == -1) {
+        return false;
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+
+    auto size = static_cast<size_t>(st.st_size);
+    auto *addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // The mapping remains valid after the file descriptor is closed.
+    ::close(fd);
+
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+
+    m_data = static_cast<const uint8_t *>(addr);
+    m_size = size;
+
+    return true;
+}
+
+void mapped_file::close() {
+    if (m_data) {
+        munmap(const_cast<uint8_t *>(m_data), m_size);
+        m_data = nullptr;
+        m_size = 0;
+    }
+}
+
+void mapped_file::will_need(size_t offset, size_t size) const {
+    EDYN_ASSERT(offset + size <= m_size);
+
+    // The address must be aligned to a page boundary.
+    auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    auto begin = offset / page_size * page_size;
+    madvise(const_cast<uint8_t *>(m_data) + begin, offset + size - begin, MADV_WILLNEED);
+}
+
+}
@@ -0,0 +1,92 @@
+#include "edyn/serialization/mapped_file.hpp"
+#include "edyn/config/config.h"
+#include <utility>
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+
+namespace edyn {
+
+mapped_file::mapped_file(const std::string &path) {
+    open(path);
+}
+
+mapped_file::~mapped_file() {
+    close();
+}
+
+mapped_file::mapped_file(mapped_file &&other) noexcept
+    : m_data(std::exchange(other.m_data, nullptr))
+    , m_size(std::exchange(other.m_size, 0))
+    , m_handle(std::exchange(other.m_handle, nullptr))
+{}
+
+mapped_file & mapped_file::operator=(mapped_file &&other) noexcept {
+    if (this != &other) {
+        close();
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+        m_handle = std::exchange(other.m_handle, nullptr);
+    }
+
+    return *this;
+}
+
+bool mapped_file::open(const std::string &path) {
+    close();
+
+    auto file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    auto mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    // The mapping keeps the file open.
+    CloseHandle(file);
+
+    if (mapping == nullptr) {
+        return false;
+    }
+
+    auto *addr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+    if (addr == nullptr) {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    m_data = static_cast<const uint8_t *>(addr);
+    m_size = static_cast<size_t>(size.QuadPart);
+    m_handle = mapping;
+
+    return true;
+}
+
+void mapped_file::close() {
+    if (m_data) {
+        UnmapViewOfFile(m_data);
+        CloseHandle(static_cast<HANDLE>(m_handle));
+        m_data = nullptr;
+        m_size = 0;
+        m_handle = nullptr;
+    }
+}
+
+void mapped_file::will_need(size_t offset, size_t size) const {
+    EDYN_ASSERT(offset + size <= m_size);
+    // Pages are read on first access.
+}
+
+}
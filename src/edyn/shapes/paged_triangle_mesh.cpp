@@ -1,5 +1,6 @@
 #include "edyn/shapes/paged_triangle_mesh.hpp"
 #include "edyn/parallel/parallel_for.hpp"
+#include <algorithm>
 #include <atomic>
 #include <limits>
 #include <mutex>
@@ -13,61 +14,222 @@ paged_triangle_mesh::paged_triangle_mesh(std::shared_ptr<triangle_mesh_page_load
     m_page_loader->on_load_sink().connect<&paged_triangle_mesh::assign_mesh>(*this);
 }
 
-size_t paged_triangle_mesh::cache_num_vertices() const {
+void paged_triangle_mesh::init_cache(size_t num_submeshes) {
+    m_cache.clear();
+    m_cache.resize(num_submeshes);
+    m_clock_hand = null_node;
+    m_cache_num_vertices.store(0, std::memory_order_relaxed);
+
+    m_is_loading_submesh = std::make_unique<std::atomic<bool>[]>(num_submeshes);
+    m_recently_visited = std::make_unique<std::atomic<bool>[]>(num_submeshes);
+}
+
+void paged_triangle_mesh::track_loaded_nodes() {
+    auto lock = std::lock_guard(m_cache_mutex);
     size_t count = 0;
 
-    for (auto &node : m_cache) {
-        if (!node.trimesh) {
-            continue;
+    for (size_t i = 0; i < m_cache.size(); ++i) {
+        auto &node = m_cache[i];
+
+        if (node.trimesh && node.clock_next == null_node) {
+            clock_insert(i);
         }
 
-        count += node.num_vertices;
+        if (node.trimesh) {
+            count += node.num_vertices;
+        }
     }
 
-    return count;
+    m_cache_num_vertices.store(count, std::memory_order_relaxed);
 }
 
-void paged_triangle_mesh::load_node_if_needed(size_t trimesh_idx) {
-    EDYN_ASSERT(m_is_loading_submesh && trimesh_idx < m_cache.size());
-    auto already_loading = m_is_loading_submesh[trimesh_idx].exchange(true, std::memory_order_relaxed);
+paged_triangle_mesh::cache_stats paged_triangle_mesh::get_cache_stats() const {
+    return {
+        m_num_cache_hits.load(std::memory_order_relaxed),
+        m_num_cache_misses.load(std::memory_order_relaxed),
+        m_num_cache_evictions.load(std::memory_order_relaxed),
+        m_num_cache_prefetches.load(std::memory_order_relaxed)
+    };
+}
 
-    if (already_loading) {
-        return;
-    }
+void paged_triangle_mesh::reset_cache_stats() {
+    m_num_cache_hits.store(0, std::memory_order_relaxed);
+    m_num_cache_misses.store(0, std::memory_order_relaxed);
+    m_num_cache_evictions.store(0, std::memory_order_relaxed);
+    m_num_cache_prefetches.store(0, std::memory_order_relaxed);
+}
 
+void paged_triangle_mesh::load_node_if_needed(size_t trimesh_idx, cache_query_counts &counts) {
+    EDYN_ASSERT(m_is_loading_submesh && trimesh_idx < m_cache.size());
     auto &node = m_cache[trimesh_idx];
 
     if (node.trimesh) {
-        m_is_loading_submesh[trimesh_idx].store(false, std::memory_order_relaxed);
+        ++counts.hits;
         return;
     }
 
-    EDYN_ASSERT(node.num_vertices < m_max_cache_num_vertices);
-    // Load triangle mesh into cache. Clear cache if it would go
-    // above limits.
-    while (cache_num_vertices() + node.num_vertices > m_max_cache_num_vertices) {
-        unload_least_recently_visited_node();
+    ++counts.misses;
+    start_loading(trimesh_idx);
+}
+
+void paged_triangle_mesh::add_cache_counts(const cache_query_counts &counts) {
+    if (counts.hits > 0) {
+        m_num_cache_hits.fetch_add(counts.hits, std::memory_order_relaxed);
     }
 
-    m_page_loader->load(trimesh_idx);
+    if (counts.misses > 0) {
+        m_num_cache_misses.fetch_add(counts.misses, std::memory_order_relaxed);
+    }
 }
 
-void paged_triangle_mesh::mark_recent_visit(size_t trimesh_idx) {
-    auto lock = std::lock_guard(m_lru_mutex);
-    auto it = std::find(m_lru_indices.begin(), m_lru_indices.end(), trimesh_idx);
-    std::rotate(m_lru_indices.begin(), it, it + 1);
+size_t paged_triangle_mesh::prefetch_budget() {
+    auto lock = std::lock_guard(m_cache_mutex);
+    auto num_cached_vertices = cache_num_vertices();
+    size_t budget = num_cached_vertices < m_max_cache_num_vertices ?
+                    m_max_cache_num_vertices - num_cached_vertices : 0;
+
+    // Submeshes not visited since the last sweep of the clock hand would be
+    // unloaded first to make room.
+    if (m_clock_hand != null_node) {
+        auto idx = m_clock_hand;
+
+        do {
+            if (!m_recently_visited[idx].load(std::memory_order_relaxed)) {
+                budget += m_cache[idx].num_vertices;
+            }
+
+            idx = m_cache[idx].clock_next;
+        } while (idx != m_clock_hand);
+    }
+
+    return std::min(budget, m_max_cache_num_vertices / 2);
 }
 
-void paged_triangle_mesh::unload_least_recently_visited_node() {
-    auto lock = std::lock_guard(m_lru_mutex);
+void paged_triangle_mesh::prefetch_submeshes(const std::vector<size_t> &indices) {
+    // Mark submeshes which are already loaded first so they do not count
+    // as room for new submeshes.
+    for (auto idx : indices) {
+        EDYN_ASSERT(idx < m_cache.size());
+
+        if (m_cache[idx].trimesh) {
+            mark_recent_visit(idx);
+        }
+    }
+
+    auto max_num_vertices = prefetch_budget();
+    size_t num_vertices = 0;
+
+    for (auto idx : indices) {
+        auto &node = m_cache[idx];
 
-    for (auto it = m_lru_indices.rbegin(); it != m_lru_indices.rend(); ++it) {
-        auto &node = m_cache[*it];
         if (node.trimesh) {
-            node.trimesh.reset();
+            continue;
+        }
+
+        if (num_vertices + node.num_vertices > max_num_vertices) {
             break;
         }
+
+        if (start_loading(idx)) {
+            num_vertices += node.num_vertices;
+            m_num_cache_prefetches.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+bool paged_triangle_mesh::start_loading(size_t trimesh_idx) {
+    auto &node = m_cache[trimesh_idx];
+    auto already_loading = m_is_loading_submesh[trimesh_idx].exchange(true, std::memory_order_relaxed);
+
+    if (already_loading) {
+        return false;
+    }
+
+    {
+        auto lock = std::lock_guard(m_cache_mutex);
+
+        // It might have been assigned after the first check.
+        if (node.trimesh || node.load_failed) {
+            m_is_loading_submesh[trimesh_idx].store(false, std::memory_order_relaxed);
+            return false;
+        }
+
+        EDYN_ASSERT(node.num_vertices < m_max_cache_num_vertices);
+        // Unload nodes if the cache would go above limits. The vertices are
+        // accounted for before the load finishes so that concurrent loads
+        // do not overshoot the budget.
+        while (cache_num_vertices() + node.num_vertices > m_max_cache_num_vertices) {
+            if (!unload_node()) {
+                break;
+            }
+        }
+
+        m_cache_num_vertices.fetch_add(node.num_vertices, std::memory_order_relaxed);
+    }
+
+    // Load outside of the lock since the loader might assign the mesh
+    // immediately.
+    m_page_loader->load(trimesh_idx);
+    return true;
+}
+
+void paged_triangle_mesh::clock_insert(size_t trimesh_idx) {
+    auto &node = m_cache[trimesh_idx];
+    EDYN_ASSERT(node.clock_prev == null_node && node.clock_next == null_node);
+
+    if (m_clock_hand == null_node) {
+        node.clock_prev = node.clock_next = trimesh_idx;
+        m_clock_hand = trimesh_idx;
+        return;
+    }
+
+    // Insert right behind the hand, so it's the last to be checked.
+    auto &next = m_cache[m_clock_hand];
+    auto &prev = m_cache[next.clock_prev];
+    node.clock_prev = next.clock_prev;
+    node.clock_next = m_clock_hand;
+    prev.clock_next = trimesh_idx;
+    next.clock_prev = trimesh_idx;
+}
+
+void paged_triangle_mesh::clock_erase(size_t trimesh_idx) {
+    auto &node = m_cache[trimesh_idx];
+    EDYN_ASSERT(node.clock_prev != null_node && node.clock_next != null_node);
+
+    if (node.clock_next == trimesh_idx) {
+        m_clock_hand = null_node;
+    } else {
+        m_cache[node.clock_prev].clock_next = node.clock_next;
+        m_cache[node.clock_next].clock_prev = node.clock_prev;
+
+        if (m_clock_hand == trimesh_idx) {
+            m_clock_hand = node.clock_next;
+        }
     }
+
+    node.clock_prev = node.clock_next = null_node;
+}
+
+bool paged_triangle_mesh::unload_node() {
+    // Give nodes that were visited a second chance by clearing the flag and
+    // moving on. This terminates in at most one full turn plus one step.
+    while (m_clock_hand != null_node) {
+        auto idx = m_clock_hand;
+        auto &node = m_cache[idx];
+
+        if (m_recently_visited[idx].exchange(false, std::memory_order_relaxed)) {
+            m_clock_hand = node.clock_next;
+            continue;
+        }
+
+        clock_erase(idx);
+        node.trimesh.reset();
+        m_cache_num_vertices.fetch_sub(node.num_vertices, std::memory_order_relaxed);
+        m_num_cache_evictions.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    return false;
 }
 
 triangle_vertices paged_triangle_mesh::get_triangle_vertices(size_t mesh_idx, size_t tri_idx) {
@@ -77,16 +239,50 @@ triangle_vertices paged_triangle_mesh::get_triangle_vertices(size_t mesh_idx, si
 }
 
 void paged_triangle_mesh::clear_cache() {
-    for (auto &node : m_cache) {
-        node.trimesh.reset();
+    auto lock = std::lock_guard(m_cache_mutex);
+
+    for (size_t i = 0; i < m_cache.size(); ++i) {
+        auto &node = m_cache[i];
+
+        if (node.trimesh) {
+            clock_erase(i);
+            node.trimesh.reset();
+            m_cache_num_vertices.fetch_sub(node.num_vertices, std::memory_order_relaxed);
+        }
     }
 }
 
 void paged_triangle_mesh::assign_mesh(size_t index, std::shared_ptr<triangle_mesh> mesh) {
     // Use lock to prevent assigning to the same trimesh shared_ptr concurrently
-    // if `unload_least_recently_visited_node` is executing in another thread.
-    auto lock = std::lock_guard(m_lru_mutex);
-    m_cache[index].trimesh = mesh;
+    // if `unload_node` is executing in another thread.
+    auto lock = std::lock_guard(m_cache_mutex);
+    auto &node = m_cache[index];
+
+    // Account for the new mesh and release the vertices reserved in
+    // `load_node_if_needed`, in this order to not wrap around zero.
+    if (mesh) {
+        m_cache_num_vertices.fetch_add(node.num_vertices, std::memory_order_relaxed);
+    }
+
+    if (m_is_loading_submesh[index].load(std::memory_order_relaxed)) {
+        m_cache_num_vertices.fetch_sub(node.num_vertices, std::memory_order_relaxed);
+    }
+
+    if (node.trimesh) {
+        clock_erase(index);
+        m_cache_num_vertices.fetch_sub(node.num_vertices, std::memory_order_relaxed);
+    }
+
+    if (mesh) {
+        clock_insert(index);
+        m_recently_visited[index].store(true, std::memory_order_relaxed);
+    } else {
+        // Loaders publish a null mesh if the data is invalid, which would
+        // fail again if reloaded.
+        node.load_failed = true;
+    }
+
+    node.trimesh = mesh;
     m_is_loading_submesh[index].store(false, std::memory_order_release);
 }
 
@@ -1,6 +1,5 @@
 #include "edyn/shapes/triangle_mesh.hpp"
 #include <limits>
-#include <set>
 
 namespace edyn {
 
@@ -26,7 +25,36 @@ void triangle_mesh::calculate_face_normals() {
 void triangle_mesh::init_edge_indices() {
     constexpr auto idx_max = std::numeric_limits<index_type>::max();
     m_face_edge_indices.resize(m_indices.size());
-    auto vertex_edge_indices = std::vector<std::set<index_type>>(m_vertices.size());
+
+    // Edges of each vertex are stored in a single array where each vertex
+    // has a range large enough to hold two edges for each face it belongs
+    // to, which avoids allocating one array per vertex.
+    auto vertex_edge_offsets = std::vector<index_type>(m_vertices.size() + 1, 0);
+
+    for (auto &indices : m_indices) {
+        for (auto idx : indices) {
+            vertex_edge_offsets[idx + 1] += 2;
+        }
+    }
+
+    for (size_t i = 1; i < vertex_edge_offsets.size(); ++i) {
+        vertex_edge_offsets[i] += vertex_edge_offsets[i - 1];
+    }
+
+    auto vertex_edge_indices = std::vector<index_type>(vertex_edge_offsets.back());
+    auto vertex_edge_counts = std::vector<index_type>(m_vertices.size(), 0);
+
+    auto add_vertex_edge = [&](index_type vertex_idx, index_type edge_idx) {
+        auto &count = vertex_edge_counts[vertex_idx];
+        vertex_edge_indices[vertex_edge_offsets[vertex_idx] + count] = edge_idx;
+        ++count;
+    };
+
+    // By Euler's formula, the number of edges in a mesh without holes is
+    // about the number of faces plus the number of vertices.
+    auto edge_count_estimate = m_indices.size() + m_vertices.size();
+    m_edge_vertex_indices.reserve(edge_count_estimate);
+    m_edge_face_indices.reserve(edge_count_estimate);
 
     for (size_t face_idx = 0; face_idx < m_indices.size(); ++face_idx) {
         auto indices = m_indices[face_idx];
@@ -38,9 +66,14 @@ void triangle_mesh::init_edge_indices() {
             auto pair = unordered_pair(i0, i1);
             auto edge_idx = SIZE_MAX;
 
-            for (size_t k = 0; k < m_edge_vertex_indices.size(); ++k) {
-                if (m_edge_vertex_indices[k] == pair) {
-                    edge_idx = k;
+            // An existing edge with these vertices must be among the edges
+            // of the first vertex, which avoids searching over all edges.
+            auto edges_begin = vertex_edge_indices.begin() + vertex_edge_offsets[i0];
+            auto edges_end = edges_begin + vertex_edge_counts[i0];
+
+            for (auto it = edges_begin; it != edges_end; ++it) {
+                if (m_edge_vertex_indices[*it] == pair) {
+                    edge_idx = *it;
                     break;
                 }
             }
@@ -49,10 +82,14 @@ void triangle_mesh::init_edge_indices() {
                 edge_idx = m_edge_vertex_indices.size();
                 m_edge_vertex_indices.push_back(pair);
                 m_edge_face_indices.push_back({idx_max, idx_max});
-            }
+                // Edges are numbered in order of creation, thus appending new
+                // edges keeps the edge indices of each vertex sorted.
+                add_vertex_edge(i0, edge_idx);
 
-            vertex_edge_indices[i0].insert(edge_idx);
-            vertex_edge_indices[i1].insert(edge_idx);
+                if (i1 != i0) {
+                    add_vertex_edge(i1, edge_idx);
+                }
+            }
 
             m_face_edge_indices[face_idx][i] = edge_idx;
 
@@ -66,11 +103,17 @@ void triangle_mesh::init_edge_indices() {
         }
     }
 
-    for (auto edge_indices : vertex_edge_indices) {
+    // Each edge is in the array of both of its vertices.
+    m_vertex_edge_indices.reserve_nested(m_vertices.size());
+    m_vertex_edge_indices.reserve_data(m_edge_vertex_indices.size() * 2);
+
+    for (size_t i = 0; i < m_vertices.size(); ++i) {
         m_vertex_edge_indices.push_array();
+        auto edges_begin = vertex_edge_indices.begin() + vertex_edge_offsets[i];
+        auto edges_end = edges_begin + vertex_edge_counts[i];
 
-        for (auto edge_idx : edge_indices) {
-            m_vertex_edge_indices.push_back(edge_idx);
+        for (auto it = edges_begin; it != edges_end; ++it) {
+            m_vertex_edge_indices.push_back(*it);
         }
     }
 
@@ -9,10 +9,10 @@
 #include "edyn/context/settings.hpp"
 #include "edyn/math/vector3.hpp"
 #include "edyn/util/island_util.hpp"
-#include "edyn/util/vector_util.hpp"
 #include "edyn/util/entt_util.hpp"
 #include <entt/entity/registry.hpp>
 #include <entt/entity/utility.hpp>
+#include <algorithm>
 #include <set>
 
 namespace edyn {
@@ -45,6 +45,13 @@ void island_manager::on_destroy_graph_node(entt::registry &registry, entt::entit
     auto &node = registry.get<graph_node>(entity);
     auto &graph = registry.ctx().at<entity_graph>();
 
+    // Neighbors could end up in separate islands.
+    if (graph.is_connecting_node(node.node_index)) {
+        graph.visit_neighbors(node.node_index, [&](entt::entity neighbor) {
+            m_split_seed_nodes.push_back(neighbor);
+        });
+    }
+
     graph.visit_edges(node.node_index, [&](auto edge_index) {
         auto edge_entity = graph.edge_entity(edge_index);
         registry.destroy(edge_entity);
@@ -60,6 +67,9 @@ void island_manager::on_destroy_graph_node(entt::registry &registry, entt::entit
 void island_manager::on_destroy_graph_edge(entt::registry &registry, entt::entity entity) {
     auto &graph = registry.ctx().at<entity_graph>();
     auto &edge = registry.get<graph_edge>(entity);
+    auto node_entities = graph.edge_node_entities(edge.edge_index);
+    m_split_seed_nodes.push_back(node_entities.first);
+    m_split_seed_nodes.push_back(node_entities.second);
     graph.remove_edge(edge.edge_index);
 }
 
@@ -76,9 +86,19 @@ void island_manager::on_destroy_island_resident(entt::registry &registry, entt::
         island.nodes.erase(entity);
     } else if (island.edges.contains(entity)) {
         island.edges.erase(entity);
+
+        // A non-procedural node leaves the island along with its last edge
+        // in it, which does not cause a split.
+        auto node_entity = erase_non_procedural_edge(entity, resident.island_entity);
+        m_edge_non_procedural_nodes.erase(entity);
+
+        if (node_entity != entt::null) {
+            remove_non_procedural_node(node_entity, resident.island_entity);
+        }
     }
 
-    // Island could have been split.
+    // Island could now be empty. Splits are handled separately starting
+    // at the nodes of destroyed edges.
     if (!m_islands_to_split.contains(resident.island_entity)) {
         m_islands_to_split.emplace(resident.island_entity);
     }
@@ -95,6 +115,7 @@ void island_manager::on_destroy_multi_island_resident(entt::registry &registry,
     for (auto island_entity : resident.island_entities) {
         auto [island] = island_view.get(island_entity);
         island.nodes.erase(entity);
+        m_non_procedural_edge_counts.erase(entity_pair{entity, island_entity});
 
         // Non-procedural entities do not form islands thus there's no need to
         // check whether this island was split by its removal. It is necessary
@@ -146,9 +167,12 @@ void island_manager::init_new_nodes_and_edges() {
 
     if (procedural_node_indices.empty()) return;
 
-    std::vector<entt::entity> connected_nodes;
+    // Sets are used for nodes and islands since non-procedural nodes and
+    // islands are reached multiple times, e.g. a static ground touching many
+    // islands.
+    entt::sparse_set connected_nodes;
     std::vector<entt::entity> connected_edges;
-    std::vector<entt::entity> island_entities;
+    entt::sparse_set island_entities;
     auto resident_view = m_registry->view<const island_resident>();
     auto procedural_view = m_registry->view<procedural_tag>();
 
@@ -160,7 +184,7 @@ void island_manager::init_new_nodes_and_edges() {
             auto [resident] = resident_view.get(entity);
 
             if (resident.island_entity == entt::null) {
-                connected_nodes.push_back(entity);
+                connected_nodes.emplace(entity);
             }
         },
         [&](entt::entity entity) { // visit_edge_func
@@ -168,12 +192,8 @@ void island_manager::init_new_nodes_and_edges() {
 
             if (resident.island_entity == entt::null) {
                 connected_edges.push_back(entity);
-            } else {
-                auto contains_island = vector_contains(island_entities, resident.island_entity);
-
-                if (!contains_island) {
-                    island_entities.push_back(resident.island_entity);
-                }
+            } else if (!island_entities.contains(resident.island_entity)) {
+                island_entities.emplace(resident.island_entity);
             }
         },
         [&](entity_graph::index_type node_index) { // should_visit_func
@@ -182,8 +202,8 @@ void island_manager::init_new_nodes_and_edges() {
             // Do not visit non-procedural nodes.
             if (!procedural_view.contains(other_entity)) {
                 // However, add them to the island.
-                if (!vector_contains(connected_nodes, other_entity)) {
-                    connected_nodes.push_back(other_entity);
+                if (!connected_nodes.contains(other_entity)) {
+                    connected_nodes.emplace(other_entity);
                 }
 
                 return false;
@@ -196,11 +216,9 @@ void island_manager::init_new_nodes_and_edges() {
                 return true;
             }
 
-            auto contains_island = vector_contains(island_entities, other_resident.island_entity);
-
             // Collect islands involved in this connected component.
-            if (!contains_island) {
-                island_entities.push_back(other_resident.island_entity);
+            if (!island_entities.contains(other_resident.island_entity)) {
+                island_entities.emplace(other_resident.island_entity);
             }
 
             bool continue_visiting = false;
@@ -223,7 +241,7 @@ void island_manager::init_new_nodes_and_edges() {
                 if (island_entities.empty()) {
                     island_entity = create_island();
                 } else {
-                    island_entity = island_entities.front();
+                    island_entity = *island_entities.begin();
                 }
 
                 insert_to_island(island_entity, connected_nodes, connected_edges);
@@ -247,7 +265,7 @@ entt::entity island_manager::create_island() {
 }
 
 void island_manager::insert_to_island(entt::entity island_entity,
-                                      const std::vector<entt::entity> &nodes,
+                                      const entt::sparse_set &nodes,
                                       const std::vector<entt::entity> &edges) {
     auto resident_view = m_registry->view<island_resident>();
     auto multi_resident_view = m_registry->view<multi_island_resident>();
@@ -279,6 +297,7 @@ void island_manager::insert_to_island(entt::entity island_entity,
             resident.island_entity = island_entity;
         });
         m_registry->remove<sleeping_tag>(entity);
+        insert_non_procedural_edge(entity, island_entity);
     }
 
     island.edges.insert(edges.begin(), edges.end());
@@ -286,9 +305,9 @@ void island_manager::insert_to_island(entt::entity island_entity,
     wake_up_island(*m_registry, island_entity);
 }
 
-void island_manager::merge_islands(const std::vector<entt::entity> &island_entities,
-                                   const std::vector<entt::entity> &new_nodes,
-                                   const std::vector<entt::entity> &new_edges) {
+void island_manager::merge_islands(const entt::sparse_set &island_entities,
+                                   entt::sparse_set &nodes,
+                                   std::vector<entt::entity> &edges) {
     EDYN_ASSERT(island_entities.size() > 1);
 
     // Pick biggest island and move the other entities into it.
@@ -308,33 +327,100 @@ void island_manager::merge_islands(const std::vector<entt::entity> &island_entit
 
     EDYN_ASSERT(island_entity != entt::null);
 
-    auto other_island_entities = island_entities;
-    vector_erase(other_island_entities, island_entity);
+    auto other_island_entities = std::vector<entt::entity>{};
+    other_island_entities.reserve(island_entities.size() - 1);
 
-    auto all_nodes = new_nodes;
-    auto all_edges = new_edges;
+    for (auto entity : island_entities) {
+        if (entity != island_entity) {
+            other_island_entities.push_back(entity);
+        }
+    }
+
+    auto multi_resident_view = m_registry->view<multi_island_resident>();
 
     for (auto other_island_entity : other_island_entities) {
         auto &island = island_view.get<edyn::island>(other_island_entity);
-        all_edges.insert(all_edges.end(), island.edges.begin(), island.edges.end());
+        edges.insert(edges.end(), island.edges.begin(), island.edges.end());
+
+        // Edge counts are moved into the destination island when the edges
+        // are inserted into it.
+        for (auto entity : island.edges) {
+            erase_non_procedural_edge(entity, other_island_entity);
+        }
 
         // There could be duplicate nodes since non-procedural entities can be
         // in more than one island.
         for (auto entity : island.nodes) {
-            if (!vector_contains(all_nodes, entity)) {
-                all_nodes.push_back(entity);
+            if (!nodes.contains(entity)) {
+                nodes.emplace(entity);
+            }
+
+            // Only the non-procedural entities in the islands being destroyed
+            // refer to them, thus there's no need to visit all residents.
+            if (multi_resident_view.contains(entity)) {
+                auto [resident] = multi_resident_view.get(entity);
+                resident.island_entities.remove(other_island_entity);
             }
         }
     }
 
-    insert_to_island(island_entity, all_nodes, all_edges);
+    insert_to_island(island_entity, nodes, edges);
 
     // Destroy empty islands.
     m_registry->destroy(other_island_entities.begin(), other_island_entities.end());
+}
 
-    // Remove destroyed islands from residents.
-    for (auto [entity, resident] : m_registry->view<multi_island_resident>().each()) {
-        resident.island_entities.remove(other_island_entities.begin(), other_island_entities.end());
+void island_manager::insert_non_procedural_edge(entt::entity edge_entity, entt::entity island_entity) {
+    auto it = m_edge_non_procedural_nodes.find(edge_entity);
+
+    if (it == m_edge_non_procedural_nodes.end()) {
+        auto &graph = m_registry->ctx().at<entity_graph>();
+        auto &edge = m_registry->get<graph_edge>(edge_entity);
+        auto node_entities = graph.edge_node_entities(edge.edge_index);
+        auto procedural_view = m_registry->view<procedural_tag>();
+        auto node_entity = entt::entity{entt::null};
+
+        if (!procedural_view.contains(node_entities.first)) {
+            node_entity = node_entities.first;
+        } else if (!procedural_view.contains(node_entities.second)) {
+            node_entity = node_entities.second;
+        } else {
+            return;
+        }
+
+        it = m_edge_non_procedural_nodes.emplace(edge_entity, node_entity).first;
+    }
+
+    ++m_non_procedural_edge_counts[entity_pair{it->second, island_entity}];
+}
+
+entt::entity island_manager::erase_non_procedural_edge(entt::entity edge_entity, entt::entity island_entity) {
+    auto it = m_edge_non_procedural_nodes.find(edge_entity);
+
+    if (it == m_edge_non_procedural_nodes.end()) {
+        return entt::null;
+    }
+
+    auto count_it = m_non_procedural_edge_counts.find(entity_pair{it->second, island_entity});
+
+    if (count_it == m_non_procedural_edge_counts.end() || --count_it->second > 0) {
+        return entt::null;
+    }
+
+    m_non_procedural_edge_counts.erase(count_it);
+    return it->second;
+}
+
+void island_manager::remove_non_procedural_node(entt::entity node_entity, entt::entity island_entity) {
+    auto &island = m_registry->get<edyn::island>(island_entity);
+
+    if (island.nodes.contains(node_entity)) {
+        island.nodes.remove(node_entity);
+    }
+
+    if (auto *resident = m_registry->try_get<multi_island_resident>(node_entity);
+        resident && resident->island_entities.contains(island_entity)) {
+        resident->island_entities.remove(island_entity);
     }
 }
 
@@ -345,15 +431,9 @@ void island_manager::split_islands() {
         }
     }
 
-    if (m_islands_to_split.empty()) return;
-
-    auto island_view = m_registry->view<island, island_AABB>();
-    auto node_view = m_registry->view<graph_node>();
+    auto island_view = m_registry->view<island>();
     auto multi_resident_view = m_registry->view<multi_island_resident>();
-    auto aabb_view = m_registry->view<AABB>();
     auto procedural_view = m_registry->view<procedural_tag>();
-    auto disabled_view = m_registry->view<disabled_tag>();
-    auto &graph = m_registry->ctx().at<entity_graph>();
 
     for (auto source_island_entity : m_islands_to_split) {
         auto &source_island = island_view.get<edyn::island>(source_island_entity);
@@ -373,142 +453,145 @@ void island_manager::split_islands() {
             }
 
             m_registry->destroy(source_island_entity);
-            continue;
         }
+    }
 
-        auto all_nodes = entt::sparse_set{};
-        all_nodes.insert(source_island.nodes.begin(), source_island.nodes.end());
-        std::vector<edyn::island> islands;
+    m_islands_to_split.clear();
 
-        while (!all_nodes.empty()) {
-            auto start_node_entity = *all_nodes.begin();
+    if (m_split_seed_nodes.empty()) return;
 
-            if (!procedural_view.contains(start_node_entity)) {
-                all_nodes.erase(start_node_entity);
-                continue;
-            }
+    // Group seed nodes by the island they're currently in. Islands could have
+    // been merged since the edges were destroyed. Only procedural nodes
+    // connect islands thus other nodes can be ignored.
+    auto resident_view = m_registry->view<island_resident, graph_node, procedural_tag>();
+    auto seeds = std::vector<std::pair<entt::entity, entt::entity>>{};
 
-            auto start_node_index = node_view.get<graph_node>(start_node_entity).node_index;
-            auto &curr_island = islands.emplace_back();
-
-            graph.traverse(start_node_index,
-                [&](auto node_index) {
-                    // Add node to island and assign island to resident.
-                    auto node_entity = graph.node_entity(node_index);
-                    curr_island.nodes.emplace(node_entity);
-
-                    // Remove visited entity from list of entities to be visited.
-                    all_nodes.remove(node_entity);
-                }, [&](auto edge_index) {
-                    auto edge_entity = graph.edge_entity(edge_index);
-                    curr_island.edges.emplace(edge_entity);
-                });
+    for (auto entity : m_split_seed_nodes) {
+        if (!m_registry->valid(entity) || !resident_view.contains(entity)) {
+            continue;
         }
 
-        EDYN_ASSERT(!islands.empty());
+        auto &resident = resident_view.get<island_resident>(entity);
 
-        if (islands.size() == 1) {
-            // Island is a single connected component in the entity graph.
-            continue;
+        if (resident.island_entity != entt::null) {
+            seeds.emplace_back(resident.island_entity, entity);
         }
+    }
 
-        // Find biggest island among all and move that into the original as to
-        // minimize the amount of changes.
-        unsigned biggest_size = 0;
-        unsigned biggest_idx = 0;
+    m_split_seed_nodes.clear();
 
-        for (unsigned i = 0; i < islands.size(); ++i) {
-            auto &island = islands[i];
+    std::sort(seeds.begin(), seeds.end());
+    seeds.erase(std::unique(seeds.begin(), seeds.end()), seeds.end());
 
-            if (island.nodes.size() > biggest_size) {
-                biggest_size = island.nodes.size();
-                biggest_idx = i;
-            }
+    auto island_seeds = std::vector<entt::entity>{};
+
+    for (size_t i = 0; i < seeds.size();) {
+        auto island_entity = seeds[i].first;
+        island_seeds.clear();
+
+        for (; i < seeds.size() && seeds[i].first == island_entity; ++i) {
+            island_seeds.push_back(seeds[i].second);
         }
 
-        source_island = std::move(islands[biggest_idx]);
-        // swap with last and pop.
-        islands[biggest_idx] = std::move(islands.back());
-        islands.pop_back();
+        // A split requires at least two nodes that were connected.
+        if (island_seeds.size() > 1) {
+            split_island(island_entity, island_seeds);
+        }
+    }
+}
 
-        remove_sleeping_tag_from_island(*m_registry, source_island_entity, source_island);
-        const bool disabled = disabled_view.contains(source_island_entity);
+void island_manager::split_island(entt::entity source_island_entity, const std::vector<entt::entity> &seed_nodes) {
+    auto node_view = m_registry->view<graph_node>();
+    auto multi_resident_view = m_registry->view<multi_island_resident>();
+    auto aabb_view = m_registry->view<AABB>();
+    auto procedural_view = m_registry->view<procedural_tag>();
+    auto disabled_view = m_registry->view<disabled_tag>();
+    auto &graph = m_registry->ctx().at<entity_graph>();
 
-        /* Update island AABB. */ {
-            auto is_first_node = true;
-            auto &island_aabb = island_view.get<island_AABB>(source_island_entity);
+    auto node_indices = std::vector<entity_graph::index_type>{};
+    node_indices.reserve(seed_nodes.size());
 
-            for (auto entity : source_island.nodes) {
-                if (procedural_view.contains(entity) && aabb_view.contains(entity)) {
-                    auto [node_aabb] = aabb_view.get(entity);
-
-                    if (is_first_node) {
-                        island_aabb = {node_aabb};
-                        is_first_node = false;
-                    } else {
-                        island_aabb = {enclosing_aabb(island_aabb, node_aabb)};
-                    }
-                }
+    for (auto entity : seed_nodes) {
+        node_indices.push_back(node_view.get<graph_node>(entity).node_index);
+    }
+
+    // Only the components that are separated from the rest of the island
+    // are visited and moved into new islands, thus the cost is proportional
+    // to their size instead of the size of the island. The source island is
+    // woken up in the same update thus its AABB will be recalculated.
+    auto components = graph.split_components(node_indices);
+
+    if (components.empty()) {
+        return;
+    }
+
+    remove_sleeping_tag_from_island(*m_registry, source_island_entity,
+                                    m_registry->get<edyn::island>(source_island_entity));
+    const bool disabled = disabled_view.contains(source_island_entity);
+
+    for (auto &component : components) {
+        auto island_entity_new = m_registry->create();
+        auto &island_new = m_registry->emplace<edyn::island>(island_entity_new);
+        auto &aabb = m_registry->emplace<island_AABB>(island_entity_new);
+        // Get source island after emplacing the new one since references
+        // could be invalidated.
+        auto &source_island = m_registry->get<edyn::island>(source_island_entity);
+        auto is_first_node = true;
+
+        for (auto node_entity : component.nodes) {
+            island_new.nodes.emplace(node_entity);
+
+            if (!procedural_view.contains(node_entity)) {
+                auto [resident] = multi_resident_view.get(node_entity);
+                resident.island_entities.emplace(island_entity_new);
+                continue;
             }
-        }
 
-        for (auto &other_island : islands) {
-            auto island_entity_new = m_registry->create();
-            auto &island_new = m_registry->emplace<edyn::island>(island_entity_new, std::move(other_island));
-            auto &aabb = m_registry->emplace<island_AABB>(island_entity_new);
-            auto is_first_node = true;
+            source_island.nodes.remove(node_entity);
+            m_registry->patch<island_resident>(node_entity, [island_entity_new](island_resident &resident) {
+                resident.island_entity = island_entity_new;
+            });
 
-            for (auto node_entity : island_new.nodes) {
-                bool is_procedural = procedural_view.contains(node_entity);
+            // Update island AABB by uniting all AABBs of all
+            // procedural entities.
+            if (aabb_view.contains(node_entity)) {
+                auto [node_aabb] = aabb_view.get(node_entity);
 
-                if (is_procedural) {
-                    m_registry->patch<island_resident>(node_entity, [island_entity_new](island_resident &resident) {
-                        resident.island_entity = island_entity_new;
-                    });
+                if (is_first_node) {
+                    aabb = {node_aabb};
+                    is_first_node = false;
                 } else {
-                    auto [resident] = multi_resident_view.get(node_entity);
-                    resident.island_entities.emplace(island_entity_new);
-
-                    // Remove the original island if this non-procedural entity
-                    // is not contained in it anymore.
-                    auto &original_island = m_registry->get<edyn::island>(source_island_entity);
-                    if (!original_island.nodes.contains(node_entity)) {
-                        resident.island_entities.remove(source_island_entity);
-                    }
-                }
-
-                // Update island AABB by uniting all AABBs of all
-                // procedural entities.
-                if (is_procedural && aabb_view.contains(node_entity)) {
-                    auto [node_aabb] = aabb_view.get(node_entity);
-
-                    if (is_first_node) {
-                        aabb = {node_aabb};
-                        is_first_node = false;
-                    } else {
-                        aabb = {enclosing_aabb(aabb, node_aabb)};
-                    }
+                    aabb = {enclosing_aabb(aabb, node_aabb)};
                 }
             }
+        }
+
+        for (auto edge_entity : component.edges) {
+            island_new.edges.emplace(edge_entity);
+            source_island.edges.remove(edge_entity);
+            m_registry->patch<island_resident>(edge_entity, [island_entity_new](island_resident &resident) {
+                resident.island_entity = island_entity_new;
+            });
 
-            for (auto edge_entity : island_new.edges) {
-                m_registry->patch<island_resident>(edge_entity, [island_entity_new](island_resident &resident) {
-                    resident.island_entity = island_entity_new;
-                });
+            // Remove the source island from non-procedural entities which
+            // are not connected to any procedural entity that remained in it.
+            auto node_entity = erase_non_procedural_edge(edge_entity, source_island_entity);
+            insert_non_procedural_edge(edge_entity, island_entity_new);
+
+            if (node_entity != entt::null) {
+                remove_non_procedural_node(node_entity, source_island_entity);
             }
+        }
 
-            remove_sleeping_tag_from_island(*m_registry, island_entity_new, island_new);
+        remove_sleeping_tag_from_island(*m_registry, island_entity_new, island_new);
 
-            m_registry->emplace<island_tag>(island_entity_new);
+        m_registry->emplace<island_tag>(island_entity_new);
 
-            // Inherit disabled status.
-            if (disabled) {
-                m_registry->emplace<disabled_tag>(island_entity_new);
-            }
+        // Inherit disabled status.
+        if (disabled) {
+            m_registry->emplace<disabled_tag>(island_entity_new);
         }
     }
-
-    m_islands_to_split.clear();
 }
 
 void island_manager::wake_up_islands() {
@@ -42,6 +42,7 @@
 #include "edyn/replication/registry_operation.hpp"
 #include "edyn/replication/registry_operation_builder.hpp"
 #include "edyn/context/settings.hpp"
+#include "edyn/context/profile.hpp"
 #include "edyn/context/registry_operation_context.hpp"
 #include "edyn/networking/extrapolation/extrapolation_result.hpp"
 #include <entt/entity/registry.hpp>
@@ -54,6 +55,7 @@ simulation_worker::simulation_worker(const settings &settings,
                                      const registry_operation_context &reg_op_ctx,
                                      const material_mix_table &material_table)
     : m_raycast_service(m_registry)
+    , m_shape_cast_service(m_registry)
     , m_island_manager(m_registry)
     , m_poly_initializer(m_registry)
     , m_solver(m_registry)
@@ -71,6 +73,7 @@ simulation_worker::simulation_worker(const settings &settings,
         msg::apply_network_pools,
         msg::wake_up_residents,
         msg::raycast_request,
+        msg::shape_cast_request,
         msg::query_aabb_request,
         msg::query_aabb_of_interest_request,
         extrapolation_result>("worker"))
@@ -105,6 +108,7 @@ void simulation_worker::init() {
     m_message_queue.sink<msg::set_registry_operation_context>().connect<&simulation_worker::on_set_reg_op_ctx>(*this);
     m_message_queue.sink<msg::set_material_table>().connect<&simulation_worker::on_set_material_table>(*this);
     m_message_queue.sink<msg::raycast_request>().connect<&simulation_worker::on_raycast_request>(*this);
+    m_message_queue.sink<msg::shape_cast_request>().connect<&simulation_worker::on_shape_cast_request>(*this);
     m_message_queue.sink<msg::query_aabb_request>().connect<&simulation_worker::on_query_aabb_request>(*this);
     m_message_queue.sink<msg::query_aabb_of_interest_request>().connect<&simulation_worker::on_query_aabb_of_interest_request>(*this);
     m_message_queue.sink<msg::apply_network_pools>().connect<&simulation_worker::on_apply_network_pools>(*this);
@@ -267,10 +271,16 @@ void simulation_worker::wake_up_affected_islands(const registry_operation &ops)
 }
 
 void simulation_worker::sync() {
-    if (!m_op_builder->empty()) {
+    auto stats = std::vector<step_stats>{};
+
+#ifdef EDYN_ENABLE_PROFILING
+    stats = internal::take_step_stats(m_registry);
+#endif
+
+    if (!m_op_builder->empty() || !stats.empty()) {
         auto &&ops = std::move(m_op_builder->finish());
         message_dispatcher::global().send<msg::step_update>(
-            {"main"}, m_message_queue.identifier, std::move(ops), m_sim_time);
+            {"main"}, m_message_queue.identifier, std::move(ops), m_sim_time, std::move(stats));
     }
 }
 
@@ -295,6 +305,8 @@ void simulation_worker::update() {
     m_message_queue.update();
     m_raycast_service.update(true);
     consume_raycast_results();
+    m_shape_cast_service.update(true);
+    consume_shape_cast_results();
 
     if (m_paused) {
         m_island_manager.update(m_last_time);
@@ -329,11 +341,27 @@ void simulation_worker::update() {
             (*settings.pre_step_callback)(m_registry);
         }
 
-        bphase.update(true);
-        m_island_manager.update(m_sim_time);
-        nphase.update(true);
+        EDYN_PROFILE_BEGIN_STEP(m_registry, m_sim_time);
+
+        {
+            EDYN_PROFILE_SCOPE(m_registry, profile_stage::broadphase);
+            bphase.update(true);
+        }
+
+        {
+            EDYN_PROFILE_SCOPE(m_registry, profile_stage::island_manager);
+            m_island_manager.update(m_sim_time);
+        }
+
+        {
+            EDYN_PROFILE_SCOPE(m_registry, profile_stage::narrowphase);
+            nphase.update(true);
+        }
+
         m_solver.update(true);
 
+        EDYN_PROFILE_END_STEP(m_registry);
+
         m_sim_time += fixed_dt;
 
         if (settings.clear_actions_func) {
@@ -387,6 +415,14 @@ void simulation_worker::consume_raycast_results() {
     });
 }
 
+void simulation_worker::consume_shape_cast_results() {
+    auto &dispatcher = message_dispatcher::global();
+    m_shape_cast_service.consume_results([&](unsigned id, shape_cast_result &result) {
+        dispatcher.send<msg::shape_cast_response>(
+            {"main"}, m_message_queue.identifier, id, result);
+    });
+}
+
 void simulation_worker::mark_transforms_replaced() {
     auto body_view = m_registry.view<position, orientation, linvel, angvel, dynamic_tag>(exclude_sleeping_disabled);
     m_op_builder->replace<position>(body_view.begin(), body_view.end());
@@ -419,11 +455,28 @@ void simulation_worker::on_step_simulation(message<msg::step_simulation> &) {
     }
 
     m_poly_initializer.init_new_shapes();
-    bphase.update(true);
-    m_island_manager.update(m_last_time);
-    nphase.update(true);
+
+    EDYN_PROFILE_BEGIN_STEP(m_registry, m_sim_time);
+
+    {
+        EDYN_PROFILE_SCOPE(m_registry, profile_stage::broadphase);
+        bphase.update(true);
+    }
+
+    {
+        EDYN_PROFILE_SCOPE(m_registry, profile_stage::island_manager);
+        m_island_manager.update(m_last_time);
+    }
+
+    {
+        EDYN_PROFILE_SCOPE(m_registry, profile_stage::narrowphase);
+        nphase.update(true);
+    }
+
     m_solver.update(true);
 
+    EDYN_PROFILE_END_STEP(m_registry);
+
     if (settings.clear_actions_func) {
         (*settings.clear_actions_func)(m_registry);
     }
@@ -480,6 +533,20 @@ void simulation_worker::on_raycast_request(message<msg::raycast_request> &msg) {
     m_raycast_service.add_ray(msg.content.p0, msg.content.p1, msg.content.id, ignore_entities);
 }
 
+void simulation_worker::on_shape_cast_request(message<msg::shape_cast_request> &msg) {
+    auto &request = msg.content;
+    auto ignore_entities = std::vector<entt::entity>{};
+
+    for (auto remote_entity : request.ignore_entities) {
+        if (m_entity_map.contains(remote_entity)) {
+            ignore_entities.push_back(m_entity_map.at(remote_entity));
+        }
+    }
+
+    m_shape_cast_service.add_cast(request.shape, request.orn, request.p0, request.p1,
+                                  request.id, ignore_entities);
+}
+
 void simulation_worker::on_query_aabb_request(message<msg::query_aabb_request> &msg) {
     auto &bphase = m_registry.ctx().at<broadphase>();
     auto &request = msg.content;
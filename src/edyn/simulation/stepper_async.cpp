@@ -16,6 +16,7 @@
 #include "edyn/comp/graph_edge.hpp"
 #include "edyn/replication/registry_operation.hpp"
 #include "edyn/context/settings.hpp"
+#include "edyn/context/profile.hpp"
 #include "edyn/dynamics/material_mixing.hpp"
 #include <entt/entity/registry.hpp>
 #include <numeric>
@@ -28,6 +29,7 @@ stepper_async::stepper_async(entt::registry &registry, double time)
         message_dispatcher::global().make_queue<
             msg::step_update,
             msg::raycast_response,
+            msg::shape_cast_response,
             msg::query_aabb_response
         >("main"))
     , m_worker(registry.ctx().at<settings>(),
@@ -44,6 +46,7 @@ stepper_async::stepper_async(entt::registry &registry, double time)
 
     m_message_queue_handle.sink<msg::step_update>().connect<&stepper_async::on_step_update>(*this);
     m_message_queue_handle.sink<msg::raycast_response>().connect<&stepper_async::on_raycast_response>(*this);
+    m_message_queue_handle.sink<msg::shape_cast_response>().connect<&stepper_async::on_shape_cast_response>(*this);
     m_message_queue_handle.sink<msg::query_aabb_response>().connect<&stepper_async::on_query_aabb_response>(*this);
 
     auto &reg_op_ctx = m_registry->ctx().at<registry_operation_context>();
@@ -115,6 +118,10 @@ void stepper_async::on_step_update(message<msg::step_update> &msg) {
 
     m_sim_time = msg.content.timestamp;
 
+#ifdef EDYN_ENABLE_PROFILING
+    internal::push_step_stats(registry, msg.content.stats);
+#endif
+
     // Insert entity mappings for new entities into the current op.
     for (auto remote_entity : ops.create_entities) {
         if (m_entity_map.contains(remote_entity)) {
@@ -191,6 +198,23 @@ void stepper_async::on_raycast_response(message<msg::raycast_response> &msg) {
     m_raycast_ctx.erase(response.id);
 }
 
+void stepper_async::on_shape_cast_response(message<msg::shape_cast_response> &msg) {
+    auto &response = msg.content;
+    auto result = response.result;
+
+    if (result.entity != entt::null) {
+        if (m_entity_map.contains(result.entity)) {
+            result.entity = m_entity_map.at(result.entity);
+        } else {
+            result.entity = entt::null;
+        }
+    }
+
+    auto &ctx = m_shape_cast_ctx.at(response.id);
+    ctx.delegate(response.id, result);
+    m_shape_cast_ctx.erase(response.id);
+}
+
 void stepper_async::on_query_aabb_response(message<msg::query_aabb_response> &msg) {
     auto &response = msg.content;
     auto result = query_aabb_result{};
@@ -338,6 +362,18 @@ raycast_id_type stepper_async::raycast(vector3 p0, vector3 p1,
     return id;
 }
 
+shape_cast_id_type stepper_async::shape_cast(const cast_shapes_variant_t &shape, const quaternion &orn,
+                                             vector3 p0, vector3 p1,
+                                             const shape_cast_delegate_type &delegate,
+                                             std::vector<entt::entity> ignore_entities) {
+    auto id = m_next_shape_cast_id++;
+    auto &ctx = m_shape_cast_ctx[id];
+    ctx.delegate = delegate;
+    send_message_to_worker<msg::shape_cast_request>(id, shape, orn, p0, p1, ignore_entities);
+
+    return id;
+}
+
 query_aabb_id_type stepper_async::query_aabb(const AABB &aabb,
                                              const query_aabb_delegate_type &delegate,
                                              bool query_procedural,
@@ -1,6 +1,7 @@
 #include "edyn/simulation/stepper_sequential.hpp"
 #include "edyn/collision/contact_event_emitter.hpp"
 #include "edyn/context/settings.hpp"
+#include "edyn/context/profile.hpp"
 #include "edyn/collision/broadphase.hpp"
 #include "edyn/collision/contact_manifold_map.hpp"
 #include "edyn/collision/narrowphase.hpp"
@@ -63,12 +64,28 @@ void stepper_sequential::update(double time) {
             (*settings.pre_step_callback)(*m_registry);
         }
 
-        bphase.update(m_multithreaded);
-        m_island_manager.update(step_time);
-        nphase.update(m_multithreaded);
+        EDYN_PROFILE_BEGIN_STEP(*m_registry, step_time);
+
+        {
+            EDYN_PROFILE_SCOPE(*m_registry, profile_stage::broadphase);
+            bphase.update(m_multithreaded);
+        }
+
+        {
+            EDYN_PROFILE_SCOPE(*m_registry, profile_stage::island_manager);
+            m_island_manager.update(step_time);
+        }
+
+        {
+            EDYN_PROFILE_SCOPE(*m_registry, profile_stage::narrowphase);
+            nphase.update(m_multithreaded);
+        }
+
         m_solver.update(m_multithreaded);
         emitter.consume_events();
 
+        EDYN_PROFILE_END_STEP(*m_registry);
+
         if (settings.clear_actions_func) {
             (*settings.clear_actions_func)(*m_registry);
         }
@@ -78,6 +95,10 @@ void stepper_sequential::update(double time) {
         }
     }
 
+#ifdef EDYN_ENABLE_PROFILING
+    internal::publish_step_stats(*m_registry);
+#endif
+
     m_last_time = time;
     update_presentation(*m_registry, get_simulation_timestamp(), time, elapsed, fixed_dt);
 }
@@ -97,12 +118,29 @@ void stepper_sequential::step_simulation(double time) {
     }
 
     m_poly_initializer.init_new_shapes();
-    bphase.update(m_multithreaded);
-    m_island_manager.update(m_last_time);
-    nphase.update(m_multithreaded);
+
+    EDYN_PROFILE_BEGIN_STEP(*m_registry, m_last_time);
+
+    {
+        EDYN_PROFILE_SCOPE(*m_registry, profile_stage::broadphase);
+        bphase.update(m_multithreaded);
+    }
+
+    {
+        EDYN_PROFILE_SCOPE(*m_registry, profile_stage::island_manager);
+        m_island_manager.update(m_last_time);
+    }
+
+    {
+        EDYN_PROFILE_SCOPE(*m_registry, profile_stage::narrowphase);
+        nphase.update(m_multithreaded);
+    }
+
     m_solver.update(m_multithreaded);
     emitter.consume_events();
 
+    EDYN_PROFILE_END_STEP(*m_registry);
+
     if (settings.clear_actions_func) {
         (*settings.clear_actions_func)(*m_registry);
     }
@@ -110,6 +148,10 @@ void stepper_sequential::step_simulation(double time) {
     if (settings.post_step_callback) {
         (*settings.post_step_callback)(*m_registry);
     }
+
+#ifdef EDYN_ENABLE_PROFILING
+    internal::publish_step_stats(*m_registry);
+#endif
 }
 
 void stepper_sequential::set_paused(bool paused) {
@@ -7,27 +7,12 @@
 #include "edyn/comp/island.hpp"
 #include "edyn/util/aabb_util.hpp"
 #include "edyn/util/island_util.hpp"
+#include "edyn/util/entt_util.hpp"
+#include "edyn/parallel/parallel_for.hpp"
 #include <entt/entity/registry.hpp>
 
 namespace edyn {
 
-template<typename ShapeType>
-AABB updated_aabb(const ShapeType &shape, const vector3 &pos, const quaternion &orn) {
-    return shape_aabb(shape, pos, orn);
-}
-
-template<>
-AABB updated_aabb(const polyhedron_shape &polyhedron,
-                  const vector3 &pos, const quaternion &orn) {
-    // `shape_aabb(const polyhedron_shape &, ...)` rotates each vertex of a
-    // polyhedron to calculate the AABB. Specialize `updated_aabb` for
-    // polyhedrons to use the rotated mesh.
-    auto aabb = point_cloud_aabb(polyhedron.rotated->vertices);
-    aabb.min += pos;
-    aabb.max += pos;
-    return aabb;
-}
-
 template<typename ShapeType, typename TransformView, typename OriginView>
 void update_aabb(entt::entity entity, ShapeType &shape, TransformView &tr_view,
                  OriginView &origin_view) {
@@ -68,12 +53,13 @@ void update_aabbs(entt::registry &registry) {
     update_aabbs(registry, dynamic_shapes_tuple);
 }
 
-void update_island_aabbs(entt::registry &registry) {
+void update_island_aabbs(entt::registry &registry, bool mt) {
     auto aabb_view = registry.view<AABB>();
     auto procedural_view = registry.view<procedural_tag>();
+    auto island_view = registry.view<island, island_AABB>(exclude_sleeping_disabled);
 
-    registry.view<island, island_AABB>(exclude_sleeping_disabled)
-        .each([&](island &island, island_AABB &aabb) {
+    auto for_loop_body = [aabb_view, procedural_view, island_view](entt::entity island_entity) {
+        auto [island, aabb] = island_view.get(island_entity);
         auto is_first_node = true;
 
         for (auto entity : island.nodes) {
@@ -90,7 +76,18 @@ void update_island_aabbs(entt::registry &registry) {
                 aabb = {enclosing_aabb(aabb, node_aabb)};
             }
         }
-    });
+    };
+
+    const size_t max_sequential_size = 64;
+
+    if (mt && calculate_view_size(island_view) > max_sequential_size) {
+        auto &dispatcher = job_dispatcher::global();
+        parallel_for_each(dispatcher, island_view.begin(), island_view.end(), for_loop_body);
+    } else {
+        for (auto island_entity : island_view) {
+            for_loop_body(island_entity);
+        }
+    }
 }
 
 }
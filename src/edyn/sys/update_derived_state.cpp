@@ -0,0 +1,98 @@
+#include "edyn/sys/update_derived_state.hpp"
+#include "edyn/sys/update_aabbs.hpp"
+#include "edyn/sys/update_rotated_meshes.hpp"
+#include "edyn/comp/aabb.hpp"
+#include "edyn/comp/center_of_mass.hpp"
+#include "edyn/comp/inertia.hpp"
+#include "edyn/comp/origin.hpp"
+#include "edyn/comp/orientation.hpp"
+#include "edyn/comp/position.hpp"
+#include "edyn/comp/rotated_mesh_list.hpp"
+#include "edyn/comp/shape_index.hpp"
+#include "edyn/comp/tag.hpp"
+#include "edyn/math/transform.hpp"
+#include "edyn/parallel/parallel_for.hpp"
+#include "edyn/util/aabb_util.hpp"
+#include "edyn/util/entt_util.hpp"
+#include "edyn/util/island_util.hpp"
+#include "edyn/util/tuple_util.hpp"
+#include <entt/entity/registry.hpp>
+
+namespace edyn {
+
+void update_derived_state(entt::registry &registry, bool mt) {
+    auto body_view = registry.view<position, orientation>(exclude_sleeping_disabled);
+    auto origin_view = registry.view<origin>();
+    auto com_view = registry.view<center_of_mass>();
+    auto rotated_view = registry.view<rotated_mesh_list>();
+    auto aabb_view = registry.view<shape_index, AABB>();
+    auto inertia_view = registry.view<inertia_inv, inertia_world_inv, dynamic_tag>();
+    auto shape_views_tuple = get_tuple_of_shape_views(registry);
+
+    // The steps depend on one another in this order for each body, but there
+    // are no dependencies between bodies.
+    auto for_loop_body = [body_view, origin_view, com_view, rotated_view, aabb_view,
+                          inertia_view, shape_views_tuple](entt::entity entity) {
+        auto [pos, orn] = body_view.get(entity);
+        auto orig = static_cast<vector3>(pos);
+
+        if (origin_view.contains(entity)) {
+            auto &origin = origin_view.get<edyn::origin>(entity);
+
+            if (com_view.contains(entity)) {
+                auto &com = com_view.get<center_of_mass>(entity);
+                origin = to_world_space(-com, pos, orn);
+            }
+
+            orig = origin;
+        }
+
+        // Rotated meshes must be updated before the AABB because they are
+        // used to calculate the AABB of polyhedrons.
+        if (rotated_view.contains(entity)) {
+            auto rotated_entity = entity;
+
+            do {
+                auto &rotated = rotated_view.get<rotated_mesh_list>(rotated_entity);
+                update_rotated_mesh(*rotated.rotated, *rotated.mesh, orn * rotated.orientation);
+                rotated_entity = rotated.next;
+            } while (rotated_entity != entt::null);
+        }
+
+        if (aabb_view.contains(entity)) {
+            auto [sh_idx, aabb] = aabb_view.get(entity);
+
+            visit_shape(sh_idx, entity, shape_views_tuple, [&](auto &&shape) {
+                using ShapeType = std::decay_t<decltype(shape)>;
+
+                // AABBs of static shapes never change.
+                if constexpr(tuple_has_type<ShapeType, dynamic_shapes_tuple_t>::value) {
+                    aabb = updated_aabb(shape, orig, orn);
+                }
+            });
+        }
+
+        if (inertia_view.contains(entity)) {
+            auto [inv_I, inv_IW] = inertia_view.get<inertia_inv, inertia_world_inv>(entity);
+            auto basis = to_matrix3x3(orn);
+            inv_IW = basis * inv_I * transpose(basis);
+        }
+    };
+
+    const size_t max_sequential_size = 256;
+
+    if (mt && calculate_view_size(body_view) > max_sequential_size) {
+        auto &dispatcher = job_dispatcher::global();
+        parallel_for_each(dispatcher, body_view.begin(), body_view.end(), for_loop_body);
+    } else {
+        for (auto entity : body_view) {
+            for_loop_body(entity);
+        }
+    }
+
+    // Island AABBs enclose the AABBs of their nodes, thus they can only be
+    // updated after all bodies are done.
+    update_island_aabbs(registry, mt);
+}
+
+}
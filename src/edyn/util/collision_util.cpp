@@ -17,6 +17,7 @@
 #include "edyn/math/triangle.hpp"
 #include "edyn/util/island_util.hpp"
 #include <limits>
+#include <type_traits>
 
 namespace edyn {
 
@@ -26,17 +27,7 @@ void update_contact_distances(entt::registry &registry) {
     auto origin_view = registry.view<origin>();
 
     manifold_view.each([&](contact_manifold &manifold) {
-        auto [posA, ornA] = tr_view.get(manifold.body[0]);
-        auto [posB, ornB] = tr_view.get(manifold.body[1]);
-        auto originA = origin_view.contains(manifold.body[0]) ? origin_view.get<origin>(manifold.body[0]) : static_cast<vector3>(posA);
-        auto originB = origin_view.contains(manifold.body[1]) ? origin_view.get<origin>(manifold.body[1]) : static_cast<vector3>(posB);
-
-        for (unsigned i = 0; i < manifold.num_points; ++i) {
-            auto &cp = manifold.get_point(i);
-            auto pivotA_world = to_world_space(cp.pivotA, originA, ornA);
-            auto pivotB_world = to_world_space(cp.pivotB, originB, ornB);
-            cp.distance = dot(cp.normal, pivotA_world - pivotB_world);
-        }
+        update_contact_distances(manifold, tr_view, origin_view);
     });
 }
 
@@ -291,6 +282,40 @@ static void assign_material_properties(entt::registry &registry, contact_manifol
     }
 }
 
+// Speculative points of bodies with continuous contacts can be created while
+// the bodies are still far apart. Contact events are only raised for points
+// that are touching, i.e. within the contact breaking threshold.
+static bool is_touching(const contact_point &cp) {
+    return cp.distance <= contact_breaking_threshold;
+}
+
+static bool has_touching_points(const contact_manifold &manifold) {
+    for (unsigned i = 0; i < manifold.num_points; ++i) {
+        if (!manifold.get_point(i).speculative) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void promote_touching_points(contact_manifold &manifold, contact_manifold_events &events) {
+    auto had_touching_points = has_touching_points(manifold);
+
+    for (unsigned i = 0; i < manifold.num_points; ++i) {
+        auto pt_id = manifold.ids[i];
+        auto &cp = manifold.point[pt_id];
+
+        if (cp.speculative && is_touching(cp)) {
+            cp.speculative = false;
+            events.contact_started |= !had_touching_points;
+            had_touching_points = true;
+            EDYN_ASSERT(events.num_contacts_created < max_contacts);
+            events.contacts_created[events.num_contacts_created++] = pt_id;
+        }
+    }
+}
+
 void create_contact_point(entt::registry &registry,
                           entt::entity manifold_entity,
                           contact_manifold& manifold,
@@ -317,7 +342,7 @@ void create_contact_point(entt::registry &registry,
 #endif
 
     // Add new index.
-    auto is_first_contact = manifold.num_points == 0;
+    auto is_first_contact = !has_touching_points(manifold);
     manifold.ids[manifold.num_points++] = pt_id;
 
     EDYN_ASSERT(length_sqr(rp.normal) > EDYN_EPSILON);
@@ -332,6 +357,7 @@ void create_contact_point(entt::registry &registry,
     cp.distance = rp.distance;
     cp.featureA = rp.featureA;
     cp.featureB = rp.featureB;
+    cp.speculative = !is_touching(cp);
 
     if (rp.normal_attachment != contact_normal_attachment::none) {
         auto idx = rp.normal_attachment == contact_normal_attachment::normal_on_A ? 0 : 1;
@@ -349,6 +375,10 @@ void create_contact_point(entt::registry &registry,
     // Force update signal to be triggered for contact manifold.
     registry.patch<contact_manifold>(manifold_entity);
 
+    if (cp.speculative) {
+        return;
+    }
+
     // Add contact created event.
     registry.patch<contact_manifold_events>(manifold_entity, [&](contact_manifold_events &events) {
         events.contact_started |= is_first_contact;
@@ -361,7 +391,8 @@ bool maybe_remove_point(contact_manifold &manifold,
                         contact_manifold_events &events,
                         size_t pt_idx,
                         const vector3 &posA, const quaternion &ornA,
-                        const vector3 &posB, const quaternion &ornB) {
+                        const vector3 &posB, const quaternion &ornB,
+                        const vector3 &displacement) {
     constexpr auto threshold = contact_breaking_threshold;
     constexpr auto threshold_sqr = threshold * threshold;
     auto pt_id = manifold.ids[pt_idx];
@@ -380,6 +411,16 @@ bool maybe_remove_point(contact_manifold &manifold,
         return false;
     }
 
+    // Keep speculative points while the bodies are still approaching and
+    // the gap can be closed in the next step, so they are not recreated
+    // every step and their impulses are preserved.
+    auto approach = -dot(displacement, n);
+
+    if (cp.speculative && approach > 0 &&
+        normal_dist < threshold + approach && tangential_dist_sqr < threshold_sqr) {
+        return false;
+    }
+
     // Swap with last element.
     EDYN_ASSERT(manifold.num_points > 0);
     size_t last_idx = manifold.num_points - 1;
@@ -387,8 +428,10 @@ bool maybe_remove_point(contact_manifold &manifold,
     manifold.ids[last_idx] = contact_manifold::invalid_id;
     --manifold.num_points;
 
-    events.contact_ended = manifold.num_points == 0;
-    events.contacts_destroyed[events.num_contacts_destroyed++] = pt_id;
+    if (!cp.speculative) {
+        events.contact_ended = !has_touching_points(manifold);
+        events.contacts_destroyed[events.num_contacts_destroyed++] = pt_id;
+    }
 
     return true;
 }
@@ -402,9 +445,103 @@ void destroy_contact_point(entt::registry &registry, entt::entity manifold_entit
     registry.patch<contact_manifold_events>(manifold_entity);
 }
 
+// Maximum number of times a body is advanced towards a mesh looking for the
+// first impact.
+static constexpr unsigned max_conservative_advancement_iterations = 8;
+
+template<typename ShapeType>
+constexpr bool is_mesh_shape_v = std::is_same_v<ShapeType, mesh_shape> ||
+                                 std::is_same_v<ShapeType, paged_mesh_shape>;
+
+template<typename ShapeAType, typename ShapeBType>
+static void collide_continuous(const ShapeAType &shA, const ShapeBType &shB,
+                               const collision_context &ctx, const vector3 &displacement,
+                               collision_result &result) {
+    // Generate speculative points for features within reach in the next step.
+    // The contact constraint only prevents them from being crossed, thus they
+    // have no effect if the bodies do not get there.
+    auto travel = length(displacement);
+    auto speculative_ctx = ctx;
+    speculative_ctx.threshold = collision_threshold + travel;
+    collide(shA, shB, speculative_ctx, result);
+
+    // Speculative points are taken from the closest features in the current
+    // pose which, against a mesh, are not necessarily the ones that will be
+    // hit, such as when moving along an edge. Use conservative advancement to
+    // find the features hit first instead. Meshes are static, thus move the
+    // other shape.
+    if constexpr(is_mesh_shape_v<ShapeAType> == is_mesh_shape_v<ShapeBType>) {
+        return;
+    } else {
+        auto advanced_ctx = speculative_ctx;
+        auto advanced_result = result;
+        auto fraction = scalar(0);
+
+        for (unsigned i = 0; i < max_conservative_advancement_iterations; ++i) {
+            // Find the largest fraction of the displacement that can be
+            // travelled without crossing any of the points.
+            auto min_distance = EDYN_SCALAR_MAX;
+            auto advance = EDYN_SCALAR_MAX;
+
+            for (size_t pt_idx = 0; pt_idx < advanced_result.num_points; ++pt_idx) {
+                auto &rp = advanced_result.point[pt_idx];
+                min_distance = std::min(rp.distance, min_distance);
+                auto approach = -dot(rp.normal, displacement);
+
+                if (approach > EDYN_EPSILON) {
+                    advance = std::min(rp.distance / approach, advance);
+                }
+            }
+
+            if (min_distance <= collision_threshold) {
+                break;
+            }
+
+            // Nothing will be hit in this step.
+            if (advance == EDYN_SCALAR_MAX || fraction + advance >= 1) {
+                return;
+            }
+
+            fraction += advance;
+
+            if constexpr(is_mesh_shape_v<ShapeAType>) {
+                advanced_ctx.posB = ctx.posB - displacement * fraction;
+            } else {
+                advanced_ctx.posA = ctx.posA + displacement * fraction;
+            }
+
+            advanced_ctx.threshold = collision_threshold + travel * (1 - fraction);
+            advanced_result = {};
+            collide(shA, shB, advanced_ctx, advanced_result);
+        }
+
+        // Shapes are already touching, thus the points in the current pose
+        // are the right ones.
+        if (fraction == 0) {
+            return;
+        }
+
+        // Only the shape that is not a mesh was translated, thus pivots in
+        // object space are still valid. Bring distances back to the current
+        // pose.
+        for (size_t pt_idx = 0; pt_idx < advanced_result.num_points; ++pt_idx) {
+            auto &rp = advanced_result.point[pt_idx];
+            rp.distance -= dot(rp.normal, displacement) * fraction;
+        }
+
+        result = advanced_result;
+    }
+}
+
 void detect_collision(std::array<entt::entity, 2> body, collision_result &result,
                       const detect_collision_body_view_t &body_view, const origin_view_t &origin_view,
                       const tuple_of_shape_views_t &views_tuple) {
+    detect_collision(body, result, body_view, origin_view, views_tuple, vector3_zero);
+}
+
+void detect_collision(std::array<entt::entity, 2> body, collision_result &result,
+                      const detect_collision_body_view_t &body_view, const origin_view_t &origin_view,
+                      const tuple_of_shape_views_t &views_tuple, const vector3 &displacement) {
     auto &aabbA = body_view.get<AABB>(body[0]);
     auto &aabbB = body_view.get<AABB>(body[1]);
     const auto offset = vector3_one * -contact_breaking_threshold;
@@ -412,7 +549,8 @@ void detect_collision(std::array<entt::entity, 2> body, collision_result &result
     // Only proceed to closest points calculation if AABBs intersect, since
     // a manifold is allowed to exist whilst the AABB separation is smaller
     // than `manifold.separation_threshold` which is greater than the
-    // contact breaking threshold.
+    // contact breaking threshold. AABBs of bodies with continuous contacts
+    // enclose their displacement in the next step.
     if (intersect(aabbA.inset(offset), aabbB)) {
         auto &ornA = body_view.get<orientation>(body[0]);
         auto &ornB = body_view.get<orientation>(body[1]);
@@ -428,9 +566,17 @@ void detect_collision(std::array<entt::entity, 2> body, collision_result &result
         auto shape_indexB = body_view.get<shape_index>(body[1]);
         auto ctx = collision_context{originA, ornA, aabbA, originB, ornB, aabbB, collision_threshold};
 
+        // Displacements shorter than the collision threshold are covered by
+        // regular contacts.
+        auto continuous = length_sqr(displacement) > collision_threshold * collision_threshold;
+
         visit_shape(shape_indexA, body[0], views_tuple, [&](auto &&shA) {
             visit_shape(shape_indexB, body[1], views_tuple, [&](auto &&shB) {
-                collide(shA, shB, ctx, result);
+                if (continuous) {
+                    collide_continuous(shA, shB, ctx, displacement, result);
+                } else {
+                    collide(shA, shB, ctx, result);
+                }
             });
         });
     } else {
@@ -438,4 +584,20 @@ void detect_collision(std::array<entt::entity, 2> body, collision_result &result
     }
 }
 
+vector3 get_continuous_displacement(std::array<entt::entity, 2> body,
+                                    const linvel_view_t &linvel_view,
+                                    const continuous_contacts_view_t &continuous_view,
+                                    scalar dt) {
+    if (!continuous_view.contains(body[0]) && !continuous_view.contains(body[1])) {
+        return vector3_zero;
+    }
+
+    auto vA = linvel_view.contains(body[0]) ?
+        static_cast<vector3>(linvel_view.get<linvel>(body[0])) : vector3_zero;
+    auto vB = linvel_view.contains(body[1]) ?
+        static_cast<vector3>(linvel_view.get<linvel>(body[1])) : vector3_zero;
+
+    return (vA - vB) * dt;
+}
+
 }
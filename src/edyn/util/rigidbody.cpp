@@ -145,6 +145,10 @@ void make_rigidbody(entt::entity entity, entt::registry &registry, const rigidbo
         registry.emplace<sleeping_disabled_tag>(entity);
     }
 
+    if (def.continuous_contacts && def.kind == rigidbody_kind::rb_dynamic) {
+        registry.emplace<continuous_contacts_tag>(entity);
+    }
+
     if (def.networked) {
         registry.emplace<networked_tag>(entity);
     }
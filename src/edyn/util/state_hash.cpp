@@ -0,0 +1,79 @@
+#include "edyn/util/state_hash.hpp"
+#include "edyn/comp/angvel.hpp"
+#include "edyn/comp/linvel.hpp"
+#include "edyn/comp/orientation.hpp"
+#include "edyn/comp/position.hpp"
+#include <entt/entity/registry.hpp>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace edyn {
+
+// 64-bit FNV-1a.
+static constexpr uint64_t fnv_offset_basis = 14695981039346656037ull;
+static constexpr uint64_t fnv_prime = 1099511628211ull;
+
+template<typename T>
+static void hash_combine(uint64_t &hash, const T &value) {
+    unsigned char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+
+    for (auto byte : bytes) {
+        hash ^= byte;
+        hash *= fnv_prime;
+    }
+}
+
+// Hash each component individually to skip padding.
+static void hash_combine(uint64_t &hash, const vector3 &v) {
+    hash_combine(hash, v.x);
+    hash_combine(hash, v.y);
+    hash_combine(hash, v.z);
+}
+
+static void hash_combine(uint64_t &hash, const quaternion &q) {
+    hash_combine(hash, q.x);
+    hash_combine(hash, q.y);
+    hash_combine(hash, q.z);
+    hash_combine(hash, q.w);
+}
+
+template<typename View>
+static void hash_body(uint64_t &hash, const View &view, entt::entity entity) {
+    auto [pos, orn, v, w] = view.get(entity);
+    hash_combine(hash, entt::to_integral(entity));
+    hash_combine(hash, static_cast<const vector3 &>(pos));
+    hash_combine(hash, static_cast<const quaternion &>(orn));
+    hash_combine(hash, static_cast<const vector3 &>(v));
+    hash_combine(hash, static_cast<const vector3 &>(w));
+}
+
+uint64_t hash_state(const entt::registry &registry) {
+    auto view = registry.view<const position, const orientation, const linvel, const angvel>();
+    auto entities = std::vector<entt::entity>(view.begin(), view.end());
+    std::sort(entities.begin(), entities.end(), [](entt::entity lhs, entt::entity rhs) {
+        return entt::to_integral(lhs) < entt::to_integral(rhs);
+    });
+
+    auto hash = fnv_offset_basis;
+
+    for (auto entity : entities) {
+        hash_body(hash, view, entity);
+    }
+
+    return hash;
+}
+
+uint64_t hash_state(const entt::registry &registry, entt::entity entity) {
+    auto view = registry.view<const position, const orientation, const linvel, const angvel>();
+    auto hash = fnv_offset_basis;
+
+    if (view.contains(entity)) {
+        hash_body(hash, view, entity);
+    }
+
+    return hash;
+}
+
+}
@@ -1,5 +1,7 @@
 #include "../common/common.hpp"
 #include "edyn/collision/should_collide.hpp"
+#include "edyn/util/contact_manifold_util.hpp"
+#include "edyn/sys/update_aabbs.hpp"
 
 TEST(test_broadphase, collision_filtering) {
     entt::registry registry;
@@ -32,3 +34,83 @@ TEST(test_broadphase, collision_filtering) {
 
     edyn::detach(registry);
 }
+
+TEST(test_broadphase, manifolds_for_moved_entities) {
+    entt::registry registry;
+    auto config = edyn::init_config{};
+    config.execution_mode = edyn::execution_mode::sequential;
+    edyn::attach(registry, config);
+    edyn::set_paused(registry, true);
+
+    auto def = edyn::rigidbody_def{};
+    def.shape = edyn::box_shape{0.5, 0.5, 0.5};
+    def.gravity = edyn::vector3_zero;
+    auto first = edyn::make_rigidbody(registry, def);
+    def.position = {0.9, 0, 0};
+    auto second = edyn::make_rigidbody(registry, def);
+    def.position = {10, 0, 0};
+    auto third = edyn::make_rigidbody(registry, def);
+
+    edyn::step_simulation(registry);
+
+    ASSERT_TRUE(edyn::manifold_exists(registry, first, second));
+    ASSERT_FALSE(edyn::manifold_exists(registry, first, third));
+    ASSERT_FALSE(edyn::manifold_exists(registry, second, third));
+
+    // Teleport third entity next to the second, far outside of its fat AABB.
+    // The broadphase runs before the AABBs are recalculated in a step, thus
+    // update it right away.
+    registry.get<edyn::position>(third) = {1.8, 0, 0};
+    edyn::update_aabb(registry, third);
+    edyn::step_simulation(registry);
+
+    ASSERT_TRUE(edyn::manifold_exists(registry, second, third));
+    ASSERT_FALSE(edyn::manifold_exists(registry, first, third));
+
+    edyn::detach(registry);
+}
+
+TEST(test_broadphase, pairs_restored_on_wake_up) {
+    entt::registry registry;
+    auto config = edyn::init_config{};
+    config.execution_mode = edyn::execution_mode::sequential;
+    edyn::attach(registry, config);
+    edyn::set_paused(registry, true);
+
+    auto def = edyn::rigidbody_def{};
+    def.shape = edyn::box_shape{0.5, 0.5, 0.5};
+    def.gravity = edyn::vector3_zero;
+    auto first = edyn::make_rigidbody(registry, def);
+    // Fat AABBs intersect but the AABBs are too far apart for a manifold.
+    def.position = {1.1, 0, 0};
+    auto second = edyn::make_rigidbody(registry, def);
+
+    auto time = 0.0;
+    auto dt = registry.ctx().at<edyn::settings>().fixed_dt;
+    auto step = [&] {
+        time += dt;
+        edyn::step_simulation(registry, time);
+    };
+
+    for (int i = 0; i < 200; ++i) {
+        step();
+    }
+
+    ASSERT_TRUE(registry.all_of<edyn::sleeping_tag>(first));
+    ASSERT_TRUE(registry.all_of<edyn::sleeping_tag>(second));
+    ASSERT_FALSE(edyn::manifold_exists(registry, first, second));
+
+    edyn::wake_up_entity(registry, first);
+    step();
+    ASSERT_FALSE(registry.all_of<edyn::sleeping_tag>(first));
+
+    // Move it closer while staying within its fat AABB, thus it isn't moved
+    // in the tree and its pairs must have been found when it woke up.
+    registry.get<edyn::position>(first) = {0.09, 0, 0};
+    step();
+    step();
+
+    ASSERT_TRUE(edyn::manifold_exists(registry, first, second));
+
+    edyn::detach(registry);
+}
@@ -0,0 +1,182 @@
+#include "../common/common.hpp"
+#include "edyn/util/shape_util.hpp"
+#include "edyn/util/collision_util.hpp"
+
+static entt::entity make_fast_sphere(entt::registry &registry, bool continuous) {
+    auto def = edyn::rigidbody_def{};
+    def.shape = edyn::sphere_shape{0.1};
+    def.gravity = edyn::vector3_zero;
+    def.position = {0, 0.5, 0};
+    // Travels 1 unit per step, which is much more than its diameter.
+    def.linvel = {0, -60, 0};
+    def.continuous_contacts = continuous;
+    return edyn::make_rigidbody(registry, def);
+}
+
+static void attach_paused(entt::registry &registry) {
+    auto config = edyn::init_config{};
+    config.execution_mode = edyn::execution_mode::sequential;
+    edyn::attach(registry, config);
+    edyn::set_paused(registry, true);
+}
+
+TEST(test_continuous_contacts, no_tunneling_through_mesh) {
+    for (auto continuous : {false, true}) {
+        entt::registry registry;
+        attach_paused(registry);
+
+        std::vector<edyn::vector3> vertices;
+        std::vector<edyn::triangle_mesh::index_type> indices;
+        edyn::make_plane_mesh(4, 4, 4, 4, vertices, indices);
+
+        auto trimesh = std::make_shared<edyn::triangle_mesh>();
+        trimesh->insert_vertices(vertices.begin(), vertices.end());
+        trimesh->insert_indices(indices.begin(), indices.end());
+        trimesh->initialize();
+
+        auto floor_def = edyn::rigidbody_def{};
+        floor_def.kind = edyn::rigidbody_kind::rb_static;
+        floor_def.shape = edyn::mesh_shape{trimesh};
+        edyn::make_rigidbody(registry, floor_def);
+
+        auto sphere = make_fast_sphere(registry, continuous);
+
+        for (int i = 0; i < 10; ++i) {
+            edyn::step_simulation(registry);
+        }
+
+        auto &pos = registry.get<edyn::position>(sphere);
+
+        if (continuous) {
+            ASSERT_GT(pos.y, 0);
+        } else {
+            ASSERT_LT(pos.y, 0);
+        }
+
+        edyn::detach(registry);
+    }
+}
+
+TEST(test_continuous_contacts, no_tunneling_through_thin_box) {
+    entt::registry registry;
+    attach_paused(registry);
+
+    auto wall_def = edyn::rigidbody_def{};
+    wall_def.kind = edyn::rigidbody_kind::rb_static;
+    wall_def.shape = edyn::box_shape{2, 0.01, 2};
+    edyn::make_rigidbody(registry, wall_def);
+
+    auto sphere = make_fast_sphere(registry, true);
+
+    for (int i = 0; i < 10; ++i) {
+        edyn::step_simulation(registry);
+    }
+
+    ASSERT_GT(registry.get<edyn::position>(sphere).y, 0);
+
+    edyn::detach(registry);
+}
+
+struct contact_event_counter {
+    void on_contact_started(entt::entity) {
+        ++num_started;
+    }
+
+    void on_contact_point_created(entt::entity, edyn::contact_manifold::contact_id_type) {
+        ++num_points_created;
+    }
+
+    int num_started {0};
+    int num_points_created {0};
+};
+
+TEST(test_continuous_contacts, no_events_when_passing_by) {
+    entt::registry registry;
+    attach_paused(registry);
+
+    auto wall_def = edyn::rigidbody_def{};
+    wall_def.kind = edyn::rigidbody_kind::rb_static;
+    wall_def.shape = edyn::box_shape{0.01, 2, 2};
+    edyn::make_rigidbody(registry, wall_def);
+
+    // Passes 0.4 units beside the edge of the wall, which is less than it
+    // travels in one step, thus speculative points are created.
+    auto def = edyn::rigidbody_def{};
+    def.shape = edyn::sphere_shape{0.1};
+    def.gravity = edyn::vector3_zero;
+    def.position = {-3, 0, 2.5};
+    def.linvel = {60, 0, 0};
+    def.continuous_contacts = true;
+    auto sphere = edyn::make_rigidbody(registry, def);
+
+    auto counter = contact_event_counter{};
+    edyn::on_contact_started(registry).connect<&contact_event_counter::on_contact_started>(counter);
+    edyn::on_contact_point_created(registry).connect<&contact_event_counter::on_contact_point_created>(counter);
+
+    auto had_speculative_points = false;
+
+    for (int i = 0; i < 6; ++i) {
+        edyn::step_simulation(registry);
+
+        for (auto [entity, manifold] : registry.view<edyn::contact_manifold>().each()) {
+            had_speculative_points |= manifold.num_points > 0;
+        }
+    }
+
+    ASSERT_TRUE(had_speculative_points);
+    ASSERT_EQ(counter.num_started, 0);
+    ASSERT_EQ(counter.num_points_created, 0);
+
+    auto &pos = registry.get<edyn::position>(sphere);
+    ASSERT_GT(pos.x, 0);
+    ASSERT_SCALAR_EQ(pos.z, 2.5);
+
+    edyn::detach(registry);
+}
+
+TEST(test_continuous_contacts, speculative_points_kept_while_approaching) {
+    // Speculative point 0.2 units above the ground, with A on top of B.
+    auto make_manifold = [] {
+        auto manifold = edyn::contact_manifold{};
+        manifold.num_points = 1;
+        manifold.ids[0] = 0;
+        auto &cp = manifold.point[0];
+        cp.pivotA = {0, -0.1, 0};
+        cp.pivotB = {0, 0, 0};
+        cp.normal = {0, 1, 0};
+        cp.distance = 0.2;
+        cp.speculative = true;
+        return manifold;
+    };
+
+    auto posA = edyn::vector3{0, 0.3, 0};
+    auto posB = edyn::vector3_zero;
+    auto orn = edyn::quaternion_identity;
+
+    // Still approaching and within reach in the next step.
+    {
+        auto manifold = make_manifold();
+        auto events = edyn::contact_manifold_events{};
+        auto displacement = edyn::vector3{0, -0.5, 0};
+        ASSERT_FALSE(edyn::maybe_remove_point(manifold, events, 0, posA, orn, posB, orn, displacement));
+        ASSERT_EQ(manifold.num_points, 1);
+    }
+
+    // Moving away.
+    {
+        auto manifold = make_manifold();
+        auto events = edyn::contact_manifold_events{};
+        auto displacement = edyn::vector3{0, 0.5, 0};
+        ASSERT_TRUE(edyn::maybe_remove_point(manifold, events, 0, posA, orn, posB, orn, displacement));
+        ASSERT_EQ(manifold.num_points, 0);
+        ASSERT_EQ(events.num_contacts_destroyed, 0);
+    }
+
+    // Approaching but out of reach in the next step.
+    {
+        auto manifold = make_manifold();
+        auto events = edyn::contact_manifold_events{};
+        auto displacement = edyn::vector3{0, -0.05, 0};
+        ASSERT_TRUE(edyn::maybe_remove_point(manifold, events, 0, posA, orn, posB, orn, displacement));
+    }
+}
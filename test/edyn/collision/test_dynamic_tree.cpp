@@ -0,0 +1,52 @@
+#include "../common/common.hpp"
+#include <random>
+#include <set>
+
+TEST(dynamic_tree, wide_tree_matches_binary_tree) {
+    auto rng = std::mt19937(3);
+    auto position = std::uniform_real_distribution<edyn::scalar>(-100, 100);
+    auto size = std::uniform_real_distribution<edyn::scalar>(0.1, 3);
+    auto tree = edyn::dynamic_tree{};
+    auto ids = std::vector<edyn::tree_node_id_t>{};
+
+    auto random_aabb = [&]() {
+        auto center = edyn::vector3{position(rng), position(rng), position(rng)};
+        auto half_extent = edyn::vector3{size(rng), size(rng), size(rng)};
+        return edyn::AABB{center - half_extent, center + half_extent};
+    };
+
+    for (unsigned i = 0; i < 3000; ++i) {
+        ids.push_back(tree.create(random_aabb(), entt::entity(i)));
+    }
+
+    // Remove some leaves to have a tree with free nodes.
+    for (unsigned i = 0; i < ids.size(); i += 7) {
+        tree.destroy(ids[i]);
+    }
+
+    for (int i = 0; i < 100; ++i) {
+        auto aabb = random_aabb().inset(edyn::vector3_one * -5);
+        auto p0 = edyn::vector3{position(rng), position(rng), position(rng)};
+        auto p1 = edyn::vector3{position(rng), position(rng), position(rng)};
+
+        auto binary_query = std::set<edyn::tree_node_id_t>{};
+        auto binary_raycast = std::set<edyn::tree_node_id_t>{};
+        tree.query(aabb, [&](auto id) { binary_query.insert(id); });
+        tree.raycast(p0, p1, [&](auto id) { binary_raycast.insert(id); });
+
+        tree.update_wide_tree();
+
+        auto wide_query = std::set<edyn::tree_node_id_t>{};
+        auto wide_raycast = std::set<edyn::tree_node_id_t>{};
+        tree.query(aabb, [&](auto id) { wide_query.insert(id); });
+        tree.raycast(p0, p1, [&](auto id) { wide_raycast.insert(id); });
+
+        ASSERT_EQ(binary_query, wide_query);
+        ASSERT_EQ(binary_raycast, wide_raycast);
+
+        // Changing the tree invalidates the wide layout.
+        tree.create(random_aabb(), entt::entity(10000 + i));
+    }
+
+    ASSERT_EQ(tree.num_leaves(), 3000 - 429 + 100);
+}
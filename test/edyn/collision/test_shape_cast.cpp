@@ -0,0 +1,72 @@
+#include "../common/common.hpp"
+#include "edyn/util/shape_util.hpp"
+
+class test_shape_cast : public ::testing::Test {
+protected:
+    void SetUp() override {
+        auto config = edyn::init_config{};
+        config.execution_mode = edyn::execution_mode::sequential;
+        edyn::attach(registry, config);
+    }
+
+    void TearDown() override {
+        edyn::detach(registry);
+    }
+
+    entt::registry registry;
+};
+
+TEST_F(test_shape_cast, sphere_against_box) {
+    auto def = edyn::rigidbody_def{};
+    def.kind = edyn::rigidbody_kind::rb_static;
+    def.shape = edyn::box_shape{1, 0.5, 1};
+    auto box_entity = edyn::make_rigidbody(registry, def);
+    edyn::update(registry);
+
+    auto sphere = edyn::sphere_shape{0.5};
+    auto p0 = edyn::vector3{0, 5, 0};
+    auto p1 = edyn::vector3{0, -5, 0};
+    auto result = edyn::shape_cast(registry, sphere, edyn::quaternion_identity, p0, p1);
+
+    // Sphere touches the top face when its center is at y = 1.
+    ASSERT_EQ(result.entity, box_entity);
+    ASSERT_NEAR(result.fraction, 0.4, 0.001);
+    ASSERT_NEAR(result.normal.y, 1, 0.001);
+    ASSERT_NEAR(result.point.y, 0.5, 0.001);
+
+    // Passes beside the box.
+    result = edyn::shape_cast(registry, sphere, edyn::quaternion_identity, {2, 5, 0}, {2, -5, 0});
+    ASSERT_EQ(result.entity, entt::null);
+
+    // Does not reach the box.
+    result = edyn::shape_cast(registry, sphere, edyn::quaternion_identity, {0, 5, 0}, {0, 2, 0});
+    ASSERT_EQ(result.entity, entt::null);
+
+    // Box is ignored.
+    result = edyn::shape_cast(registry, sphere, edyn::quaternion_identity, p0, p1, {box_entity});
+    ASSERT_EQ(result.entity, entt::null);
+}
+
+TEST_F(test_shape_cast, box_against_mesh) {
+    std::vector<edyn::vector3> vertices;
+    std::vector<edyn::triangle_mesh::index_type> indices;
+    edyn::make_plane_mesh(4, 4, 4, 4, vertices, indices);
+
+    auto trimesh = std::make_shared<edyn::triangle_mesh>();
+    trimesh->insert_vertices(vertices.begin(), vertices.end());
+    trimesh->insert_indices(indices.begin(), indices.end());
+    trimesh->initialize();
+
+    auto def = edyn::rigidbody_def{};
+    def.kind = edyn::rigidbody_kind::rb_static;
+    def.shape = edyn::mesh_shape{trimesh};
+    auto mesh_entity = edyn::make_rigidbody(registry, def);
+    edyn::update(registry);
+
+    // Box touches the plane when its center is at y = 0.5.
+    auto box = edyn::box_shape{0.5, 0.5, 0.5};
+    auto result = edyn::shape_cast(registry, box, edyn::quaternion_identity, {0.3, 3, 0.2}, {0.3, -3, 0.2});
+    ASSERT_EQ(result.entity, mesh_entity);
+    ASSERT_NEAR(result.fraction, 2.5 / 6, 0.001);
+    ASSERT_NEAR(result.normal.y, 1, 0.001);
+}
@@ -0,0 +1,119 @@
+#include "../common/common.hpp"
+#include "edyn/serialization/memory_archive.hpp"
+#include "edyn/serialization/static_tree_s11n.hpp"
+#include <cstring>
+#include <random>
+#include <set>
+
+class static_tree_test : public ::testing::Test {
+protected:
+    void SetUp() override {
+        auto rng = std::mt19937(7);
+        auto position = std::uniform_real_distribution<edyn::scalar>(-100, 100);
+        auto size = std::uniform_real_distribution<edyn::scalar>(0.01, 2);
+        aabbs.resize(5000);
+
+        for (auto &aabb : aabbs) {
+            auto center = edyn::vector3{position(rng), position(rng) * edyn::scalar(0.1), position(rng)};
+            auto half_extent = edyn::vector3{size(rng), size(rng), size(rng)};
+            aabb = {center - half_extent, center + half_extent};
+        }
+
+        // Add some coincident primitives.
+        for (size_t i = 1; i < 20; ++i) {
+            aabbs[i] = aabbs[0];
+        }
+
+        auto report_leaf = [&](edyn::static_tree::tree_node &node, auto ids_begin, auto ids_end) {
+            node.id = leaves.size();
+            leaves.emplace_back(ids_begin, ids_end);
+        };
+        tree.build(aabbs.begin(), aabbs.end(), report_leaf, 4);
+    }
+
+    std::vector<edyn::AABB> aabbs;
+    std::vector<std::vector<uint32_t>> leaves;
+    edyn::static_tree tree;
+};
+
+TEST_F(static_tree_test, leaves_cover_all_primitives) {
+    auto ids = std::set<uint32_t>{};
+
+    for (auto &leaf : leaves) {
+        ASSERT_LE(leaf.size(), 4);
+        ids.insert(leaf.begin(), leaf.end());
+    }
+
+    ASSERT_EQ(ids.size(), aabbs.size());
+    ASSERT_TRUE(tree.root_aabb().contains(aabbs.front()));
+}
+
+TEST_F(static_tree_test, query_matches_brute_force) {
+    auto rng = std::mt19937(11);
+    auto position = std::uniform_real_distribution<edyn::scalar>(-110, 110);
+    auto size = std::uniform_real_distribution<edyn::scalar>(0.1, 10);
+
+    for (int i = 0; i < 200; ++i) {
+        auto center = edyn::vector3{position(rng), position(rng) * edyn::scalar(0.1), position(rng)};
+        auto half_extent = edyn::vector3{size(rng), size(rng), size(rng)};
+        auto query_aabb = edyn::AABB{center - half_extent, center + half_extent};
+
+        auto found = std::set<uint32_t>{};
+        tree.query(query_aabb, [&](uint32_t node_idx) {
+            auto &leaf = leaves[tree.get_node(node_idx).id];
+            found.insert(leaf.begin(), leaf.end());
+        });
+
+        for (uint32_t id = 0; id < aabbs.size(); ++id) {
+            if (edyn::intersect(aabbs[id], query_aabb)) {
+                ASSERT_TRUE(found.count(id));
+            }
+        }
+    }
+}
+
+TEST_F(static_tree_test, raycast_matches_brute_force) {
+    auto rng = std::mt19937(13);
+    auto position = std::uniform_real_distribution<edyn::scalar>(-110, 110);
+
+    for (int i = 0; i < 200; ++i) {
+        auto p0 = edyn::vector3{position(rng), position(rng) * edyn::scalar(0.1), position(rng)};
+        auto p1 = edyn::vector3{position(rng), position(rng) * edyn::scalar(0.1), position(rng)};
+
+        auto found = std::set<uint32_t>{};
+        tree.raycast(p0, p1, [&](uint32_t node_idx) {
+            auto &leaf = leaves[tree.get_node(node_idx).id];
+            found.insert(leaf.begin(), leaf.end());
+        });
+
+        for (uint32_t id = 0; id < aabbs.size(); ++id) {
+            if (edyn::intersect_segment_aabb(p0, p1, aabbs[id].min, aabbs[id].max)) {
+                ASSERT_TRUE(found.count(id));
+            }
+        }
+    }
+}
+
+TEST_F(static_tree_test, serialization_rejects_other_versions) {
+    auto buffer = std::vector<uint8_t>{};
+    auto output = edyn::memory_output_archive(buffer);
+    edyn::serialize(output, tree);
+
+    {
+        auto input_tree = edyn::static_tree{};
+        auto input = edyn::memory_input_archive(buffer.data(), buffer.size());
+        edyn::serialize(input, input_tree);
+        ASSERT_FALSE(input.failed());
+        ASSERT_EQ(input_tree.size(), tree.size());
+    }
+
+    // The version is written first.
+    auto version = edyn::static_tree_serialization_version - 1;
+    std::memcpy(buffer.data(), &version, sizeof(version));
+
+    auto input_tree = edyn::static_tree{};
+    auto input = edyn::memory_input_archive(buffer.data(), buffer.size());
+    edyn::serialize(input, input_tree);
+    ASSERT_TRUE(input.failed());
+    ASSERT_TRUE(input_tree.empty());
+}
@@ -0,0 +1,130 @@
+#include "../common/common.hpp"
+#include <algorithm>
+
+static void make_stack(entt::registry &registry) {
+    auto floor_def = edyn::rigidbody_def{};
+    floor_def.kind = edyn::rigidbody_kind::rb_static;
+    floor_def.shape = edyn::plane_shape{{0, 1, 0}, 0};
+    edyn::make_rigidbody(registry, floor_def);
+
+    auto def = edyn::rigidbody_def{};
+    def.shape = edyn::box_shape{0.2, 0.2, 0.2};
+
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            for (int k = 0; k < 4; ++k) {
+                def.position = {edyn::scalar(i * 0.41), edyn::scalar(0.2 + j * 0.41), edyn::scalar(k * 0.41)};
+                edyn::make_rigidbody(registry, def);
+            }
+        }
+    }
+}
+
+static std::vector<uint64_t> simulate_stack(edyn::execution_mode mode, unsigned num_steps) {
+    entt::registry registry;
+    auto config = edyn::init_config{};
+    config.execution_mode = mode;
+    edyn::attach(registry, config);
+    edyn::set_paused(registry, true);
+    edyn::set_deterministic(registry, true);
+    make_stack(registry);
+
+    auto hashes = std::vector<uint64_t>{};
+
+    for (unsigned i = 0; i < num_steps; ++i) {
+        edyn::step_simulation(registry);
+        hashes.push_back(edyn::hash_state(registry));
+    }
+
+    edyn::detach(registry);
+
+    return hashes;
+}
+
+TEST(test_determinism, multithreaded_matches_sequential) {
+    auto seq = simulate_stack(edyn::execution_mode::sequential, 60);
+    auto mt = simulate_stack(edyn::execution_mode::sequential_multithreaded, 60);
+
+    for (size_t i = 0; i < seq.size(); ++i) {
+        ASSERT_EQ(seq[i], mt[i]) << "Diverged at step " << i;
+    }
+}
+
+// Simulates a stack of boxes next to a row of spheres which are destroyed
+// after a few steps. Spheres are created and destroyed in opposite orders
+// when `reverse` is set, which changes the identifiers of their contact
+// manifolds and the identifiers recycled for the contact manifolds created
+// later in the stack, besides the order of entities in their pools.
+static std::vector<uint64_t> simulate_stack_with_history(bool reverse, unsigned num_steps) {
+    entt::registry registry;
+    auto config = edyn::init_config{};
+    config.execution_mode = edyn::execution_mode::sequential;
+    edyn::attach(registry, config);
+    edyn::set_paused(registry, true);
+    edyn::set_deterministic(registry, true);
+    make_stack(registry);
+
+    auto def = edyn::rigidbody_def{};
+    def.shape = edyn::sphere_shape{0.2};
+    const int num_spheres = 8;
+    auto spheres = std::vector<entt::entity>{};
+
+    for (int i = 0; i < num_spheres; ++i) {
+        auto idx = reverse ? num_spheres - 1 - i : i;
+        def.position = {edyn::scalar(5 + idx * 0.41), edyn::scalar(0.2), 0};
+        spheres.push_back(edyn::make_rigidbody(registry, def));
+    }
+
+    for (unsigned i = 0; i < 5; ++i) {
+        edyn::step_simulation(registry);
+    }
+
+    // Destroy the spheres in their order of position in both simulations,
+    // which is the opposite order of creation in one of them.
+    if (reverse) {
+        std::reverse(spheres.begin(), spheres.end());
+    }
+
+    for (auto entity : spheres) {
+        registry.destroy(entity);
+    }
+
+    auto hashes = std::vector<uint64_t>{};
+
+    for (unsigned i = 0; i < num_steps; ++i) {
+        edyn::step_simulation(registry);
+        hashes.push_back(edyn::hash_state(registry));
+    }
+
+    edyn::detach(registry);
+
+    return hashes;
+}
+
+TEST(test_determinism, independent_of_creation_and_destruction_order) {
+    auto forward = simulate_stack_with_history(false, 60);
+    auto reverse = simulate_stack_with_history(true, 60);
+
+    for (size_t i = 0; i < forward.size(); ++i) {
+        ASSERT_EQ(forward[i], reverse[i]) << "Diverged at step " << i;
+    }
+}
+
+TEST(test_determinism, hash_changes_with_state) {
+    entt::registry registry;
+    auto config = edyn::init_config{};
+    config.execution_mode = edyn::execution_mode::sequential;
+    edyn::attach(registry, config);
+
+    auto def = edyn::rigidbody_def{};
+    def.shape = edyn::sphere_shape{0.5};
+    auto entity = edyn::make_rigidbody(registry, def);
+
+    auto hash = edyn::hash_state(registry);
+    ASSERT_EQ(hash, edyn::hash_state(registry));
+
+    registry.get<edyn::linvel>(entity).x += edyn::scalar(1e-6);
+    ASSERT_NE(hash, edyn::hash_state(registry));
+
+    edyn::detach(registry);
+}
@@ -0,0 +1,149 @@
+#include "../common/common.hpp"
+#include <edyn/dynamics/row_block.hpp>
+#include <edyn/dynamics/row_cache.hpp>
+#include <edyn/dynamics/row_coloring.hpp>
+#include <random>
+
+class test_row_block : public ::testing::Test {
+protected:
+    edyn::vector3 random_vector() {
+        return edyn::vector3{dist(gen), dist(gen), dist(gen)};
+    }
+
+    void init_slots(unsigned num_slots) {
+        colors.num_colors = 1;
+        colors.batches.resize(1);
+        colors.batches[0].offsets.push_back({0, 0, 0, 0});
+        colors.dv.resize(num_slots);
+        colors.dw.resize(num_slots);
+
+        for (unsigned i = 0; i < num_slots; ++i) {
+            colors.dv[i] = random_vector();
+            colors.dw[i] = random_vector();
+        }
+
+        row_dv = colors.dv;
+        row_dw = colors.dw;
+    }
+
+    // Inserts a constraint with `num_rows` rows acting upon the bodies in the
+    // given slots into the batch.
+    void add_constraint(unsigned num_rows, unsigned slotA, unsigned slotB) {
+        auto &batch = colors.batches[0];
+
+        for (unsigned i = 0; i < num_rows; ++i) {
+            auto row_index = static_cast<unsigned>(cache.rows.size());
+            auto &row = cache.rows.emplace_back();
+
+            for (auto &J : row.J) {
+                J = random_vector();
+            }
+
+            row.eff_mass = edyn::scalar(0.5);
+            row.rhs = dist(gen);
+            // Make a few rows hit the limits.
+            row.lower_limit = row_index % 2 == 0 ? -EDYN_SCALAR_MAX : edyn::scalar(-0.1);
+            row.upper_limit = row_index % 3 == 0 ? EDYN_SCALAR_MAX : edyn::scalar(0.05);
+            row.impulse = dist(gen) * edyn::scalar(0.01);
+            row.inv_mA = 1;
+            row.inv_mB = edyn::scalar(0.5);
+            row.inv_IA = edyn::matrix3x3_identity;
+            row.inv_IB = edyn::matrix3x3_identity * edyn::scalar(2);
+            row.dvA = &row_dv[slotA];
+            row.dwA = &row_dw[slotA];
+            row.dvB = &row_dv[slotB];
+            row.dwB = &row_dw[slotB];
+
+            batch.rows.push_back(row_index);
+            colors.row_slots.push_back({slotA, slotB});
+        }
+
+        batch.offsets.push_back({static_cast<unsigned>(batch.rows.size()), 0, 0, 0});
+    }
+
+    // Solves the blocks and compares against solving the rows one by one in
+    // the order they were inserted.
+    void solve_and_compare() {
+        blocks.clear();
+        edyn::pack_row_blocks(cache, colors, blocks);
+
+        auto rows = cache.rows;
+
+        for (unsigned iteration = 0; iteration < 4; ++iteration) {
+            for (auto &block : blocks.blocks) {
+                edyn::solve(block, colors.dv.data(), colors.dw.data(), cache.rows);
+            }
+
+            for (auto &row : rows) {
+                auto delta_impulse = edyn::solve(row);
+                edyn::apply_row_impulse(delta_impulse, row);
+            }
+        }
+
+        for (unsigned i = 0; i < rows.size(); ++i) {
+            ASSERT_SCALAR_EQ(cache.rows[i].impulse, rows[i].impulse);
+        }
+
+        for (unsigned i = 0; i < colors.dv.size(); ++i) {
+            ASSERT_VECTOR3_EQ(colors.dv[i], row_dv[i]);
+            ASSERT_VECTOR3_EQ(colors.dw[i], row_dw[i]);
+        }
+    }
+
+    std::mt19937 gen {0};
+    std::uniform_real_distribution<edyn::scalar> dist {-1, 1};
+    edyn::row_cache cache;
+    edyn::row_color_batches colors;
+    edyn::row_block_cache blocks;
+    std::vector<edyn::delta_linvel> row_dv;
+    std::vector<edyn::delta_angvel> row_dw;
+};
+
+TEST_F(test_row_block, matches_row_solver) {
+    // Create rows that do not share bodies, with two bodies per row. Use a
+    // number of rows that is not a multiple of the block width.
+    constexpr unsigned num_rows = edyn::constraint_row_block::width * 2 + 1;
+    init_slots(num_rows * 2);
+
+    for (unsigned i = 0; i < num_rows; ++i) {
+        add_constraint(1, i * 2, i * 2 + 1);
+    }
+
+    solve_and_compare();
+    ASSERT_EQ(blocks.blocks.size(), 3);
+}
+
+TEST_F(test_row_block, rows_on_same_bodies) {
+    // Constraints with multiple rows acting upon the same pair of bodies, such
+    // as contact manifolds and joints, with a different number of rows each.
+    constexpr unsigned num_constraints = edyn::constraint_row_block::width + 2;
+    init_slots(num_constraints * 2);
+
+    for (unsigned i = 0; i < num_constraints; ++i) {
+        add_constraint(i % 3 + 2, i * 2, i * 2 + 1);
+    }
+
+    solve_and_compare();
+
+    // No two lanes of a block can write to the same body.
+    for (auto &block : blocks.blocks) {
+        for (unsigned i = 0; i < block.num_rows; ++i) {
+            for (unsigned j = i + 1; j < block.num_rows; ++j) {
+                ASSERT_NE(block.slotA[i], block.slotA[j]);
+                ASSERT_NE(block.slotB[i], block.slotB[j]);
+            }
+        }
+    }
+}
+
+TEST_F(test_row_block, constraints_sharing_a_body) {
+    // The last constraint shares a body with the first, which must place it
+    // in another group solved after the first.
+    init_slots(6);
+    add_constraint(3, 0, 1);
+    add_constraint(3, 2, 3);
+    add_constraint(3, 4, 0);
+
+    solve_and_compare();
+    ASSERT_EQ(blocks.group_offsets.size(), 3);
+}
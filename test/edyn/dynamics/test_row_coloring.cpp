@@ -0,0 +1,67 @@
+#include "../common/common.hpp"
+#include <algorithm>
+
+// Simulates a stack of boxes until it settles and returns the final position
+// of each box, in order of creation, and the greatest final speed.
+static std::vector<edyn::vector3> settle_stack(unsigned coloring_threshold, unsigned num_steps,
+                                               edyn::scalar &max_speed) {
+    entt::registry registry;
+    auto config = edyn::init_config{};
+    config.execution_mode = edyn::execution_mode::sequential;
+    edyn::attach(registry, config);
+    edyn::set_paused(registry, true);
+    edyn::set_solver_island_coloring_threshold(registry, coloring_threshold);
+
+    auto floor_def = edyn::rigidbody_def{};
+    floor_def.kind = edyn::rigidbody_kind::rb_static;
+    floor_def.shape = edyn::plane_shape{{0, 1, 0}, 0};
+    edyn::make_rigidbody(registry, floor_def);
+
+    auto def = edyn::rigidbody_def{};
+    def.shape = edyn::box_shape{0.2, 0.2, 0.2};
+    def.sleeping_disabled = true;
+    auto entities = std::vector<entt::entity>{};
+
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            for (int k = 0; k < 3; ++k) {
+                def.position = {edyn::scalar(i * 0.41), edyn::scalar(0.2 + j * 0.4), edyn::scalar(k * 0.41)};
+                entities.push_back(edyn::make_rigidbody(registry, def));
+            }
+        }
+    }
+
+    for (unsigned i = 0; i < num_steps; ++i) {
+        edyn::step_simulation(registry);
+    }
+
+    auto positions = std::vector<edyn::vector3>{};
+    max_speed = 0;
+
+    for (auto entity : entities) {
+        positions.push_back(registry.get<edyn::position>(entity));
+        max_speed = std::max(max_speed, edyn::length(registry.get<edyn::linvel>(entity)));
+    }
+
+    edyn::detach(registry);
+
+    return positions;
+}
+
+TEST(test_row_coloring, colored_matches_sequential_resting_state) {
+    // A threshold of zero disables coloring and a threshold of one colors
+    // every island.
+    edyn::scalar sequential_speed, colored_speed;
+    auto sequential = settle_stack(0, 240, sequential_speed);
+    auto colored = settle_stack(1, 240, colored_speed);
+
+    ASSERT_LT(sequential_speed, edyn::scalar(0.05));
+    ASSERT_LT(colored_speed, edyn::scalar(0.05));
+    ASSERT_EQ(sequential.size(), colored.size());
+
+    for (size_t i = 0; i < sequential.size(); ++i) {
+        ASSERT_NEAR(sequential[i].x, colored[i].x, 0.01) << "Body " << i;
+        ASSERT_NEAR(sequential[i].y, colored[i].y, 0.01) << "Body " << i;
+        ASSERT_NEAR(sequential[i].z, colored[i].z, 0.01) << "Body " << i;
+    }
+}
@@ -2,6 +2,7 @@
 #include "edyn/networking/networking.hpp"
 #include "edyn/networking/util/client_snapshot_exporter.hpp"
 #include "edyn/networking/util/client_snapshot_importer.hpp"
+#include "edyn/networking/util/server_snapshot_exporter.hpp"
 #include <entt/core/type_info.hpp>
 #include <entt/meta/factory.hpp>
 #include <entt/core/hashed_string.hpp>
@@ -67,3 +68,37 @@ TEST(networking_test, client_export_import) {
     ASSERT_EQ(reg1.get<comp>(emap.at(ent0)).entity, emap.at(ent1));
     ASSERT_EQ(reg1.get<comp>(emap.at(ent0)).d, 1.618);
 }
+
+TEST(networking_test, server_export_into_reused_snapshot) {
+    auto registry = entt::registry{};
+    auto exporter = edyn::server_snapshot_exporter_impl(registry, edyn::networked_components);
+    std::vector<entt::entity> entities;
+
+    for (int i = 0; i < 8; ++i) {
+        auto entity = registry.create();
+        registry.emplace<edyn::networked_tag>(entity);
+        registry.emplace<edyn::position>(entity, edyn::scalar(i), 0, 0);
+        entities.push_back(entity);
+    }
+
+    auto first = std::vector<entt::entity>(entities.begin(), entities.begin() + 4);
+    auto second = std::vector<entt::entity>(entities.rbegin(), entities.rbegin() + 6);
+    auto snap = edyn::packet::registry_snapshot{};
+    exporter.export_all(snap, first);
+
+    // Clear the snapshot as done when the same packet is reused to export
+    // the next snapshot. Entities from the previous export must not linger.
+    snap.entities.clear();
+    snap.pools.clear();
+    exporter.export_all(snap, second);
+
+    ASSERT_EQ(snap.entities, second);
+    ASSERT_EQ(snap.pools.size(), 1);
+    auto *pool = static_cast<edyn::pool_snapshot_data_impl<edyn::position> *>(snap.pools.front().ptr.get());
+    ASSERT_EQ(pool->entity_indices.size(), second.size());
+
+    for (size_t i = 0; i < second.size(); ++i) {
+        ASSERT_EQ(snap.entities[pool->entity_indices[i]], second[i]);
+        ASSERT_SCALAR_EQ(pool->components[i].x, registry.get<edyn::position>(second[i]).x);
+    }
+}
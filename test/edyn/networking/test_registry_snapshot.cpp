@@ -0,0 +1,125 @@
+#include "../common/common.hpp"
+#include "edyn/networking/networking.hpp"
+#include "edyn/networking/packet/registry_snapshot.hpp"
+#include "edyn/networking/util/split_registry_snapshot.hpp"
+#include "edyn/serialization/memory_archive.hpp"
+
+static edyn::packet::registry_snapshot make_position_snapshot(size_t num_entities) {
+    auto snap = edyn::packet::registry_snapshot{};
+    auto index = edyn::tuple_index_of<edyn::component_index_type, edyn::position>(edyn::networked_components);
+    auto *pool = edyn::internal::get_pool<edyn::position>(snap.pools, index);
+
+    for (size_t i = 0; i < num_entities; ++i) {
+        snap.entities.push_back(entt::entity(i));
+        pool->entity_indices.push_back(i);
+        pool->components.push_back(edyn::vector3{edyn::scalar(i), 0, 0});
+    }
+
+    return snap;
+}
+
+TEST(registry_snapshot, many_entities) {
+    constexpr size_t num_entities = 3000;
+    auto snap = make_position_snapshot(num_entities);
+    snap.timestamp = 1;
+
+    auto buffer = edyn::memory_output_archive::buffer_type{};
+    auto output = edyn::memory_output_archive(buffer);
+    output(snap);
+
+    auto input = edyn::memory_input_archive(buffer.data(), buffer.size());
+    auto result = edyn::packet::registry_snapshot{};
+    input(result);
+    ASSERT_FALSE(input.failed());
+    ASSERT_EQ(result.entities.size(), num_entities);
+    ASSERT_EQ(result.pools.size(), 1);
+
+    auto *pool = static_cast<edyn::pool_snapshot_data_impl<edyn::position> *>(result.pools[0].ptr.get());
+    ASSERT_EQ(pool->entity_indices.size(), num_entities);
+
+    for (size_t i = 0; i < num_entities; ++i) {
+        ASSERT_EQ(pool->entity_indices[i], i);
+        ASSERT_SCALAR_EQ(pool->components[i].x, edyn::scalar(i));
+    }
+}
+
+TEST(registry_snapshot, small_index_size) {
+    // Sequential indices take a single byte each, plus one for the count.
+    auto snap = make_position_snapshot(100);
+    auto buffer = edyn::memory_output_archive::buffer_type{};
+    auto output = edyn::memory_output_archive(buffer);
+    snap.pools[0].ptr->write(output);
+    ASSERT_EQ(buffer.size(), 1 + 100 + 100 * sizeof(edyn::position));
+}
+
+TEST(registry_snapshot, split) {
+    constexpr size_t num_entities = 10;
+    auto snap = make_position_snapshot(num_entities);
+
+    // Highest priority for the last entities.
+    auto order = std::vector<size_t>(num_entities);
+
+    for (size_t i = 0; i < num_entities; ++i) {
+        order[i] = num_entities - i - 1;
+    }
+
+    auto fragments = edyn::split_registry_snapshot(snap, order, 4);
+    ASSERT_EQ(fragments.size(), 3);
+    ASSERT_EQ(fragments[2].entities.size(), 2);
+
+    size_t count = 0;
+
+    for (auto &fragment : fragments) {
+        for (auto entity : fragment.entities) {
+            ASSERT_EQ(entity, entt::entity(order[count++]));
+        }
+
+        ASSERT_EQ(fragment.pools.size(), 1);
+        auto *pool = static_cast<edyn::pool_snapshot_data_impl<edyn::position> *>(fragment.pools[0].ptr.get());
+        ASSERT_EQ(pool->entity_indices.size(), fragment.entities.size());
+
+        for (size_t i = 0; i < pool->entity_indices.size(); ++i) {
+            auto entity = fragment.entities[pool->entity_indices[i]];
+            ASSERT_SCALAR_EQ(pool->components[i].x, edyn::scalar(entt::to_integral(entity)));
+        }
+    }
+
+    ASSERT_EQ(count, num_entities);
+}
+
+TEST(registry_snapshot, insert_entities) {
+    auto registry = entt::registry{};
+    auto entities = std::vector<entt::entity>{};
+
+    for (size_t i = 0; i < 5; ++i) {
+        auto entity = registry.create();
+        registry.emplace<edyn::networked_tag>(entity);
+        registry.emplace<edyn::position>(entity, edyn::scalar(i), 0, 0);
+        registry.emplace<edyn::linvel>(entity, 0, edyn::scalar(i), 0);
+        entities.push_back(entity);
+    }
+
+    auto pos_index = edyn::tuple_index_of<edyn::component_index_type, edyn::position>(edyn::networked_components);
+    auto vel_index = edyn::tuple_index_of<edyn::component_index_type, edyn::linvel>(edyn::networked_components);
+    auto snap = edyn::packet::registry_snapshot{};
+    auto index_map = edyn::pool_snapshot_data::entity_index_map{};
+
+    // Each entity is added to the list once, in the order they were first
+    // inserted, even after the list is cleared to be reused while the index
+    // map still holds entries from before.
+    for (int repeat = 0; repeat < 2; ++repeat) {
+        snap.entities.clear();
+        snap.pools.clear();
+        edyn::internal::snapshot_insert_entities<edyn::position>(registry, entities.rbegin(), entities.rend(), snap, index_map, pos_index);
+        edyn::internal::snapshot_insert_entities<edyn::linvel>(registry, entities.begin(), entities.end(), snap, index_map, vel_index);
+
+        ASSERT_EQ(snap.entities.size(), entities.size());
+        ASSERT_EQ(snap.pools.size(), 2);
+        auto *vel_pool = static_cast<edyn::pool_snapshot_data_impl<edyn::linvel> *>(snap.pools[1].ptr.get());
+
+        for (size_t i = 0; i < entities.size(); ++i) {
+            ASSERT_EQ(snap.entities[vel_pool->entity_indices[i]], entities[i]);
+            ASSERT_SCALAR_EQ(vel_pool->components[i].y, edyn::scalar(i));
+        }
+    }
+}
@@ -0,0 +1,110 @@
+#include "../common/common.hpp"
+#include "edyn/networking/networking.hpp"
+#include "edyn/networking/packet/registry_snapshot.hpp"
+#include "edyn/networking/util/snapshot_compression.hpp"
+#include <random>
+
+template<typename Component>
+static void insert_components(edyn::packet::registry_snapshot &snap, const std::vector<Component> &components) {
+    auto index = edyn::tuple_index_of<edyn::component_index_type, Component>(edyn::networked_components);
+    auto *pool = edyn::internal::get_pool<Component>(snap.pools, index);
+
+    for (size_t i = 0; i < components.size(); ++i) {
+        pool->entity_indices.push_back(i);
+        pool->components.push_back(components[i]);
+    }
+}
+
+template<typename Component>
+static edyn::pool_snapshot_data_impl<Component> * find_pool(edyn::packet::registry_snapshot &snap) {
+    auto index = edyn::tuple_index_of<edyn::component_index_type, Component>(edyn::networked_components);
+
+    for (auto &pool : snap.pools) {
+        if (pool.component_index == index) {
+            return static_cast<edyn::pool_snapshot_data_impl<Component> *>(pool.ptr.get());
+        }
+    }
+
+    return nullptr;
+}
+
+TEST(snapshot_compression, delta_against_acknowledged) {
+    auto rng = std::mt19937(5);
+    auto dist = std::uniform_real_distribution<edyn::scalar>(-50, 50);
+    auto quantization = edyn::snapshot_quantization{};
+    auto server_history = edyn::snapshot_baseline_history{};
+    auto client_history = edyn::snapshot_baseline_history{};
+
+    constexpr size_t num_entities = 50;
+    auto positions = std::vector<edyn::position>(num_entities);
+    auto orientations = std::vector<edyn::orientation>(num_entities);
+    auto velocities = std::vector<edyn::linvel>(num_entities);
+
+    for (size_t i = 0; i < num_entities; ++i) {
+        positions[i] = edyn::vector3{dist(rng), dist(rng), dist(rng)};
+        orientations[i] = edyn::normalize(edyn::quaternion{dist(rng), dist(rng), dist(rng), dist(rng)});
+        velocities[i] = edyn::vector3{dist(rng), dist(rng), dist(rng)};
+    }
+
+    auto position_tolerance = std::ldexp(edyn::scalar(1), -quantization.position_fraction_bits);
+    auto velocity_tolerance = std::ldexp(edyn::scalar(1), -quantization.velocity_fraction_bits);
+    size_t first_size = 0;
+
+    for (int step = 0; step < 4; ++step) {
+        auto snap = edyn::packet::registry_snapshot{};
+
+        for (size_t i = 0; i < num_entities; ++i) {
+            snap.entities.push_back(entt::entity(i * 2));
+            positions[i].x += edyn::scalar(0.01);
+        }
+
+        insert_components(snap, positions);
+        insert_components(snap, orientations);
+        insert_components(snap, velocities);
+
+        edyn::compress_registry_snapshot(snap, quantization, server_history);
+        ASSERT_TRUE(snap.pools.empty());
+        ASSERT_FALSE(snap.motion.empty());
+
+        if (step == 0) {
+            first_size = snap.motion.size();
+        } else {
+            // Encoded as deltas from the acknowledged snapshot.
+            ASSERT_LT(snap.motion.size(), first_size);
+        }
+
+        uint32_t sequence;
+        ASSERT_TRUE(edyn::decompress_registry_snapshot(snap, client_history, sequence));
+        server_history.acknowledge(sequence);
+
+        auto *position_pool = find_pool<edyn::position>(snap);
+        auto *orientation_pool = find_pool<edyn::orientation>(snap);
+        auto *velocity_pool = find_pool<edyn::linvel>(snap);
+        ASSERT_TRUE(position_pool && orientation_pool && velocity_pool);
+        ASSERT_EQ(find_pool<edyn::angvel>(snap), nullptr);
+        ASSERT_EQ(position_pool->components.size(), num_entities);
+
+        for (size_t i = 0; i < num_entities; ++i) {
+            ASSERT_EQ(position_pool->entity_indices[i], i);
+            auto dp = position_pool->components[i] - positions[i];
+            auto dv = velocity_pool->components[i] - velocities[i];
+
+            for (size_t j = 0; j < 3; ++j) {
+                ASSERT_LE(std::abs(dp[j]), position_tolerance);
+                ASSERT_LE(std::abs(dv[j]), velocity_tolerance);
+            }
+
+            ASSERT_GT(std::abs(edyn::dot(orientation_pool->components[i], orientations[i])), edyn::scalar(0.9999));
+        }
+    }
+
+    // A client that does not have the baseline drops the snapshot.
+    auto snap = edyn::packet::registry_snapshot{};
+    snap.entities.push_back(entt::entity(0));
+    insert_components(snap, std::vector<edyn::position>{positions[0]});
+    edyn::compress_registry_snapshot(snap, quantization, server_history);
+
+    auto new_client_history = edyn::snapshot_baseline_history{};
+    uint32_t sequence;
+    ASSERT_FALSE(edyn::decompress_registry_snapshot(snap, new_client_history, sequence));
+}
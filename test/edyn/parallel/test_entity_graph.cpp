@@ -63,3 +63,56 @@ TEST(entity_graph_test, test_connected_components) {
         ASSERT_EQ(edge_entity, edge_entity01_1);
     });
 }
+
+TEST(entity_graph_test, test_split_components) {
+    auto registry = entt::registry();
+    auto graph = edyn::entity_graph();
+
+    // A chain of nodes where both ends touch a non-connecting node.
+    std::vector<entt::entity> node_entities;
+    std::vector<edyn::entity_graph::index_type> node_indices;
+
+    for (int i = 0; i < 5; ++i) {
+        auto entity = registry.create();
+        node_entities.push_back(entity);
+        node_indices.push_back(graph.insert_node(entity));
+    }
+
+    auto ground_entity = registry.create();
+    auto ground_index = graph.insert_node(ground_entity, true);
+
+    std::vector<edyn::entity_graph::index_type> edge_indices;
+
+    for (int i = 0; i < 4; ++i) {
+        edge_indices.push_back(graph.insert_edge(registry.create(), node_indices[i], node_indices[i + 1]));
+    }
+
+    graph.insert_edge(registry.create(), node_indices[0], ground_index);
+    graph.insert_edge(registry.create(), node_indices[4], ground_index);
+
+    // Still connected through another path.
+    auto shortcut_edge_index = graph.insert_edge(registry.create(), node_indices[2], node_indices[4]);
+    graph.remove_edge(edge_indices[2]);
+    ASSERT_TRUE(graph.split_components({node_indices[2], node_indices[3]}).empty());
+
+    // Separate the first two nodes. The separated component is the one that
+    // is fully visited first, which is the smaller one.
+    graph.remove_edge(edge_indices[1]);
+    auto components = graph.split_components({node_indices[1], node_indices[2]});
+    ASSERT_EQ(components.size(), 1);
+
+    auto &component = components.front();
+    ASSERT_EQ(component.nodes.size(), 3);
+    ASSERT_EQ(component.edges.size(), 2);
+
+    for (auto entity : {node_entities[0], node_entities[1], ground_entity}) {
+        ASSERT_NE(std::find(component.nodes.begin(), component.nodes.end(), entity), component.nodes.end());
+    }
+
+    // Isolate all nodes.
+    graph.remove_edge(edge_indices[0]);
+    graph.remove_edge(edge_indices[3]);
+    graph.remove_edge(shortcut_edge_index);
+    components = graph.split_components({node_indices[2], node_indices[3], node_indices[4]});
+    ASSERT_EQ(components.size(), 2);
+}
@@ -129,6 +129,40 @@ TEST_F(job_dispatcher_test, parallel_for_async) {
     }
 }
 
+std::atomic<int> nested_job_count {0};
+edyn::job_dispatcher *nested_job_dispatcher {nullptr};
+
+void count_nested_job(edyn::job::data_type &) {
+    nested_job_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void schedule_nested_jobs(edyn::job::data_type &) {
+    // Scheduled from a worker thread, thus inserted into its local deque and
+    // available to be stolen by other workers.
+    for (auto i = 0; i < 1000; ++i) {
+        auto j = edyn::job();
+        j.func = &count_nested_job;
+        nested_job_dispatcher->async(j);
+    }
+}
+
+TEST_F(job_dispatcher_test, async_from_worker) {
+    nested_job_count.store(0, std::memory_order_relaxed);
+    nested_job_dispatcher = &dispatcher;
+
+    for (auto i = 0; i < 16; ++i) {
+        auto j = edyn::job();
+        j.func = &schedule_nested_jobs;
+        dispatcher.async(j);
+    }
+
+    while (nested_job_count.load(std::memory_order_relaxed) < 16 * 1000) {
+        edyn::delay(1);
+    }
+
+    ASSERT_EQ(nested_job_count.load(std::memory_order_relaxed), 16 * 1000);
+}
+
 /*
 TEST_F(job_dispatcher_test, nested_parallel_for) {
     constexpr size_t rows = 2012;
@@ -1,5 +1,9 @@
 #include "../common/common.hpp"
 #include "edyn/util/shape_util.hpp"
+#include "edyn/parallel/job_dispatcher.hpp"
+#include "edyn/shapes/create_paged_triangle_mesh.hpp"
+#include "edyn/serialization/paged_triangle_mesh_mapped.hpp"
+#include "edyn/serialization/triangle_mesh_compression.hpp"
 
 TEST(triangle_mesh_serialization, test) {
     // Create triangle mesh.
@@ -70,3 +74,123 @@ TEST(triangle_mesh_serialization, test) {
         ASSERT_EQ(trimesh.is_convex_edge(i), input_trimesh.is_convex_edge(i));
     }
 }
+
+TEST(triangle_mesh_serialization, paged_mapped) {
+    edyn::job_dispatcher::global().start(1);
+
+    std::vector<edyn::vector3> vertices;
+    std::vector<edyn::triangle_mesh::index_type> indices;
+    edyn::make_plane_mesh(8, 8, 16, 16, vertices, indices);
+
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        vertices[i].y = std::sin(edyn::scalar(i) * edyn::scalar(0.37));
+    }
+
+    auto source_loader = std::make_shared<edyn::paged_triangle_mesh_mapped_loader>();
+    auto source = edyn::paged_triangle_mesh(source_loader);
+    edyn::create_paged_triangle_mesh(source, vertices.begin(), vertices.end(),
+                                     indices.begin(), indices.end(), 16, {});
+
+    auto filename = "paged_trimesh_mapped.bin";
+    ASSERT_TRUE(edyn::write_mapped_paged_triangle_mesh(filename, source));
+
+    auto loader = std::make_shared<edyn::paged_triangle_mesh_mapped_loader>(filename);
+    ASSERT_TRUE(loader->is_open());
+
+    auto paged_trimesh = edyn::paged_triangle_mesh(loader);
+    ASSERT_TRUE(loader->read(paged_trimesh));
+    ASSERT_EQ(paged_trimesh.num_submeshes(), source.num_submeshes());
+
+    for (size_t i = 0; i < source.num_submeshes(); ++i) {
+        auto expected = source.get_submesh(i);
+        auto submesh = loader->load_submesh(i);
+        ASSERT_TRUE(submesh);
+        ASSERT_EQ(submesh->num_vertices(), expected->num_vertices());
+        ASSERT_EQ(submesh->num_triangles(), expected->num_triangles());
+        ASSERT_EQ(submesh->num_edges(), expected->num_edges());
+
+        for (size_t j = 0; j < expected->num_vertices(); ++j) {
+            ASSERT_VECTOR3_EQ(submesh->get_vertex_position(j), expected->get_vertex_position(j));
+        }
+
+        for (size_t j = 0; j < expected->num_triangles(); ++j) {
+            for (size_t k = 0; k < 3; ++k) {
+                ASSERT_EQ(submesh->get_face_vertex_index(j, k), expected->get_face_vertex_index(j, k));
+            }
+        }
+
+        for (size_t j = 0; j < expected->num_edges(); ++j) {
+            ASSERT_EQ(submesh->is_convex_edge(j), expected->is_convex_edge(j));
+            ASSERT_EQ(submesh->is_boundary_edge(j), expected->is_boundary_edge(j));
+        }
+    }
+
+    edyn::job_dispatcher::global().stop();
+}
+
+TEST(triangle_mesh_serialization, compressed) {
+    edyn::job_dispatcher::global().start(1);
+
+    std::vector<edyn::vector3> vertices;
+    std::vector<edyn::triangle_mesh::index_type> indices;
+    edyn::make_plane_mesh(8, 8, 16, 16, vertices, indices);
+
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        vertices[i].y = std::sin(edyn::scalar(i) * edyn::scalar(0.37));
+    }
+
+    auto loader = std::make_shared<edyn::paged_triangle_mesh_mapped_loader>();
+    auto source = edyn::paged_triangle_mesh(loader);
+    edyn::create_paged_triangle_mesh(source, vertices.begin(), vertices.end(),
+                                     indices.begin(), indices.end(), 16, {});
+
+    auto step = edyn::default_triangle_mesh_quantization_step;
+
+    for (size_t i = 0; i < source.num_submeshes(); ++i) {
+        auto expected = source.get_submesh(i);
+        auto buffer = std::vector<uint8_t>{};
+        edyn::compress_triangle_mesh(*expected, buffer, step);
+
+        auto submesh = edyn::triangle_mesh{};
+        ASSERT_TRUE(edyn::decompress_triangle_mesh(buffer.data(), buffer.size(), submesh));
+        ASSERT_EQ(submesh.num_vertices(), expected->num_vertices());
+        ASSERT_EQ(submesh.num_triangles(), expected->num_triangles());
+        ASSERT_EQ(submesh.num_edges(), expected->num_edges());
+
+        for (size_t j = 0; j < expected->num_vertices(); ++j) {
+            auto delta = submesh.get_vertex_position(j) - expected->get_vertex_position(j);
+            ASSERT_LE(std::abs(delta.x), step);
+            ASSERT_LE(std::abs(delta.y), step);
+            ASSERT_LE(std::abs(delta.z), step);
+        }
+
+        for (size_t j = 0; j < expected->num_triangles(); ++j) {
+            for (size_t k = 0; k < 3; ++k) {
+                ASSERT_EQ(submesh.get_face_vertex_index(j, k), expected->get_face_vertex_index(j, k));
+                auto dot = edyn::dot(submesh.get_adjacent_face_normal(j, k), expected->get_adjacent_face_normal(j, k));
+                ASSERT_GT(dot, edyn::scalar(0.999));
+            }
+        }
+
+        for (size_t j = 0; j < expected->num_edges(); ++j) {
+            ASSERT_EQ(submesh.is_convex_edge(j), expected->is_convex_edge(j));
+            ASSERT_EQ(submesh.is_boundary_edge(j), expected->is_boundary_edge(j));
+        }
+
+        // The triangle tree is recreated from its layout.
+        for (size_t j = 0; j < submesh.num_triangles(); ++j) {
+            auto tri_aabb = edyn::get_triangle_aabb(submesh.get_triangle_vertices(j));
+            auto found = false;
+            submesh.visit_triangles(tri_aabb, [&](auto tri_idx) {
+                found |= tri_idx == j;
+            });
+            ASSERT_TRUE(found);
+        }
+
+        // Truncated data is rejected.
+        auto truncated = edyn::triangle_mesh{};
+        ASSERT_FALSE(edyn::decompress_triangle_mesh(buffer.data(), buffer.size() / 2, truncated));
+    }
+
+    edyn::job_dispatcher::global().stop();
+}
@@ -1,6 +1,7 @@
 #include "../common/common.hpp"
 #include "edyn/parallel/job_dispatcher.hpp"
 #include "edyn/shapes/create_paged_triangle_mesh.hpp"
+#include "edyn/util/shape_util.hpp"
 
 class triangle_mesh_page_loader: public edyn::triangle_mesh_page_loader_base {
 public:
@@ -53,3 +54,180 @@ TEST(test_paged_trimesh, voronoi_regions) {
 
     edyn::job_dispatcher::global().stop();
 }
+
+// Loads submeshes immediately from meshes kept in memory.
+class memory_page_loader: public edyn::triangle_mesh_page_loader_base {
+public:
+    void load(size_t index) override {
+        ++num_loads;
+        m_loaded_signal.publish(index, meshes[index]);
+    }
+
+    virtual entt::sink<entt::sigh<loaded_mesh_func_t>> on_load_sink() override {
+        return {m_loaded_signal};
+    }
+
+    std::vector<std::shared_ptr<edyn::triangle_mesh>> meshes;
+    size_t num_loads {0};
+
+private:
+    entt::sigh<loaded_mesh_func_t> m_loaded_signal;
+};
+
+TEST(test_paged_trimesh, cache_budget) {
+    edyn::job_dispatcher::global().start(1);
+
+    std::vector<edyn::vector3> vertices;
+    std::vector<edyn::triangle_mesh::index_type> indices;
+    edyn::make_plane_mesh(100, 100, 40, 40, vertices, indices);
+
+    auto loader = std::make_shared<memory_page_loader>();
+    auto trimesh = edyn::paged_triangle_mesh(loader);
+    edyn::create_paged_triangle_mesh(trimesh, vertices.begin(), vertices.end(), indices.begin(), indices.end(), 16, {});
+
+    size_t total_num_vertices = 0;
+
+    for (size_t i = 0; i < trimesh.num_submeshes(); ++i) {
+        loader->meshes.push_back(trimesh.get_submesh(i));
+        total_num_vertices += trimesh.get_submesh(i)->num_vertices();
+    }
+
+    ASSERT_EQ(trimesh.cache_num_vertices(), total_num_vertices);
+
+    trimesh.clear_cache();
+    ASSERT_EQ(trimesh.cache_num_vertices(), 0);
+
+    trimesh.m_max_cache_num_vertices = 300;
+
+    for (int i = 0; i < 500; ++i) {
+        auto x = edyn::scalar((i * 37) % 100) - 50;
+        auto z = edyn::scalar((i * 61) % 100) - 50;
+        auto aabb = edyn::AABB{{x - 2, -1, z - 2}, {x + 2, 1, z + 2}};
+        trimesh.visit_triangles(aabb, [](auto, auto) {});
+
+        size_t num_vertices = 0;
+
+        for (size_t j = 0; j < trimesh.num_submeshes(); ++j) {
+            if (auto submesh = trimesh.get_submesh(j)) {
+                num_vertices += submesh->num_vertices();
+            }
+        }
+
+        ASSERT_EQ(trimesh.cache_num_vertices(), num_vertices);
+        ASSERT_LE(num_vertices, trimesh.m_max_cache_num_vertices);
+
+        // Repeating the query must not load anything.
+        auto stats = trimesh.get_cache_stats();
+        trimesh.visit_triangles(aabb, [](auto, auto) {});
+        ASSERT_EQ(trimesh.get_cache_stats().misses, stats.misses);
+    }
+
+    auto stats = trimesh.get_cache_stats();
+    ASSERT_EQ(stats.misses, loader->num_loads);
+    ASSERT_GT(stats.hits, 0);
+    ASSERT_GT(stats.evictions, 0);
+
+    trimesh.reset_cache_stats();
+    ASSERT_EQ(trimesh.get_cache_stats().hits, 0);
+
+    edyn::job_dispatcher::global().stop();
+}
+
+TEST(test_paged_trimesh, prefetch) {
+    edyn::job_dispatcher::global().start(1);
+
+    std::vector<edyn::vector3> vertices;
+    std::vector<edyn::triangle_mesh::index_type> indices;
+    edyn::make_plane_mesh(100, 100, 40, 40, vertices, indices);
+
+    auto loader = std::make_shared<memory_page_loader>();
+    auto trimesh = edyn::paged_triangle_mesh(loader);
+    edyn::create_paged_triangle_mesh(trimesh, vertices.begin(), vertices.end(), indices.begin(), indices.end(), 16, {});
+
+    for (size_t i = 0; i < trimesh.num_submeshes(); ++i) {
+        loader->meshes.push_back(trimesh.get_submesh(i));
+    }
+
+    trimesh.clear_cache();
+
+    auto aabb = edyn::AABB{{-10, -1, -10}, {10, 1, 10}};
+    auto submesh_indices = std::vector<size_t>{};
+    trimesh.visit_submesh_bounds(aabb, [&](size_t submesh_idx, const edyn::AABB &submesh_aabb) {
+        ASSERT_TRUE(edyn::intersect(aabb, submesh_aabb));
+        submesh_indices.push_back(submesh_idx);
+    });
+    ASSERT_FALSE(submesh_indices.empty());
+
+    trimesh.prefetch_submeshes(submesh_indices);
+    ASSERT_EQ(trimesh.get_cache_stats().prefetches, submesh_indices.size());
+
+    // Prefetched submeshes are hits.
+    trimesh.visit_triangles(aabb, [](auto, auto) {});
+    ASSERT_EQ(trimesh.get_cache_stats().misses, 0);
+
+    // Prefetching stops at half the cache.
+    trimesh.clear_cache();
+    trimesh.reset_cache_stats();
+    trimesh.m_max_cache_num_vertices = 100;
+    trimesh.prefetch_submeshes(submesh_indices);
+    ASSERT_LE(trimesh.cache_num_vertices(), 50);
+    ASSERT_LT(trimesh.get_cache_stats().prefetches, submesh_indices.size());
+
+    // Recently visited submeshes are not unloaded to make room, thus
+    // prefetching is limited by the space left in the cache.
+    auto reversed_indices = std::vector<size_t>(submesh_indices.rbegin(), submesh_indices.rend());
+    trimesh.prefetch_submeshes(reversed_indices);
+    trimesh.prefetch_submeshes(submesh_indices);
+    ASSERT_LE(trimesh.cache_num_vertices(), 100);
+    ASSERT_EQ(trimesh.get_cache_stats().evictions, 0);
+
+    edyn::job_dispatcher::global().stop();
+}
+
+TEST(test_paged_trimesh, failed_load) {
+    edyn::job_dispatcher::global().start(1);
+
+    std::vector<edyn::vector3> vertices;
+    std::vector<edyn::triangle_mesh::index_type> indices;
+    edyn::make_plane_mesh(100, 100, 40, 40, vertices, indices);
+
+    auto loader = std::make_shared<memory_page_loader>();
+    auto trimesh = edyn::paged_triangle_mesh(loader);
+    edyn::create_paged_triangle_mesh(trimesh, vertices.begin(), vertices.end(), indices.begin(), indices.end(), 16, {});
+
+    for (size_t i = 0; i < trimesh.num_submeshes(); ++i) {
+        loader->meshes.push_back(trimesh.get_submesh(i));
+    }
+
+    trimesh.clear_cache();
+
+    // Loader fails to load the first submesh in the query.
+    auto aabb = edyn::AABB{{-2, -1, -2}, {2, 1, 2}};
+    auto failed_idx = trimesh.num_submeshes();
+    trimesh.visit_submesh_bounds(aabb, [&](size_t submesh_idx, const edyn::AABB &) {
+        failed_idx = std::min(failed_idx, submesh_idx);
+    });
+    ASSERT_LT(failed_idx, trimesh.num_submeshes());
+    loader->meshes[failed_idx] = nullptr;
+
+    trimesh.visit_triangles(aabb, [](auto, auto) {});
+    auto num_loads = loader->num_loads;
+    ASSERT_GT(num_loads, 0);
+    ASSERT_EQ(trimesh.get_submesh(failed_idx), nullptr);
+
+    // It is not requested again and does not take space in the cache.
+    trimesh.visit_triangles(aabb, [](auto, auto) {});
+    ASSERT_EQ(loader->num_loads, num_loads);
+
+    size_t num_vertices = 0;
+
+    for (size_t j = 0; j < trimesh.num_submeshes(); ++j) {
+        if (auto submesh = trimesh.get_submesh(j)) {
+            num_vertices += submesh->num_vertices();
+        }
+    }
+
+    ASSERT_EQ(trimesh.cache_num_vertices(), num_vertices);
+
+    edyn::job_dispatcher::global().stop();
+}
@@ -0,0 +1,81 @@
+#include "../common/common.hpp"
+#include <edyn/comp/island.hpp>
+
+class test_island_manager : public ::testing::Test {
+protected:
+    void SetUp() override {
+        auto config = edyn::init_config{};
+        config.execution_mode = edyn::execution_mode::sequential;
+        edyn::attach(registry, config);
+        edyn::set_gravity(registry, edyn::vector3_zero);
+
+        auto def = edyn::rigidbody_def{};
+        def.kind = edyn::rigidbody_kind::rb_static;
+        def.shape = edyn::box_shape{0.5, 0.5, 0.5};
+        static_entity = edyn::make_rigidbody(registry, def);
+
+        def.kind = edyn::rigidbody_kind::rb_dynamic;
+        def.mass = 1;
+        def.shape = edyn::sphere_shape{0.5};
+        def.position = {4, 0, 0};
+        dynamic_entity0 = edyn::make_rigidbody(registry, def);
+
+        def.position = {8, 0, 0};
+        dynamic_entity1 = edyn::make_rigidbody(registry, def);
+    }
+
+    void TearDown() override {
+        edyn::detach(registry);
+    }
+
+    bool static_in_island(entt::entity island_entity) {
+        auto &island = registry.get<edyn::island>(island_entity);
+        auto &resident = registry.get<edyn::multi_island_resident>(static_entity);
+        EXPECT_EQ(island.nodes.contains(static_entity), resident.island_entities.contains(island_entity));
+        return island.nodes.contains(static_entity);
+    }
+
+    entt::registry registry;
+    entt::entity static_entity;
+    entt::entity dynamic_entity0;
+    entt::entity dynamic_entity1;
+};
+
+TEST_F(test_island_manager, remove_only_edge_to_static) {
+    auto constraint = edyn::make_constraint<edyn::distance_constraint>(registry, dynamic_entity0, static_entity);
+    edyn::update(registry);
+
+    auto island_entity = registry.get<edyn::island_resident>(dynamic_entity0).island_entity;
+    ASSERT_TRUE(static_in_island(island_entity));
+
+    // The island is not split since it has a single procedural node, but the
+    // static body must leave it.
+    registry.destroy(constraint);
+    edyn::update(registry);
+
+    ASSERT_EQ(registry.get<edyn::island_resident>(dynamic_entity0).island_entity, island_entity);
+    ASSERT_FALSE(static_in_island(island_entity));
+}
+
+TEST_F(test_island_manager, split_keeps_static_connected) {
+    // Both dynamic bodies are connected to the static body and to each other.
+    edyn::make_constraint<edyn::distance_constraint>(registry, dynamic_entity0, static_entity);
+    edyn::make_constraint<edyn::distance_constraint>(registry, dynamic_entity1, static_entity);
+    auto constraint = edyn::make_constraint<edyn::distance_constraint>(registry, dynamic_entity0, dynamic_entity1);
+    edyn::update(registry);
+
+    auto island_entity0 = registry.get<edyn::island_resident>(dynamic_entity0).island_entity;
+    ASSERT_EQ(registry.get<edyn::island_resident>(dynamic_entity1).island_entity, island_entity0);
+
+    // Static bodies do not connect islands thus it splits in two, with the
+    // static body in both.
+    registry.destroy(constraint);
+    edyn::update(registry);
+
+    island_entity0 = registry.get<edyn::island_resident>(dynamic_entity0).island_entity;
+    auto island_entity1 = registry.get<edyn::island_resident>(dynamic_entity1).island_entity;
+    ASSERT_NE(island_entity0, island_entity1);
+    ASSERT_TRUE(static_in_island(island_entity0));
+    ASSERT_TRUE(static_in_island(island_entity1));
+    ASSERT_EQ(registry.get<edyn::multi_island_resident>(static_entity).island_entities.size(), 2);
+}
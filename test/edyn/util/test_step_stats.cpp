@@ -0,0 +1,28 @@
+#include "../common/common.hpp"
+#include "edyn/context/step_stats.hpp"
+
+TEST(test_step_stats, history_wraps_around) {
+    auto history = edyn::step_stats_history(3);
+    ASSERT_TRUE(history.empty());
+
+    for (int i = 0; i < 5; ++i) {
+        auto stats = edyn::step_stats{};
+        stats.timestamp = i;
+        history.push(stats);
+    }
+
+    ASSERT_EQ(history.size(), 3);
+    ASSERT_EQ(history.capacity(), 3);
+    ASSERT_EQ(history[0].timestamp, 2);
+    ASSERT_EQ(history[1].timestamp, 3);
+    ASSERT_EQ(history.latest().timestamp, 4);
+
+    double expected = 2;
+    history.each([&](const edyn::step_stats &stats) {
+        ASSERT_EQ(stats.timestamp, expected);
+        expected += 1;
+    });
+
+    history.clear();
+    ASSERT_TRUE(history.empty());
+}